@@ -0,0 +1,422 @@
+#include "appstreamcatalog.h"
+#include "flatpakbackend.h"
+#include <QThreadPool>
+#include <QMetaObject>
+#include <QStandardPaths>
+#include <QSysInfo>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QDataStream>
+#include <QProcess>
+#include <QXmlStreamReader>
+#include <QRegularExpression>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+
+const quint32 CACHE_MAGIC = 0x41505358;     // "APSX"
+const quint32 CACHE_VERSION = 1;
+
+// The arch flatpak deploys appstream for on this machine
+QString flatpakArch()
+{
+    const QString arch = QSysInfo::currentCpuArchitecture();
+    if (arch == "arm64") return "aarch64";
+    return arch;
+}
+
+QByteArray readAppstream(const QString &directory)
+{
+    QFile plain(directory + "/appstream.xml");
+    if (plain.open(QIODevice::ReadOnly)) {
+        return plain.readAll();
+    }
+    
+    // Only the compressed copy is deployed by some flatpak versions
+    const QString compressed = directory + "/appstream.xml.gz";
+    if (!QFileInfo::exists(compressed)) return QByteArray();
+    
+    QProcess gzip;
+    gzip.start("gzip", QStringList() << "-dc" << compressed);
+    if (!gzip.waitForFinished(30000) || gzip.exitCode() != 0) {
+        qWarning() << "Cannot decompress" << compressed << gzip.errorString();
+        return QByteArray();
+    }
+    return gzip.readAllStandardOutput();
+}
+
+bool isTranslated(const QXmlStreamReader &reader)
+{
+    return reader.attributes().hasAttribute("xml:lang");
+}
+
+QStringList readList(QXmlStreamReader &reader, const QString &item)
+{
+    QStringList values;
+    while (reader.readNextStartElement()) {
+        if (reader.name() == item && !isTranslated(reader)) {
+            const QString value = reader.readElementText().trimmed();
+            if (!value.isEmpty()) values << value;
+        } else {
+            reader.skipCurrentElement();
+        }
+    }
+    return values;
+}
+
+// Reads one <component> up to its end element; false for anything that is not an app
+bool readComponent(QXmlStreamReader &reader, CatalogApp *app)
+{
+    const QString type = reader.attributes().value("type").toString();
+    const bool isApp = type == "desktop-application" || type == "desktop" || type == "console-application";
+    int iconSize = 0;
+    
+    while (reader.readNextStartElement()) {
+        const auto name = reader.name();
+        
+        if (!isApp) {
+            reader.skipCurrentElement();
+        } else if (name == QLatin1String("id")) {
+            app->id = reader.readElementText().trimmed();
+        } else if (name == QLatin1String("name") && !isTranslated(reader)) {
+            app->name = reader.readElementText().simplified();
+        } else if (name == QLatin1String("summary") && !isTranslated(reader)) {
+            app->summary = reader.readElementText().simplified();
+        } else if (name == QLatin1String("developer_name") && !isTranslated(reader)) {
+            app->developer = reader.readElementText().simplified();
+        } else if (name == QLatin1String("developer")) {
+            const QStringList names = readList(reader, "name");
+            if (app->developer.isEmpty() && !names.isEmpty()) app->developer = names.first();
+        } else if (name == QLatin1String("keywords") && !isTranslated(reader)) {
+            app->keywords << readList(reader, "keyword");
+        } else if (name == QLatin1String("categories")) {
+            app->categories = readList(reader, "category");
+        } else if (name == QLatin1String("bundle")) {
+            const bool flatpak = reader.attributes().value("type") == QLatin1String("flatpak");
+            const QString ref = reader.readElementText().trimmed();
+            if (flatpak) app->ref = ref;
+        } else if (name == QLatin1String("icon")) {
+            const bool cached = reader.attributes().value("type") == QLatin1String("cached");
+            const int height = reader.attributes().value("height").toInt();
+            const QString file = reader.readElementText().trimmed();
+            // 128px looks right in the list; 64px is what every app ships
+            if (cached && !file.isEmpty() && height <= 128 && height > iconSize) {
+                iconSize = height;
+                app->icon = QString("%1x%1/%2").arg(height).arg(file);
+            }
+        } else {
+            reader.skipCurrentElement();
+        }
+    }
+    
+    if (!isApp || app->id.isEmpty() || app->name.isEmpty()) return false;
+    if (app->id.endsWith(".desktop")) app->id.chop(8);
+    if (app->ref.isEmpty()) app->ref = QString("app/%1/%2/stable").arg(app->id, flatpakArch());
+    return true;
+}
+
+} // namespace
+
+// Streamed as part of QVector<CatalogApp>, so these have to be found by ADL
+static QDataStream &operator<<(QDataStream &stream, const CatalogApp &app)
+{
+    return stream << app.id << app.name << app.summary << app.developer << app.keywords
+                  << app.categories << app.ref << app.icon;
+}
+
+static QDataStream &operator>>(QDataStream &stream, CatalogApp &app)
+{
+    return stream >> app.id >> app.name >> app.summary >> app.developer >> app.keywords
+                  >> app.categories >> app.ref >> app.icon;
+}
+
+// AppstreamCatalog Implementation
+AppstreamCatalog *AppstreamCatalog::instance()
+{
+    static AppstreamCatalog catalog;
+    return &catalog;
+}
+
+AppstreamCatalog::AppstreamCatalog(QObject *parent)
+    : QObject(parent)
+    , m_loading(false)
+    , m_loadAgain(false)
+{
+    connect(FlatpakBackend::instance(), &FlatpakBackend::refreshed, this, &AppstreamCatalog::refresh);
+}
+
+void AppstreamCatalog::refresh()
+{
+    if (m_loading) {
+        m_loadAgain = true;
+        return;
+    }
+    m_loading = true;
+    
+    QVector<Source> sources;
+    for (const FlatpakRemoteInfo &remote : FlatpakBackend::instance()->remotes()) {
+        if (!remote.enabled) continue;
+        Source source;
+        source.remote = remote.name;
+        source.installation = remote.installation;
+        source.isSystem = remote.isSystem;
+        source.directory = QString("%1/appstream/%2/%3/active")
+                               .arg(installationPath(remote.installation, remote.isSystem), remote.name, flatpakArch());
+        sources << source;
+    }
+    const QVector<Source> previous = m_sources;
+    
+    QThreadPool::globalInstance()->start([this, sources, previous]() mutable {
+        int reparsed = 0;
+        
+        for (Source &source : sources) {
+            source.commit = currentCommit(source.directory);
+            if (source.commit.isEmpty()) continue;      // never fetched
+            
+            auto same = std::find_if(previous.cbegin(), previous.cend(), [&source](const Source &old) {
+                return old.remote == source.remote && old.installation == source.installation;
+            });
+            if (same != previous.cend() && same->commit == source.commit) {
+                source.apps = same->apps;
+                continue;
+            }
+            if (!loadSource(&source)) {
+                parseSource(&source);
+                saveSource(source);
+                QDir(iconCacheDirectory(source.installation, source.remote)).removeRecursively();
+                ++reparsed;
+            }
+            cacheIcons(&source);
+        }
+        
+        QMetaObject::invokeMethod(this, [this, sources, reparsed]() {
+            publish(sources, reparsed);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void AppstreamCatalog::publish(const QVector<Source> &sources, int reparsed)
+{
+    m_sources = sources;
+    m_apps.clear();
+    m_index.clear();
+    m_byId.clear();
+    
+    // An app offered by several remotes is listed once, preferring the system one
+    for (const Source &source : std::as_const(m_sources)) {
+        for (CatalogApp app : source.apps) {
+            app.remote = source.remote;
+            app.installation = source.installation;
+            app.isSystem = source.isSystem;
+            
+            auto existing = m_byId.constFind(app.id);
+            if (existing != m_byId.constEnd()) {
+                if (m_apps[*existing].isSystem || !app.isSystem) continue;
+                m_apps[*existing] = app;
+                continue;
+            }
+            m_byId.insert(app.id, m_apps.size());
+            m_apps.append(app);
+        }
+    }
+    
+    m_index.reserve(m_apps.size());
+    for (const CatalogApp &app : std::as_const(m_apps)) {
+        IndexEntry entry;
+        entry.name = app.name.toLower();
+        entry.id = app.id.toLower();
+        entry.keywords = app.keywords.join(' ').toLower();
+        entry.summary = app.summary.toLower();
+        entry.categories = app.categories.join(' ').toLower();
+        m_index.append(entry);
+    }
+    
+    m_loading = false;
+    emit loaded(m_apps.size(), reparsed);
+    
+    if (m_loadAgain) {
+        m_loadAgain = false;
+        refresh();
+    }
+}
+
+QList<CatalogApp> AppstreamCatalog::search(const QString &query, int limit) const
+{
+    const QStringList terms = query.toLower().split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+    if (terms.isEmpty()) return QList<CatalogApp>();
+    
+    // Every term has to match somewhere; where it matches decides the rank
+    QVector<QPair<int, int>> matches;
+    for (int i = 0; i < m_index.size(); ++i) {
+        const IndexEntry &entry = m_index[i];
+        int score = 0;
+        for (const QString &term : terms) {
+            int termScore = 0;
+            if (entry.name.startsWith(term)) termScore = 100;
+            else if (entry.name.contains(term)) termScore = 60;
+            else if (entry.id.contains(term)) termScore = 40;
+            else if (entry.keywords.contains(term)) termScore = 30;
+            else if (entry.summary.contains(term)) termScore = 20;
+            else if (entry.categories.contains(term)) termScore = 10;
+            
+            if (termScore == 0) {
+                score = 0;
+                break;
+            }
+            score += termScore;
+        }
+        if (score > 0) matches.append(qMakePair(score, i));
+    }
+    
+    std::sort(matches.begin(), matches.end(), [this](const QPair<int, int> &a, const QPair<int, int> &b) {
+        if (a.first != b.first) return a.first > b.first;
+        return m_index[a.second].name < m_index[b.second].name;
+    });
+    
+    QList<CatalogApp> results;
+    for (int i = 0; i < matches.size() && i < limit; ++i) {
+        results.append(m_apps[matches[i].second]);
+    }
+    return results;
+}
+
+const CatalogApp *AppstreamCatalog::app(const QString &id) const
+{
+    auto it = m_byId.constFind(id);
+    return it != m_byId.constEnd() ? &m_apps[*it] : nullptr;
+}
+
+QString AppstreamCatalog::installationPath(const QString &installation, bool isSystem)
+{
+    if (!isSystem) return QDir::homePath() + "/.local/share/flatpak";
+    if (installation.isEmpty() || installation == "default") return "/var/lib/flatpak";
+    
+    // Extra system installations are declared as [Installation "id"] groups
+    const QDir configDir("/etc/flatpak/installations.d");
+    for (const QString &name : configDir.entryList(QStringList() << "*.conf", QDir::Files)) {
+        QFile file(configDir.filePath(name));
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) continue;
+        
+        bool inGroup = false;
+        while (!file.atEnd()) {
+            const QString line = QString::fromUtf8(file.readLine()).trimmed();
+            if (line.startsWith('[')) {
+                inGroup = line == QString("[Installation \"%1\"]").arg(installation);
+            } else if (inGroup && line.startsWith("Path=")) {
+                return line.mid(5).trimmed();
+            }
+        }
+    }
+    return "/var/lib/flatpak";
+}
+
+QString AppstreamCatalog::currentCommit(const QString &directory)
+{
+    // "active" links to the deployed checkout, which is named after its commit
+    const QFileInfo active(directory);
+    if (active.isSymLink()) {
+        return QFileInfo(active.symLinkTarget()).fileName();
+    }
+    
+    const QFileInfo xml(directory + "/appstream.xml.gz");
+    if (xml.exists()) return QString::number(xml.lastModified().toSecsSinceEpoch());
+    const QFileInfo plain(directory + "/appstream.xml");
+    if (plain.exists()) return QString::number(plain.lastModified().toSecsSinceEpoch());
+    return QString();
+}
+
+bool AppstreamCatalog::loadSource(Source *source)
+{
+    QFile file(cacheFile(*source));
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    
+    QDataStream stream(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QString commit;
+    stream >> magic >> version >> commit;
+    if (magic != CACHE_MAGIC || version != CACHE_VERSION || commit != source->commit) return false;
+    
+    QVector<CatalogApp> apps;
+    stream >> apps;
+    if (stream.status() != QDataStream::Ok) {
+        qWarning() << "Discarding corrupt appstream cache" << file.fileName();
+        return false;
+    }
+    
+    source->apps = apps;
+    return true;
+}
+
+void AppstreamCatalog::parseSource(Source *source)
+{
+    source->apps.clear();
+    
+    const QByteArray xml = readAppstream(source->directory);
+    if (xml.isEmpty()) return;
+    
+    QXmlStreamReader reader(xml);
+    while (!reader.atEnd()) {
+        reader.readNext();
+        if (!reader.isStartElement() || reader.name() != QLatin1String("component")) continue;
+        
+        CatalogApp app;
+        if (readComponent(reader, &app)) {
+            source->apps.append(app);
+        }
+    }
+    
+    if (reader.hasError()) {
+        qWarning() << "Appstream data of" << source->remote << "is malformed:" << reader.errorString();
+    }
+}
+
+void AppstreamCatalog::saveSource(const Source &source)
+{
+    const QString path = cacheFile(source);
+    QDir().mkpath(QFileInfo(path).path());
+    
+    // Replaces the old cache only once it is complete
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Cannot write appstream cache:" << file.errorString();
+        return;
+    }
+    
+    QDataStream stream(&file);
+    stream << CACHE_MAGIC << CACHE_VERSION << source.commit << source.apps;
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        qWarning() << "Cannot write appstream cache:" << file.errorString();
+    }
+}
+
+void AppstreamCatalog::cacheIcons(Source *source)
+{
+    const QString directory = iconCacheDirectory(source->installation, source->remote);
+    QDir().mkpath(directory);
+    
+    for (CatalogApp &app : source->apps) {
+        if (app.icon.isEmpty()) continue;
+        
+        const QString cached = directory + "/" + QFileInfo(app.icon).fileName();
+        if (QFileInfo::exists(cached) || QFile::copy(source->directory + "/icons/" + app.icon, cached)) {
+            app.iconFile = cached;
+        }
+    }
+}
+
+QString AppstreamCatalog::cacheFile(const Source &source)
+{
+    return QString("%1/appstream/%2-%3.cache")
+        .arg(QStandardPaths::writableLocation(QStandardPaths::CacheLocation), source.installation, source.remote);
+}
+
+QString AppstreamCatalog::iconCacheDirectory(const QString &installation, const QString &remote)
+{
+    return QString("%1/appstream-icons/%2-%3")
+        .arg(QStandardPaths::writableLocation(QStandardPaths::CacheLocation), installation, remote);
+}
@@ -0,0 +1,90 @@
+#ifndef APPSTREAMCATALOG_H
+#define APPSTREAMCATALOG_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QVector>
+#include <QHash>
+
+struct CatalogApp {
+    QString id;
+    QString name;
+    QString summary;
+    QString developer;
+    QStringList keywords;
+    QStringList categories;
+    QString ref;                // app/<id>/<arch>/<branch>
+    QString remote;
+    QString installation;
+    bool isSystem = true;
+    QString icon;               // relative to the remote's icon directory, e.g. 128x128/<id>.png
+    QString iconFile;           // copy in the icon cache, filled in when the remote is loaded
+};
+
+// Searchable index of the applications each enabled Flatpak remote
+// offers, built from the appstream data flatpak keeps under every
+// installation. A remote is parsed again only when its deployed appstream
+// commit changes; otherwise its index is read back from the cache. Icons
+// are copied into the cache while a remote is loaded in the background, so
+// they outlive the appstream commit they came from. Searching never leaves
+// memory.
+class AppstreamCatalog : public QObject
+{
+    Q_OBJECT
+
+public:
+    static AppstreamCatalog *instance();
+    
+    // Picks up appstream changes for the current remotes in the background
+    void refresh();
+    bool isLoading() const { return m_loading; }
+    int size() const { return m_apps.size(); }
+    
+    QList<CatalogApp> search(const QString &query, int limit = 100) const;
+    const CatalogApp *app(const QString &id) const;
+
+signals:
+    void loaded(int apps, int reparsedRemotes);
+
+private:
+    explicit AppstreamCatalog(QObject *parent = nullptr);
+    
+    struct Source {
+        QString remote;
+        QString installation;
+        bool isSystem = true;
+        QString directory;      // <installation>/appstream/<remote>/<arch>/active
+        QString commit;
+        QVector<CatalogApp> apps;
+    };
+    
+    // Lower-cased copies of the searched fields, kept beside m_apps
+    struct IndexEntry {
+        QString name;
+        QString id;
+        QString keywords;
+        QString summary;
+        QString categories;
+    };
+    
+    static QString installationPath(const QString &installation, bool isSystem);
+    static QString currentCommit(const QString &directory);
+    static bool loadSource(Source *source);
+    static void parseSource(Source *source);
+    static void saveSource(const Source &source);
+    static void cacheIcons(Source *source);
+    static QString cacheFile(const Source &source);
+    static QString iconCacheDirectory(const QString &installation, const QString &remote);
+    void publish(const QVector<Source> &sources, int reparsed);
+    
+    QVector<CatalogApp> m_apps;
+    QVector<IndexEntry> m_index;
+    QHash<QString, int> m_byId;
+    QVector<Source> m_sources;
+    bool m_loading;
+    bool m_loadAgain;
+};
+
+#endif // APPSTREAMCATALOG_H
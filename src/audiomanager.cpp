@@ -1,6 +1,13 @@
 #include "audiomanager.h"
 #include "systemutils.h"
 #include "privilegedexecutor.h"
+#include "pipewiregraph.h"
+#include "easyeffectspresets.h"
+#include "audiostreams.h"
+#include "latencyprofile.h"
+#include "realtimediagnostics.h"
+#include "processrunner.h"
+#include "tracing.h"
 #include <QApplication>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -46,6 +53,9 @@
 #include <QFileInfo>
 #include <QSpinBox>
 #include <QTabWidget>
+#include <QSignalBlocker>
+#include <QSet>
+#include <algorithm>
 
 // AudioDeviceWorker Implementation
 AudioDeviceWorker::AudioDeviceWorker(QObject *parent)
@@ -236,16 +246,84 @@ AudioManager::AudioManager(QWidget *parent)
     : QWidget(parent)
     , m_systemUtils(nullptr)
     , m_privilegedExecutor(nullptr)
+    , m_easyEffectsPresetList(nullptr)
     , m_deviceWorker(nullptr)
+    , m_pipeWireGraphModel(nullptr)
+    , m_pipeWireGraphDialog(nullptr)
+    , m_presetIndex(nullptr)
+    , m_easyEffectsSearchEdit(nullptr)
+    , m_streamMonitor(nullptr)
+    , m_streamTable(nullptr)
+    , m_latencyEngine(nullptr)
+    , m_latencyProfileCombo(nullptr)
+    , m_realtimeDiagnostics(nullptr)
+    , m_diagnosticsDialog(nullptr)
+    , m_diagnosticsTree(nullptr)
     , m_autoRefresh(true)
     , m_refreshInterval(15000) // 15 seconds
     , m_currentAudioSystem("auto")
     , m_masterVolume(50)
     , m_masterMute(false)
     , m_isScanning(false)
+    , m_pendingProbes(0)
 {
+    TraceSpan span("AudioManager::AudioManager");
+    
+    m_presetIndex = new EasyEffectsPresetIndex(this);
+    connect(m_presetIndex, &EasyEffectsPresetIndex::indexChanged, this, &AudioManager::updateEasyEffectsPresetList);
+    
+    m_latencyEngine = new LatencyProfileEngine(this);
+    connect(m_latencyEngine, &LatencyProfileEngine::errorOccurred, this, [this](const QString &error) {
+        m_statusLabel->setText(error);
+    });
+    connect(m_latencyEngine, &LatencyProfileEngine::profileApplied, this,
+            [this](const QString &name, bool needsPipeWireRestart, bool needsWirePlumberRestart) {
+        const LatencyProfile profile = m_latencyEngine->currentProfile();
+        if (m_sampleRateCombo && m_bufferSizeCombo && m_latencyProfileCombo) {
+            QSignalBlocker rateBlocker(m_sampleRateCombo);
+            QSignalBlocker bufferBlocker(m_bufferSizeCombo);
+            QSignalBlocker profileBlocker(m_latencyProfileCombo);
+            m_sampleRateCombo->setCurrentText(QString::number(profile.rate));
+            m_bufferSizeCombo->setCurrentText(QString::number(profile.quantum));
+            if (m_latencyProfileCombo->findText(name) < 0) {
+                m_latencyProfileCombo->addItem(name);
+            }
+            m_latencyProfileCombo->setCurrentText(name);
+        }
+        m_statusLabel->setText(QString("%1 profile applied: %2 Hz, %3 samples (%4 ms)")
+                               .arg(name).arg(profile.rate).arg(profile.quantum)
+                               .arg(profile.quantum * 1000.0 / profile.rate, 0, 'f', 1));
+        
+        if (needsPipeWireRestart || needsWirePlumberRestart) {
+            const QString service = needsPipeWireRestart ? "PipeWire" : "WirePlumber";
+            int ret = QMessageBox::question(this, "Restart Required",
+                                            "The real-time priority or device settings of this profile only take effect after "
+                                            "restarting " + service + ", which briefly interrupts audio.\n\nRestart now?",
+                                            QMessageBox::Yes | QMessageBox::No);
+            if (ret == QMessageBox::Yes) {
+                if (needsPipeWireRestart) {
+                    restartPipeWire();
+                } else {
+                    QProcess::startDetached("systemctl", QStringList() << "--user" << "restart" << "wireplumber.service");
+                }
+            }
+        }
+    });
+    
+    m_streamMonitor = new AudioStreamMonitor(this);
+    connect(m_streamMonitor, &AudioStreamMonitor::streamsChanged, this, &AudioManager::updateStreamTable);
+    connect(m_streamMonitor, &AudioStreamMonitor::endpointsChanged, this, &AudioManager::updateStreamTable);
+    connect(m_streamMonitor, &AudioStreamMonitor::errorOccurred, this, [this](const QString &error) {
+        m_statusLabel->setText("Streams: " + error);
+    });
+    
     setupUI();
     setupContextMenus();
+    probeAudioSystems();
+    
+    // Cached presets show up immediately, the rescan runs in the background
+    m_presetIndex->load();
+    m_streamMonitor->start();
     
     // Initialize refresh timer
     m_refreshTimer = new QTimer(this);
@@ -263,6 +341,10 @@ AudioManager::~AudioManager()
         m_deviceWorker->wait(3000);
         delete m_deviceWorker;
     }
+    
+    if (m_realtimeDiagnostics) {
+        m_realtimeDiagnostics->wait(3000);
+    }
 }
 
 void AudioManager::setSystemUtils(SystemUtils *utils)
@@ -319,12 +401,9 @@ void AudioManager::setupToolbar()
     QLabel *systemLabel = new QLabel("Audio System:");
     m_toolbarLayout->addWidget(systemLabel);
     
+    // The detected systems are added once probeAudioSystems() has heard back
     m_systemComboBox = new QComboBox();
-    QStringList systems = getAvailableAudioSystems();
     m_systemComboBox->addItem("Auto-detect", "auto");
-    for (const QString &system : systems) {
-        m_systemComboBox->addItem(system.toUpper(), system);
-    }
     
     connect(m_systemComboBox, QOverload<const QString&>::of(&QComboBox::currentTextChanged),
             [this](const QString &text) {
@@ -450,41 +529,104 @@ QStringList AudioManager::getAvailableAudioSystems()
 
 bool AudioManager::isPipeWireAvailable()
 {
-    QProcess process;
-    process.start("systemctl", QStringList() << "--user" << "is-active" << "pipewire");
-    process.waitForFinished(1000);
-    return process.exitCode() == 0;
+    return m_audioSystems.value("pipewire");
 }
 
 bool AudioManager::isPulseAudioAvailable()
 {
-    QProcess process;
-    process.start("pulseaudio", QStringList() << "--check");
-    process.waitForFinished(1000);
-    return process.exitCode() == 0;
+    return m_audioSystems.value("pulseaudio");
 }
 
 bool AudioManager::isAlsaAvailable()
 {
-    QProcess process;
-    process.start("aplay", QStringList() << "--version");
-    return process.waitForFinished(3000) && process.exitCode() == 0;
+    return m_audioSystems.value("alsa");
 }
 
 bool AudioManager::isJackAvailable()
 {
-    QProcess process;
-    process.start("jack_control", QStringList() << "status");
-    return process.waitForFinished(3000) && process.exitCode() == 0;
+    return m_audioSystems.value("jack");
 }
 
 bool AudioManager::isEasyEffectsAvailable()
 {
-    // Quick non-blocking check using synchronous call
-    QProcess process;
-    process.start("flatpak", QStringList() << "list" << "--app" << "com.github.wwmm.easyeffects");
-    process.waitForFinished(1000); // Short timeout
-    return process.exitCode() == 0;
+    return m_audioSystems.value("easyeffects");
+}
+
+void AudioManager::probeAudioSystems()
+{
+    if (m_pendingProbes > 0) return;
+    
+    struct Probe {
+        const char *system;
+        const char *program;
+        QStringList arguments;
+        int timeoutMs;
+    };
+    const QList<Probe> probes = {
+        {"pipewire", "systemctl", {"--user", "is-active", "pipewire"}, 1000},
+        {"pulseaudio", "pulseaudio", {"--check"}, 1000},
+        {"alsa", "aplay", {"--version"}, 3000},
+        {"jack", "jack_control", {"status"}, 3000},
+        {"easyeffects", "flatpak", {"list", "--app", "com.github.wwmm.easyeffects"}, 1000},
+    };
+    
+    // All at once, so the slowest probe is the whole wait, and none of it on the event loop
+    m_pendingProbes = probes.size();
+    for (const Probe &probe : probes) {
+        const QString system = probe.system;
+        ProcessRunner::instance()->run(probe.program, probe.arguments, probe.timeoutMs)
+            .then(this, [this, system](const ProcessResult &result) {
+            m_audioSystems.insert(system, result.success());
+            if (--m_pendingProbes == 0) {
+                onAudioSystemsProbed();
+            }
+        });
+    }
+}
+
+void AudioManager::onAudioSystemsProbed()
+{
+    {
+        QSignalBlocker blocker(m_systemComboBox);
+        while (m_systemComboBox->count() > 1) {
+            m_systemComboBox->removeItem(1);
+        }
+        for (const QString &system : getAvailableAudioSystems()) {
+            m_systemComboBox->addItem(system.toUpper(), system);
+        }
+    }
+    
+    // Update button states based on EasyEffects availability
+    bool available = isEasyEffectsAvailable();
+    m_startEasyEffectsButton->setEnabled(available);
+    m_stopEasyEffectsButton->setEnabled(available);
+    m_autostartEasyEffectsButton->setEnabled(available);
+    m_loadEasyEffectsPresetButton->setEnabled(available);
+    m_saveEasyEffectsPresetButton->setEnabled(available);
+    m_deleteEasyEffectsPresetButton->setEnabled(available);
+    m_refreshEasyEffectsButton->setEnabled(available);
+    
+    if (!available) {
+        m_easyEffectsInfoLabel->setText("EasyEffects is not installed. Click 'Install EasyEffects' to install it.");
+        m_easyEffectsInfoLabel->setStyleSheet("color: #cc6600; margin-bottom: 8px;");
+    }
+    
+    // Update button states based on PipeWire availability
+    available = isPipeWireAvailable();
+    m_startPipeWireButton->setEnabled(available);
+    m_stopPipeWireButton->setEnabled(available);
+    m_restartPipeWireButton->setEnabled(available);
+    m_autostartPipeWireButton->setEnabled(available);
+    m_graphPipeWireButton->setEnabled(available);
+    m_optimizeLatencyButton->setEnabled(available);
+    m_optimizeQualityButton->setEnabled(available);
+    m_refreshPipeWireButton->setEnabled(available);
+    
+    if (!available) {
+        m_pipeWireInfoLabel->setText("PipeWire is not installed. Click 'Install PipeWire' to install it.");
+        m_pipeWireInfoLabel->setStyleSheet("color: #cc6600; margin-bottom: 8px;");
+        m_pipeWireInfoText->setText("PipeWire not available");
+    }
 }
 
 void AudioManager::updateTheme()
@@ -787,10 +929,10 @@ void AudioManager::setupEasyEffectsTab()
     m_easyEffectsLayout->setSpacing(8);
     
     // Info label
-    QLabel *infoLabel = new QLabel("EasyEffects provides professional audio processing for PipeWire.");
-    infoLabel->setWordWrap(true);
-    infoLabel->setStyleSheet("color: #666; margin-bottom: 8px;");
-    m_easyEffectsLayout->addWidget(infoLabel);
+    m_easyEffectsInfoLabel = new QLabel("EasyEffects provides professional audio processing for PipeWire.");
+    m_easyEffectsInfoLabel->setWordWrap(true);
+    m_easyEffectsInfoLabel->setStyleSheet("color: #666; margin-bottom: 8px;");
+    m_easyEffectsLayout->addWidget(m_easyEffectsInfoLabel);
     
     // EasyEffects preset list
     m_easyEffectsPresetList = new QListWidget();
@@ -840,21 +982,6 @@ void AudioManager::setupEasyEffectsTab()
     
     m_easyEffectsLayout->addLayout(m_easyEffectsButtonLayout);
     
-    // Update button states based on EasyEffects availability
-    bool available = isEasyEffectsAvailable();
-    m_startEasyEffectsButton->setEnabled(available);
-    m_stopEasyEffectsButton->setEnabled(available);
-    m_autostartEasyEffectsButton->setEnabled(available);
-    m_loadEasyEffectsPresetButton->setEnabled(available);
-    m_saveEasyEffectsPresetButton->setEnabled(available);
-    m_deleteEasyEffectsPresetButton->setEnabled(available);
-    m_refreshEasyEffectsButton->setEnabled(available);
-    
-    if (!available) {
-        infoLabel->setText("EasyEffects is not installed. Click 'Install EasyEffects' to install it.");
-        infoLabel->setStyleSheet("color: #cc6600; margin-bottom: 8px;");
-    }
-    
     m_tabWidget->addTab(m_easyEffectsTab, "EasyEffects");
 }
 
@@ -866,10 +993,10 @@ void AudioManager::setupPipeWireTab()
     m_pipeWireLayout->setSpacing(8);
     
     // Info label
-    QLabel *infoLabel = new QLabel("PipeWire is a modern audio/video server for Linux.");
-    infoLabel->setWordWrap(true);
-    infoLabel->setStyleSheet("color: #666; margin-bottom: 8px;");
-    m_pipeWireLayout->addWidget(infoLabel);
+    m_pipeWireInfoLabel = new QLabel("PipeWire is a modern audio/video server for Linux.");
+    m_pipeWireInfoLabel->setWordWrap(true);
+    m_pipeWireInfoLabel->setStyleSheet("color: #666; margin-bottom: 8px;");
+    m_pipeWireLayout->addWidget(m_pipeWireInfoLabel);
     
     // PipeWire info text
     m_pipeWireInfoText = new QTextEdit();
@@ -922,23 +1049,6 @@ void AudioManager::setupPipeWireTab()
     
     m_pipeWireLayout->addLayout(m_pipeWireButtonLayout);
     
-    // Update button states based on PipeWire availability
-    bool available = isPipeWireAvailable();
-    m_startPipeWireButton->setEnabled(available);
-    m_stopPipeWireButton->setEnabled(available);
-    m_restartPipeWireButton->setEnabled(available);
-    m_autostartPipeWireButton->setEnabled(available);
-    m_graphPipeWireButton->setEnabled(available);
-    m_optimizeLatencyButton->setEnabled(available);
-    m_optimizeQualityButton->setEnabled(available);
-    m_refreshPipeWireButton->setEnabled(available);
-    
-    if (!available) {
-        infoLabel->setText("PipeWire is not installed. Click 'Install PipeWire' to install it.");
-        infoLabel->setStyleSheet("color: #cc6600; margin-bottom: 8px;");
-        m_pipeWireInfoText->setText("PipeWire not available");
-    }
-    
     m_tabWidget->addTab(m_pipeWireTab, "PipeWire");
 }
 
@@ -1084,19 +1194,16 @@ void AudioManager::refreshDevices()
     
     // Scan PulseAudio devices asynchronously
     if (isPulseAudioAvailable()) {
-        QProcess *process = new QProcess(this);
-        connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-                this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-            if (exitCode == 0) {
-                QString output = process->readAllStandardOutput();
+        ProcessRunner::instance()->run("pactl", QStringList() << "list" << "sinks")
+            .then(this, [this](const ProcessResult &result) {
+            if (result.success()) {
+                QString output = result.output();
                 parsePulseAudioDevices(output);
             }
-            process->deleteLater();
             
             // Continue with PipeWire scan
             scanPipeWireDevicesAsync();
         });
-        process->start("pactl", QStringList() << "list" << "sinks");
     } else {
         // Skip to PipeWire if PulseAudio not available
         scanPipeWireDevicesAsync();
@@ -1106,17 +1213,14 @@ void AudioManager::refreshDevices()
 void AudioManager::scanPipeWireDevicesAsync()
 {
     if (isPipeWireAvailable()) {
-        QProcess *process = new QProcess(this);
-        connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-                this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-            if (exitCode == 0) {
-                QString output = process->readAllStandardOutput();
+        ProcessRunner::instance()->run("pw-cli", QStringList() << "list-objects")
+            .then(this, [this](const ProcessResult &result) {
+            if (result.success()) {
+                QString output = result.output();
                 parsePipeWireDevices(output);
             }
-            process->deleteLater();
             finishDeviceScan();
         });
-        process->start("pw-cli", QStringList() << "list-objects");
     } else {
         finishDeviceScan();
     }
@@ -1206,13 +1310,10 @@ void AudioManager::refreshProfiles()
     QTimer::singleShot(0, this, [this]() {
         // Load PulseAudio profiles
         if (isPulseAudioAvailable()) {
-            QProcess *process = new QProcess(this);
-            process->start("pactl", QStringList() << "list" << "cards");
-            
-            connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-                    this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-                if (exitCode == 0) {
-                    QString output = process->readAllStandardOutput();
+            ProcessRunner::instance()->run("pactl", QStringList() << "list" << "cards")
+                .then(this, [this](const ProcessResult &result) {
+                if (result.success()) {
+                    QString output = result.output();
                     QStringList lines = output.split('\n');
                     
                     for (const QString &line : lines) {
@@ -1232,19 +1333,15 @@ void AudioManager::refreshProfiles()
                         }
                     }
                 }
-                process->deleteLater();
             });
         }
         
         // Load PipeWire profiles
         if (isPipeWireAvailable()) {
-            QProcess *process = new QProcess(this);
-            process->start("pw-cli", QStringList() << "list-objects");
-            
-            connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-                    this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-                if (exitCode == 0) {
-                    QString output = process->readAllStandardOutput();
+            ProcessRunner::instance()->run("pw-cli", QStringList() << "list-objects")
+                .then(this, [this](const ProcessResult &result) {
+                if (result.success()) {
+                    QString output = result.output();
                     // Parse PipeWire output for profiles
                     if (output.contains("Node") && m_profileTable) {
                         QStringList profiles = {"PipeWire Default", "Pro Audio", "Analog Stereo"};
@@ -1257,7 +1354,6 @@ void AudioManager::refreshProfiles()
                         }
                     }
                 }
-                process->deleteLater();
             });
         }
         
@@ -1280,58 +1376,10 @@ void AudioManager::refreshProfiles()
 
 void AudioManager::refreshEasyEffectsPresets()
 {
-    if (!isEasyEffectsAvailable()) return;
-    
-    m_statusLabel->setText("Loading EasyEffects presets...");
+    if (!m_presetIndex) return;
     
-    // Clear existing presets
-    if (m_easyEffectsPresetList) {
-        m_easyEffectsPresetList->clear();
-    }
-    
-    // Load presets asynchronously to avoid blocking UI
-    QTimer::singleShot(0, this, [this]() {
-        // Load EasyEffects presets from Flatpak user data directory
-        QString presetsDir = QDir::homePath() + "/.var/app/com.github.wwmm.easyeffects/config/easyeffects/output";
-        QDir dir(presetsDir);
-        
-        if (dir.exists()) {
-            QStringList presetFiles = dir.entryList(QStringList() << "*.json", QDir::Files);
-            
-            for (const QString &fileName : presetFiles) {
-                QString presetName = QFileInfo(fileName).baseName();
-                if (m_easyEffectsPresetList) {
-                    m_easyEffectsPresetList->addItem(presetName);
-                }
-            }
-        }
-        
-        // Also check the system presets directory
-        QString systemPresetsDir = QDir::homePath() + "/.var/app/com.github.wwmm.easyeffects/data/easyeffects/presets";
-        QDir systemDir(systemPresetsDir);
-        
-        if (systemDir.exists()) {
-            QStringList systemPresetFiles = systemDir.entryList(QStringList() << "*.json", QDir::Files);
-            
-            for (const QString &fileName : systemPresetFiles) {
-                QString presetName = QFileInfo(fileName).baseName();
-                if (m_easyEffectsPresetList) {
-                    m_easyEffectsPresetList->addItem(presetName + " (System)");
-                }
-            }
-        }
-        
-        // Add default presets if none found
-        if (m_easyEffectsPresetList && m_easyEffectsPresetList->count() == 0) {
-            m_easyEffectsPresetList->addItem("Default");
-            m_easyEffectsPresetList->addItem("Music");
-            m_easyEffectsPresetList->addItem("Voice");
-            m_easyEffectsPresetList->addItem("Gaming");
-            m_easyEffectsPresetList->addItem("Studio");
-        }
-        
-        m_statusLabel->setText("Ready");
-    });
+    // Only files whose size or mtime changed are re-read
+    m_presetIndex->rescan();
 }
 
 void AudioManager::refreshPipeWireInfo()
@@ -1340,14 +1388,13 @@ void AudioManager::refreshPipeWireInfo()
     
     m_statusLabel->setText("Loading PipeWire information...");
     
-    QProcess process;
-    process.start("pw-cli", QStringList() << "info");
-    if (process.waitForFinished(5000)) {
-        QString output = process.readAllStandardOutput();
-        m_pipeWireInfoText->setPlainText(output);
-    }
-    
-    m_statusLabel->setText("Ready");
+    ProcessRunner::instance()->run("pw-cli", QStringList() << "info", 5000)
+        .then(this, [this](const ProcessResult &result) {
+        if (!result.timedOut) {
+            m_pipeWireInfoText->setPlainText(result.output());
+        }
+        m_statusLabel->setText("Ready");
+    });
 }
 
 void AudioManager::searchDevices()
@@ -1847,36 +1894,23 @@ void AudioManager::installEasyEffects()
 
 void AudioManager::startEasyEffects() 
 {
-    showProgress("Starting", "Starting EasyEffects...");
-    
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-        hideProgress();
-        if (exitCode == 0) {
-            showSuccess("EasyEffects", "EasyEffects started successfully!");
-        } else {
-            showError("Start Failed", "Failed to start EasyEffects");
-        }
-        process->deleteLater();
-    });
-    
-    process->start("flatpak", QStringList() << "run" << "com.github.wwmm.easyeffects" << "--gapplication-service");
+    // The service keeps running, so there is no exit to wait for
+    if (QProcess::startDetached("flatpak", QStringList() << "run" << "com.github.wwmm.easyeffects" << "--gapplication-service")) {
+        showSuccess("EasyEffects", "EasyEffects started successfully!");
+    } else {
+        showError("Start Failed", "Failed to start EasyEffects");
+    }
 }
 
 void AudioManager::stopEasyEffects() 
 {
     showProgress("Stopping", "Stopping EasyEffects...");
     
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
+    ProcessRunner::instance()->run("flatpak", QStringList() << "kill" << "com.github.wwmm.easyeffects")
+        .then(this, [this](const ProcessResult &) {
         hideProgress();
         showSuccess("EasyEffects", "EasyEffects stopped");
-        process->deleteLater();
     });
-    
-    process->start("flatpak", QStringList() << "kill" << "com.github.wwmm.easyeffects");
 }
 
 void AudioManager::loadEasyEffectsPreset() 
@@ -1886,23 +1920,79 @@ void AudioManager::loadEasyEffectsPreset()
         return;
     }
     
-    QString preset = m_easyEffectsPresetList->currentItem()->text();
+    const EasyEffectsPreset preset = m_presetIndex->preset(m_easyEffectsPresetList->currentItem()->data(Qt::UserRole).toString());
+    if (preset.path.isEmpty()) {
+        showError("Load Failed", "Preset is no longer available");
+        return;
+    }
+    
+    QStringList command = EasyEffectsPresetIndex::applyCommand(preset);
+    const QString program = command.takeFirst();
     
-    showProgress("Loading", "Loading EasyEffects preset: " + preset);
+    showProgress("Loading", "Loading EasyEffects preset: " + preset.name);
     
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process, preset](int exitCode, QProcess::ExitStatus exitStatus) {
+    // With no EasyEffects running yet, this one becomes it and stays
+    ProcessRunner::instance()->run(program, command, 0)
+        .then(this, [this, preset](const ProcessResult &result) {
         hideProgress();
-        if (exitCode == 0) {
-            showSuccess("Preset Loaded", "Successfully loaded preset: " + preset);
+        if (result.success()) {
+            showSuccess("Preset Loaded", "Successfully loaded preset: " + preset.name);
         } else {
-            showError("Load Failed", "Failed to load preset: " + preset);
+            showError("Load Failed", "Failed to load preset: " + preset.name);
         }
-        process->deleteLater();
     });
+}
+
+void AudioManager::loadEasyEffectsPresetByName(const QString &presetName)
+{
+    if (!m_easyEffectsPresetList || !m_presetIndex) return;
     
-    process->start("flatpak", QStringList() << "run" << "com.github.wwmm.easyeffects" << "--load-preset" << preset);
+    const QList<EasyEffectsPreset> presets = m_presetIndex->presets();
+    for (const EasyEffectsPreset &preset : presets) {
+        if (preset.name != presetName) continue;
+        
+        for (int i = 0; i < m_easyEffectsPresetList->count(); ++i) {
+            QListWidgetItem *item = m_easyEffectsPresetList->item(i);
+            if (item->data(Qt::UserRole).toString() == preset.path) {
+                m_easyEffectsPresetList->setCurrentItem(item);
+                loadEasyEffectsPreset();
+                return;
+            }
+        }
+    }
+    
+    showError("Load Failed", "Preset not found: " + presetName);
+}
+
+void AudioManager::compareEasyEffectsPresets()
+{
+    const QList<QListWidgetItem*> selected = m_easyEffectsPresetList ? m_easyEffectsPresetList->selectedItems()
+                                                                      : QList<QListWidgetItem*>();
+    if (selected.size() != 2) {
+        showError("Compare Presets", "Select exactly two presets to compare");
+        return;
+    }
+    
+    const EasyEffectsPreset first = m_presetIndex->preset(selected.at(0)->data(Qt::UserRole).toString());
+    const EasyEffectsPreset second = m_presetIndex->preset(selected.at(1)->data(Qt::UserRole).toString());
+    const QStringList differences = EasyEffectsPresetIndex::diff(first, second);
+    
+    QDialog dialog(this);
+    dialog.setWindowTitle(QString("Compare: %1 / %2").arg(first.name, second.name));
+    dialog.resize(640, 480);
+    
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+    QTextEdit *textEdit = new QTextEdit();
+    textEdit->setReadOnly(true);
+    textEdit->setFontFamily("monospace");
+    textEdit->setPlainText(differences.isEmpty() ? "The presets are identical." : differences.join("\n"));
+    layout->addWidget(textEdit);
+    
+    QPushButton *closeButton = new QPushButton("Close");
+    connect(closeButton, &QPushButton::clicked, &dialog, &QDialog::accept);
+    layout->addWidget(closeButton, 0, Qt::AlignRight);
+    
+    dialog.exec();
 }
 
 void AudioManager::installPipeWire() 
@@ -1931,46 +2021,37 @@ void AudioManager::startPipeWire()
 {
     showProgress("Starting", "Starting PipeWire service...");
     
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
+    ProcessRunner::instance()->run("systemctl", QStringList() << "--user" << "enable" << "--now" << "pipewire.service")
+        .then(this, [this](const ProcessResult &result) {
         hideProgress();
-        if (exitCode == 0) {
+        if (result.success()) {
             showSuccess("PipeWire", "PipeWire started successfully!");
             refreshDevices();
         } else {
             showError("Start Failed", "Failed to start PipeWire");
         }
-        process->deleteLater();
     });
-    
-    process->start("systemctl", QStringList() << "--user" << "enable" << "--now" << "pipewire.service");
 }
 
 void AudioManager::stopPipeWire() 
 {
     showProgress("Stopping", "Stopping PipeWire service...");
     
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
+    ProcessRunner::instance()->run("systemctl", QStringList() << "--user" << "stop" << "pipewire.service")
+        .then(this, [this](const ProcessResult &) {
         hideProgress();
         showSuccess("PipeWire", "PipeWire stopped");
         refreshDevices();
-        process->deleteLater();
     });
-    
-    process->start("systemctl", QStringList() << "--user" << "stop" << "pipewire.service");
 }
 
 void AudioManager::restartPipeWire() 
 {
     m_statusLabel->setText("Restarting PipeWire service...");
     
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-        if (exitCode == 0) {
+    ProcessRunner::instance()->run("systemctl", QStringList() << "--user" << "restart" << "pipewire.service")
+        .then(this, [this](const ProcessResult &result) {
+        if (result.success()) {
             m_statusLabel->setText("PipeWire restarted successfully!");
         } else {
             m_statusLabel->setText("Failed to restart PipeWire");
@@ -1980,138 +2061,270 @@ void AudioManager::restartPipeWire()
                 m_statusLabel->setText("Ready"); 
             }
         });
-        process->deleteLater();
     });
-    
-    process->start("systemctl", QStringList() << "--user" << "restart" << "pipewire.service");
 }
 
 void AudioManager::testAudioDevices() 
 {
     showProgress("Testing", "Testing audio devices...");
     
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
+    ProcessRunner::instance()->run("speaker-test", QStringList() << "-t" << "wav" << "-c" << "2" << "-l" << "1")
+        .then(this, [this](const ProcessResult &result) {
         hideProgress();
-        if (exitCode == 0) {
+        if (result.success()) {
             showSuccess("Audio Test", "Audio test completed successfully!");
         } else {
             showError("Test Failed", "Audio test failed");
         }
-        process->deleteLater();
     });
-    
-    process->start("speaker-test", QStringList() << "-t" << "wav" << "-c" << "2" << "-l" << "1");
 }
 
 void AudioManager::showPipeWireGraph() 
 {
-    showProgress("Loading", "Opening PipeWire graph...");
+    if (!m_pipeWireGraphDialog) {
+        m_pipeWireGraphModel = new PipeWireGraphModel(this);
+        
+        m_pipeWireGraphDialog = new QDialog(this);
+        m_pipeWireGraphDialog->setWindowTitle("PipeWire Graph");
+        m_pipeWireGraphDialog->resize(1000, 650);
+        
+        QVBoxLayout *layout = new QVBoxLayout(m_pipeWireGraphDialog);
+        
+        QLabel *hintLabel = new QLabel("Drag from an output port to an input port to connect. "
+                                       "Drag a connected input away to disconnect, or double-click a link.");
+        hintLabel->setWordWrap(true);
+        hintLabel->setStyleSheet("color: #666;");
+        layout->addWidget(hintLabel);
+        
+        PipeWireGraphView *graphView = new PipeWireGraphView(m_pipeWireGraphModel);
+        layout->addWidget(graphView);
+        
+        QHBoxLayout *buttonLayout = new QHBoxLayout();
+        QPushButton *arrangeButton = new QPushButton("Auto Arrange");
+        connect(arrangeButton, &QPushButton::clicked, graphView, &PipeWireGraphView::relayoutAll);
+        buttonLayout->addWidget(arrangeButton);
+        
+        QPushButton *externalButton = new QPushButton("Open in qpwgraph");
+        connect(externalButton, &QPushButton::clicked, this, [this]() {
+            if (!QProcess::startDetached("qpwgraph") && !QProcess::startDetached("helvum")) {
+                showError("Graph Failed", "Failed to open PipeWire graph. Try installing qpwgraph or helvum.");
+            }
+        });
+        buttonLayout->addWidget(externalButton);
+        buttonLayout->addStretch();
+        
+        QPushButton *closeButton = new QPushButton("Close");
+        connect(closeButton, &QPushButton::clicked, m_pipeWireGraphDialog, &QDialog::close);
+        buttonLayout->addWidget(closeButton);
+        layout->addLayout(buttonLayout);
+        
+        connect(graphView, &PipeWireGraphView::linkRequested, this, [this](quint32 outputPort, quint32 inputPort) {
+            linkPipeWirePorts(QString::number(outputPort), QString::number(inputPort));
+        });
+        connect(graphView, &PipeWireGraphView::unlinkRequested, this, [this](quint32 linkId) {
+            const PipeWireLink link = m_pipeWireGraphModel->links().value(linkId);
+            if (link.id != 0) {
+                unlinkPipeWirePorts(QString::number(link.outputPortId), QString::number(link.inputPortId));
+            }
+        });
+        connect(m_pipeWireGraphModel, &PipeWireGraphModel::errorOccurred, this, [this](const QString &error) {
+            m_statusLabel->setText(error);
+        });
+        
+        // Only keep the registry monitor alive while the graph is on screen
+        connect(m_pipeWireGraphDialog, &QDialog::finished, m_pipeWireGraphModel, &PipeWireGraphModel::stop);
+    }
     
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-        hideProgress();
-        if (exitCode == 0) {
-            showSuccess("Graph", "PipeWire graph opened successfully!");
-        } else {
-            showError("Graph Failed", "Failed to open PipeWire graph. Try installing qpwgraph or helvum.");
-        }
-        process->deleteLater();
-    });
+    m_pipeWireGraphModel->start();
+    m_pipeWireGraphDialog->show();
+    m_pipeWireGraphDialog->raise();
+    m_pipeWireGraphDialog->activateWindow();
+}
+
+void AudioManager::showRealtimeDiagnostics()
+{
+    if (!m_diagnosticsDialog) {
+        m_realtimeDiagnostics = new RealtimeDiagnostics(this);
+        connect(m_realtimeDiagnostics, &QThread::finished, this, &AudioManager::updateRealtimeDiagnostics);
+        
+        m_diagnosticsDialog = new QDialog(this);
+        m_diagnosticsDialog->setWindowTitle("Real-time Audio Diagnostics");
+        m_diagnosticsDialog->resize(800, 480);
+        
+        QVBoxLayout *layout = new QVBoxLayout(m_diagnosticsDialog);
+        
+        m_diagnosticsTree = new QTreeWidget();
+        m_diagnosticsTree->setHeaderLabels(QStringList() << "Status" << "Check" << "Details");
+        m_diagnosticsTree->setRootIsDecorated(false);
+        m_diagnosticsTree->setWordWrap(true);
+        m_diagnosticsTree->setAlternatingRowColors(true);
+        m_diagnosticsTree->header()->setSectionResizeMode(2, QHeaderView::Stretch);
+        layout->addWidget(m_diagnosticsTree);
+        
+        QHBoxLayout *buttonLayout = new QHBoxLayout();
+        
+        QPushButton *fixButton = new QPushButton("Apply Fix");
+        fixButton->setEnabled(false);
+        connect(fixButton, &QPushButton::clicked, this, &AudioManager::applyRealtimeFix);
+        connect(m_diagnosticsTree, &QTreeWidget::currentItemChanged, fixButton, [fixButton](QTreeWidgetItem *current) {
+            fixButton->setEnabled(current && !current->data(0, Qt::UserRole).toString().isEmpty());
+        });
+        buttonLayout->addWidget(fixButton);
+        
+        QPushButton *rerunButton = new QPushButton("Run Again");
+        connect(rerunButton, &QPushButton::clicked, this, [this]() {
+            if (!m_realtimeDiagnostics->isRunning()) {
+                m_realtimeDiagnostics->start();
+            }
+        });
+        buttonLayout->addWidget(rerunButton);
+        
+        buttonLayout->addStretch();
+        
+        QPushButton *closeButton = new QPushButton("Close");
+        connect(closeButton, &QPushButton::clicked, m_diagnosticsDialog, &QDialog::close);
+        buttonLayout->addWidget(closeButton);
+        
+        layout->addLayout(buttonLayout);
+    }
     
-    // Try qpwgraph first, then helvum as fallback
-    process->start("qpwgraph");
+    if (!m_realtimeDiagnostics->isRunning()) {
+        m_statusLabel->setText("Running real-time diagnostics...");
+        m_realtimeDiagnostics->start();
+    }
     
-    QTimer::singleShot(2000, this, [this, process]() {
-        if (process->state() == QProcess::NotRunning && process->exitCode() != 0) {
-            // qpwgraph failed, try helvum
-            process->start("helvum");
-        }
-    });
+    m_diagnosticsDialog->show();
+    m_diagnosticsDialog->raise();
+    m_diagnosticsDialog->activateWindow();
 }
 
-void AudioManager::showAudioAnalyzer() 
+void AudioManager::updateRealtimeDiagnostics()
 {
-    showProgress("Loading", "Opening audio analyzer...");
+    const QList<RealtimeFinding> findings = m_realtimeDiagnostics->findings();
     
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-        hideProgress();
-        if (exitCode == 0) {
-            showSuccess("Analyzer", "Audio analyzer opened successfully!");
-        } else {
-            showError("Analyzer Failed", "Failed to open audio analyzer. Try installing pavucontrol.");
+    m_diagnosticsTree->clear();
+    int problems = 0;
+    for (const RealtimeFinding &finding : findings) {
+        QTreeWidgetItem *item = new QTreeWidgetItem(m_diagnosticsTree);
+        item->setText(0, RealtimeDiagnostics::severityName(finding.severity));
+        item->setText(1, finding.title);
+        item->setText(2, finding.fixDescription.isEmpty() ? finding.detail
+                                                          : finding.detail + "\nFix: " + finding.fixDescription);
+        item->setData(0, Qt::UserRole, finding.fixScript);
+        item->setData(0, Qt::UserRole + 1, finding.fixDescription);
+        
+        switch (finding.severity) {
+        case RealtimeFinding::Ok:
+            item->setIcon(0, style()->standardIcon(QStyle::SP_DialogApplyButton));
+            break;
+        case RealtimeFinding::Info:
+            item->setIcon(0, style()->standardIcon(QStyle::SP_MessageBoxInformation));
+            break;
+        case RealtimeFinding::Warning:
+            item->setIcon(0, style()->standardIcon(QStyle::SP_MessageBoxWarning));
+            ++problems;
+            break;
+        case RealtimeFinding::Critical:
+            item->setIcon(0, style()->standardIcon(QStyle::SP_MessageBoxCritical));
+            ++problems;
+            break;
         }
-        process->deleteLater();
-    });
+    }
+    m_diagnosticsTree->resizeColumnToContents(0);
+    m_diagnosticsTree->resizeColumnToContents(1);
     
-    process->start("pavucontrol");
+    m_statusLabel->setText(problems == 0 ? "Real-time diagnostics: no problems found"
+                                         : QString("Real-time diagnostics: %1 problem(s) found").arg(problems));
 }
 
-void AudioManager::optimizeForLatency() 
+void AudioManager::applyRealtimeFix()
 {
-    showProgress("Optimizing", "Optimizing audio for low latency...");
+    QTreeWidgetItem *item = m_diagnosticsTree ? m_diagnosticsTree->currentItem() : nullptr;
+    if (!item || !m_privilegedExecutor) return;
     
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-        hideProgress();
-        if (exitCode == 0) {
-            showSuccess("Optimization", "Audio optimized for low latency!");
-            refreshDevices();
-        } else {
-            showError("Optimization Failed", "Failed to optimize for latency");
-        }
-        process->deleteLater();
-    });
+    const QString script = item->data(0, Qt::UserRole).toString();
+    const QString description = item->data(0, Qt::UserRole + 1).toString();
+    if (script.isEmpty()) return;
+    
+    int ret = QMessageBox::question(this, "Apply Fix",
+                                    description + "\n\nThe following will be run as root:\n" + script,
+                                    QMessageBox::Yes | QMessageBox::No);
+    if (ret != QMessageBox::Yes) {
+        return;
+    }
     
-    // Restart PipeWire with optimized settings
-    process->start("systemctl", QStringList() << "--user" << "restart" << "pipewire.service");
+    showProgress("Applying", description + "...");
+    m_privilegedExecutor->executeCommandAsync("sh", QStringList() << "-c" << script, description,
+                                              this, "onRealtimeFixFinished", "onRealtimeFixFailed");
 }
 
-void AudioManager::optimizeForQuality() 
+void AudioManager::onRealtimeFixFinished(const QString &output)
 {
-    showProgress("Optimizing", "Optimizing audio for high quality...");
+    Q_UNUSED(output);
+    hideProgress();
+    m_statusLabel->setText("Fix applied");
     
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-        hideProgress();
-        if (exitCode == 0) {
-            showSuccess("Optimization", "Audio optimized for high quality!");
-            refreshDevices();
-        } else {
-            showError("Optimization Failed", "Failed to optimize for quality");
+    if (m_realtimeDiagnostics && !m_realtimeDiagnostics->isRunning()) {
+        m_realtimeDiagnostics->start();
+    }
+}
+
+void AudioManager::onRealtimeFixFailed(const QString &error)
+{
+    hideProgress();
+    showError("Fix Failed", error);
+}
+
+void AudioManager::linkPipeWirePorts(const QString &outputPort, const QString &inputPort)
+{
+    ProcessRunner::instance()->run("pw-link", QStringList() << outputPort << inputPort)
+        .then(this, [this, outputPort, inputPort](const ProcessResult &result) {
+        if (!result.success()) {
+            m_statusLabel->setText(QString("Failed to link %1 to %2: %3")
+                                   .arg(outputPort, inputPort, QString::fromUtf8(result.standardError).trimmed()));
         }
-        process->deleteLater();
     });
-    
-    // Restart PipeWire with quality settings
-    process->start("systemctl", QStringList() << "--user" << "restart" << "pipewire.service");
 }
 
-void AudioManager::optimizeForPowerSaving() 
+void AudioManager::unlinkPipeWirePorts(const QString &outputPort, const QString &inputPort)
 {
-    showProgress("Optimizing", "Optimizing audio for power saving...");
-    
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-        hideProgress();
-        if (exitCode == 0) {
-            showSuccess("Optimization", "Audio optimized for power saving!");
-            refreshDevices();
-        } else {
-            showError("Optimization Failed", "Failed to optimize for power saving");
+    ProcessRunner::instance()->run("pw-link", QStringList() << "-d" << outputPort << inputPort)
+        .then(this, [this, outputPort, inputPort](const ProcessResult &result) {
+        if (!result.success()) {
+            m_statusLabel->setText(QString("Failed to unlink %1 from %2: %3")
+                                   .arg(outputPort, inputPort, QString::fromUtf8(result.standardError).trimmed()));
         }
-        process->deleteLater();
     });
-    
-    // Restart PipeWire with power saving settings
-    process->start("systemctl", QStringList() << "--user" << "restart" << "pipewire.service");
+}
+
+void AudioManager::showAudioAnalyzer() 
+{
+    if (QProcess::startDetached("pavucontrol")) {
+        showSuccess("Analyzer", "Audio analyzer opened successfully!");
+    } else {
+        showError("Analyzer Failed", "Failed to open audio analyzer. Try installing pavucontrol.");
+    }
+}
+
+void AudioManager::optimizeForLatency() 
+{
+    applyLatencyProfile("Low Latency");
+}
+
+void AudioManager::optimizeForQuality() 
+{
+    applyLatencyProfile("High Quality");
+}
+
+void AudioManager::optimizeForPowerSaving() 
+{
+    applyLatencyProfile("Power Saving");
+}
+
+void AudioManager::applyLatencyProfile(const QString &profileName)
+{
+    // Clock changes go live through PipeWire metadata, no service restart
+    m_latencyEngine->applyProfile(LatencyProfile::builtin(profileName));
 }
 
 void AudioManager::calibrateAudioLevels() 
@@ -2533,9 +2746,191 @@ void AudioManager::updateEffectTable()
 
 void AudioManager::updateEasyEffectsPresetList() 
 {
+    if (!m_easyEffectsPresetList || !m_presetIndex) return;
+    
+    const QString query = m_easyEffectsSearchEdit ? m_easyEffectsSearchEdit->text() : QString();
+    const QList<EasyEffectsPreset> presets = m_presetIndex->search(query);
+    
+    // Keep the selection across index updates
+    QString selectedPath;
+    if (m_easyEffectsPresetList->currentItem()) {
+        selectedPath = m_easyEffectsPresetList->currentItem()->data(Qt::UserRole).toString();
+    }
+    
+    m_easyEffectsPresetList->setUpdatesEnabled(false);
+    m_easyEffectsPresetList->clear();
+    for (const EasyEffectsPreset &preset : presets) {
+        QString label = preset.name;
+        if (preset.type == "input") {
+            label += " (Input)";
+        }
+        if (preset.source != "Native") {
+            label += " [" + preset.source + "]";
+        }
+        
+        QListWidgetItem *item = new QListWidgetItem(label);
+        item->setData(Qt::UserRole, preset.path);
+        item->setToolTip(preset.plugins.isEmpty() ? preset.path
+                                                  : preset.plugins.join(" > ") + "\n" + preset.path);
+        m_easyEffectsPresetList->addItem(item);
+        
+        if (preset.path == selectedPath) {
+            m_easyEffectsPresetList->setCurrentItem(item);
+        }
+    }
+    m_easyEffectsPresetList->setUpdatesEnabled(true);
+    
     updateInfoPanel();
 }
 
+void AudioManager::updateStreamTable()
+{
+    if (!m_streamTable || !m_streamMonitor) return;
+    
+    // Don't rebuild under an open device popup
+    for (QComboBox *combo : m_streamTable->findChildren<QComboBox*>()) {
+        if (combo->view()->isVisible()) {
+            QTimer::singleShot(500, this, &AudioManager::updateStreamTable);
+            return;
+        }
+    }
+    
+    // Rows are keyed by stream and updated in place, so they keep their
+    // device combo and the selection follows the stream, not the row number
+    auto streamKey = [](quint32 index, bool isInput) {
+        return (quint64(index) << 1) | (isInput ? 1 : 0);
+    };
+    const QList<AudioStream> streams = m_streamMonitor->streams();
+    QSet<quint64> live;
+    for (const AudioStream &stream : streams) {
+        live.insert(streamKey(stream.index, stream.isInput));
+    }
+    
+    m_streamTable->setUpdatesEnabled(false);
+    
+    for (int row = m_streamTable->rowCount() - 1; row >= 0; --row) {
+        const QTableWidgetItem *appItem = m_streamTable->item(row, 0);
+        if (!live.contains(streamKey(appItem->data(Qt::UserRole).toUInt(), appItem->data(Qt::UserRole + 1).toBool()))) {
+            m_streamTable->removeRow(row);
+        }
+    }
+    QHash<quint64, int> rows;
+    for (int row = 0; row < m_streamTable->rowCount(); ++row) {
+        const QTableWidgetItem *appItem = m_streamTable->item(row, 0);
+        rows.insert(streamKey(appItem->data(Qt::UserRole).toUInt(), appItem->data(Qt::UserRole + 1).toBool()), row);
+    }
+    
+    auto setText = [this](int row, int column, const QString &text) {
+        QTableWidgetItem *item = m_streamTable->item(row, column);
+        if (item->text() != text) item->setText(text);
+    };
+    
+    for (const AudioStream &stream : streams) {
+        int row = rows.value(streamKey(stream.index, stream.isInput), -1);
+        if (row < 0) {
+            row = m_streamTable->rowCount();
+            m_streamTable->insertRow(row);
+            
+            QTableWidgetItem *appItem = new QTableWidgetItem();
+            appItem->setData(Qt::UserRole, stream.index);
+            appItem->setData(Qt::UserRole + 1, stream.isInput);
+            m_streamTable->setItem(row, 0, appItem);
+            m_streamTable->setItem(row, 1, new QTableWidgetItem(stream.isInput ? "Recording" : "Playback"));
+            m_streamTable->setItem(row, 3, new QTableWidgetItem());
+            m_streamTable->setItem(row, 4, new QTableWidgetItem());
+            
+            QComboBox *deviceCombo = new QComboBox();
+            const quint32 index = stream.index;
+            const bool isInput = stream.isInput;
+            connect(deviceCombo, QOverload<int>::of(&QComboBox::activated), this, [this, deviceCombo, index, isInput](int comboIndex) {
+                m_streamMonitor->moveStream(index, isInput, deviceCombo->itemData(comboIndex).toString());
+            });
+            m_streamTable->setCellWidget(row, 2, deviceCombo);
+        }
+        
+        QTableWidgetItem *appItem = m_streamTable->item(row, 0);
+        setText(row, 0, stream.application.isEmpty() ? stream.binary : stream.application);
+        const bool routed = m_streamMonitor->ruleFor(stream) != nullptr;
+        if (appItem->data(Qt::UserRole + 2).toBool() != routed) {
+            appItem->setData(Qt::UserRole + 2, routed);
+            appItem->setIcon(routed ? style()->standardIcon(QStyle::SP_DialogApplyButton) : QIcon());
+        }
+        appItem->setToolTip(routed ? stream.mediaName + "\nRouted by a saved rule" : stream.mediaName);
+        
+        // The device list is only refilled when the endpoints themselves changed
+        QComboBox *deviceCombo = qobject_cast<QComboBox*>(m_streamTable->cellWidget(row, 2));
+        const QList<AudioEndpoint> endpoints = m_streamMonitor->endpoints(stream.isInput);
+        bool sameEndpoints = deviceCombo->count() == endpoints.size();
+        for (int i = 0; sameEndpoints && i < endpoints.size(); ++i) {
+            sameEndpoints = deviceCombo->itemData(i).toString() == endpoints.at(i).name;
+        }
+        if (!sameEndpoints) {
+            deviceCombo->clear();
+            for (const AudioEndpoint &endpoint : endpoints) {
+                deviceCombo->addItem(endpoint.description.isEmpty() ? endpoint.name : endpoint.description, endpoint.name);
+            }
+        }
+        int current = -1;
+        for (int i = 0; i < endpoints.size(); ++i) {
+            if (endpoints.at(i).index == stream.deviceIndex) current = i;
+        }
+        if (deviceCombo->currentIndex() != current) {
+            deviceCombo->setCurrentIndex(current);
+        }
+        
+        setText(row, 3, stream.muted ? "Muted" : QString("%1%").arg(stream.volume));
+        setText(row, 4, QString("%1 ms").arg(stream.latencyUsec / 1000.0, 0, 'f', 1));
+    }
+    
+    m_streamTable->setUpdatesEnabled(true);
+}
+
+void AudioManager::rememberStreamRouting()
+{
+    const int row = m_streamTable ? m_streamTable->currentRow() : -1;
+    QComboBox *deviceCombo = row >= 0 ? qobject_cast<QComboBox*>(m_streamTable->cellWidget(row, 2)) : nullptr;
+    if (!deviceCombo || deviceCombo->currentIndex() < 0) {
+        showError("No Selection", "Please select a stream");
+        return;
+    }
+    
+    StreamRoutingRule rule;
+    rule.application = m_streamTable->item(row, 0)->text();
+    rule.isInput = m_streamTable->item(row, 0)->data(Qt::UserRole + 1).toBool();
+    rule.deviceName = deviceCombo->currentData().toString();
+    m_streamMonitor->setRule(rule);
+    
+    m_statusLabel->setText(QString("%1 will always use %2").arg(rule.application, deviceCombo->currentText()));
+    updateStreamTable();
+}
+
+void AudioManager::forgetStreamRouting()
+{
+    const int row = m_streamTable ? m_streamTable->currentRow() : -1;
+    if (row < 0) {
+        showError("No Selection", "Please select a stream");
+        return;
+    }
+    
+    const QString application = m_streamTable->item(row, 0)->text();
+    m_streamMonitor->removeRule(application, m_streamTable->item(row, 0)->data(Qt::UserRole + 1).toBool());
+    
+    m_statusLabel->setText("Removed routing rule for " + application);
+    updateStreamTable();
+}
+
+void AudioManager::moveStreamToDevice(const QString &streamName, const QString &deviceName)
+{
+    if (!m_streamMonitor) return;
+    
+    const QList<AudioStream> streams = m_streamMonitor->streams();
+    for (const AudioStream &stream : streams) {
+        if (stream.application == streamName || stream.binary == streamName || stream.mediaName == streamName) {
+            m_streamMonitor->moveStream(stream.index, stream.isInput, deviceName);
+        }
+    }
+}
+
 void AudioManager::updatePipeWireInfo() 
 {
     updateInfoPanel();
@@ -2628,20 +3023,16 @@ void AudioManager::saveEasyEffectsPreset()
     
     showProgress("Saving", "Saving EasyEffects preset: " + name);
     
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process, name](int exitCode, QProcess::ExitStatus exitStatus) {
+    ProcessRunner::instance()->run("flatpak", QStringList() << "run" << "com.github.wwmm.easyeffects" << "--save-preset" << name, 0)
+        .then(this, [this, name](const ProcessResult &result) {
         hideProgress();
-        if (exitCode == 0) {
+        if (result.success()) {
             showSuccess("Preset Saved", "Successfully saved preset: " + name);
             refreshEasyEffectsPresets();
         } else {
             showError("Save Failed", "Failed to save preset: " + name);
         }
-        process->deleteLater();
     });
-    
-    process->start("flatpak", QStringList() << "run" << "com.github.wwmm.easyeffects" << "--save-preset" << name);
 }
 
 void AudioManager::deleteEasyEffectsPreset() 
@@ -2651,7 +3042,8 @@ void AudioManager::deleteEasyEffectsPreset()
         return;
     }
     
-    QString preset = m_easyEffectsPresetList->currentItem()->text();
+    const QString presetPath = m_easyEffectsPresetList->currentItem()->data(Qt::UserRole).toString();
+    const QString preset = QFileInfo(presetPath).completeBaseName();
     
     int ret = QMessageBox::question(this, "Delete Preset", 
                                    "Are you sure you want to delete preset '" + preset + "'?",
@@ -2662,15 +3054,12 @@ void AudioManager::deleteEasyEffectsPreset()
     
     showProgress("Deleting", "Deleting EasyEffects preset: " + preset);
     
-    // Delete the preset file from the Flatpak data directory
-    QTimer::singleShot(0, this, [this, preset]() {
-        QString presetFile = QDir::homePath() + "/.var/app/com.github.wwmm.easyeffects/config/easyeffects/output/" + preset + ".json";
-        
-        if (QFile::exists(presetFile)) {
-            if (QFile::remove(presetFile)) {
+    // The directory watcher picks up the removal and updates the index
+    QTimer::singleShot(0, this, [this, preset, presetPath]() {
+        if (QFile::exists(presetPath)) {
+            if (QFile::remove(presetPath)) {
                 hideProgress();
                 showSuccess("Preset Deleted", "Successfully deleted preset: " + preset);
-                refreshEasyEffectsPresets();
             } else {
                 hideProgress();
                 showError("Delete Failed", "Failed to delete preset file");
@@ -2693,155 +3082,93 @@ void AudioManager::resetEasyEffectsPreset()
     
     showProgress("Resetting", "Resetting EasyEffects to default settings...");
     
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
+    ProcessRunner::instance()->run("flatpak", QStringList() << "run" << "com.github.wwmm.easyeffects" << "--reset", 0)
+        .then(this, [this](const ProcessResult &result) {
         hideProgress();
-        if (exitCode == 0) {
+        if (result.success()) {
             showSuccess("Reset Complete", "EasyEffects has been reset to default settings");
         } else {
             showError("Reset Failed", "Failed to reset EasyEffects");
         }
-        process->deleteLater();
     });
-    
-    process->start("flatpak", QStringList() << "run" << "com.github.wwmm.easyeffects" << "--reset");
 }
 
 void AudioManager::enablePipeWireAutostart() 
 {
     showProgress("Configuring", "Enabling PipeWire autostart...");
     
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
+    ProcessRunner::instance()->run("systemctl", QStringList() << "--user" << "enable" << "pipewire.service")
+        .then(this, [this](const ProcessResult &result) {
         hideProgress();
-        if (exitCode == 0) {
+        if (result.success()) {
             showSuccess("Autostart", "PipeWire autostart enabled successfully!");
         } else {
             showError("Autostart Failed", "Failed to enable PipeWire autostart");
         }
-        process->deleteLater();
     });
-    
-    process->start("systemctl", QStringList() << "--user" << "enable" << "pipewire.service");
 }
 
 void AudioManager::disablePipeWireAutostart() 
 {
     showProgress("Configuring", "Disabling PipeWire autostart...");
     
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
+    ProcessRunner::instance()->run("systemctl", QStringList() << "--user" << "disable" << "pipewire.service")
+        .then(this, [this](const ProcessResult &result) {
         hideProgress();
-        if (exitCode == 0) {
+        if (result.success()) {
             showSuccess("Autostart", "PipeWire autostart disabled successfully!");
         } else {
             showError("Autostart Failed", "Failed to disable PipeWire autostart");
         }
-        process->deleteLater();
     });
-    
-    process->start("systemctl", QStringList() << "--user" << "disable" << "pipewire.service");
 }
 
 void AudioManager::setMasterVolume(int volume)
 {
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-        process->deleteLater();
-    });
-    
     // Use pactl to set PulseAudio/PipeWire volume
-    process->start("pactl", QStringList() << "set-sink-volume" << "@DEFAULT_SINK@" << QString("%1%").arg(volume));
+    ProcessRunner::instance()->run("pactl", QStringList() << "set-sink-volume" << "@DEFAULT_SINK@" << QString("%1%").arg(volume));
 }
 
 void AudioManager::setMasterMute(bool muted)
 {
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-        process->deleteLater();
-    });
-    
     // Use pactl to mute/unmute
-    process->start("pactl", QStringList() << "set-sink-mute" << "@DEFAULT_SINK@" << (muted ? "1" : "0"));
+    ProcessRunner::instance()->run("pactl", QStringList() << "set-sink-mute" << "@DEFAULT_SINK@" << (muted ? "1" : "0"));
 }
 
 void AudioManager::setInputVolume(int volume)
 {
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-        process->deleteLater();
-    });
-    
     // Use pactl to set input volume
-    process->start("pactl", QStringList() << "set-source-volume" << "@DEFAULT_SOURCE@" << QString("%1%").arg(volume));
+    ProcessRunner::instance()->run("pactl", QStringList() << "set-source-volume" << "@DEFAULT_SOURCE@" << QString("%1%").arg(volume));
 }
 
 void AudioManager::setInputMute(bool muted)
 {
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-        process->deleteLater();
-    });
-    
     // Use pactl to mute/unmute input
-    process->start("pactl", QStringList() << "set-source-mute" << "@DEFAULT_SOURCE@" << (muted ? "1" : "0"));
+    ProcessRunner::instance()->run("pactl", QStringList() << "set-source-mute" << "@DEFAULT_SOURCE@" << (muted ? "1" : "0"));
 }
 
 void AudioManager::setSampleRate(const QString &sampleRate)
 {
-    // Update PipeWire config with new sample rate
-    QString configPath = QDir::homePath() + "/.config/pipewire/pipewire.conf";
-    QFile configFile(configPath);
-    
-    if (configFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        QString content = configFile.readAll();
-        configFile.close();
-        
-        // Replace sample rate in config
-        QRegularExpression re("default\\.clock\\.rate\\s*=\\s*\\d+");
-        content.replace(re, QString("default.clock.rate = %1").arg(sampleRate));
-        
-        if (configFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            QTextStream stream(&configFile);
-            stream << content;
-            configFile.close();
-            
-            m_statusLabel->setText(QString("Sample rate set to %1 Hz").arg(sampleRate));
-            QTimer::singleShot(3000, [this]() { m_statusLabel->setText("Ready"); });
-        }
+    LatencyProfile profile = m_latencyEngine->currentProfile();
+    profile.name = "Custom";
+    profile.rate = sampleRate.toInt();
+    if (!profile.allowedRates.contains(profile.rate)) {
+        profile.allowedRates.append(profile.rate);
+        std::sort(profile.allowedRates.begin(), profile.allowedRates.end());
     }
+    
+    m_latencyEngine->applyProfile(profile);
 }
 
 void AudioManager::setBufferSize(const QString &bufferSize)
 {
-    // Update PipeWire config with new buffer size
-    QString configPath = QDir::homePath() + "/.config/pipewire/pipewire.conf";
-    QFile configFile(configPath);
+    LatencyProfile profile = m_latencyEngine->currentProfile();
+    profile.name = "Custom";
+    profile.quantum = bufferSize.toInt();
+    profile.minQuantum = qMin(profile.minQuantum, profile.quantum);
+    profile.maxQuantum = qMax(profile.maxQuantum, profile.quantum);
     
-    if (configFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        QString content = configFile.readAll();
-        configFile.close();
-        
-        // Replace buffer size in config
-        QRegularExpression re("default\\.clock\\.quantum\\s*=\\s*\\d+");
-        content.replace(re, QString("default.clock.quantum = %1").arg(bufferSize));
-        
-        if (configFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            QTextStream stream(&configFile);
-            stream << content;
-            configFile.close();
-            
-            m_statusLabel->setText(QString("Buffer size set to %1 samples").arg(bufferSize));
-            QTimer::singleShot(3000, [this]() { m_statusLabel->setText("Ready"); });
-        }
-    }
+    m_latencyEngine->applyProfile(profile);
 }
 
 void AudioManager::editPipeWireConfig()
@@ -2911,50 +3238,29 @@ context.properties = {
 
 void AudioManager::reloadPipeWireConfig()
 {
-    m_statusLabel->setText("Reloading PipeWire configuration...");
-    
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-        if (exitCode == 0) {
-            m_statusLabel->setText("PipeWire config reloaded");
-        } else {
-            m_statusLabel->setText("Failed to reload config");
+    // Push the active profile's clock settings again instead of restarting
+    // the daemon, which would drop every client
+    m_latencyEngine->reapplyLive();
+    m_statusLabel->setText("PipeWire clock settings re-applied");
+    QTimer::singleShot(3000, [this]() { 
+        if (m_statusLabel) {
+            m_statusLabel->setText("Ready"); 
         }
-        QTimer::singleShot(3000, [this]() { 
-            if (m_statusLabel) {
-                m_statusLabel->setText("Ready"); 
-            }
-        });
-        process->deleteLater();
     });
-    
-    process->start("systemctl", QStringList() << "--user" << "reload" << "pipewire");
 }
 
 void AudioManager::launchEasyEffects()
 {
-    showProgress("Launching", "Starting EasyEffects...");
-    
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-        hideProgress();
-        if (exitCode == 0) {
-            m_statusLabel->setText("EasyEffects launched");
-        } else {
-            m_statusLabel->setText("Failed to launch EasyEffects");
-        }
-        QTimer::singleShot(3000, [this]() { m_statusLabel->setText("Ready"); });
-        process->deleteLater();
-    });
-    
     // Try flatpak first, then native
+    bool started;
     if (isEasyEffectsAvailable()) {
-        process->start("flatpak", QStringList() << "run" << "com.github.wwmm.easyeffects");
+        started = QProcess::startDetached("flatpak", QStringList() << "run" << "com.github.wwmm.easyeffects");
     } else {
-        process->start("easyeffects");
+        started = QProcess::startDetached("easyeffects");
     }
+    
+    m_statusLabel->setText(started ? "EasyEffects launched" : "Failed to launch EasyEffects");
+    QTimer::singleShot(3000, [this]() { m_statusLabel->setText("Ready"); });
 }
 
 void AudioManager::setupSimplifiedAudioControls()
@@ -3017,6 +3323,37 @@ void AudioManager::setupSimplifiedAudioControls()
     
     m_mainLayout->addWidget(volumeGroup);
     
+    // Application Streams Section
+    QGroupBox *streamsGroup = new QGroupBox("Application Streams");
+    QVBoxLayout *streamsLayout = new QVBoxLayout(streamsGroup);
+    
+    m_streamTable = new QTableWidget(0, 5);
+    m_streamTable->setHorizontalHeaderLabels(QStringList() << "Application" << "Direction" << "Device" << "Volume" << "Latency");
+    m_streamTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    m_streamTable->horizontalHeader()->setSectionResizeMode(2, QHeaderView::Stretch);
+    m_streamTable->verticalHeader()->setVisible(false);
+    m_streamTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_streamTable->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_streamTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_streamTable->setMinimumHeight(120);
+    streamsLayout->addWidget(m_streamTable);
+    
+    QHBoxLayout *streamButtons = new QHBoxLayout();
+    
+    QPushButton *rememberRoutingButton = new QPushButton("Remember Device");
+    rememberRoutingButton->setToolTip("Always route this application to its current device");
+    connect(rememberRoutingButton, &QPushButton::clicked, this, &AudioManager::rememberStreamRouting);
+    streamButtons->addWidget(rememberRoutingButton);
+    
+    QPushButton *forgetRoutingButton = new QPushButton("Forget Device");
+    connect(forgetRoutingButton, &QPushButton::clicked, this, &AudioManager::forgetStreamRouting);
+    streamButtons->addWidget(forgetRoutingButton);
+    
+    streamButtons->addStretch();
+    streamsLayout->addLayout(streamButtons);
+    
+    m_mainLayout->addWidget(streamsGroup);
+    
     // PipeWire Config Section
     QGroupBox *pipeWireGroup = new QGroupBox("PipeWire Configuration");
     QVBoxLayout *pipeWireLayout = new QVBoxLayout(pipeWireGroup);
@@ -3035,23 +3372,49 @@ void AudioManager::setupSimplifiedAudioControls()
     connect(restartPipeWireButton, &QPushButton::clicked, this, &AudioManager::restartPipeWire);
     pipeWireButtons->addWidget(restartPipeWireButton);
     
+    QPushButton *graphButton = new QPushButton("Graph");
+    connect(graphButton, &QPushButton::clicked, this, &AudioManager::showPipeWireGraph);
+    pipeWireButtons->addWidget(graphButton);
+    
+    QPushButton *diagnoseButton = new QPushButton("RT Diagnostics");
+    diagnoseButton->setToolTip("Check whether this system can sustain low-latency audio");
+    connect(diagnoseButton, &QPushButton::clicked, this, &AudioManager::showRealtimeDiagnostics);
+    pipeWireButtons->addWidget(diagnoseButton);
+    
     pipeWireLayout->addLayout(pipeWireButtons);
     
     // Sample Rate and Buffer Size
     QHBoxLayout *configLayout = new QHBoxLayout();
+    const LatencyProfile activeProfile = m_latencyEngine->currentProfile();
+    
+    configLayout->addWidget(new QLabel("Profile:"));
+    m_latencyProfileCombo = new QComboBox();
+    for (const LatencyProfile &profile : LatencyProfile::builtinProfiles()) {
+        m_latencyProfileCombo->addItem(profile.name);
+    }
+    if (m_latencyProfileCombo->findText(activeProfile.name) < 0) {
+        m_latencyProfileCombo->addItem(activeProfile.name);
+    }
+    m_latencyProfileCombo->setCurrentText(activeProfile.name);
+    connect(m_latencyProfileCombo, QOverload<int>::of(&QComboBox::activated), this, [this](int index) {
+        if (m_latencyProfileCombo->itemText(index) != "Custom") {
+            applyLatencyProfile(m_latencyProfileCombo->itemText(index));
+        }
+    });
+    configLayout->addWidget(m_latencyProfileCombo);
     
     configLayout->addWidget(new QLabel("Sample Rate:"));
     m_sampleRateCombo = new QComboBox();
     m_sampleRateCombo->addItems({"44100", "48000", "96000", "192000"});
-    m_sampleRateCombo->setCurrentText("48000");
+    m_sampleRateCombo->setCurrentText(QString::number(activeProfile.rate));
     connect(m_sampleRateCombo, QOverload<const QString &>::of(&QComboBox::currentTextChanged),
             this, &AudioManager::setSampleRate);
     configLayout->addWidget(m_sampleRateCombo);
     
     configLayout->addWidget(new QLabel("Buffer Size:"));
     m_bufferSizeCombo = new QComboBox();
-    m_bufferSizeCombo->addItems({"64", "128", "256", "512", "1024"});
-    m_bufferSizeCombo->setCurrentText("256");
+    m_bufferSizeCombo->addItems({"64", "128", "256", "512", "1024", "2048"});
+    m_bufferSizeCombo->setCurrentText(QString::number(activeProfile.quantum));
     connect(m_bufferSizeCombo, QOverload<const QString &>::of(&QComboBox::currentTextChanged),
             this, &AudioManager::setBufferSize);
     configLayout->addWidget(m_bufferSizeCombo);
@@ -3076,5 +3439,41 @@ void AudioManager::setupSimplifiedAudioControls()
     
     easyEffectsLayout->addLayout(easyEffectsButtons);
     
+    m_easyEffectsSearchEdit = new QLineEdit();
+    m_easyEffectsSearchEdit->setPlaceholderText("Search presets by name or plugin...");
+    m_easyEffectsSearchEdit->setClearButtonEnabled(true);
+    connect(m_easyEffectsSearchEdit, &QLineEdit::textChanged, this, &AudioManager::updateEasyEffectsPresetList);
+    easyEffectsLayout->addWidget(m_easyEffectsSearchEdit);
+    
+    m_easyEffectsPresetList = new QListWidget();
+    m_easyEffectsPresetList->setAlternatingRowColors(true);
+    m_easyEffectsPresetList->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    m_easyEffectsPresetList->setMinimumHeight(120);
+    connect(m_easyEffectsPresetList, &QListWidget::itemDoubleClicked, this, &AudioManager::loadEasyEffectsPreset);
+    easyEffectsLayout->addWidget(m_easyEffectsPresetList);
+    
+    QHBoxLayout *presetButtons = new QHBoxLayout();
+    
+    QPushButton *applyPresetButton = new QPushButton("Apply Preset");
+    connect(applyPresetButton, &QPushButton::clicked, this, &AudioManager::loadEasyEffectsPreset);
+    presetButtons->addWidget(applyPresetButton);
+    
+    QPushButton *comparePresetsButton = new QPushButton("Compare");
+    comparePresetsButton->setToolTip("Compare the two selected presets");
+    connect(comparePresetsButton, &QPushButton::clicked, this, &AudioManager::compareEasyEffectsPresets);
+    presetButtons->addWidget(comparePresetsButton);
+    
+    QPushButton *deletePresetButton = new QPushButton("Delete");
+    connect(deletePresetButton, &QPushButton::clicked, this, &AudioManager::deleteEasyEffectsPreset);
+    presetButtons->addWidget(deletePresetButton);
+    
+    presetButtons->addStretch();
+    
+    QPushButton *rescanPresetsButton = new QPushButton("Rescan");
+    connect(rescanPresetsButton, &QPushButton::clicked, this, &AudioManager::refreshEasyEffectsPresets);
+    presetButtons->addWidget(rescanPresetsButton);
+    
+    easyEffectsLayout->addLayout(presetButtons);
+    
     m_mainLayout->addWidget(easyEffectsGroup);
 }
\ No newline at end of file
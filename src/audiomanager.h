@@ -53,9 +53,17 @@
 #include <QRadioButton>
 #include <QDoubleSpinBox>
 #include <QDial>
+#include <QDialog>
+#include <QHash>
 
 class SystemUtils;
 class PrivilegedExecutor;
+class PipeWireGraphModel;
+class PipeWireGraphView;
+class EasyEffectsPresetIndex;
+class AudioStreamMonitor;
+class LatencyProfileEngine;
+class RealtimeDiagnostics;
 
 class AudioDeviceWorker : public QThread
 {
@@ -154,6 +162,9 @@ private slots:
     void saveEasyEffectsPreset();
     void deleteEasyEffectsPreset();
     void resetEasyEffectsPreset();
+    void compareEasyEffectsPresets();
+    void rememberStreamRouting();
+    void forgetStreamRouting();
     void installPipeWire();
     void startPipeWire();
     void stopPipeWire();
@@ -161,6 +172,11 @@ private slots:
     void enablePipeWireAutostart();
     void disablePipeWireAutostart();
     void showPipeWireGraph();
+    void showRealtimeDiagnostics();
+    void updateRealtimeDiagnostics();
+    void applyRealtimeFix();
+    void onRealtimeFixFinished(const QString &output);
+    void onRealtimeFixFailed(const QString &error);
     void optimizeForLatency();
     void optimizeForQuality();
     void optimizeForPowerSaving();
@@ -265,12 +281,14 @@ private:
     void optimizePipeWireForLatency();
     void optimizePipeWireForQuality();
     void optimizePipeWireForPowerSaving();
+    void applyLatencyProfile(const QString &profileName);
     
     // Data management
     void updateDeviceTable();
     void updateProfileTable();
     void updateEffectTable();
     void updateEasyEffectsPresetList();
+    void updateStreamTable();
     void updatePipeWireInfo();
     void updateMixerControls();
     void updateEffectChain();
@@ -310,6 +328,8 @@ private:
     bool isJackAvailable();
     QString getAudioSystem();
     QStringList getAvailableAudioSystems();
+    void probeAudioSystems();
+    void onAudioSystemsProbed();
     
     // Member variables
     SystemUtils *m_systemUtils;
@@ -367,6 +387,7 @@ private:
     QVBoxLayout *m_easyEffectsLayout;
     QListWidget *m_easyEffectsPresetList;
     QHBoxLayout *m_easyEffectsButtonLayout;
+    QLabel *m_easyEffectsInfoLabel;
     QPushButton *m_installEasyEffectsButton;
     QPushButton *m_startEasyEffectsButton;
     QPushButton *m_stopEasyEffectsButton;
@@ -382,6 +403,7 @@ private:
     QVBoxLayout *m_pipeWireLayout;
     QTextEdit *m_pipeWireInfoText;
     QHBoxLayout *m_pipeWireButtonLayout;
+    QLabel *m_pipeWireInfoLabel;
     QPushButton *m_installPipeWireButton;
     QPushButton *m_startPipeWireButton;
     QPushButton *m_stopPipeWireButton;
@@ -444,6 +466,27 @@ private:
     AudioDeviceWorker *m_deviceWorker;
     QTimer *m_refreshTimer;
     
+    // PipeWire graph
+    PipeWireGraphModel *m_pipeWireGraphModel;
+    QDialog *m_pipeWireGraphDialog;
+    
+    // EasyEffects preset index
+    EasyEffectsPresetIndex *m_presetIndex;
+    QLineEdit *m_easyEffectsSearchEdit;
+    
+    // Application streams
+    AudioStreamMonitor *m_streamMonitor;
+    QTableWidget *m_streamTable;
+    
+    // PipeWire latency profiles
+    LatencyProfileEngine *m_latencyEngine;
+    QComboBox *m_latencyProfileCombo;
+    
+    // Real-time diagnostics
+    RealtimeDiagnostics *m_realtimeDiagnostics;
+    QDialog *m_diagnosticsDialog;
+    QTreeWidget *m_diagnosticsTree;
+    
     // Data
     QList<QJsonObject> m_devices;
     QList<QJsonObject> m_profiles;
@@ -464,6 +507,8 @@ private:
     
     // State
     bool m_isScanning;
+    QHash<QString, bool> m_audioSystems;    // filled in by probeAudioSystems()
+    int m_pendingProbes;
     QMutex m_dataMutex;
     
     // Constants
@@ -0,0 +1,636 @@
+#include "audiostreams.h"
+#include "processrunner.h"
+#include <QSettings>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QMetaObject>
+#include <QPointer>
+#include <QDebug>
+#include <algorithm>
+
+#ifdef HAVE_LIBPULSE
+#include <pulse/pulseaudio.h>
+
+// libpulse callbacks run on the mainloop thread; results are handed to the
+// monitor on the GUI thread through queued calls.
+class PulseCallbacks
+{
+public:
+    static void contextState(pa_context *context, void *userdata)
+    {
+        AudioStreamMonitor *monitor = static_cast<AudioStreamMonitor*>(userdata);
+        
+        switch (pa_context_get_state(context)) {
+        case PA_CONTEXT_READY: {
+            pa_context_set_subscribe_callback(context, &PulseCallbacks::subscribeEvent, monitor);
+            const pa_subscription_mask_t mask = static_cast<pa_subscription_mask_t>(
+                PA_SUBSCRIPTION_MASK_SINK | PA_SUBSCRIPTION_MASK_SOURCE |
+                PA_SUBSCRIPTION_MASK_SINK_INPUT | PA_SUBSCRIPTION_MASK_SOURCE_OUTPUT);
+            release(pa_context_subscribe(context, mask, nullptr, nullptr));
+            release(pa_context_get_sink_info_list(context, &PulseCallbacks::sinkInfo, monitor));
+            release(pa_context_get_source_info_list(context, &PulseCallbacks::sourceInfo, monitor));
+            release(pa_context_get_sink_input_info_list(context, &PulseCallbacks::sinkInputInfo, monitor));
+            release(pa_context_get_source_output_info_list(context, &PulseCallbacks::sourceOutputInfo, monitor));
+            break;
+        }
+        case PA_CONTEXT_FAILED:
+        case PA_CONTEXT_TERMINATED: {
+            const QString error = QString::fromUtf8(pa_strerror(pa_context_errno(context)));
+            QMetaObject::invokeMethod(monitor, [monitor, error]() {
+                monitor->onNativeFailed(error);
+            }, Qt::QueuedConnection);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    
+    static void subscribeEvent(pa_context *context, pa_subscription_event_type_t event, uint32_t index, void *userdata)
+    {
+        AudioStreamMonitor *monitor = static_cast<AudioStreamMonitor*>(userdata);
+        const int facility = event & PA_SUBSCRIPTION_EVENT_FACILITY_MASK;
+        
+        if ((event & PA_SUBSCRIPTION_EVENT_TYPE_MASK) == PA_SUBSCRIPTION_EVENT_REMOVE) {
+            const bool isInput = facility == PA_SUBSCRIPTION_EVENT_SOURCE ||
+                                 facility == PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT;
+            const bool isStream = facility == PA_SUBSCRIPTION_EVENT_SINK_INPUT ||
+                                  facility == PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT;
+            QMetaObject::invokeMethod(monitor, [monitor, index, isInput, isStream]() {
+                if (isStream) {
+                    monitor->removeStream(index, isInput);
+                    emit monitor->streamsChanged();
+                } else {
+                    monitor->removeEndpoint(index, isInput);
+                    emit monitor->endpointsChanged();
+                }
+            }, Qt::QueuedConnection);
+            return;
+        }
+        
+        // New or changed: fetch just this object
+        switch (facility) {
+        case PA_SUBSCRIPTION_EVENT_SINK:
+            release(pa_context_get_sink_info_by_index(context, index, &PulseCallbacks::sinkInfo, monitor));
+            break;
+        case PA_SUBSCRIPTION_EVENT_SOURCE:
+            release(pa_context_get_source_info_by_index(context, index, &PulseCallbacks::sourceInfo, monitor));
+            break;
+        case PA_SUBSCRIPTION_EVENT_SINK_INPUT:
+            release(pa_context_get_sink_input_info(context, index, &PulseCallbacks::sinkInputInfo, monitor));
+            break;
+        case PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT:
+            release(pa_context_get_source_output_info(context, index, &PulseCallbacks::sourceOutputInfo, monitor));
+            break;
+        default:
+            break;
+        }
+    }
+    
+    static void sinkInfo(pa_context *, const pa_sink_info *info, int eol, void *userdata)
+    {
+        if (eol || !info) return;
+        
+        AudioEndpoint endpoint;
+        endpoint.index = info->index;
+        endpoint.isInput = false;
+        endpoint.name = QString::fromUtf8(info->name);
+        endpoint.description = QString::fromUtf8(info->description);
+        postEndpoint(static_cast<AudioStreamMonitor*>(userdata), endpoint);
+    }
+    
+    static void sourceInfo(pa_context *, const pa_source_info *info, int eol, void *userdata)
+    {
+        // Monitor sources are not useful recording targets
+        if (eol || !info || info->monitor_of_sink != PA_INVALID_INDEX) return;
+        
+        AudioEndpoint endpoint;
+        endpoint.index = info->index;
+        endpoint.isInput = true;
+        endpoint.name = QString::fromUtf8(info->name);
+        endpoint.description = QString::fromUtf8(info->description);
+        postEndpoint(static_cast<AudioStreamMonitor*>(userdata), endpoint);
+    }
+    
+    static void sinkInputInfo(pa_context *, const pa_sink_input_info *info, int eol, void *userdata)
+    {
+        if (eol || !info) return;
+        
+        AudioStream stream;
+        stream.index = info->index;
+        stream.isInput = false;
+        stream.deviceIndex = info->sink;
+        stream.mediaName = QString::fromUtf8(info->name);
+        fillProperties(stream, info->proplist);
+        fillVolume(stream, info->volume);
+        stream.muted = info->mute;
+        stream.latencyUsec = qint64(info->buffer_usec + info->sink_usec);
+        postStream(static_cast<AudioStreamMonitor*>(userdata), stream);
+    }
+    
+    static void sourceOutputInfo(pa_context *, const pa_source_output_info *info, int eol, void *userdata)
+    {
+        if (eol || !info) return;
+        
+        AudioStream stream;
+        stream.index = info->index;
+        stream.isInput = true;
+        stream.deviceIndex = info->source;
+        stream.mediaName = QString::fromUtf8(info->name);
+        fillProperties(stream, info->proplist);
+        fillVolume(stream, info->volume);
+        stream.muted = info->mute;
+        stream.latencyUsec = qint64(info->buffer_usec + info->source_usec);
+        postStream(static_cast<AudioStreamMonitor*>(userdata), stream);
+    }
+    
+    static void operationResult(pa_context *context, int success, void *userdata)
+    {
+        if (success) return;
+        
+        AudioStreamMonitor *monitor = static_cast<AudioStreamMonitor*>(userdata);
+        const QString error = QString::fromUtf8(pa_strerror(pa_context_errno(context)));
+        QMetaObject::invokeMethod(monitor, [monitor, error]() {
+            emit monitor->errorOccurred(error);
+        }, Qt::QueuedConnection);
+    }
+    
+    static void release(pa_operation *operation)
+    {
+        if (operation) {
+            pa_operation_unref(operation);
+        }
+    }
+
+private:
+    static void fillProperties(AudioStream &stream, pa_proplist *properties)
+    {
+        stream.application = QString::fromUtf8(pa_proplist_gets(properties, PA_PROP_APPLICATION_NAME));
+        stream.binary = QString::fromUtf8(pa_proplist_gets(properties, PA_PROP_APPLICATION_PROCESS_BINARY));
+    }
+    
+    static void fillVolume(AudioStream &stream, const pa_cvolume &volume)
+    {
+        stream.channels = qMax<int>(1, volume.channels);
+        stream.volume = qRound(pa_cvolume_avg(&volume) * 100.0 / PA_VOLUME_NORM);
+    }
+    
+    static void postStream(AudioStreamMonitor *monitor, const AudioStream &stream)
+    {
+        QMetaObject::invokeMethod(monitor, [monitor, stream]() {
+            monitor->updateStream(stream);
+            emit monitor->streamsChanged();
+        }, Qt::QueuedConnection);
+    }
+    
+    static void postEndpoint(AudioStreamMonitor *monitor, const AudioEndpoint &endpoint)
+    {
+        QMetaObject::invokeMethod(monitor, [monitor, endpoint]() {
+            monitor->updateEndpoint(endpoint);
+            emit monitor->endpointsChanged();
+        }, Qt::QueuedConnection);
+    }
+};
+#endif
+
+// AudioStreamMonitor Implementation
+AudioStreamMonitor::AudioStreamMonitor(QObject *parent)
+    : QObject(parent)
+#ifdef HAVE_LIBPULSE
+    , m_mainloop(nullptr)
+    , m_context(nullptr)
+#endif
+    , m_subscribed(false)
+    , m_refreshTimer(new QTimer(this))
+    , m_pactlJsonWarned(false)
+{
+    m_refreshTimer->setSingleShot(true);
+    m_refreshTimer->setInterval(100);
+    connect(m_refreshTimer, &QTimer::timeout, this, &AudioStreamMonitor::refreshFromPactl);
+    
+    loadRules();
+}
+
+AudioStreamMonitor::~AudioStreamMonitor()
+{
+    stop();
+}
+
+quint64 AudioStreamMonitor::key(quint32 index, bool isInput)
+{
+    return (quint64(isInput ? 1 : 0) << 32) | index;
+}
+
+void AudioStreamMonitor::start()
+{
+    if (isNative() || m_subscribed) return;
+    
+    if (!startNative()) {
+        startPactl();
+    }
+}
+
+void AudioStreamMonitor::stop()
+{
+    stopNative();
+    stopPactl();
+    
+    m_streams.clear();
+    m_endpoints.clear();
+    m_routedStreams.clear();
+}
+
+bool AudioStreamMonitor::isNative() const
+{
+#ifdef HAVE_LIBPULSE
+    return m_context != nullptr;
+#else
+    return false;
+#endif
+}
+
+QList<AudioStream> AudioStreamMonitor::streams() const
+{
+    QList<AudioStream> result = m_streams.values();
+    std::sort(result.begin(), result.end(), [](const AudioStream &a, const AudioStream &b) {
+        if (a.isInput != b.isInput) return !a.isInput;
+        const int order = QString::compare(a.application, b.application, Qt::CaseInsensitive);
+        return order != 0 ? order < 0 : a.index < b.index;
+    });
+    return result;
+}
+
+QList<AudioEndpoint> AudioStreamMonitor::endpoints(bool isInput) const
+{
+    QList<AudioEndpoint> result;
+    for (const AudioEndpoint &endpoint : m_endpoints) {
+        if (endpoint.isInput == isInput) {
+            result.append(endpoint);
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const AudioEndpoint &a, const AudioEndpoint &b) {
+        return QString::compare(a.description, b.description, Qt::CaseInsensitive) < 0;
+    });
+    return result;
+}
+
+QString AudioStreamMonitor::endpointName(quint32 index, bool isInput) const
+{
+    return m_endpoints.value(key(index, isInput)).name;
+}
+
+void AudioStreamMonitor::moveStream(quint32 index, bool isInput, const QString &deviceName)
+{
+#ifdef HAVE_LIBPULSE
+    if (m_context) {
+        const QByteArray name = deviceName.toUtf8();
+        pa_threaded_mainloop_lock(m_mainloop);
+        PulseCallbacks::release(isInput
+            ? pa_context_move_source_output_by_name(m_context, index, name.constData(), &PulseCallbacks::operationResult, this)
+            : pa_context_move_sink_input_by_name(m_context, index, name.constData(), &PulseCallbacks::operationResult, this));
+        pa_threaded_mainloop_unlock(m_mainloop);
+        return;
+    }
+#endif
+    runPactl(QStringList() << (isInput ? "move-source-output" : "move-sink-input")
+                           << QString::number(index) << deviceName);
+}
+
+void AudioStreamMonitor::setStreamVolume(quint32 index, bool isInput, int percent)
+{
+#ifdef HAVE_LIBPULSE
+    if (m_context) {
+        const AudioStream stream = m_streams.value(key(index, isInput));
+        pa_cvolume volume;
+        pa_cvolume_set(&volume, stream.channels, pa_volume_t(qint64(percent) * PA_VOLUME_NORM / 100));
+        
+        pa_threaded_mainloop_lock(m_mainloop);
+        PulseCallbacks::release(isInput
+            ? pa_context_set_source_output_volume(m_context, index, &volume, &PulseCallbacks::operationResult, this)
+            : pa_context_set_sink_input_volume(m_context, index, &volume, &PulseCallbacks::operationResult, this));
+        pa_threaded_mainloop_unlock(m_mainloop);
+        return;
+    }
+#endif
+    runPactl(QStringList() << (isInput ? "set-source-output-volume" : "set-sink-input-volume")
+                           << QString::number(index) << QString("%1%").arg(percent));
+}
+
+const StreamRoutingRule *AudioStreamMonitor::ruleFor(const AudioStream &stream) const
+{
+    for (const StreamRoutingRule &rule : m_rules) {
+        if (rule.isInput != stream.isInput) continue;
+        if (QString::compare(rule.application, stream.application, Qt::CaseInsensitive) == 0 ||
+            (!stream.binary.isEmpty() && QString::compare(rule.application, stream.binary, Qt::CaseInsensitive) == 0)) {
+            return &rule;
+        }
+    }
+    return nullptr;
+}
+
+void AudioStreamMonitor::setRule(const StreamRoutingRule &rule)
+{
+    removeRule(rule.application, rule.isInput);
+    m_rules.append(rule);
+    saveRules();
+}
+
+void AudioStreamMonitor::removeRule(const QString &application, bool isInput)
+{
+    for (int i = m_rules.size() - 1; i >= 0; --i) {
+        if (m_rules.at(i).isInput == isInput &&
+            QString::compare(m_rules.at(i).application, application, Qt::CaseInsensitive) == 0) {
+            m_rules.removeAt(i);
+        }
+    }
+    saveRules();
+}
+
+void AudioStreamMonitor::updateStream(const AudioStream &stream)
+{
+    m_streams.insert(key(stream.index, stream.isInput), stream);
+    applyRules(stream);
+}
+
+void AudioStreamMonitor::removeStream(quint32 index, bool isInput)
+{
+    m_streams.remove(key(index, isInput));
+    m_routedStreams.remove(key(index, isInput));
+}
+
+void AudioStreamMonitor::updateEndpoint(const AudioEndpoint &endpoint)
+{
+    m_endpoints.insert(key(endpoint.index, endpoint.isInput), endpoint);
+}
+
+void AudioStreamMonitor::removeEndpoint(quint32 index, bool isInput)
+{
+    m_endpoints.remove(key(index, isInput));
+}
+
+void AudioStreamMonitor::applyRules(const AudioStream &stream)
+{
+    // Rules only route a stream when it first shows up, so manual moves stick
+    const quint64 streamKey = key(stream.index, stream.isInput);
+    if (m_routedStreams.contains(streamKey)) return;
+    m_routedStreams.insert(streamKey);
+    
+    const StreamRoutingRule *rule = ruleFor(stream);
+    if (rule && endpointName(stream.deviceIndex, stream.isInput) != rule->deviceName) {
+        moveStream(stream.index, stream.isInput, rule->deviceName);
+    }
+}
+
+void AudioStreamMonitor::loadRules()
+{
+    QSettings settings;
+    const int count = settings.beginReadArray("AudioRouting/rules");
+    for (int i = 0; i < count; ++i) {
+        settings.setArrayIndex(i);
+        StreamRoutingRule rule;
+        rule.application = settings.value("application").toString();
+        rule.isInput = settings.value("input").toBool();
+        rule.deviceName = settings.value("device").toString();
+        if (!rule.application.isEmpty() && !rule.deviceName.isEmpty()) {
+            m_rules.append(rule);
+        }
+    }
+    settings.endArray();
+}
+
+void AudioStreamMonitor::saveRules() const
+{
+    QSettings settings;
+    settings.beginWriteArray("AudioRouting/rules", m_rules.size());
+    for (int i = 0; i < m_rules.size(); ++i) {
+        settings.setArrayIndex(i);
+        settings.setValue("application", m_rules.at(i).application);
+        settings.setValue("input", m_rules.at(i).isInput);
+        settings.setValue("device", m_rules.at(i).deviceName);
+    }
+    settings.endArray();
+}
+
+bool AudioStreamMonitor::startNative()
+{
+#ifdef HAVE_LIBPULSE
+    m_mainloop = pa_threaded_mainloop_new();
+    if (!m_mainloop) return false;
+    
+    m_context = pa_context_new(pa_threaded_mainloop_get_api(m_mainloop), "Oreon System Manager");
+    if (!m_context) {
+        stopNative();
+        return false;
+    }
+    
+    pa_context_set_state_callback(m_context, &PulseCallbacks::contextState, this);
+    if (pa_context_connect(m_context, nullptr, PA_CONTEXT_NOAUTOSPAWN, nullptr) < 0 ||
+        pa_threaded_mainloop_start(m_mainloop) < 0) {
+        qWarning() << "Could not connect to the sound server:" << pa_strerror(pa_context_errno(m_context));
+        stopNative();
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void AudioStreamMonitor::stopNative()
+{
+#ifdef HAVE_LIBPULSE
+    if (!m_mainloop) return;
+    
+    if (m_context) {
+        pa_threaded_mainloop_lock(m_mainloop);
+        pa_context_set_state_callback(m_context, nullptr, nullptr);
+        pa_context_set_subscribe_callback(m_context, nullptr, nullptr);
+        pa_context_disconnect(m_context);
+        pa_context_unref(m_context);
+        m_context = nullptr;
+        pa_threaded_mainloop_unlock(m_mainloop);
+    }
+    
+    pa_threaded_mainloop_stop(m_mainloop);
+    pa_threaded_mainloop_free(m_mainloop);
+    m_mainloop = nullptr;
+#endif
+}
+
+void AudioStreamMonitor::onNativeFailed(const QString &error)
+{
+    if (!isNative()) return;
+    
+    // e.g. the sound server restarted; keep working through pactl
+    qWarning() << "Sound server connection lost:" << error;
+    stopNative();
+    startPactl();
+}
+
+void AudioStreamMonitor::startPactl()
+{
+    m_subscribed = true;
+    m_subscribeToken = CancellationToken();
+    
+    ProcessRequest request("pactl", QStringList() << "subscribe");
+    request.timeoutMs = 0;
+    request.launcher = ProcessRequest::QtProcess;
+    request.pooled = false;
+    
+    // Events from a subscription we already stopped, or that outlived us, are dropped
+    QPointer<AudioStreamMonitor> self(this);
+    const CancellationToken token = m_subscribeToken;
+    request.onOutput = [self, token](const QByteArray &chunk) {
+        if (self && !token.isCancelled()) self->readSubscribeOutput(chunk);
+    };
+    
+    ProcessRunner::instance()->run(request, token).then(this, [this, token](const ProcessResult &result) {
+        if (token.isCancelled()) return;
+        
+        stopPactl();
+        if (!result.started) {
+            emit errorOccurred("pactl is not available; install pulseaudio-utils to manage streams");
+            return;
+        }
+        // The sound server went away; reconnect once it is back
+        QTimer::singleShot(2000, this, &AudioStreamMonitor::start);
+    });
+    
+    m_pendingLists << "sinks" << "sources" << "sink-inputs" << "source-outputs";
+    refreshFromPactl();
+}
+
+void AudioStreamMonitor::stopPactl()
+{
+    m_refreshTimer->stop();
+    m_pendingLists.clear();
+    m_subscribeBuffer.clear();
+    
+    if (m_subscribed) {
+        m_subscribeToken.cancel();
+        m_subscribed = false;
+    }
+}
+
+void AudioStreamMonitor::readSubscribeOutput(const QByteArray &chunk)
+{
+    m_subscribeBuffer.append(chunk);
+    
+    // Lines look like: Event 'change' on sink-input #42
+    int newline;
+    while ((newline = m_subscribeBuffer.indexOf('\n')) >= 0) {
+        const QString line = QString::fromUtf8(m_subscribeBuffer.left(newline));
+        m_subscribeBuffer.remove(0, newline + 1);
+        
+        const int on = line.indexOf(" on ");
+        const int hash = line.lastIndexOf(" #");
+        if (on < 0 || hash <= on) continue;
+        
+        const QString facility = line.mid(on + 4, hash - on - 4);
+        if (facility == "sink" || facility == "source" ||
+            facility == "sink-input" || facility == "source-output") {
+            m_pendingLists.insert(facility + "s");
+            m_refreshTimer->start();
+        }
+    }
+}
+
+void AudioStreamMonitor::refreshFromPactl()
+{
+    const QSet<QString> lists = m_pendingLists;
+    m_pendingLists.clear();
+    for (const QString &type : lists) {
+        listWithPactl(type);
+    }
+}
+
+void AudioStreamMonitor::listWithPactl(const QString &type)
+{
+    ProcessRunner::instance()->run("pactl", QStringList() << "-f" << "json" << "list" << type)
+        .then(this, [this, type](const ProcessResult &result) {
+        if (!result.success()) {
+            if (!m_pactlJsonWarned) {
+                m_pactlJsonWarned = true;
+                emit errorOccurred("pactl could not list " + type + " (pactl 16 or newer is required)");
+            }
+            return;
+        }
+        
+        const bool isStream = type == "sink-inputs" || type == "source-outputs";
+        const bool isInput = type == "sources" || type == "source-outputs";
+        const QJsonArray entries = QJsonDocument::fromJson(result.standardOutput).array();
+        QSet<quint64> seen;
+        
+        for (const QJsonValue &value : entries) {
+            const QJsonObject entry = value.toObject();
+            const QJsonObject properties = entry.value("properties").toObject();
+            const quint32 index = quint32(entry.value("index").toDouble());
+            
+            if (isStream) {
+                AudioStream stream;
+                stream.index = index;
+                stream.isInput = isInput;
+                stream.application = properties.value("application.name").toString();
+                stream.binary = properties.value("application.process.binary").toString();
+                stream.mediaName = properties.value("media.name").toString();
+                stream.deviceIndex = quint32(entry.value(isInput ? "source" : "sink").toDouble());
+                stream.muted = entry.value("mute").toBool();
+                stream.latencyUsec = qint64(entry.value("buffer_latency_usec").toDouble() +
+                                            entry.value(isInput ? "source_latency_usec" : "sink_latency_usec").toDouble());
+                
+                const QJsonObject volume = entry.value("volume").toObject();
+                double total = 0;
+                for (auto it = volume.begin(); it != volume.end(); ++it) {
+                    total += it.value().toObject().value("value").toDouble();
+                }
+                stream.channels = qMax(1, int(volume.size()));
+                stream.volume = qRound(total * 100.0 / stream.channels / 65536.0);
+                
+                updateStream(stream);
+            } else {
+                // Skip monitor sources, as the native path does
+                if (isInput && properties.value("device.class").toString() == "monitor") continue;
+                
+                AudioEndpoint endpoint;
+                endpoint.index = index;
+                endpoint.isInput = isInput;
+                endpoint.name = entry.value("name").toString();
+                endpoint.description = entry.value("description").toString();
+                updateEndpoint(endpoint);
+            }
+            seen.insert(key(index, isInput));
+        }
+        
+        // Drop objects of this type that went away
+        if (isStream) {
+            const QList<quint64> keys = m_streams.keys();
+            for (quint64 streamKey : keys) {
+                const AudioStream &stream = m_streams[streamKey];
+                if (stream.isInput == isInput && !seen.contains(streamKey)) {
+                    removeStream(stream.index, stream.isInput);
+                }
+            }
+            emit streamsChanged();
+        } else {
+            const QList<quint64> keys = m_endpoints.keys();
+            for (quint64 endpointKey : keys) {
+                const AudioEndpoint &endpoint = m_endpoints[endpointKey];
+                if (endpoint.isInput == isInput && !seen.contains(endpointKey)) {
+                    removeEndpoint(endpoint.index, endpoint.isInput);
+                }
+            }
+            emit endpointsChanged();
+        }
+    });
+}
+
+void AudioStreamMonitor::runPactl(const QStringList &args)
+{
+    ProcessRunner::instance()->run("pactl", args).then(this, [this](const ProcessResult &result) {
+        if (!result.success()) {
+            const QString error = QString::fromUtf8(result.standardError).trimmed();
+            emit errorOccurred(error.isEmpty() ? result.errorString : error);
+        }
+    });
+}
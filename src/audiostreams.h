@@ -0,0 +1,120 @@
+#ifndef AUDIOSTREAMS_H
+#define AUDIOSTREAMS_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QByteArray>
+#include <QTimer>
+#include "processrunner.h"
+
+#ifdef HAVE_LIBPULSE
+struct pa_threaded_mainloop;
+struct pa_context;
+#endif
+
+struct AudioStream {
+    quint32 index = 0;
+    bool isInput = false;       // source-output (recording) instead of sink-input
+    QString application;
+    QString binary;
+    QString mediaName;
+    quint32 deviceIndex = 0;
+    int channels = 2;
+    int volume = 0;             // percent
+    bool muted = false;
+    qint64 latencyUsec = 0;
+};
+
+struct AudioEndpoint {
+    quint32 index = 0;
+    bool isInput = false;
+    QString name;
+    QString description;
+};
+
+struct StreamRoutingRule {
+    QString application;        // application name or binary, case-insensitive
+    bool isInput = false;
+    QString deviceName;
+};
+
+// Live view of the playback and recording streams of the sound server.
+// Built with libpulse, one connection to PulseAudio/pipewire-pulse is kept
+// open and a stream move is a single request on it. Otherwise
+// `pactl subscribe` drives refreshes and moves go through pactl.
+class AudioStreamMonitor : public QObject
+{
+    Q_OBJECT
+    friend class PulseCallbacks;
+
+public:
+    explicit AudioStreamMonitor(QObject *parent = nullptr);
+    ~AudioStreamMonitor();
+    
+    void start();
+    void stop();
+    bool isNative() const;
+    
+    QList<AudioStream> streams() const;
+    QList<AudioEndpoint> endpoints(bool isInput) const;
+    QString endpointName(quint32 index, bool isInput) const;
+    
+    void moveStream(quint32 index, bool isInput, const QString &deviceName);
+    void setStreamVolume(quint32 index, bool isInput, int percent);
+    
+    QList<StreamRoutingRule> rules() const { return m_rules; }
+    const StreamRoutingRule *ruleFor(const AudioStream &stream) const;
+    void setRule(const StreamRoutingRule &rule);
+    void removeRule(const QString &application, bool isInput);
+
+signals:
+    void streamsChanged();
+    void endpointsChanged();
+    void errorOccurred(const QString &error);
+
+private slots:
+    void refreshFromPactl();
+
+private:
+    static quint64 key(quint32 index, bool isInput);
+    void updateStream(const AudioStream &stream);
+    void removeStream(quint32 index, bool isInput);
+    void updateEndpoint(const AudioEndpoint &endpoint);
+    void removeEndpoint(quint32 index, bool isInput);
+    void applyRules(const AudioStream &stream);
+    void loadRules();
+    void saveRules() const;
+    
+    bool startNative();
+    void stopNative();
+    void onNativeFailed(const QString &error);
+    
+    void startPactl();
+    void stopPactl();
+    void readSubscribeOutput(const QByteArray &chunk);
+    void runPactl(const QStringList &args);
+    void listWithPactl(const QString &type);
+
+#ifdef HAVE_LIBPULSE
+    pa_threaded_mainloop *m_mainloop;
+    pa_context *m_context;
+#endif
+
+    CancellationToken m_subscribeToken;
+    bool m_subscribed;
+    QByteArray m_subscribeBuffer;
+    QSet<QString> m_pendingLists;
+    QTimer *m_refreshTimer;
+    bool m_pactlJsonWarned;
+    
+    QHash<quint64, AudioStream> m_streams;
+    QHash<quint64, AudioEndpoint> m_endpoints;
+    QSet<quint64> m_routedStreams;
+    QList<StreamRoutingRule> m_rules;
+};
+
+#endif // AUDIOSTREAMS_H
@@ -1,6 +1,8 @@
 #include "containermanager.h"
 #include "systemutils.h"
 #include "privilegedexecutor.h"
+#include "processrunner.h"
+#include "tracing.h"
 #include <QApplication>
 #include <QDesktopServices>
 #include <QInputDialog>
@@ -42,16 +44,14 @@ void ContainerSearchWorker::searchContainersAsync()
 {
     if (m_containerType == "docker") {
         // Search Docker containers
-        QProcess *process = new QProcess();
-        connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-                this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
+        ProcessRunner::instance()->run("docker", QStringList() << "ps" << "-a" << "--format" << "json")
+            .then(this, [this](const ProcessResult &result) {
             if (m_stopRequested) {
-                process->deleteLater();
                 return;
             }
             
-            if (exitCode == 0) {
-                QString output = process->readAllStandardOutput();
+            if (result.success()) {
+                QString output = result.output();
                 QStringList lines = output.split('\n', Qt::SkipEmptyParts);
                 
                 for (const QString &line : lines) {
@@ -70,13 +70,9 @@ void ContainerSearchWorker::searchContainersAsync()
                 }
             }
             
-            process->deleteLater();
-            
             // Search Docker images
             searchDockerImagesAsync();
         });
-        
-        process->start("docker", QStringList() << "ps" << "-a" << "--format" << "json");
     } else {
         emit searchFinished();
     }
@@ -84,16 +80,14 @@ void ContainerSearchWorker::searchContainersAsync()
 
 void ContainerSearchWorker::searchDockerImagesAsync()
 {
-    QProcess *process = new QProcess();
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
+    ProcessRunner::instance()->run("docker", QStringList() << "images" << "--format" << "json")
+        .then(this, [this](const ProcessResult &result) {
         if (m_stopRequested) {
-            process->deleteLater();
             return;
         }
         
-        if (exitCode == 0) {
-            QString output = process->readAllStandardOutput();
+        if (result.success()) {
+            QString output = result.output();
             QStringList lines = output.split('\n', Qt::SkipEmptyParts);
             
             for (const QString &line : lines) {
@@ -112,11 +106,8 @@ void ContainerSearchWorker::searchDockerImagesAsync()
             }
         }
         
-        process->deleteLater();
         emit searchFinished();
     });
-    
-    process->start("docker", QStringList() << "images" << "--format" << "json");
 }
 
 // ContainerManager Implementation
@@ -130,6 +121,8 @@ ContainerManager::ContainerManager(QWidget *parent)
     , m_defaultRuntime("docker")
     , m_isSearching(false)
 {
+    TraceSpan span("ContainerManager::ContainerManager");
+    
     setupUI();
     setupContextMenus();
     
@@ -145,10 +138,10 @@ ContainerManager::ContainerManager(QWidget *parent)
         m_defaultRuntime = "podman";
     }
     
-    // Initial refresh
-    QTimer::singleShot(1000, this, &ContainerManager::refreshContainers);
-    QTimer::singleShot(1000, this, &ContainerManager::refreshImages);
-    QTimer::singleShot(1000, this, &ContainerManager::refreshDistroboxContainers);
+    // Initial refresh; the tab is only built when it is needed, so there is no startup to stay out of
+    QTimer::singleShot(0, this, &ContainerManager::refreshContainers);
+    QTimer::singleShot(0, this, &ContainerManager::refreshImages);
+    QTimer::singleShot(0, this, &ContainerManager::refreshDistroboxContainers);
 }
 
 ContainerManager::~ContainerManager()
@@ -335,23 +328,17 @@ void ContainerManager::setupProgressArea()
 
 bool ContainerManager::isDockerAvailable()
 {
-    QProcess process;
-    process.start("docker", QStringList() << "--version");
-    return process.waitForFinished(500) && process.exitCode() == 0; // Very short timeout
+    return !QStandardPaths::findExecutable("docker").isEmpty();
 }
 
 bool ContainerManager::isPodmanAvailable()
 {
-    QProcess process;
-    process.start("podman", QStringList() << "--version");
-    return process.waitForFinished(500) && process.exitCode() == 0; // Very short timeout
+    return !QStandardPaths::findExecutable("podman").isEmpty();
 }
 
 bool ContainerManager::isDistroboxAvailable()
 {
-    QProcess process;
-    process.start("distrobox", QStringList() << "--version");
-    return process.waitForFinished(500) && process.exitCode() == 0; // Very short timeout
+    return !QStandardPaths::findExecutable("distrobox").isEmpty();
 }
 
 void ContainerManager::updateTheme()
@@ -1758,11 +1745,10 @@ void ContainerManager::showContainerLogs()
     
     // Load logs
     auto loadLogs = [=]() {
-        QProcess process;
-        process.start(m_defaultRuntime, QStringList() << "logs" << containerId);
-        if (process.waitForFinished(10000)) {
-            logTextEdit->setPlainText(process.readAllStandardOutput());
-        }
+        ProcessRunner::instance()->run(m_defaultRuntime, QStringList() << "logs" << containerId, 10000)
+            .then(logTextEdit, [logTextEdit](const ProcessResult &result) {
+            if (!result.timedOut) logTextEdit->setPlainText(result.output());
+        });
     };
     
     connect(refreshButton, &QPushButton::clicked, loadLogs);
@@ -1792,11 +1778,10 @@ void ContainerManager::showContainerInspect()
     layout->addWidget(inspectTextEdit);
     
     // Load inspect data
-    QProcess process;
-    process.start(m_defaultRuntime, QStringList() << "inspect" << containerId);
-    if (process.waitForFinished(10000)) {
-        inspectTextEdit->setPlainText(process.readAllStandardOutput());
-    }
+    ProcessRunner::instance()->run(m_defaultRuntime, QStringList() << "inspect" << containerId, 10000)
+        .then(inspectTextEdit, [inspectTextEdit](const ProcessResult &result) {
+        if (!result.timedOut) inspectTextEdit->setPlainText(result.output());
+    });
     
     dialog.exec();
 }
@@ -1822,11 +1807,10 @@ void ContainerManager::showImageInspect()
     layout->addWidget(inspectTextEdit);
     
     // Load inspect data
-    QProcess process;
-    process.start(m_defaultRuntime, QStringList() << "inspect" << imageId);
-    if (process.waitForFinished(10000)) {
-        inspectTextEdit->setPlainText(process.readAllStandardOutput());
-    }
+    ProcessRunner::instance()->run(m_defaultRuntime, QStringList() << "inspect" << imageId, 10000)
+        .then(inspectTextEdit, [inspectTextEdit](const ProcessResult &result) {
+        if (!result.timedOut) inspectTextEdit->setPlainText(result.output());
+    });
     
     dialog.exec();
 }
@@ -2071,4 +2055,3 @@ void ContainerManager::pruneImages()
     }
 }
 
- 
\ No newline at end of file
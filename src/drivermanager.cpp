@@ -1,11 +1,56 @@
 #include "drivermanager.h"
 #include "systemutils.h"
 #include "privilegedexecutor.h"
+#include "processrunner.h"
+#include "kernelmoduleindex.h"
+#include "moduleinventory.h"
+#include "kernellog.h"
+#include "firmwareindex.h"
+#include "tracing.h"
 #include <QApplication>
 #include <QStyle>
 #include <QHeaderView>
 #include <QSplitter>
+#include <QFile>
+#include <QDirIterator>
+#include <QSet>
 #include <QDebug>
+#include <QSysInfo>
+#include <sys/utsname.h>
+
+namespace {
+
+// Keys identifying the same item across scans and scan stages
+QString hardwareKey(const QJsonObject &info)
+{
+    return info["type"].toString() + '/' + info["bus_id"].toString();
+}
+
+QString driverKey(const QJsonObject &info)
+{
+    return info["type"].toString() + '/' + info["name"].toString() + '/' + info["device"].toString();
+}
+
+QString moduleKey(const QJsonObject &info)
+{
+    return info["name"].toString();
+}
+
+QString firmwareKey(const QJsonObject &info)
+{
+    return info["path"].toString(info["name"].toString());
+}
+
+QStringList modaliases(const QJsonObject &device)
+{
+    QStringList aliases;
+    for (const QJsonValue &alias : device["modaliases"].toArray()) {
+        aliases << alias.toString();
+    }
+    return aliases;
+}
+
+}
 
 // HardwareScanner Implementation
 HardwareScanner::HardwareScanner(QObject *parent)
@@ -28,6 +73,8 @@ void HardwareScanner::setScanType(const QString &scanType)
 void HardwareScanner::run()
 {
     m_stopRequested = false;
+    m_pciDevices.clear();
+    m_batchTimer.start();
     
     try {
         if (m_scanType == "hardware" || m_scanType.isEmpty()) {
@@ -56,6 +103,7 @@ void HardwareScanner::run()
             scanAudioDrivers();
         }
         
+        flushResults();
         emit scanFinished();
     } catch (const std::exception &e) {
         emit errorOccurred(QString("Scan error: %1").arg(e.what()));
@@ -64,473 +112,259 @@ void HardwareScanner::run()
 
 void HardwareScanner::scanPCIDevices()
 {
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-        if (m_stopRequested) {
-            process->deleteLater();
-            return;
-        }
-        
-        if (exitCode != 0) {
-            emit errorOccurred("Failed to run lspci");
-            process->deleteLater();
-            return;
-        }
-        
-        QString output = process->readAllStandardOutput();
-        QStringList lines = output.split('\n');
-        QJsonObject currentDevice;
-        
-        for (const QString &line : lines) {
-            if (m_stopRequested) {
-                process->deleteLater();
-                return;
-            }
-            
-            if (!line.startsWith('\t') && !line.isEmpty()) {
-                if (!currentDevice.isEmpty()) {
-                    emit hardwareFound(currentDevice);
-                }
-                currentDevice = parseLspciOutput(line);
-            } else if (line.startsWith('\t')) {
-                // Parse additional device information
-                if (line.contains("Kernel driver in use:")) {
-                    QString driver = line.split(":").last().trimmed();
-                    currentDevice["driver"] = driver;
-                    currentDevice["status"] = "loaded";
-                } else if (line.contains("Kernel modules:")) {
-                    QString modules = line.split(":").last().trimmed();
-                    currentDevice["modules"] = modules;
-                }
-            }
-        }
-        
-        if (!currentDevice.isEmpty()) {
-            emit hardwareFound(currentDevice);
-        }
-        
-        process->deleteLater();
-    });
+    m_pciDevices = SysfsDeviceEnumerator::pciDevices();
     
-    process->start("lspci", QStringList() << "-nnv");
+    for (const SysfsDevice &device : m_pciDevices) {
+        if (m_stopRequested) return;
+        report(HardwareResult, deviceInfo(device));
+    }
 }
 
 void HardwareScanner::scanUSBDevices()
 {
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-        if (m_stopRequested) {
-            process->deleteLater();
-            return;
-        }
-        
-        if (exitCode != 0) {
-            emit errorOccurred("Failed to run lsusb");
-            process->deleteLater();
-            return;
-        }
-        
-        QString output = process->readAllStandardOutput();
-        QStringList lines = output.split('\n');
-        
-        for (const QString &line : lines) {
-            if (m_stopRequested) {
-                process->deleteLater();
-                return;
-            }
-            
-            if (line.startsWith("Bus ")) {
-                QJsonObject device = parseLsusbOutput(line);
-                if (!device.isEmpty()) {
-                    emit hardwareFound(device);
-                }
-            }
-        }
-        
-        process->deleteLater();
-    });
+    const QList<SysfsDevice> devices = SysfsDeviceEnumerator::usbDevices();
+    
+    for (const SysfsDevice &device : devices) {
+        if (m_stopRequested) return;
+        report(HardwareResult, deviceInfo(device));
+    }
+}
+
+QJsonObject HardwareScanner::deviceInfo(const SysfsDevice &device)
+{
+    QJsonObject info = device.toJson();
     
-    process->start("lsusb", QStringList() << "-v");
+    // What lspci -k reports as "Kernel modules:", matched from modules.alias
+    const QStringList modules = KernelModuleIndex::runningKernel().match(device.modaliases);
+    if (!modules.isEmpty()) {
+        info["modules"] = modules.join(", ");
+    }
+    
+    return info;
+}
+
+const QList<SysfsDevice> &HardwareScanner::pciDevices()
+{
+    // The driver scans share one sysfs walk instead of rerunning lspci -k each
+    if (m_pciDevices.isEmpty()) {
+        m_pciDevices = SysfsDeviceEnumerator::pciDevices();
+    }
+    return m_pciDevices;
 }
 
 void HardwareScanner::scanKernelModules()
 {
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-        if (m_stopRequested) {
-            process->deleteLater();
-            return;
-        }
-        
-        if (exitCode != 0) {
-            emit errorOccurred("Failed to scan kernel modules");
-            process->deleteLater();
-            return;
-        }
-        
-        QString output = process->readAllStandardOutput();
-        QStringList modules = output.split('\n');
+    // modules.dep lists every module of the running kernel, compressed ones included
+    const KernelModuleIndex &index = KernelModuleIndex::runningKernel();
+    if (!index.isValid()) {
+        emit errorOccurred(QString("No module index found for kernel %1").arg(index.kernelRelease()));
+        return;
+    }
+    
+    const QStringList names = index.moduleNames();
+    for (const QString &name : names) {
+        if (m_stopRequested) return;
         
-        for (const QString &modulePath : modules) {
-            if (m_stopRequested) {
-                process->deleteLater();
-                return;
-            }
-            if (modulePath.isEmpty()) continue;
-            
-            QFileInfo fileInfo(modulePath);
-            QString moduleName = fileInfo.baseName();
-            
-            QJsonObject moduleInfo;
-            moduleInfo["name"] = moduleName;
-            moduleInfo["path"] = modulePath;
-            moduleInfo["type"] = "kernel_module";
-            moduleInfo["status"] = "available";
-            
-            emit moduleFound(moduleInfo);
-        }
+        QJsonObject moduleInfo;
+        moduleInfo["name"] = name;
+        moduleInfo["path"] = index.modulePath(name);
+        moduleInfo["depends"] = index.dependencies(name).join(", ");
+        moduleInfo["type"] = "kernel_module";
+        moduleInfo["status"] = "available";
         
-        process->deleteLater();
-    });
-    
-    process->start("find", QStringList() << "/lib/modules" << "-name" << "*.ko");
+        report(ModuleResult, moduleInfo);
+    }
 }
 
 void HardwareScanner::scanLoadedModules()
 {
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-        if (m_stopRequested) {
-            process->deleteLater();
-            return;
-        }
-        
-        if (exitCode != 0) {
-            emit errorOccurred("Failed to run lsmod");
-            process->deleteLater();
-            return;
-        }
-        
-        QString output = process->readAllStandardOutput();
-        QStringList lines = output.split('\n');
+    const QSharedPointer<const ModuleInventory> inventory = ModuleInventory::snapshot();
+    const KernelModuleIndex &index = KernelModuleIndex::runningKernel();
+    
+    for (const LoadedModule &module : inventory->loadedModules()) {
+        if (m_stopRequested) return;
         
-        // Skip header line
-        for (int i = 1; i < lines.size(); ++i) {
-            if (m_stopRequested) {
-                process->deleteLater();
-                return;
-            }
-            
-            const QString &line = lines[i];
-            if (line.isEmpty()) continue;
-            
-            QJsonObject moduleInfo = parseLsmodOutput(line);
-            if (!moduleInfo.isEmpty()) {
-                emit moduleFound(moduleInfo);
-            }
-        }
+        QJsonObject moduleInfo;
+        moduleInfo["name"] = module.name;
+        moduleInfo["size"] = QString::number(module.size);
+        moduleInfo["used_count"] = QString::number(module.refCount);
+        moduleInfo["used_by"] = module.usedBy.join(", ");
+        moduleInfo["depends"] = inventory->uses(module.name).join(", ");
+        moduleInfo["path"] = index.modulePath(module.name);
+        moduleInfo["status"] = "loaded";
+        moduleInfo["type"] = "kernel_module";
         
-        process->deleteLater();
-    });
-    
-    process->start("lsmod");
+        report(ModuleResult, moduleInfo);
+    }
 }
 
 void HardwareScanner::scanAvailableFirmware()
 {
-    QStringList firmwareDirs = {"/lib/firmware", "/usr/lib/firmware"};
-    scanFirmwareDirectory(firmwareDirs, 0);
+    FirmwareIndex &index = FirmwareIndex::instance();
+    index.refresh();
+    
+    for (const FirmwareFile &file : index.files()) {
+        if (m_stopRequested) return;
+        
+        QJsonObject firmwareInfo;
+        // Relative to the firmware root, the way drivers request it
+        firmwareInfo["name"] = file.names.first();
+        firmwareInfo["path"] = file.path;
+        firmwareInfo["size"] = file.size;
+        firmwareInfo["package"] = file.package;
+        firmwareInfo["version"] = file.packageVersion;
+        firmwareInfo["status"] = "installed";
+        firmwareInfo["type"] = "firmware";
+        if (file.names.size() > 1) {
+            firmwareInfo["aliases"] = QJsonArray::fromStringList(file.names.mid(1));
+        }
+        
+        report(FirmwareResult, firmwareInfo);
+    }
 }
 
-void HardwareScanner::scanFirmwareDirectory(const QStringList &dirs, int currentIndex)
+void HardwareScanner::report(ResultType type, const QJsonObject &info)
 {
-    if (currentIndex >= dirs.size() || m_stopRequested) {
-        return;
+    switch (type) {
+    case HardwareResult: m_pendingHardware.append(info); break;
+    case DriverResult: m_pendingDrivers.append(info); break;
+    case ModuleResult: m_pendingModules.append(info); break;
+    case FirmwareResult: m_pendingFirmware.append(info); break;
     }
     
-    const QString &dir = dirs[currentIndex];
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process, dirs, currentIndex](int exitCode, QProcess::ExitStatus exitStatus) {
-        if (m_stopRequested) {
-            process->deleteLater();
-            return;
-        }
-        
-        if (exitCode == 0) {
-            QString output = process->readAllStandardOutput();
-            QStringList files = output.split('\n');
-            
-            for (const QString &file : files) {
-                if (m_stopRequested) {
-                    process->deleteLater();
-                    return;
-                }
-                if (file.isEmpty()) continue;
-                
-                QFileInfo fileInfo(file);
-                QJsonObject firmwareInfo;
-                firmwareInfo["name"] = fileInfo.fileName();
-                firmwareInfo["path"] = file;
-                firmwareInfo["size"] = fileInfo.size();
-                firmwareInfo["status"] = "installed";
-                firmwareInfo["type"] = "firmware";
-                
-                emit firmwareFound(firmwareInfo);
-            }
-        }
-        
-        process->deleteLater();
-        
-        // Continue with next directory
-        scanFirmwareDirectory(dirs, currentIndex + 1);
-    });
+    // Hand results over in batches; one queued signal per item swamps the GUI thread
+    const int pending = m_pendingHardware.size() + m_pendingDrivers.size()
+                      + m_pendingModules.size() + m_pendingFirmware.size();
+    if (pending >= BATCH_SIZE || m_batchTimer.elapsed() >= BATCH_INTERVAL_MS) {
+        flushResults();
+    }
+}
+
+void HardwareScanner::flushResults()
+{
+    if (!m_pendingHardware.isEmpty()) emit hardwareFound(m_pendingHardware);
+    if (!m_pendingDrivers.isEmpty()) emit driverFound(m_pendingDrivers);
+    if (!m_pendingModules.isEmpty()) emit moduleFound(m_pendingModules);
+    if (!m_pendingFirmware.isEmpty()) emit firmwareFound(m_pendingFirmware);
     
-    process->start("find", QStringList() << dir << "-type" << "f");
+    m_pendingHardware.clear();
+    m_pendingDrivers.clear();
+    m_pendingModules.clear();
+    m_pendingFirmware.clear();
+    m_batchTimer.restart();
 }
 
 void HardwareScanner::scanMissingFirmware()
 {
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-        if (m_stopRequested) {
-            process->deleteLater();
-            return;
-        }
+    KernelLog &log = KernelLog::instance();
+    if (!log.update()) {
+        emit errorOccurred("Failed to read the kernel log: " + log.errorString());
+        return;
+    }
+    
+    for (const MissingFirmware &firmware : log.missingFirmware()) {
+        if (m_stopRequested) return;
         
-        if (exitCode != 0) {
-            emit errorOccurred("Failed to read dmesg");
-            process->deleteLater();
-            return;
+        // Installed since the failure was logged
+        if (FirmwareIndex::instance().contains(firmware.name)) {
+            log.forget(firmware.name);
+            continue;
         }
         
-        QString output = process->readAllStandardOutput();
-        QStringList lines = output.split('\n');
-        
-        for (const QString &line : lines) {
-            if (m_stopRequested) {
-                process->deleteLater();
-                return;
-            }
-            
-            if (line.contains("firmware") && (line.contains("failed") || line.contains("missing"))) {
-                QRegularExpression re("firmware: (\\S+)");
-                QRegularExpressionMatch match = re.match(line);
-                if (match.hasMatch()) {
-                    QString firmwareName = match.captured(1);
-                    
-                    QJsonObject firmwareInfo;
-                    firmwareInfo["name"] = firmwareName;
-                    firmwareInfo["status"] = "missing";
-                    firmwareInfo["type"] = "firmware";
-                    firmwareInfo["error"] = line.trimmed();
-                    
-                    emit firmwareFound(firmwareInfo);
-                }
-            }
-        }
+        QJsonObject firmwareInfo;
+        firmwareInfo["name"] = firmware.name;
+        firmwareInfo["status"] = "missing";
+        firmwareInfo["type"] = "firmware";
+        firmwareInfo["error"] = firmware.message;
+        firmwareInfo["device"] = firmware.device;
+        firmwareInfo["count"] = firmware.count;
+        firmwareInfo["last_seen"] = QString::number(firmware.lastSeen, 'f', 6);
         
-        process->deleteLater();
-    });
-    
-    process->start("dmesg");
+        report(FirmwareResult, firmwareInfo);
+    }
 }
 
 void HardwareScanner::scanDrivers()
 {
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-        if (m_stopRequested || exitCode != 0) {
-            process->deleteLater();
-            return;
-        }
-        
-        QString output = process->readAllStandardOutput();
-        QStringList lines = output.split('\n');
+    const QSharedPointer<const ModuleInventory> inventory = ModuleInventory::snapshot();
+    
+    for (const LoadedModule &module : inventory->loadedModules()) {
+        if (m_stopRequested) return;
         
-        for (int i = 1; i < lines.size(); ++i) {
-            if (m_stopRequested) {
-                process->deleteLater();
-                return;
-            }
-            
-            const QString &line = lines[i];
-            if (line.isEmpty()) continue;
-            
-            QJsonObject driverInfo = parseDriverInfo(line);
-            if (!driverInfo.isEmpty()) {
-                emit driverFound(driverInfo);
-            }
-        }
+        QJsonObject driverInfo;
+        driverInfo["name"] = module.name;
+        driverInfo["version"] = driverVersion(module.name);
+        driverInfo["size"] = QString::number(module.size);
+        driverInfo["used_by"] = module.usedBy.join(", ");
+        driverInfo["status"] = "loaded";
+        driverInfo["type"] = "kernel_driver";
         
-        process->deleteLater();
-    });
-    
-    process->start("lsmod");
+        report(DriverResult, driverInfo);
+    }
 }
 
 void HardwareScanner::scanGPUDrivers()
 {
-    // Check for NVIDIA drivers
-    QProcess nvidia;
-    nvidia.start("nvidia-smi", QStringList() << "--query-gpu=name,driver_version" << "--format=csv,noheader,nounits");
-    if (nvidia.waitForFinished(3000)) {
-        QString output = nvidia.readAllStandardOutput();
-        if (!output.isEmpty()) {
-            QStringList lines = output.trimmed().split('\n');
-            for (const QString &line : lines) {
-                QStringList parts = line.split(", ");
-                if (parts.size() >= 2) {
-                    QJsonObject driverInfo;
-                    driverInfo["name"] = "nvidia";
-                    driverInfo["version"] = parts[1];
-                    driverInfo["device"] = parts[0];
-                    driverInfo["type"] = "gpu_driver";
-                    driverInfo["status"] = "loaded";
-                    emit driverFound(driverInfo);
-                }
-            }
-        }
-    }
-    
-    // Check for AMD drivers
-    QProcess amd;
-    amd.start("lspci", QStringList() << "-k");
-    if (amd.waitForFinished(3000)) {
-        QString output = amd.readAllStandardOutput();
-        if (output.contains("amdgpu") || output.contains("radeon")) {
-            QJsonObject driverInfo;
-            driverInfo["name"] = output.contains("amdgpu") ? "amdgpu" : "radeon";
-            driverInfo["type"] = "gpu_driver";
-            driverInfo["status"] = "loaded";
-            emit driverFound(driverInfo);
-        }
+    for (const SysfsDevice &device : pciDevices()) {
+        if (m_stopRequested) return;
+        
+        // PCI base class 0x03: display controllers
+        if (device.baseClass() != 0x03 || device.driver.isEmpty()) continue;
+        
+        QJsonObject driverInfo;
+        driverInfo["name"] = device.driver;
+        driverInfo["version"] = driverVersion(device.driver);
+        driverInfo["device"] = device.deviceName();
+        driverInfo["type"] = "gpu_driver";
+        driverInfo["status"] = "loaded";
+        report(DriverResult, driverInfo);
     }
 }
 
 void HardwareScanner::scanNetworkDrivers()
 {
-    QProcess process;
-    process.start("lspci", QStringList() << "-k");
-    if (!process.waitForFinished(5000)) return;
-    
-    QString output = process.readAllStandardOutput();
-    QStringList lines = output.split('\n');
-    
-    for (int i = 0; i < lines.size(); ++i) {
+    for (const SysfsDevice &device : pciDevices()) {
         if (m_stopRequested) return;
         
-        if (lines[i].contains("Network") || lines[i].contains("Ethernet") || lines[i].contains("Wireless")) {
-            // Look for driver in the next few lines
-            for (int j = i + 1; j < qMin(i + 5, lines.size()); ++j) {
-                if (lines[j].contains("Kernel driver in use:")) {
-                    QString driver = lines[j].split(":").last().trimmed();
-                    
-                    QJsonObject driverInfo;
-                    driverInfo["name"] = driver;
-                    driverInfo["type"] = "network_driver";
-                    driverInfo["status"] = "loaded";
-                    driverInfo["device"] = lines[i].split(": ").last();
-                    
-                    emit driverFound(driverInfo);
-                    break;
-                }
-            }
-        }
+        // 0x02: network controllers, 0x0d: wireless controllers
+        if ((device.baseClass() != 0x02 && device.baseClass() != 0x0d) || device.driver.isEmpty()) continue;
+        
+        QJsonObject driverInfo;
+        driverInfo["name"] = device.driver;
+        driverInfo["version"] = driverVersion(device.driver);
+        driverInfo["type"] = "network_driver";
+        driverInfo["status"] = "loaded";
+        driverInfo["device"] = device.deviceName();
+        report(DriverResult, driverInfo);
     }
 }
 
 void HardwareScanner::scanAudioDrivers()
 {
-    QProcess process;
-    process.start("lspci", QStringList() << "-k");
-    if (!process.waitForFinished(5000)) return;
-    
-    QString output = process.readAllStandardOutput();
-    QStringList lines = output.split('\n');
-    
-    for (int i = 0; i < lines.size(); ++i) {
+    for (const SysfsDevice &device : pciDevices()) {
         if (m_stopRequested) return;
         
-        if (lines[i].contains("Audio") || lines[i].contains("sound")) {
-            // Look for driver in the next few lines
-            for (int j = i + 1; j < qMin(i + 5, lines.size()); ++j) {
-                if (lines[j].contains("Kernel driver in use:")) {
-                    QString driver = lines[j].split(":").last().trimmed();
-                    
-                    QJsonObject driverInfo;
-                    driverInfo["name"] = driver;
-                    driverInfo["type"] = "audio_driver";
-                    driverInfo["status"] = "loaded";
-                    driverInfo["device"] = lines[i].split(": ").last();
-                    
-                    emit driverFound(driverInfo);
-                    break;
-                }
-            }
-        }
+        // 0x04: multimedia controllers, 0x0403 is HD Audio
+        if (device.baseClass() != 0x04 || device.driver.isEmpty()) continue;
+        
+        QJsonObject driverInfo;
+        driverInfo["name"] = device.driver;
+        driverInfo["version"] = driverVersion(device.driver);
+        driverInfo["type"] = "audio_driver";
+        driverInfo["status"] = "loaded";
+        driverInfo["device"] = device.deviceName();
+        report(DriverResult, driverInfo);
     }
 }
 
-QJsonObject HardwareScanner::parseLspciOutput(const QString &output)
+QString HardwareScanner::driverVersion(const QString &driver)
 {
-    QJsonObject device;
-    QStringList parts = output.split(" ", Qt::SkipEmptyParts);
-    
-    if (parts.size() < 2) return device;
-    
-    device["bus_id"] = parts[0];
-    device["type"] = "pci";
-    
-    QString description = output;
-    description.remove(QRegularExpression("^[0-9a-f:.]+\\s+"));
-    
-    // Extract vendor and device IDs
-    QRegularExpression vendorRe("\\[([0-9a-f]{4}):([0-9a-f]{4})\\]");
-    QRegularExpressionMatch match = vendorRe.match(description);
-    if (match.hasMatch()) {
-        device["vendor_id"] = match.captured(1);
-        device["device_id"] = match.captured(2);
-        description.remove(vendorRe);
+    // Out-of-tree modules (nvidia, vboxdrv...) export their version here
+    QFile file("/sys/module/" + QString(driver).replace('-', '_') + "/version");
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QString();
     }
-    
-    device["description"] = description.trimmed();
-    device["status"] = "detected";
-    
-    return device;
-}
-
-QJsonObject HardwareScanner::parseLsusbOutput(const QString &output)
-{
-    QJsonObject device;
-    QStringList parts = output.split(" ", Qt::SkipEmptyParts);
-    
-    if (parts.size() < 6) return device;
-    
-    device["bus"] = parts[1];
-    device["device"] = parts[3].chopped(1); // Remove ':'
-    device["type"] = "usb";
-    
-    // Extract vendor and product IDs
-    QString idPart = parts[5];
-    if (idPart.contains(":")) {
-        QStringList ids = idPart.split(":");
-        device["vendor_id"] = ids[0];
-        device["product_id"] = ids[1];
-    }
-    
-    QString description = output;
-    description.remove(QRegularExpression("^Bus \\d+ Device \\d+: ID [0-9a-f:]+\\s+"));
-    device["description"] = description.trimmed();
-    device["status"] = "detected";
-    
-    return device;
+    return QString::fromLatin1(file.readAll().trimmed());
 }
 
 QJsonObject HardwareScanner::parseModinfoOutput(const QString &output)
@@ -555,25 +389,6 @@ QJsonObject HardwareScanner::parseModinfoOutput(const QString &output)
     return moduleInfo;
 }
 
-QJsonObject HardwareScanner::parseLsmodOutput(const QString &output)
-{
-    QJsonObject moduleInfo;
-    QStringList parts = output.split(QRegularExpression("\\s+"));
-    
-    if (parts.size() >= 3) {
-        moduleInfo["name"] = parts[0];
-        moduleInfo["size"] = parts[1];
-        moduleInfo["used_count"] = parts[2];
-        if (parts.size() > 3) {
-            moduleInfo["used_by"] = parts[3];
-        }
-        moduleInfo["status"] = "loaded";
-        moduleInfo["type"] = "kernel_module";
-    }
-    
-    return moduleInfo;
-}
-
 QJsonObject HardwareScanner::parseFirmwareInfo(const QString &output)
 {
     // Implementation for parsing firmware information
@@ -582,22 +397,6 @@ QJsonObject HardwareScanner::parseFirmwareInfo(const QString &output)
     return firmwareInfo;
 }
 
-QJsonObject HardwareScanner::parseDriverInfo(const QString &line)
-{
-    QJsonObject driverInfo;
-    QStringList parts = line.split(QRegularExpression("\\s+"));
-    
-    if (parts.size() >= 3) {
-        driverInfo["name"] = parts[0];
-        driverInfo["size"] = parts[1];
-        driverInfo["used_by"] = parts[2];
-        driverInfo["status"] = "loaded";
-        driverInfo["type"] = "kernel_driver";
-    }
-    
-    return driverInfo;
-}
-
 // DriverManager Implementation
 DriverManager::DriverManager(QWidget *parent)
     : QWidget(parent)
@@ -607,10 +406,16 @@ DriverManager::DriverManager(QWidget *parent)
     , m_tabWidget(nullptr)
     , m_hardwareScanner(nullptr)
     , m_refreshTimer(new QTimer(this))
+    , m_ueventMonitor(new UeventMonitor(this))
+    , m_moduleBuilder(new ModuleBuilder(this))
+    , m_initramfsBuilder(new InitramfsBuilder(this))
+    , m_tableFlushTimer(new QTimer(this))
     , m_autoRefresh(true)
     , m_refreshInterval(30000) // 30 seconds
     , m_isScanning(false)
 {
+    TraceSpan span("DriverManager::DriverManager");
+    
     setupUI();
     setupContextMenus();
     
@@ -629,6 +434,24 @@ DriverManager::DriverManager(QWidget *parent)
     connect(m_hardwareScanner, &HardwareScanner::errorOccurred,
             this, &DriverManager::onScanError);
     
+    // Scanner batches are merged right away but drawn at most once per frame
+    m_tableFlushTimer->setSingleShot(true);
+    m_tableFlushTimer->setInterval(16);
+    connect(m_tableFlushTimer, &QTimer::timeout, this, &DriverManager::flushTableUpdates);
+    
+    // Hotplug, driver bind/unbind and module load/unload update the tables
+    // in place, so no periodic rescan is needed to notice them
+    connect(m_ueventMonitor, &UeventMonitor::ueventReceived, this, &DriverManager::onUevent);
+    m_ueventMonitor->start();
+    
+    connect(m_moduleBuilder, &ModuleBuilder::buildStarted, this, &DriverManager::onModuleBuildStarted);
+    connect(m_moduleBuilder, &ModuleBuilder::buildOutput, this, &DriverManager::onModuleBuildOutput);
+    connect(m_moduleBuilder, &ModuleBuilder::buildFinished, this, &DriverManager::onModuleBuildFinished);
+    connect(m_moduleBuilder, &ModuleBuilder::finished, this, &DriverManager::onModuleBuildsFinished);
+    connect(m_initramfsBuilder, &InitramfsBuilder::imageOutput, this, &DriverManager::onInitramfsOutput);
+    connect(m_initramfsBuilder, &InitramfsBuilder::imageFinished, this, &DriverManager::onInitramfsImageFinished);
+    connect(m_initramfsBuilder, &InitramfsBuilder::finished, this, &DriverManager::onInitramfsBuildsFinished);
+    
     // Setup refresh timer (but don't start it automatically)
     connect(m_refreshTimer, &QTimer::timeout, this, &DriverManager::onRefreshTimer);
     m_autoRefresh = false; // Disable auto-refresh to prevent startup prompts
@@ -759,10 +582,7 @@ void DriverManager::setupToolbar()
         refreshModules();
         refreshFirmware();
     });
-    connect(detectHardwareButton, &QPushButton::clicked, [this]() {
-        m_hardwareScanner->setScanType("hardware");
-        m_hardwareScanner->start();
-    });
+    connect(detectHardwareButton, &QPushButton::clicked, this, &DriverManager::refreshHardware);
     connect(installMissingButton, &QPushButton::clicked, this, &DriverManager::installMissingDrivers);
     connect(updateAllButton, &QPushButton::clicked, this, &DriverManager::updateAllDrivers);
     
@@ -831,7 +651,7 @@ void DriverManager::setupHardwareTab()
     connect(m_refreshHardwareButton, &QPushButton::clicked, this, &DriverManager::refreshHardware);
     connect(m_hardwareDetailsButton, &QPushButton::clicked, this, &DriverManager::showHardwareDetails);
     connect(m_installDriverButton, &QPushButton::clicked, this, &DriverManager::installDriver);
-    connect(m_findDriverButton, &QPushButton::clicked, this, &DriverManager::showDriverInstaller);
+    connect(m_findDriverButton, &QPushButton::clicked, this, &DriverManager::findDriverForSelectedDevice);
     connect(m_deviceManagerButton, &QPushButton::clicked, this, &DriverManager::showSystemInfo);
     connect(m_hardwareReportButton, &QPushButton::clicked, this, &DriverManager::generateHardwareReport);
     
@@ -1169,6 +989,7 @@ void DriverManager::refreshHardware()
 {
     m_hardwareScanner->setScanType("hardware");
     if (!m_hardwareScanner->isRunning()) {
+        clearResults(m_hardwareTable, m_hardware, m_hardwareRows);
         m_isScanning = true;
         m_statusLabel->setText("Scanning hardware...");
         m_hardwareScanner->start();
@@ -1179,6 +1000,7 @@ void DriverManager::refreshDrivers()
 {
     m_hardwareScanner->setScanType("drivers");
     if (!m_hardwareScanner->isRunning()) {
+        clearResults(m_driverTable, m_drivers, m_driverRows);
         m_isScanning = true;
         m_statusLabel->setText("Scanning drivers...");
         m_hardwareScanner->start();
@@ -1189,6 +1011,7 @@ void DriverManager::refreshModules()
 {
     m_hardwareScanner->setScanType("modules");
     if (!m_hardwareScanner->isRunning()) {
+        clearResults(m_moduleTable, m_modules, m_moduleRows);
         m_isScanning = true;
         m_statusLabel->setText("Scanning modules...");
         m_hardwareScanner->start();
@@ -1199,6 +1022,7 @@ void DriverManager::refreshFirmware()
 {
     m_hardwareScanner->setScanType("firmware");
     if (!m_hardwareScanner->isRunning()) {
+        clearResults(m_firmwareTable, m_firmware, m_firmwareRows);
         m_isScanning = true;
         m_statusLabel->setText("Scanning firmware...");
         m_hardwareScanner->start();
@@ -1207,56 +1031,365 @@ void DriverManager::refreshFirmware()
 
 void DriverManager::scanMissingDrivers()
 {
-    if (m_privilegedExecutor) {
-        QString taskId = "scan_missing_drivers";
-        QStringList commands = {
-            "lspci -k | grep -A3 -B1 'Kernel driver'",
-            "dmesg | grep -i 'firmware.*failed'",
-            "modprobe -D nonexistent 2>&1 | grep -i 'not found' || true"
-        };
+    if (m_hardware.isEmpty()) {
+        showInfo("Missing Drivers", "Scan the hardware first.");
+        return;
+    }
+    
+    const KernelModuleIndex &index = KernelModuleIndex::runningKernel();
+    QStringList notLoaded;
+    QStringList unsupported;
+    
+    QMutexLocker locker(&m_dataMutex);
+    for (const QJsonObject &hw : m_hardware) {
+        if (!hw["driver"].toString().isEmpty()) continue;
+        
+        // Bridges and other chipset plumbing normally run without a driver
+        if (hw["type"].toString() == "pci" && hw["class_id"].toString().startsWith("06")) continue;
+        
+        const QStringList modules = index.match(modaliases(hw));
+        if (modules.isEmpty()) {
+            unsupported << QString("%1 (%2)").arg(hw["description"].toString(), hw["bus_id"].toString());
+        } else {
+            notLoaded << QString("%1: %2").arg(hw["description"].toString(), modules.join(", "));
+        }
+    }
+    locker.unlock();
+    
+    if (notLoaded.isEmpty() && unsupported.isEmpty()) {
+        showInfo("Missing Drivers", "Every device is bound to a driver.");
+        return;
+    }
+    
+    QString report;
+    if (!notLoaded.isEmpty()) {
+        report += "Devices with a matching module that is not bound:\n" + notLoaded.join("\n") + "\n\n";
+    }
+    if (!unsupported.isEmpty()) {
+        report += QString("Devices no module of kernel %1 claims:\n").arg(index.kernelRelease())
+                  + unsupported.join("\n");
+    }
+    showInfo("Missing Drivers", report.trimmed());
+}
+
+void DriverManager::findDriverForSelectedDevice()
+{
+    int row = m_hardwareTable->currentRow();
+    if (row < 0) return;
+    
+    QTableWidgetItem *nameItem = m_hardwareTable->item(row, HARDWARE_TABLE_NAME_COLUMN);
+    if (!nameItem) return;
+    
+    QMutexLocker locker(&m_dataMutex);
+    const int index = nameItem->data(Qt::UserRole).toInt();
+    if (index < 0 || index >= m_hardware.size()) return;
+    const QString deviceId = m_hardware[index]["bus_id"].toString();
+    locker.unlock();
+    
+    findDriverForDevice(deviceId);
+}
+
+void DriverManager::findDriverForDevice(const QString &deviceId)
+{
+    QJsonObject device;
+    {
+        QMutexLocker locker(&m_dataMutex);
+        for (const QJsonObject &hw : m_hardware) {
+            if (hw["bus_id"].toString() == deviceId) {
+                device = hw;
+                break;
+            }
+        }
+    }
+    if (device.isEmpty()) return;
+    
+    const KernelModuleIndex &index = KernelModuleIndex::runningKernel();
+    const QString deviceName = device["description"].toString();
+    const QStringList modules = index.match(modaliases(device));
+    
+    if (modules.isEmpty()) {
+        showInfo("Find Driver", QString("No module of kernel %1 supports %2.\n\n"
+                                        "The device may need an out-of-tree or proprietary driver.")
+                                .arg(index.kernelRelease(), deviceName));
+        return;
+    }
+    
+    // Owning packages are only looked up for modules that are actually shown
+    QStringList unresolved;
+    for (const QString &module : modules) {
+        const QString path = index.modulePath(module);
+        if (!path.isEmpty() && !m_modulePackages.contains(path)) {
+            unresolved << path;
+        }
+    }
+    
+    auto showCandidates = [this, device, modules, deviceName]() {
+        const KernelModuleIndex &index = KernelModuleIndex::runningKernel();
+        const QString boundDriver = device["driver"].toString();
         
-        m_privilegedExecutor->executeCommand("sh", QStringList() << "-c" << commands.join(" && "));
+        QStringList lines;
+        for (const QString &module : modules) {
+            QString state;
+            if (index.isBuiltin(module)) {
+                state = "built into the kernel";
+            } else if (KernelModuleIndex::isModuleLoaded(module)) {
+                state = "loaded";
+            } else {
+                state = "not loaded";
+            }
+            
+            QString line = QString("%1 - %2").arg(module, state);
+            const QString package = m_modulePackages.value(index.modulePath(module));
+            if (!package.isEmpty()) {
+                line += QString(" (%1)").arg(package);
+            }
+            if (KernelModuleIndex::normalizeName(boundDriver) == module) {
+                line += ", in use";
+            }
+            lines << line;
+        }
+        
+        showInfo("Find Driver", QString("%1\nModalias: %2\n\nCandidate modules:\n%3")
+                                .arg(deviceName, modaliases(device).join(", "), lines.join("\n")));
+    };
+    
+    if (unresolved.isEmpty()) {
+        showCandidates();
+        return;
     }
+    
+    ProcessRunner::instance()->run("rpm", QStringList() << "-qf" << "--qf" << "%{NAME}\n" << unresolved)
+        .then(this, [this, unresolved, showCandidates](const ProcessResult &result) {
+        // rpm -qf prints one line per file, in argument order, also for unowned files
+        const QStringList owners = QString::fromUtf8(result.standardOutput).split('\n');
+        for (int i = 0; i < unresolved.size() && i < owners.size(); ++i) {
+            const QString owner = owners[i].trimmed();
+            m_modulePackages.insert(unresolved[i], owner.contains(' ') ? QString() : owner);
+        }
+        showCandidates();
+    });
 }
 
-void DriverManager::onHardwareFound(const QJsonObject &hardwareInfo)
+void DriverManager::onHardwareFound(const QList<QJsonObject> &hardware)
 {
     QMutexLocker locker(&m_dataMutex);
-    m_hardware.append(hardwareInfo);
+    mergeResults(m_hardware, m_hardwareRows, hardware, hardwareKey);
     
-    // Update table in main thread
-    QMetaObject::invokeMethod(this, "updateHardwareTable", Qt::QueuedConnection);
+    if (!m_tableFlushTimer->isActive()) {
+        m_tableFlushTimer->start();
+    }
 }
 
-void DriverManager::onDriverFound(const QJsonObject &driverInfo)
+void DriverManager::onDriverFound(const QList<QJsonObject> &drivers)
 {
     QMutexLocker locker(&m_dataMutex);
-    m_drivers.append(driverInfo);
+    mergeResults(m_drivers, m_driverRows, drivers, driverKey);
     
-    // Update table in main thread
-    QMetaObject::invokeMethod(this, "updateDriverTable", Qt::QueuedConnection);
+    if (!m_tableFlushTimer->isActive()) {
+        m_tableFlushTimer->start();
+    }
 }
 
-void DriverManager::onModuleFound(const QJsonObject &moduleInfo)
+void DriverManager::onModuleFound(const QList<QJsonObject> &modules)
 {
     QMutexLocker locker(&m_dataMutex);
-    m_modules.append(moduleInfo);
+    mergeResults(m_modules, m_moduleRows, modules, moduleKey);
+    
+    if (!m_tableFlushTimer->isActive()) {
+        m_tableFlushTimer->start();
+    }
+}
+
+void DriverManager::onFirmwareFound(const QList<QJsonObject> &firmware)
+{
+    QMutexLocker locker(&m_dataMutex);
+    mergeResults(m_firmware, m_firmwareRows, firmware, firmwareKey);
+    
+    if (!m_tableFlushTimer->isActive()) {
+        m_tableFlushTimer->start();
+    }
+}
+
+void DriverManager::mergeResults(QList<QJsonObject> &data, ResultRows &rows, const QList<QJsonObject> &batch,
+                                 QString (*keyOf)(const QJsonObject &))
+{
+    for (const QJsonObject &info : batch) {
+        const QString key = keyOf(info);
+        const auto existing = rows.indexByKey.constFind(key);
+        if (existing == rows.indexByKey.constEnd()) {
+            rows.indexByKey.insert(key, data.size());
+            data.append(info);
+            continue;
+        }
+        
+        // e.g. a module first seen on disk as available and then as loaded
+        QJsonObject &merged = data[existing.value()];
+        for (auto it = info.constBegin(); it != info.constEnd(); ++it) {
+            merged.insert(it.key(), it.value());
+        }
+        rows.dirty.insert(existing.value());
+    }
+}
+
+void DriverManager::onUevent(const Uevent &event)
+{
+    if (event.subsystem == "module") {
+        if (event.action != "add" && event.action != "remove") return;
+        ModuleInventory::invalidate();
+        
+        const QString name = event.devpath.section('/', -1);
+        QJsonObject moduleInfo;
+        moduleInfo["name"] = name;
+        
+        QJsonObject driverInfo;
+        driverInfo["name"] = name;
+        driverInfo["type"] = "kernel_driver";
+        
+        if (event.action == "add") {
+            moduleInfo["status"] = "loaded";
+            driverInfo["status"] = "loaded";
+            onModuleFound(QList<QJsonObject>() << moduleInfo);
+            onDriverFound(QList<QJsonObject>() << driverInfo);
+        } else {
+            moduleInfo["status"] = "available";
+            moduleInfo["used_by"] = QString();
+            moduleInfo["used_count"] = "0";
+            onModuleFound(QList<QJsonObject>() << moduleInfo);
+            removeResult(m_driverTable, m_drivers, m_driverRows, driverKey(driverInfo));
+        }
+        return;
+    }
+    
+    if (event.subsystem != "pci" && event.subsystem != "usb") return;
+    
+    // Interface drivers of a USB device are shown on the device itself
+    QString sysfsPath = event.sysfsPath();
+    if (event.devtype == "usb_interface") {
+        if (event.action == "remove") return;
+        sysfsPath = QFileInfo(sysfsPath).path();
+    }
+    
+    QJsonObject key;
+    key["type"] = event.subsystem;
+    key["bus_id"] = QFileInfo(sysfsPath).fileName();
+    
+    if (event.action == "remove") {
+        removeResult(m_hardwareTable, m_hardware, m_hardwareRows, hardwareKey(key));
+        return;
+    }
+    
+    SysfsDevice device;
+    if (SysfsDeviceEnumerator::readDevice(event.subsystem, sysfsPath, &device)) {
+        onHardwareFound(QList<QJsonObject>() << HardwareScanner::deviceInfo(device));
+    }
+}
+
+void DriverManager::onModuleBuildStarted(const QString &tag)
+{
+    m_statusLabel->setText("Building " + tag);
+}
+
+void DriverManager::onModuleBuildOutput(const QString &tag, const QString &line)
+{
+    m_outputTextEdit->append(tag.isEmpty() ? line : QString("[%1] %2").arg(tag, line));
+}
+
+void DriverManager::onModuleBuildFinished(const QString &tag, bool success)
+{
+    m_progressBar->setValue(m_progressBar->value() + 1);
+    m_outputTextEdit->append(QString("[%1] %2").arg(tag, success ? "built" : "FAILED"));
+}
+
+void DriverManager::onModuleBuildsFinished(int built, int failed, int skipped)
+{
+    m_progressBar->setVisible(false);
+    m_statusLabel->setText(QString("Module builds: %1 built, %2 failed, %3 up to date")
+                           .arg(built).arg(failed).arg(skipped));
+    
+    if (built > 0) {
+        ModuleInventory::invalidate();
+        refreshModules();
+    }
+    if (failed > 0) {
+        showError("Module Builds", QString("%1 module build(s) failed; see the build log for details.").arg(failed));
+    }
+}
+
+void DriverManager::onInitramfsOutput(const QString &kernel, const QString &line)
+{
+    m_outputTextEdit->append(kernel.isEmpty() ? line : QString("[%1] %2").arg(kernel, line));
+}
+
+void DriverManager::onInitramfsImageFinished(const QString &kernel, bool success, qint64 elapsedMs)
+{
+    m_progressBar->setValue(m_progressBar->value() + 1);
+    m_outputTextEdit->append(success ? QString("[%1] rebuilt in %2 s").arg(kernel).arg(elapsedMs / 1000.0, 0, 'f', 1)
+                                     : QString("[%1] FAILED after %2 s").arg(kernel).arg(elapsedMs / 1000.0, 0, 'f', 1));
+}
+
+void DriverManager::onInitramfsBuildsFinished(int built, int failed, int skipped)
+{
+    m_progressBar->setVisible(false);
+    m_statusLabel->setText(QString("Initramfs: %1 rebuilt, %2 failed, %3 unchanged")
+                           .arg(built).arg(failed).arg(skipped));
     
-    // Update table in main thread
-    QMetaObject::invokeMethod(this, "updateModuleTable", Qt::QueuedConnection);
+    if (failed > 0) {
+        showError("Rebuild Initramfs", QString("%1 image(s) failed to rebuild; see the output for details.").arg(failed));
+    }
 }
 
-void DriverManager::onFirmwareFound(const QJsonObject &firmwareInfo)
+void DriverManager::removeResult(QTableWidget *table, QList<QJsonObject> &data, ResultRows &rows, const QString &key)
 {
     QMutexLocker locker(&m_dataMutex);
-    m_firmware.append(firmwareInfo);
     
-    // Update table in main thread
-    QMetaObject::invokeMethod(this, "updateFirmwareTable", Qt::QueuedConnection);
+    const auto it = rows.indexByKey.find(key);
+    if (it == rows.indexByKey.end()) return;
+    
+    const int removed = it.value();
+    rows.indexByKey.erase(it);
+    data.removeAt(removed);
+    
+    // Everything after the removed entry moves up by one, in the index and in
+    // the rows already on screen
+    for (auto entry = rows.indexByKey.begin(); entry != rows.indexByKey.end(); ++entry) {
+        if (entry.value() > removed) {
+            --entry.value();
+        }
+    }
+    
+    QSet<int> dirty;
+    for (int index : rows.dirty) {
+        if (index != removed) {
+            dirty.insert(index > removed ? index - 1 : index);
+        }
+    }
+    rows.dirty = dirty;
+    
+    for (int row = table->rowCount() - 1; row >= 0; --row) {
+        QTableWidgetItem *item = table->item(row, 0);
+        if (!item) continue;
+        
+        const int index = item->data(Qt::UserRole).toInt();
+        if (index == removed) {
+            table->removeRow(row);
+        } else if (index > removed) {
+            item->setData(Qt::UserRole, index - 1);
+        }
+    }
+}
+
+void DriverManager::clearResults(QTableWidget *table, QList<QJsonObject> &data, ResultRows &rows)
+{
+    QMutexLocker locker(&m_dataMutex);
+    data.clear();
+    rows = ResultRows();
+    table->setRowCount(0);
 }
 
 void DriverManager::onScanFinished()
 {
+    m_tableFlushTimer->stop();
+    flushTableUpdates();
     m_isScanning = false;
     m_statusLabel->setText("Ready");
     updateInfoPanel();
@@ -1286,6 +1419,7 @@ void DriverManager::onTaskCompleted(const QString &taskId, bool success, const Q
         m_statusLabel->setText("Task completed successfully");
         if (taskId.contains("install") || taskId.contains("remove") || taskId.contains("update")) {
             // Refresh relevant data
+            ModuleInventory::invalidate();
             refreshHardware();
             refreshDrivers();
             refreshModules();
@@ -1516,19 +1650,60 @@ void DriverManager::updateAllDrivers()
     commands << "dnf update -y kernel*";
     commands << "dnf update -y linux-firmware";
     commands << "dnf update -y @hardware-support";
-    commands << "dkms autoinstall";
     
-    m_privilegedExecutor->executeCommand("sh", QStringList() << "-c" << commands.join(" && "));
+    m_statusLabel->setText("Updating kernel, firmware and hardware support packages...");
+    m_privilegedExecutor->executeCommand("sh", QStringList() << "-c" << commands.join(" && "))
+        .then(this, [this](const ProcessResult &result) {
+        if (!result.success()) {
+            m_statusLabel->setText("Driver update failed");
+            showError("Update Drivers", result.errorString.isEmpty() ? result.output() : result.errorString);
+            return;
+        }
+        
+        // Only now are the new kernels there to plan module builds for
+        autoinstallDKMSModules();
+    });
 }
 
 void DriverManager::rebuildInitramfs()
 {
-    if (!m_privilegedExecutor) return;
-    
-    QString taskId = "rebuild_initramfs";
-    QString command = QString("dracut --force --regenerate-all");
+    startInitramfsBuilds(QStringList(), false);
+}
+
+void DriverManager::rebuildInitramfsForKernel(const QString &kernelVersion)
+{
+    startInitramfsBuilds(QStringList() << kernelVersion, true);
+}
+
+void DriverManager::startInitramfsBuilds(const QStringList &kernels, bool force)
+{
+    if (m_initramfsBuilder->isRunning()) {
+        showInfo("Rebuild Initramfs", "Initramfs images are already being rebuilt.");
+        return;
+    }
     
-    m_privilegedExecutor->executeCommand("sh", QStringList() << "-c" << command);
+    m_statusLabel->setText("Checking which initramfs images need rebuilding...");
+    m_initramfsBuilder->plan(kernels, force).then(this, [this](const QList<InitramfsImage> &images) {
+        if (m_initramfsBuilder->isRunning()) return;
+        
+        int pending = 0;
+        for (const InitramfsImage &image : images) {
+            if (image.needsRebuild) ++pending;
+        }
+        
+        m_outputTextEdit->clear();
+        m_outputTextEdit->setVisible(pending > 0);
+        m_progressBar->setRange(0, qMax(pending, 1));
+        m_progressBar->setValue(0);
+        m_progressBar->setVisible(pending > 0);
+        m_statusLabel->setText(QString("Rebuilding %1 initramfs image(s), %2 at a time...")
+                               .arg(pending).arg(InitramfsBuilder::buildSlots(pending)));
+        
+        if (!m_initramfsBuilder->start(images)) {
+            m_progressBar->setVisible(false);
+            showError("Rebuild Initramfs", "No privilege escalation method available");
+        }
+    });
 }
 
 void DriverManager::installDriver()
@@ -1727,11 +1902,28 @@ void DriverManager::removeFirmware()
     if (!nameItem) return;
     
     QString firmwareName = nameItem->text();
+    const FirmwareFile file = FirmwareIndex::instance().file(firmwareName);
+    if (file.path.isEmpty()) {
+        showError("Remove Firmware", QString("%1 is not installed.").arg(firmwareName));
+        return;
+    }
+    
+    if (!file.package.isEmpty()) {
+        const QMessageBox::StandardButton answer = QMessageBox::question(this, "Remove Firmware",
+            QString("%1 belongs to the %2 package and will come back with its next update.\n\n"
+                    "Remove the file anyway?").arg(firmwareName, file.package));
+        if (answer != QMessageBox::Yes) return;
+    }
     
     if (m_privilegedExecutor) {
-        QString taskId = "remove_firmware_" + firmwareName;
-        QString command = QString("rm -f /lib/firmware/%1").arg(firmwareName);
-        m_privilegedExecutor->executeCommand("sh", QStringList() << "-c" << command);
+        // The file and every symlinked name pointing at it
+        QStringList paths;
+        paths << file.path;
+        const QString root = file.path.left(file.path.size() - file.names.first().size());
+        for (int i = 1; i < file.names.size(); ++i) {
+            paths << root + file.names.at(i);
+        }
+        m_privilegedExecutor->executeCommand("rm", QStringList() << "-f" << "--" << paths);
     }
 }
 
@@ -1814,6 +2006,7 @@ void DriverManager::detectMissingFirmware()
 {
     m_hardwareScanner->setScanType("firmware");
     if (!m_hardwareScanner->isRunning()) {
+        clearResults(m_firmwareTable, m_firmware, m_firmwareRows);
         m_isScanning = true;
         m_statusLabel->setText("Scanning for missing firmware...");
         m_hardwareScanner->start();
@@ -1828,21 +2021,9 @@ void DriverManager::updateHardwareTable()
     m_hardwareTable->setRowCount(m_hardware.size());
     
     for (int i = 0; i < m_hardware.size(); ++i) {
-        const QJsonObject &hw = m_hardware[i];
-        
-        m_hardwareTable->setItem(i, HARDWARE_TABLE_NAME_COLUMN, 
-                                 new QTableWidgetItem(hw["description"].toString()));
-        m_hardwareTable->setItem(i, HARDWARE_TABLE_TYPE_COLUMN, 
-                                 new QTableWidgetItem(hw["type"].toString()));
-        m_hardwareTable->setItem(i, HARDWARE_TABLE_VENDOR_COLUMN, 
-                                 new QTableWidgetItem(hw["vendor_id"].toString()));
-        m_hardwareTable->setItem(i, HARDWARE_TABLE_MODEL_COLUMN, 
-                                 new QTableWidgetItem(hw["device_id"].toString()));
-        m_hardwareTable->setItem(i, HARDWARE_TABLE_DRIVER_COLUMN, 
-                                 new QTableWidgetItem(hw["driver"].toString()));
-        m_hardwareTable->setItem(i, HARDWARE_TABLE_STATUS_COLUMN, 
-                                 new QTableWidgetItem(hw["status"].toString()));
+        fillHardwareRow(i, m_hardware[i], i);
     }
+    m_hardwareRows.dirty.clear();
 }
 
 void DriverManager::updateDriverTable()
@@ -1853,19 +2034,9 @@ void DriverManager::updateDriverTable()
     m_driverTable->setRowCount(m_drivers.size());
     
     for (int i = 0; i < m_drivers.size(); ++i) {
-        const QJsonObject &driver = m_drivers[i];
-        
-        m_driverTable->setItem(i, DRIVER_TABLE_NAME_COLUMN, 
-                               new QTableWidgetItem(driver["name"].toString()));
-        m_driverTable->setItem(i, DRIVER_TABLE_VERSION_COLUMN, 
-                               new QTableWidgetItem(driver["version"].toString()));
-        m_driverTable->setItem(i, DRIVER_TABLE_TYPE_COLUMN, 
-                               new QTableWidgetItem(driver["type"].toString()));
-        m_driverTable->setItem(i, DRIVER_TABLE_STATUS_COLUMN, 
-                               new QTableWidgetItem(driver["status"].toString()));
-        m_driverTable->setItem(i, DRIVER_TABLE_DEVICES_COLUMN, 
-                               new QTableWidgetItem(driver["device"].toString()));
+        fillDriverRow(i, m_drivers[i], i);
     }
+    m_driverRows.dirty.clear();
 }
 
 void DriverManager::updateModuleTable()
@@ -1876,19 +2047,9 @@ void DriverManager::updateModuleTable()
     m_moduleTable->setRowCount(m_modules.size());
     
     for (int i = 0; i < m_modules.size(); ++i) {
-        const QJsonObject &module = m_modules[i];
-        
-        m_moduleTable->setItem(i, MODULE_TABLE_NAME_COLUMN, 
-                               new QTableWidgetItem(module["name"].toString()));
-        m_moduleTable->setItem(i, MODULE_TABLE_SIZE_COLUMN, 
-                               new QTableWidgetItem(module["size"].toString()));
-        m_moduleTable->setItem(i, MODULE_TABLE_USED_COLUMN, 
-                               new QTableWidgetItem(module["used_by"].toString()));
-        m_moduleTable->setItem(i, MODULE_TABLE_DEPENDENCIES_COLUMN, 
-                               new QTableWidgetItem(module["depends"].toString()));
-        m_moduleTable->setItem(i, MODULE_TABLE_STATUS_COLUMN, 
-                               new QTableWidgetItem(module["status"].toString()));
+        fillModuleRow(i, m_modules[i], i);
     }
+    m_moduleRows.dirty.clear();
 }
 
 void DriverManager::updateFirmwareTable()
@@ -1899,19 +2060,120 @@ void DriverManager::updateFirmwareTable()
     m_firmwareTable->setRowCount(m_firmware.size());
     
     for (int i = 0; i < m_firmware.size(); ++i) {
-        const QJsonObject &fw = m_firmware[i];
-        
-        m_firmwareTable->setItem(i, FIRMWARE_TABLE_NAME_COLUMN, 
-                                 new QTableWidgetItem(fw["name"].toString()));
-        m_firmwareTable->setItem(i, FIRMWARE_TABLE_VERSION_COLUMN, 
-                                 new QTableWidgetItem(fw["version"].toString()));
-        m_firmwareTable->setItem(i, FIRMWARE_TABLE_SIZE_COLUMN, 
-                                 new QTableWidgetItem(formatSize(fw["size"].toInt())));
-        m_firmwareTable->setItem(i, FIRMWARE_TABLE_DEVICE_COLUMN, 
-                                 new QTableWidgetItem(fw["device"].toString()));
-        m_firmwareTable->setItem(i, FIRMWARE_TABLE_STATUS_COLUMN, 
-                                 new QTableWidgetItem(fw["status"].toString()));
+        fillFirmwareRow(i, m_firmware[i], i);
     }
+    m_firmwareRows.dirty.clear();
+}
+
+void DriverManager::flushTableUpdates()
+{
+    QMutexLocker locker(&m_dataMutex);
+    
+    flushRows(m_hardwareTable, m_hardware, m_hardwareRows, &DriverManager::fillHardwareRow);
+    flushRows(m_driverTable, m_drivers, m_driverRows, &DriverManager::fillDriverRow);
+    flushRows(m_moduleTable, m_modules, m_moduleRows, &DriverManager::fillModuleRow);
+    flushRows(m_firmwareTable, m_firmware, m_firmwareRows, &DriverManager::fillFirmwareRow);
+}
+
+void DriverManager::flushRows(QTableWidget *table, const QList<QJsonObject> &data, ResultRows &rows,
+                              void (DriverManager::*fillRow)(int, const QJsonObject &, int))
+{
+    const int shown = table->rowCount();
+    if (shown == data.size() && rows.dirty.isEmpty()) {
+        return;
+    }
+    
+    // Sorting would move rows while they are being filled; it is restored,
+    // and reapplied, once the batch is in
+    const bool sorting = table->isSortingEnabled();
+    table->setSortingEnabled(false);
+    table->setUpdatesEnabled(false);
+    
+    // Rows may have been re-sorted, so find updated ones by their data index
+    if (!rows.dirty.isEmpty()) {
+        for (int row = 0; row < shown; ++row) {
+            const QTableWidgetItem *item = table->item(row, 0);
+            const int index = item ? item->data(Qt::UserRole).toInt() : -1;
+            if (rows.dirty.contains(index)) {
+                (this->*fillRow)(row, data[index], index);
+            }
+        }
+        rows.dirty.clear();
+    }
+    
+    table->setRowCount(data.size());
+    for (int index = shown; index < data.size(); ++index) {
+        (this->*fillRow)(index, data[index], index);
+    }
+    
+    table->setUpdatesEnabled(true);
+    table->setSortingEnabled(sorting);
+}
+
+void DriverManager::fillHardwareRow(int row, const QJsonObject &hw, int index)
+{
+    QTableWidgetItem *nameItem = new QTableWidgetItem(hw["description"].toString());
+    nameItem->setData(Qt::UserRole, index);
+    
+    m_hardwareTable->setItem(row, HARDWARE_TABLE_NAME_COLUMN, nameItem);
+    m_hardwareTable->setItem(row, HARDWARE_TABLE_TYPE_COLUMN, 
+                             new QTableWidgetItem(hw["type"].toString()));
+    m_hardwareTable->setItem(row, HARDWARE_TABLE_VENDOR_COLUMN, 
+                             new QTableWidgetItem(hw["vendor"].toString(hw["vendor_id"].toString())));
+    m_hardwareTable->setItem(row, HARDWARE_TABLE_MODEL_COLUMN, 
+                             new QTableWidgetItem(hw["vendor_id"].toString() + ":" + hw["device_id"].toString()));
+    m_hardwareTable->setItem(row, HARDWARE_TABLE_DRIVER_COLUMN, 
+                             new QTableWidgetItem(hw["driver"].toString()));
+    m_hardwareTable->setItem(row, HARDWARE_TABLE_STATUS_COLUMN, 
+                             new QTableWidgetItem(hw["status"].toString()));
+}
+
+void DriverManager::fillDriverRow(int row, const QJsonObject &driver, int index)
+{
+    QTableWidgetItem *nameItem = new QTableWidgetItem(driver["name"].toString());
+    nameItem->setData(Qt::UserRole, index);
+    
+    m_driverTable->setItem(row, DRIVER_TABLE_NAME_COLUMN, nameItem);
+    m_driverTable->setItem(row, DRIVER_TABLE_VERSION_COLUMN, 
+                           new QTableWidgetItem(driver["version"].toString()));
+    m_driverTable->setItem(row, DRIVER_TABLE_TYPE_COLUMN, 
+                           new QTableWidgetItem(driver["type"].toString()));
+    m_driverTable->setItem(row, DRIVER_TABLE_STATUS_COLUMN, 
+                           new QTableWidgetItem(driver["status"].toString()));
+    m_driverTable->setItem(row, DRIVER_TABLE_DEVICES_COLUMN, 
+                           new QTableWidgetItem(driver["device"].toString()));
+}
+
+void DriverManager::fillModuleRow(int row, const QJsonObject &module, int index)
+{
+    QTableWidgetItem *nameItem = new QTableWidgetItem(module["name"].toString());
+    nameItem->setData(Qt::UserRole, index);
+    
+    m_moduleTable->setItem(row, MODULE_TABLE_NAME_COLUMN, nameItem);
+    m_moduleTable->setItem(row, MODULE_TABLE_SIZE_COLUMN, 
+                           new QTableWidgetItem(module["size"].toString()));
+    m_moduleTable->setItem(row, MODULE_TABLE_USED_COLUMN, 
+                           new QTableWidgetItem(module["used_by"].toString()));
+    m_moduleTable->setItem(row, MODULE_TABLE_DEPENDENCIES_COLUMN, 
+                           new QTableWidgetItem(module["depends"].toString()));
+    m_moduleTable->setItem(row, MODULE_TABLE_STATUS_COLUMN, 
+                           new QTableWidgetItem(module["status"].toString()));
+}
+
+void DriverManager::fillFirmwareRow(int row, const QJsonObject &fw, int index)
+{
+    QTableWidgetItem *nameItem = new QTableWidgetItem(fw["name"].toString());
+    nameItem->setData(Qt::UserRole, index);
+    
+    m_firmwareTable->setItem(row, FIRMWARE_TABLE_NAME_COLUMN, nameItem);
+    m_firmwareTable->setItem(row, FIRMWARE_TABLE_VERSION_COLUMN, 
+                             new QTableWidgetItem(fw["version"].toString()));
+    m_firmwareTable->setItem(row, FIRMWARE_TABLE_SIZE_COLUMN, 
+                             new QTableWidgetItem(formatSize(fw["size"].toVariant().toLongLong())));
+    m_firmwareTable->setItem(row, FIRMWARE_TABLE_DEVICE_COLUMN, 
+                             new QTableWidgetItem(fw["device"].toString()));
+    m_firmwareTable->setItem(row, FIRMWARE_TABLE_STATUS_COLUMN, 
+                             new QTableWidgetItem(fw["status"].toString()));
 }
 
 void DriverManager::updateKernelInfo()
@@ -1949,20 +2211,16 @@ void DriverManager::updateTheme()
 
 QString DriverManager::getCurrentKernelVersion()
 {
-    QProcess process;
-    process.start("uname", QStringList() << "-r");
-    if (process.waitForFinished(3000)) {
-        return process.readAllStandardOutput().trimmed();
-    }
-    return "Unknown";
+    const QString release = QSysInfo::kernelVersion();
+    return release.isEmpty() ? QString("Unknown") : release;
 }
 
 QString DriverManager::getCurrentArchitecture()
 {
-    QProcess process;
-    process.start("uname", QStringList() << "-m");
-    if (process.waitForFinished(3000)) {
-        return process.readAllStandardOutput().trimmed();
+    // What uname -m prints, without starting it
+    struct utsname info;
+    if (uname(&info) == 0) {
+        return QString::fromLatin1(info.machine);
     }
     return "Unknown";
 }
@@ -2043,6 +2301,17 @@ void DriverManager::showModuleDetails()
         }
     }
     
+    QTableWidgetItem *nameItem = m_moduleTable->item(row, MODULE_TABLE_NAME_COLUMN);
+    if (nameItem) {
+        const QMap<QString, QString> parameters = ModuleInventory::parameters(nameItem->text());
+        if (!parameters.isEmpty()) {
+            details << "" << "Parameters:";
+            for (auto it = parameters.constBegin(); it != parameters.constEnd(); ++it) {
+                details << QString("  %1 = %2").arg(it.key(), it.value());
+            }
+        }
+    }
+    
     showInfo("Module Details", details.join("\n"));
 }
 
@@ -2060,6 +2329,19 @@ void DriverManager::showFirmwareDetails()
         }
     }
     
+    // Package and checksum come from the firmware index; hashing happens on first request
+    QTableWidgetItem *nameItem = m_firmwareTable->item(row, 0);
+    const FirmwareFile file = FirmwareIndex::instance().file(nameItem ? nameItem->text() : QString());
+    if (!file.path.isEmpty()) {
+        details << QString("Path: %1").arg(file.path);
+        details << QString("Package: %1").arg(file.package.isEmpty() ? QString("(not owned by a package)")
+                                                                     : file.package + "-" + file.packageVersion);
+        details << QString("SHA-256: %1").arg(QString::fromLatin1(FirmwareIndex::instance().sha256(file.names.first())));
+        if (file.names.size() > 1) {
+            details << QString("Also loaded as: %1").arg(file.names.mid(1).join(", "));
+        }
+    }
+    
     showInfo("Firmware Details", details.join("\n"));
 }
 
@@ -2208,6 +2490,47 @@ void DriverManager::buildDKMSModule()
     }
 }
 
+void DriverManager::autoinstallDKMSModules()
+{
+    startModuleBuilds(false);
+}
+
+void DriverManager::rebuildAllDKMSModules()
+{
+    startModuleBuilds(true);
+}
+
+void DriverManager::startModuleBuilds(bool force)
+{
+    if (m_moduleBuilder->isRunning()) {
+        showInfo("Module Builds", "Module builds are already running.");
+        return;
+    }
+    
+    m_statusLabel->setText("Checking which modules need building...");
+    m_moduleBuilder->plan(QStringList(), force).then(this, [this](const QList<ModuleBuild> &builds) {
+        if (m_moduleBuilder->isRunning()) return;
+        
+        int pending = 0;
+        for (const ModuleBuild &build : builds) {
+            if (build.state == ModuleBuild::Pending) ++pending;
+        }
+        
+        m_outputTextEdit->clear();
+        m_outputTextEdit->setVisible(pending > 0);
+        m_progressBar->setRange(0, qMax(pending, 1));
+        m_progressBar->setValue(0);
+        m_progressBar->setVisible(pending > 0);
+        m_statusLabel->setText(QString("Building %1 module(s), %2 at a time...")
+                               .arg(pending).arg(ModuleBuilder::buildSlots()));
+        
+        if (!m_moduleBuilder->start(builds)) {
+            m_progressBar->setVisible(false);
+            showError("Module Builds", "No privilege escalation method available");
+        }
+    });
+}
+
 void DriverManager::installBuildEssentials() 
 {
     if (m_privilegedExecutor) {
@@ -2385,44 +2708,35 @@ void DriverManager::checkFirmwareUpdates()
 {
     showProgress("Checking", "Checking for firmware updates...");
     
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
+    // May download fresh metadata from the LVFS first
+    ProcessRunner::instance()->run("fwupdmgr", QStringList() << "get-updates", 0)
+        .then(this, [this](const ProcessResult &result) {
         hideProgress();
-        if (exitCode == 0) {
-            QString output = process->readAllStandardOutput();
-            parseFirmwareUpdates(output);
+        if (result.success()) {
+            parseFirmwareUpdates(result.output());
             m_statusLabel->setText("Firmware update check completed");
         } else {
             m_statusLabel->setText("Failed to check for updates");
         }
         QTimer::singleShot(3000, [this]() { m_statusLabel->setText("Ready"); });
-        process->deleteLater();
     });
-    
-    process->start("fwupdmgr", QStringList() << "get-updates");
 }
 
 void DriverManager::refreshFirmwareDevices()
 {
     showProgress("Refreshing", "Refreshing firmware devices...");
     
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
+    ProcessRunner::instance()->run("fwupdmgr", QStringList() << "get-devices")
+        .then(this, [this](const ProcessResult &result) {
         hideProgress();
-        if (exitCode == 0) {
-            QString output = process->readAllStandardOutput();
-            parseFirmwareDevices(output);
+        if (result.success()) {
+            parseFirmwareDevices(result.output());
             m_statusLabel->setText("Device list refreshed");
         } else {
             m_statusLabel->setText("Failed to refresh devices");
         }
         QTimer::singleShot(3000, [this]() { m_statusLabel->setText("Ready"); });
-        process->deleteLater();
     });
-    
-    process->start("fwupdmgr", QStringList() << "get-devices");
 }
 
 void DriverManager::applyFirmwareUpdates()
@@ -2436,21 +2750,18 @@ void DriverManager::applyFirmwareUpdates()
     
     showProgress("Updating", "Applying firmware updates...");
     
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
+    // Flashing takes as long as the device needs
+    ProcessRunner::instance()->run("fwupdmgr", QStringList() << "update", 0)
+        .then(this, [this](const ProcessResult &result) {
         hideProgress();
-        if (exitCode == 0) {
+        if (result.success()) {
             m_statusLabel->setText("Firmware updates applied successfully");
             refreshFirmwareDevices(); // Refresh to show new versions
         } else {
             m_statusLabel->setText("Failed to apply firmware updates");
         }
         QTimer::singleShot(3000, [this]() { m_statusLabel->setText("Ready"); });
-        process->deleteLater();
     });
-    
-    process->start("fwupdmgr", QStringList() << "update");
 }
 
 void DriverManager::parseFirmwareDevices(const QString &output)
@@ -2543,4 +2854,3 @@ void DriverManager::hideProgress()
     }
 }
 
- 
\ No newline at end of file
@@ -29,10 +29,13 @@
 #include <QThread>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QHash>
+#include <QSet>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QProcess>
 #include <QStandardPaths>
 #include <QDir>
@@ -50,6 +53,10 @@
 #include <QListWidgetItem>
 #include <QButtonGroup>
 #include <QRadioButton>
+#include "sysfsdevices.h"
+#include "ueventmonitor.h"
+#include "modulebuilder.h"
+#include "initramfsbuilder.h"
 
 class SystemUtils;
 class PrivilegedExecutor;
@@ -63,21 +70,37 @@ public:
     void stop();
     void setScanType(const QString &scanType);
     
+    static QJsonObject deviceInfo(const SysfsDevice &device);
+    
 protected:
     void run() override;
     
 signals:
-    void hardwareFound(const QJsonObject &hardwareInfo);
-    void driverFound(const QJsonObject &driverInfo);
-    void moduleFound(const QJsonObject &moduleInfo);
-    void firmwareFound(const QJsonObject &firmwareInfo);
+    void hardwareFound(const QList<QJsonObject> &hardware);
+    void driverFound(const QList<QJsonObject> &drivers);
+    void moduleFound(const QList<QJsonObject> &modules);
+    void firmwareFound(const QList<QJsonObject> &firmware);
     void scanFinished();
     void errorOccurred(const QString &error);
     
 private:
+    enum ResultType { HardwareResult, DriverResult, ModuleResult, FirmwareResult };
+    
+    static const int BATCH_SIZE = 512;
+    static const int BATCH_INTERVAL_MS = 16;
+    
     QString m_scanType;
     bool m_stopRequested;
     mutable QMutex m_mutex;
+    QList<SysfsDevice> m_pciDevices;
+    QList<QJsonObject> m_pendingHardware;
+    QList<QJsonObject> m_pendingDrivers;
+    QList<QJsonObject> m_pendingModules;
+    QList<QJsonObject> m_pendingFirmware;
+    QElapsedTimer m_batchTimer;
+    
+    void report(ResultType type, const QJsonObject &info);
+    void flushResults();
     
     void scanPCIDevices();
     void scanUSBDevices();
@@ -89,13 +112,10 @@ private:
     void scanGPUDrivers();
     void scanNetworkDrivers();
     void scanAudioDrivers();
-    void scanFirmwareDirectory(const QStringList &dirs, int currentIndex);
-    QJsonObject parseLspciOutput(const QString &output);
-    QJsonObject parseLsusbOutput(const QString &output);
+    const QList<SysfsDevice> &pciDevices();
+    static QString driverVersion(const QString &driver);
     QJsonObject parseModinfoOutput(const QString &output);
-    QJsonObject parseLsmodOutput(const QString &output);
     QJsonObject parseFirmwareInfo(const QString &output);
-    QJsonObject parseDriverInfo(const QString &output);
 };
 
 class DriverManager : public QWidget
@@ -127,10 +147,10 @@ public slots:
     void rebuildInitramfs();
     
 private slots:
-    void onHardwareFound(const QJsonObject &hardwareInfo);
-    void onDriverFound(const QJsonObject &driverInfo);
-    void onModuleFound(const QJsonObject &moduleInfo);
-    void onFirmwareFound(const QJsonObject &firmwareInfo);
+    void onHardwareFound(const QList<QJsonObject> &hardware);
+    void onDriverFound(const QList<QJsonObject> &drivers);
+    void onModuleFound(const QList<QJsonObject> &modules);
+    void onFirmwareFound(const QList<QJsonObject> &firmware);
     void onScanFinished();
     void onScanError(const QString &error);
     void onHardwareTableContextMenu(const QPoint &pos);
@@ -154,6 +174,16 @@ private slots:
     void updateDriverTable();
     void updateModuleTable();
     void updateFirmwareTable();
+    void flushTableUpdates();
+    void findDriverForSelectedDevice();
+    void onUevent(const Uevent &event);
+    void onModuleBuildStarted(const QString &tag);
+    void onModuleBuildOutput(const QString &tag, const QString &line);
+    void onModuleBuildFinished(const QString &tag, bool success);
+    void onModuleBuildsFinished(int built, int failed, int skipped);
+    void onInitramfsOutput(const QString &kernel, const QString &line);
+    void onInitramfsImageFinished(const QString &kernel, bool success, qint64 elapsedMs);
+    void onInitramfsBuildsFinished(int built, int failed, int skipped);
     void showHardwareDetails();
     void showDriverDetails();
     void showModuleDetails();
@@ -229,6 +259,11 @@ private slots:
     void hideProgress();
     
 private:
+    struct ResultRows {
+        QHash<QString, int> indexByKey;
+        QSet<int> dirty;
+    };
+    
     // UI setup
     void setupUI();
     void setupHardwareTab();
@@ -291,7 +326,6 @@ private:
     void backupFirmware(const QString &firmwareName);
     void restoreFirmware(const QString &firmwareName);
     void getFirmwareInfo(const QString &firmwareName);
-    void scanFirmwareDirectory(const QStringList &dirs, int currentIndex);
     void checkFirmwareLicense(const QString &firmwareName);
     void downloadLinuxFirmware();
     
@@ -305,6 +339,7 @@ private:
     void getDKMSStatus();
     void autoinstallDKMSModules();
     void rebuildAllDKMSModules();
+    void startModuleBuilds(bool force);
     
     // Kernel operations
     void getKernelVersion();
@@ -315,6 +350,7 @@ private:
     void setDefaultKernelVersion(const QString &kernelVersion);
     void updateGrubConfig();
     void rebuildInitramfsForKernel(const QString &kernelVersion);
+    void startInitramfsBuilds(const QStringList &kernels, bool force);
     void installKernelHeadersForVersion(const QString &kernelVersion);
     void getKernelConfiguration();
     void buildCustomKernel();
@@ -322,6 +358,16 @@ private:
     // Data management
     void updateKernelInfo();
     void updateInfoPanel();
+    void mergeResults(QList<QJsonObject> &data, ResultRows &rows, const QList<QJsonObject> &batch,
+                      QString (*keyOf)(const QJsonObject &));
+    void flushRows(QTableWidget *table, const QList<QJsonObject> &data, ResultRows &rows,
+                   void (DriverManager::*fillRow)(int, const QJsonObject &, int));
+    void clearResults(QTableWidget *table, QList<QJsonObject> &data, ResultRows &rows);
+    void removeResult(QTableWidget *table, QList<QJsonObject> &data, ResultRows &rows, const QString &key);
+    void fillHardwareRow(int row, const QJsonObject &hw, int index);
+    void fillDriverRow(int row, const QJsonObject &driver, int index);
+    void fillModuleRow(int row, const QJsonObject &module, int index);
+    void fillFirmwareRow(int row, const QJsonObject &fw, int index);
     void parseHardwareList(const QString &output);
     void parseDriverList(const QString &output);
     void parseModuleList(const QString &output);
@@ -463,6 +509,9 @@ private:
     // Background workers
     HardwareScanner *m_hardwareScanner;
     QTimer *m_refreshTimer;
+    UeventMonitor *m_ueventMonitor;
+    ModuleBuilder *m_moduleBuilder;
+    InitramfsBuilder *m_initramfsBuilder;
     
     // Data
     QList<QJsonObject> m_hardware;
@@ -471,6 +520,15 @@ private:
     QList<QJsonObject> m_firmware;
     QList<QJsonObject> m_kernels;
     
+    // Keyed view over the result lists: repeated reports update their row in
+    // place and new rows are appended on the next throttled table flush
+    ResultRows m_hardwareRows;
+    ResultRows m_driverRows;
+    ResultRows m_moduleRows;
+    ResultRows m_firmwareRows;
+    QTimer *m_tableFlushTimer;
+    QHash<QString, QString> m_modulePackages;   // module file -> owning package, filled on demand
+    
     // Settings
     bool m_autoRefresh;
     int m_refreshInterval;
@@ -0,0 +1,532 @@
+#include "easyeffectspresets.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonValue>
+#include <QMap>
+#include <QMutexLocker>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+
+const quint32 CACHE_MAGIC = 0x0EEF7E57;
+const qint32 CACHE_VERSION = 1;
+const QString EASYEFFECTS_FLATPAK_ID = "com.github.wwmm.easyeffects";
+
+QString sourceForPath(const QString &path)
+{
+    if (path.contains("/.var/app/")) return "Flatpak";
+    if (path.startsWith("/usr/")) return "System";
+    return "Native";
+}
+
+QString buildSearchText(const EasyEffectsPreset &preset)
+{
+    QStringList parts;
+    parts << preset.name << preset.type << preset.source;
+    for (const QString &plugin : preset.plugins) {
+        // "equalizer#0" is searchable as "equalizer"
+        parts << plugin.section('#', 0, 0);
+    }
+    return parts.join(' ').toLower();
+}
+
+QJsonObject readChain(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return QJsonObject();
+    
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    return root.value(root.contains("output") ? "output" : "input").toObject();
+}
+
+void flattenJson(const QJsonValue &value, const QString &prefix, QMap<QString, QString> &out)
+{
+    if (value.isObject()) {
+        const QJsonObject object = value.toObject();
+        for (auto it = object.begin(); it != object.end(); ++it) {
+            flattenJson(it.value(), prefix + "." + it.key(), out);
+        }
+    } else if (value.isArray()) {
+        const QJsonArray array = value.toArray();
+        for (int i = 0; i < array.size(); ++i) {
+            flattenJson(array.at(i), QString("%1[%2]").arg(prefix).arg(i), out);
+        }
+    } else if (!value.isUndefined()) {
+        out.insert(prefix, value.toVariant().toString());
+    }
+}
+
+}
+
+// EasyEffectsPresetScanner Implementation
+EasyEffectsPresetScanner::EasyEffectsPresetScanner(QObject *parent)
+    : QThread(parent)
+    , m_parsedCount(0)
+{
+}
+
+void EasyEffectsPresetScanner::setJob(const QStringList &directories, const QHash<QString, EasyEffectsPreset> &known)
+{
+    QMutexLocker locker(&m_mutex);
+    m_directories = directories;
+    m_known = known;
+    m_results.clear();
+    m_parsedCount = 0;
+}
+
+QStringList EasyEffectsPresetScanner::directories() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_directories;
+}
+
+QHash<QString, EasyEffectsPreset> EasyEffectsPresetScanner::results() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_results;
+}
+
+int EasyEffectsPresetScanner::parsedCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_parsedCount;
+}
+
+void EasyEffectsPresetScanner::run()
+{
+    QStringList directories;
+    QHash<QString, EasyEffectsPreset> known;
+    {
+        QMutexLocker locker(&m_mutex);
+        directories = m_directories;
+        known = m_known;
+    }
+    
+    // Identical files (copies, renames, the same preset in the Flatpak and
+    // native trees) are only parsed once
+    QHash<QByteArray, EasyEffectsPreset> byHash;
+    for (const EasyEffectsPreset &preset : std::as_const(known)) {
+        if (!preset.hash.isEmpty()) {
+            byHash.insert(preset.hash, preset);
+        }
+    }
+    
+    QHash<QString, EasyEffectsPreset> results;
+    int parsed = 0;
+    
+    for (const QString &directory : std::as_const(directories)) {
+        const QFileInfoList files = QDir(directory).entryInfoList(QStringList() << "*.json",
+                                                                  QDir::Files | QDir::Readable);
+        const QString type = QFileInfo(directory).fileName();
+        const QString source = sourceForPath(directory);
+        
+        for (const QFileInfo &fileInfo : files) {
+            // Only the index's destructor asks; nobody wants the results then
+            if (isInterruptionRequested()) return;
+            
+            const QString path = fileInfo.absoluteFilePath();
+            const qint64 size = fileInfo.size();
+            const qint64 modified = fileInfo.lastModified().toMSecsSinceEpoch();
+            
+            // Unchanged since the last scan: no read, no hash, no parse
+            auto knownIt = known.constFind(path);
+            if (knownIt != known.cend() && knownIt->size == size && knownIt->modified == modified) {
+                results.insert(path, *knownIt);
+                continue;
+            }
+            
+            QFile file(path);
+            if (!file.open(QIODevice::ReadOnly)) continue;
+            const QByteArray data = file.readAll();
+            const QByteArray hash = QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+            
+            EasyEffectsPreset preset;
+            auto hashIt = byHash.constFind(hash);
+            if (hashIt != byHash.cend()) {
+                preset = *hashIt;
+            } else if (parsePreset(data, preset)) {
+                ++parsed;
+            } else {
+                continue;
+            }
+            
+            preset.name = fileInfo.completeBaseName();
+            preset.path = path;
+            preset.source = source;
+            preset.size = size;
+            preset.modified = modified;
+            preset.hash = hash;
+            if (preset.type.isEmpty()) {
+                preset.type = type;
+            }
+            preset.searchText = buildSearchText(preset);
+            
+            results.insert(path, preset);
+            byHash.insert(hash, preset);
+        }
+    }
+    
+    QMutexLocker locker(&m_mutex);
+    m_results = results;
+    m_parsedCount = parsed;
+}
+
+bool EasyEffectsPresetScanner::parsePreset(const QByteArray &data, EasyEffectsPreset &preset)
+{
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(data, &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+        return false;
+    }
+    
+    const QJsonObject root = doc.object();
+    if (root.contains("output")) {
+        preset.type = "output";
+    } else if (root.contains("input")) {
+        preset.type = "input";
+    } else {
+        return false;
+    }
+    
+    const QJsonObject chain = root.value(preset.type).toObject();
+    preset.plugins.clear();
+    
+    const QJsonArray order = chain.value("plugins_order").toArray();
+    for (const QJsonValue &plugin : order) {
+        preset.plugins << plugin.toString();
+    }
+    
+    // Very old presets have no explicit order; every object is a plugin
+    if (preset.plugins.isEmpty()) {
+        for (auto it = chain.begin(); it != chain.end(); ++it) {
+            if (it.value().isObject()) {
+                preset.plugins << it.key();
+            }
+        }
+    }
+    
+    return true;
+}
+
+// EasyEffectsPresetIndex Implementation
+EasyEffectsPresetIndex::EasyEffectsPresetIndex(QObject *parent)
+    : QObject(parent)
+    , m_watcher(new QFileSystemWatcher(this))
+    , m_scanner(new EasyEffectsPresetScanner(this))
+    , m_debounceTimer(new QTimer(this))
+    , m_cacheLoaded(false)
+{
+    m_debounceTimer->setSingleShot(true);
+    m_debounceTimer->setInterval(250);
+    
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &EasyEffectsPresetIndex::onDirectoryChanged);
+    connect(m_scanner, &QThread::finished, this, &EasyEffectsPresetIndex::onScanFinished);
+    connect(m_debounceTimer, &QTimer::timeout, this, &EasyEffectsPresetIndex::startPendingScan);
+}
+
+EasyEffectsPresetIndex::~EasyEffectsPresetIndex()
+{
+    if (m_scanner->isRunning()) {
+        m_scanner->requestInterruption();
+        m_scanner->wait();
+    }
+}
+
+QStringList EasyEffectsPresetIndex::presetDirectories()
+{
+    const QString flatpakRoot = QDir::homePath() + "/.var/app/" + EASYEFFECTS_FLATPAK_ID;
+    
+    // EasyEffects < 7.2 keeps presets under the config dir, newer releases
+    // under the data dir; community preset packages install system-wide.
+    QStringList bases;
+    bases << QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation) + "/easyeffects";
+    const QStringList dataDirs = QStandardPaths::standardLocations(QStandardPaths::GenericDataLocation);
+    for (const QString &dataDir : dataDirs) {
+        bases << dataDir + "/easyeffects";
+    }
+    bases << flatpakRoot + "/config/easyeffects";
+    bases << flatpakRoot + "/data/easyeffects";
+    bases.removeDuplicates();
+    
+    QStringList directories;
+    for (const QString &base : std::as_const(bases)) {
+        directories << base + "/output" << base + "/input";
+    }
+    return directories;
+}
+
+void EasyEffectsPresetIndex::load()
+{
+    if (!m_cacheLoaded) {
+        m_cacheLoaded = true;
+        loadCache();
+        if (!m_presets.isEmpty()) {
+            emit indexChanged();
+        }
+    }
+    
+    updateWatches();
+    rescan();
+}
+
+void EasyEffectsPresetIndex::rescan()
+{
+    const QStringList directories = presetDirectories();
+    for (const QString &directory : directories) {
+        m_pendingDirectories.insert(directory);
+    }
+    startPendingScan();
+}
+
+bool EasyEffectsPresetIndex::isScanning() const
+{
+    return m_scanner->isRunning();
+}
+
+QList<EasyEffectsPreset> EasyEffectsPresetIndex::presets() const
+{
+    return search(QString());
+}
+
+QList<EasyEffectsPreset> EasyEffectsPresetIndex::search(const QString &query) const
+{
+    const QStringList terms = query.toLower().split(' ', Qt::SkipEmptyParts);
+    
+    QList<EasyEffectsPreset> matches;
+    matches.reserve(m_presets.size());
+    for (const EasyEffectsPreset &preset : m_presets) {
+        bool matched = true;
+        for (const QString &term : terms) {
+            if (!preset.searchText.contains(term)) {
+                matched = false;
+                break;
+            }
+        }
+        if (matched) {
+            matches.append(preset);
+        }
+    }
+    
+    std::sort(matches.begin(), matches.end(), [](const EasyEffectsPreset &a, const EasyEffectsPreset &b) {
+        const int order = QString::compare(a.name, b.name, Qt::CaseInsensitive);
+        return order != 0 ? order < 0 : a.path < b.path;
+    });
+    return matches;
+}
+
+EasyEffectsPreset EasyEffectsPresetIndex::preset(const QString &path) const
+{
+    return m_presets.value(path);
+}
+
+QStringList EasyEffectsPresetIndex::diff(const EasyEffectsPreset &first, const EasyEffectsPreset &second)
+{
+    QStringList lines;
+    
+    if (first.type != second.type) {
+        lines << QString("Type: %1 -> %2").arg(first.type, second.type);
+    }
+    if (first.plugins != second.plugins) {
+        lines << QString("Plugin chain: %1 -> %2")
+                 .arg(first.plugins.join(", "), second.plugins.join(", "));
+    }
+    
+    for (const QString &plugin : first.plugins) {
+        if (!second.plugins.contains(plugin)) {
+            lines << QString("Only in %1: %2").arg(first.name, plugin);
+        }
+    }
+    for (const QString &plugin : second.plugins) {
+        if (!first.plugins.contains(plugin)) {
+            lines << QString("Only in %1: %2").arg(second.name, plugin);
+        }
+    }
+    
+    // Parameter values are read on demand; the index only keeps the chain
+    const QJsonObject firstChain = readChain(first.path);
+    const QJsonObject secondChain = readChain(second.path);
+    
+    for (const QString &plugin : first.plugins) {
+        if (!second.plugins.contains(plugin)) continue;
+        
+        QMap<QString, QString> firstValues;
+        QMap<QString, QString> secondValues;
+        flattenJson(firstChain.value(plugin), plugin, firstValues);
+        flattenJson(secondChain.value(plugin), plugin, secondValues);
+        
+        QStringList keys = firstValues.keys() + secondValues.keys();
+        keys.removeDuplicates();
+        std::sort(keys.begin(), keys.end());
+        
+        for (const QString &key : std::as_const(keys)) {
+            const QString a = firstValues.value(key, "-");
+            const QString b = secondValues.value(key, "-");
+            if (a != b) {
+                lines << QString("%1: %2 -> %3").arg(key, a, b);
+            }
+        }
+    }
+    
+    return lines;
+}
+
+QStringList EasyEffectsPresetIndex::applyCommand(const EasyEffectsPreset &preset)
+{
+    if (preset.source == "Flatpak") {
+        return QStringList() << "flatpak" << "run" << EASYEFFECTS_FLATPAK_ID << "--load-preset" << preset.name;
+    }
+    return QStringList() << "easyeffects" << "--load-preset" << preset.name;
+}
+
+void EasyEffectsPresetIndex::onDirectoryChanged(const QString &path)
+{
+    // A new output/ or input/ folder may have appeared under a base dir
+    updateWatches();
+    
+    const QStringList directories = presetDirectories();
+    for (const QString &directory : directories) {
+        if (directory == path || QFileInfo(directory).absolutePath() == path) {
+            m_pendingDirectories.insert(directory);
+        }
+    }
+    m_debounceTimer->start();
+}
+
+void EasyEffectsPresetIndex::startPendingScan()
+{
+    if (m_scanner->isRunning() || m_pendingDirectories.isEmpty()) {
+        return;
+    }
+    
+    const QStringList directories = m_pendingDirectories.values();
+    m_pendingDirectories.clear();
+    
+    m_scanner->setJob(directories, m_presets);
+    m_scanner->start(QThread::LowPriority);
+}
+
+void EasyEffectsPresetIndex::onScanFinished()
+{
+    const QStringList directories = m_scanner->directories();
+    const QHash<QString, EasyEffectsPreset> results = m_scanner->results();
+    bool changed = m_scanner->parsedCount() > 0;
+    
+    QSet<QString> scanned;
+    for (const QString &directory : directories) {
+        scanned.insert(QDir::cleanPath(directory));
+    }
+    
+    for (auto it = m_presets.begin(); it != m_presets.end();) {
+        if (scanned.contains(QFileInfo(it.key()).absolutePath()) && !results.contains(it.key())) {
+            it = m_presets.erase(it);
+            changed = true;
+        } else {
+            ++it;
+        }
+    }
+    
+    for (auto it = results.cbegin(); it != results.cend(); ++it) {
+        auto existing = m_presets.constFind(it.key());
+        if (existing == m_presets.cend() || existing->hash != it->hash || existing->modified != it->modified) {
+            changed = true;
+        }
+        m_presets.insert(it.key(), it.value());
+    }
+    
+    if (changed) {
+        saveCache();
+        emit indexChanged();
+    }
+    
+    // Changes that arrived while this scan was running
+    startPendingScan();
+}
+
+void EasyEffectsPresetIndex::updateWatches()
+{
+    QStringList paths;
+    const QStringList directories = presetDirectories();
+    for (const QString &directory : directories) {
+        const QString base = QFileInfo(directory).absolutePath();
+        if (QFileInfo::exists(base) && !paths.contains(base)) {
+            paths << base;
+        }
+        if (QFileInfo::exists(directory)) {
+            paths << directory;
+        }
+    }
+    
+    const QStringList watched = m_watcher->directories();
+    QStringList missing;
+    for (const QString &path : std::as_const(paths)) {
+        if (!watched.contains(path)) {
+            missing << path;
+        }
+    }
+    if (!missing.isEmpty()) {
+        m_watcher->addPaths(missing);
+    }
+}
+
+QString EasyEffectsPresetIndex::cachePath() const
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/easyeffects-presets.cache";
+}
+
+void EasyEffectsPresetIndex::loadCache()
+{
+    QFile file(cachePath());
+    if (!file.open(QIODevice::ReadOnly)) return;
+    
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    
+    quint32 magic = 0;
+    qint32 version = 0;
+    qint32 count = 0;
+    stream >> magic >> version >> count;
+    if (magic != CACHE_MAGIC || version != CACHE_VERSION || count < 0) {
+        return;
+    }
+    
+    m_presets.reserve(count);
+    for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        EasyEffectsPreset preset;
+        stream >> preset.path >> preset.name >> preset.type >> preset.source
+               >> preset.size >> preset.modified >> preset.hash >> preset.plugins;
+        preset.searchText = buildSearchText(preset);
+        m_presets.insert(preset.path, preset);
+    }
+    
+    if (stream.status() != QDataStream::Ok) {
+        qWarning() << "Discarding corrupt EasyEffects preset cache";
+        m_presets.clear();
+    }
+}
+
+void EasyEffectsPresetIndex::saveCache() const
+{
+    const QString path = cachePath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return;
+    
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << CACHE_MAGIC << CACHE_VERSION << qint32(m_presets.size());
+    for (const EasyEffectsPreset &preset : m_presets) {
+        stream << preset.path << preset.name << preset.type << preset.source
+               << preset.size << preset.modified << preset.hash << preset.plugins;
+    }
+    
+    file.commit();
+}
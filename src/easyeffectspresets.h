@@ -0,0 +1,100 @@
+#ifndef EASYEFFECTSPRESETS_H
+#define EASYEFFECTSPRESETS_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QByteArray>
+#include <QFileSystemWatcher>
+#include <QTimer>
+
+struct EasyEffectsPreset {
+    QString name;
+    QString path;
+    QString type;       // "output" or "input"
+    QString source;     // "Native", "Flatpak" or "System"
+    qint64 size = 0;
+    qint64 modified = 0;
+    QByteArray hash;
+    QStringList plugins;
+    QString searchText;
+};
+
+class EasyEffectsPresetScanner : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit EasyEffectsPresetScanner(QObject *parent = nullptr);
+    
+    void setJob(const QStringList &directories, const QHash<QString, EasyEffectsPreset> &known);
+    QStringList directories() const;
+    QHash<QString, EasyEffectsPreset> results() const;
+    int parsedCount() const;
+
+protected:
+    void run() override;
+
+private:
+    static bool parsePreset(const QByteArray &data, EasyEffectsPreset &preset);
+    
+    mutable QMutex m_mutex;
+    QStringList m_directories;
+    QHash<QString, EasyEffectsPreset> m_known;
+    QHash<QString, EasyEffectsPreset> m_results;
+    int m_parsedCount;
+};
+
+// Index of every EasyEffects preset on the system. Presets are parsed once
+// and cached on disk keyed by path (size + mtime) and by content hash, so a
+// warm start only needs a stat per file. Preset directories are watched and
+// only the directory that changed is rescanned.
+class EasyEffectsPresetIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit EasyEffectsPresetIndex(QObject *parent = nullptr);
+    ~EasyEffectsPresetIndex();
+    
+    static QStringList presetDirectories();
+    
+    void load();
+    void rescan();
+    bool isScanning() const;
+    
+    QList<EasyEffectsPreset> presets() const;
+    QList<EasyEffectsPreset> search(const QString &query) const;
+    EasyEffectsPreset preset(const QString &path) const;
+    
+    static QStringList diff(const EasyEffectsPreset &first, const EasyEffectsPreset &second);
+    static QStringList applyCommand(const EasyEffectsPreset &preset);
+
+signals:
+    void indexChanged();
+
+private slots:
+    void onDirectoryChanged(const QString &path);
+    void onScanFinished();
+    void startPendingScan();
+
+private:
+    void loadCache();
+    void saveCache() const;
+    void updateWatches();
+    QString cachePath() const;
+    
+    QHash<QString, EasyEffectsPreset> m_presets;
+    QFileSystemWatcher *m_watcher;
+    EasyEffectsPresetScanner *m_scanner;
+    QTimer *m_debounceTimer;
+    QSet<QString> m_pendingDirectories;
+    bool m_cacheLoaded;
+};
+
+#endif // EASYEFFECTSPRESETS_H
@@ -0,0 +1,468 @@
+#include "firmwareindex.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <QCryptographicHash>
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QDebug>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <algorithm>
+
+namespace {
+
+const quint32 CACHE_MAGIC = 0x46574958;     // "FWIX"
+const quint32 CACHE_VERSION = 1;
+
+qint64 modificationTime(const struct stat &info)
+{
+    return qint64(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+}
+
+// Name relative to whichever firmware root the path is under
+QString relativeName(const QStringList &roots, const QString &path)
+{
+    for (const QString &root : roots) {
+        if (path.startsWith(root + '/')) {
+            return path.mid(root.size() + 1);
+        }
+    }
+    return QString();
+}
+
+}
+
+// FirmwareIndex Implementation
+FirmwareIndex &FirmwareIndex::instance()
+{
+    static FirmwareIndex index;
+    return index;
+}
+
+FirmwareIndex::FirmwareIndex()
+    : m_dirty(false)
+{
+    // /lib is a symlink to /usr/lib on merged-/usr systems
+    for (const QString &dir : { QString("/lib/firmware"), QString("/usr/lib/firmware") }) {
+        const QString canonicalDir = QFileInfo(dir).canonicalFilePath();
+        if (!canonicalDir.isEmpty() && !m_roots.contains(canonicalDir)) {
+            m_roots << canonicalDir;
+        }
+    }
+    
+    load();
+    
+    if (QCoreApplication *app = QCoreApplication::instance()) {
+        QObject::connect(app, &QCoreApplication::aboutToQuit, app, [this]() {
+            flush();
+        });
+    }
+}
+
+void FirmwareIndex::refresh()
+{
+    QMutexLocker refreshLocker(&m_refreshMutex);
+    
+    Tree previous;
+    QHash<QString, FirmwareFile> previousFiles;
+    {
+        QMutexLocker locker(&m_mutex);
+        previous = m_tree;
+        previousFiles = m_files;
+    }
+    
+    Tree tree = walk(m_roots, previous);
+    
+    // Group names by inode; the real file is the one that is not a link
+    QHash<QPair<quint64, quint64>, QStringList> pathsByInode;
+    for (auto it = tree.entries.constBegin(); it != tree.entries.constEnd(); ++it) {
+        pathsByInode[qMakePair(it.value().device, it.value().inode)] << it.key();
+    }
+    
+    QHash<QString, FirmwareFile> files;
+    QHash<QString, QString> names;
+    files.reserve(pathsByInode.size());
+    
+    for (auto it = pathsByInode.begin(); it != pathsByInode.end(); ++it) {
+        QStringList &paths = it.value();
+        std::sort(paths.begin(), paths.end());
+        
+        QString realPath = paths.first();
+        for (const QString &path : paths) {
+            if (!tree.entries.value(path).isLink) {
+                realPath = path;
+                break;
+            }
+        }
+        
+        const FileState state = tree.entries.value(realPath);
+        FirmwareFile file = previousFiles.value(realPath);
+        if (file.size != state.size || file.mtime != state.mtime) {
+            file = FirmwareFile();
+        }
+        file.path = realPath;
+        file.size = state.size;
+        file.mtime = state.mtime;
+        file.names.clear();
+        
+        // The real file's own name first, then the links to it
+        paths.removeOne(realPath);
+        paths.prepend(realPath);
+        for (const QString &path : paths) {
+            const QString name = relativeName(m_roots, path);
+            file.names << name;
+            names.insert(name, realPath);
+        }
+        
+        files.insert(realPath, file);
+    }
+    
+    resolvePackages(files);
+    
+    {
+        QMutexLocker locker(&m_mutex);
+        m_tree = tree;
+        m_files = files;
+        m_names = names;
+        save();
+        m_dirty = false;
+    }
+}
+
+FirmwareIndex::Tree FirmwareIndex::walk(const QStringList &roots, const Tree &previous)
+{
+    Tree tree;
+    QMutex mutex;
+    QWaitCondition changed;
+    QStringList pending = roots;
+    int busy = 0;
+    
+    // Directories are handed out one at a time, so a large vendor subtree
+    // does not end up on a single thread
+    auto worker = [&]() {
+        QHash<QString, Directory> directories;
+        QHash<QString, FileState> entries;
+        
+        for (;;) {
+            QString dir;
+            {
+                QMutexLocker locker(&mutex);
+                while (pending.isEmpty() && busy > 0) {
+                    changed.wait(&mutex);
+                }
+                if (pending.isEmpty()) {
+                    changed.wakeAll();
+                    break;
+                }
+                dir = pending.takeLast();
+                ++busy;
+            }
+            
+            QStringList subdirs;
+            struct stat dirInfo;
+            if (::stat(QFile::encodeName(dir).constData(), &dirInfo) == 0) {
+                const qint64 mtime = modificationTime(dirInfo);
+                const auto cached = previous.directories.constFind(dir);
+                
+                if (cached != previous.directories.constEnd() && cached->mtime == mtime) {
+                    // Nothing was added, removed or renamed here; reuse what was stat'ed last time
+                    directories.insert(dir, *cached);
+                    for (const DirectoryEntry &entry : cached->entries) {
+                        const QString path = dir + '/' + entry.name;
+                        if (entry.isDirectory) {
+                            subdirs << path;
+                        } else if (previous.entries.contains(path)) {
+                            entries.insert(path, previous.entries.value(path));
+                        }
+                    }
+                } else {
+                    Directory directory;
+                    directory.mtime = mtime;
+                    
+                    DIR *handle = ::opendir(QFile::encodeName(dir).constData());
+                    while (handle) {
+                        const dirent *entry = ::readdir(handle);
+                        if (!entry) break;
+                        if (entry->d_name[0] == '.' && (entry->d_name[1] == '\0'
+                            || (entry->d_name[1] == '.' && entry->d_name[2] == '\0'))) continue;
+                        
+                        const QString name = QFile::decodeName(entry->d_name);
+                        const QString path = dir + '/' + name;
+                        const QByteArray encoded = QFile::encodeName(path);
+                        
+                        struct stat info;
+                        if (::lstat(encoded.constData(), &info) != 0) continue;
+                        
+                        if (S_ISDIR(info.st_mode)) {
+                            directory.entries.append({ name, true });
+                            subdirs << path;
+                            continue;
+                        }
+                        
+                        FileState state;
+                        state.isLink = S_ISLNK(info.st_mode);
+                        if (state.isLink && ::stat(encoded.constData(), &info) != 0) continue;  // dangling
+                        if (!S_ISREG(info.st_mode)) continue;  // links to directories are not followed
+                        
+                        state.device = info.st_dev;
+                        state.inode = info.st_ino;
+                        state.size = info.st_size;
+                        state.mtime = modificationTime(info);
+                        
+                        directory.entries.append({ name, false });
+                        entries.insert(path, state);
+                    }
+                    if (handle) {
+                        ::closedir(handle);
+                    }
+                    
+                    directories.insert(dir, directory);
+                }
+            }
+            
+            QMutexLocker locker(&mutex);
+            pending << subdirs;
+            --busy;
+            changed.wakeAll();
+        }
+        
+        QMutexLocker locker(&mutex);
+        tree.directories.insert(directories);
+        tree.entries.insert(entries);
+    };
+    
+    QThreadPool pool;
+    const int threads = qBound(1, QThread::idealThreadCount(), 8);
+    pool.setMaxThreadCount(threads);
+    for (int i = 0; i < threads; ++i) {
+        pool.start(worker);
+    }
+    pool.waitForDone();
+    
+    return tree;
+}
+
+void FirmwareIndex::resolvePackages(QHash<QString, FirmwareFile> &files)
+{
+    QStringList unresolved;
+    for (const FirmwareFile &file : files) {
+        if (!file.packageResolved) {
+            unresolved << file.path;
+        }
+    }
+    if (unresolved.isEmpty()) return;
+    
+    QHash<QString, QString> pathByName;
+    for (const FirmwareFile &file : files) {
+        for (const QString &name : file.names) {
+            pathByName.insert(name, file.path);
+        }
+    }
+    const QStringList packageRoots = { "/usr/lib/firmware", "/lib/firmware" };
+    
+    // Asking about one file lists every file of its package, so the number of
+    // rpm runs is the number of firmware packages, not the number of files
+    while (!unresolved.isEmpty()) {
+        const QString path = unresolved.takeLast();
+        if (files.value(path).packageResolved) continue;
+        
+        QProcess process;
+        process.start("rpm", QStringList() << "-qf" << "--qf"
+                      << "[%{FILENAMES}\\t%{NAME}\\t%{VERSION}-%{RELEASE}\\n]" << path);
+        if (!process.waitForFinished(30000)) {
+            qWarning() << "Cannot query package ownership of firmware:" << process.errorString();
+            return;
+        }
+        
+        files[path].packageResolved = true;  // stays unowned if rpm knows nothing about it
+        
+        const QList<QByteArray> lines = process.readAllStandardOutput().split('\n');
+        for (const QByteArray &line : lines) {
+            const QList<QByteArray> fields = line.split('\t');
+            if (fields.size() != 3) continue;
+            
+            const QString name = relativeName(packageRoots, QString::fromUtf8(fields[0]));
+            const auto owned = pathByName.constFind(name);
+            if (name.isEmpty() || owned == pathByName.constEnd()) continue;
+            
+            FirmwareFile &file = files[owned.value()];
+            if (file.package.isEmpty()) {
+                file.package = QString::fromUtf8(fields[1]);
+                file.packageVersion = QString::fromUtf8(fields[2]);
+            }
+            file.packageResolved = true;
+        }
+    }
+}
+
+QList<FirmwareFile> FirmwareIndex::files() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_files.values();
+}
+
+QString FirmwareIndex::resolveName(const QString &name) const
+{
+    for (const QString &candidate : { name, name + ".zst", name + ".xz" }) {
+        const auto it = m_names.constFind(candidate);
+        if (it != m_names.constEnd()) {
+            return it.value();
+        }
+    }
+    return QString();
+}
+
+bool FirmwareIndex::contains(const QString &name) const
+{
+    QMutexLocker locker(&m_mutex);
+    return !resolveName(name).isEmpty();
+}
+
+FirmwareFile FirmwareIndex::file(const QString &name) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_files.value(resolveName(name));
+}
+
+QByteArray FirmwareIndex::sha256(const QString &name)
+{
+    QString path;
+    {
+        QMutexLocker locker(&m_mutex);
+        path = resolveName(name);
+        if (path.isEmpty()) return QByteArray();
+        
+        const QByteArray cached = m_files.value(path).sha256;
+        if (!cached.isEmpty()) return cached;
+    }
+    
+    QFile file(path);
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if (!file.open(QIODevice::ReadOnly) || !hash.addData(&file)) {
+        return QByteArray();
+    }
+    const QByteArray digest = hash.result().toHex();
+    
+    QMutexLocker locker(&m_mutex);
+    if (m_files.contains(path)) {
+        m_files[path].sha256 = digest;
+        m_dirty = true;
+    }
+    return digest;
+}
+
+void FirmwareIndex::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_dirty) return;
+    save();
+    m_dirty = false;
+}
+
+QString FirmwareIndex::cachePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/firmware-index";
+}
+
+void FirmwareIndex::load()
+{
+    QFile file(cachePath());
+    if (!file.open(QIODevice::ReadOnly)) return;
+    
+    QDataStream stream(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QStringList roots;
+    stream >> magic >> version >> roots;
+    if (magic != CACHE_MAGIC || version != CACHE_VERSION || roots != m_roots) return;
+    
+    qint32 directoryCount = 0;
+    stream >> directoryCount;
+    for (qint32 i = 0; i < directoryCount && stream.status() == QDataStream::Ok; ++i) {
+        QString path;
+        Directory directory;
+        qint32 entryCount = 0;
+        stream >> path >> directory.mtime >> entryCount;
+        for (qint32 j = 0; j < entryCount && stream.status() == QDataStream::Ok; ++j) {
+            DirectoryEntry entry;
+            stream >> entry.name >> entry.isDirectory;
+            directory.entries.append(entry);
+        }
+        m_tree.directories.insert(path, directory);
+    }
+    
+    qint32 entryCount = 0;
+    stream >> entryCount;
+    for (qint32 i = 0; i < entryCount && stream.status() == QDataStream::Ok; ++i) {
+        QString path;
+        FileState state;
+        stream >> path >> state.device >> state.inode >> state.size >> state.mtime >> state.isLink;
+        m_tree.entries.insert(path, state);
+    }
+    
+    qint32 fileCount = 0;
+    stream >> fileCount;
+    for (qint32 i = 0; i < fileCount && stream.status() == QDataStream::Ok; ++i) {
+        FirmwareFile entry;
+        stream >> entry.path >> entry.names >> entry.size >> entry.mtime >> entry.sha256
+               >> entry.package >> entry.packageVersion >> entry.packageResolved;
+        for (const QString &name : entry.names) {
+            m_names.insert(name, entry.path);
+        }
+        m_files.insert(entry.path, entry);
+    }
+    
+    if (stream.status() != QDataStream::Ok) {
+        qWarning() << "Discarding corrupt firmware index cache";
+        m_tree = Tree();
+        m_files.clear();
+        m_names.clear();
+    }
+}
+
+void FirmwareIndex::save() const
+{
+    QDir().mkpath(QFileInfo(cachePath()).path());
+    
+    // Written aside and renamed over the old cache, so an interrupted save
+    // leaves the previous index rather than a truncated one
+    QSaveFile file(cachePath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Cannot write firmware index cache:" << file.errorString();
+        return;
+    }
+    
+    QDataStream stream(&file);
+    stream << CACHE_MAGIC << CACHE_VERSION << m_roots;
+    
+    stream << qint32(m_tree.directories.size());
+    for (auto it = m_tree.directories.constBegin(); it != m_tree.directories.constEnd(); ++it) {
+        stream << it.key() << it->mtime << qint32(it->entries.size());
+        for (const DirectoryEntry &entry : it->entries) {
+            stream << entry.name << entry.isDirectory;
+        }
+    }
+    
+    stream << qint32(m_tree.entries.size());
+    for (auto it = m_tree.entries.constBegin(); it != m_tree.entries.constEnd(); ++it) {
+        stream << it.key() << it->device << it->inode << it->size << it->mtime << it->isLink;
+    }
+    
+    stream << qint32(m_files.size());
+    for (const FirmwareFile &entry : m_files) {
+        stream << entry.path << entry.names << entry.size << entry.mtime << entry.sha256
+               << entry.package << entry.packageVersion << entry.packageResolved;
+    }
+    
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        qWarning() << "Cannot write firmware index cache:" << file.errorString();
+    }
+}
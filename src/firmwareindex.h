@@ -0,0 +1,89 @@
+#ifndef FIRMWAREINDEX_H
+#define FIRMWAREINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+
+struct FirmwareFile {
+    QString path;           // real file, absolute
+    QStringList names;      // every name a driver can request it by, symlinks included
+    qint64 size = 0;
+    qint64 mtime = 0;       // nanoseconds
+    QByteArray sha256;      // hex, empty until asked for
+    QString package;        // owning RPM, empty if unowned
+    QString packageVersion;
+    bool packageResolved = false;
+};
+
+// Index of the firmware tree, deduplicated by inode so /lib/firmware and
+// /usr/lib/firmware (one tree on merged-/usr systems) and symlinked names
+// map to one entry. It is cached on disk; a refresh walks the tree in
+// parallel but only lists directories whose mtime changed, and only asks
+// rpm about files it has not seen before.
+class FirmwareIndex
+{
+public:
+    static FirmwareIndex &instance();
+    
+    void refresh();
+    
+    QList<FirmwareFile> files() const;
+    
+    // Also true for the compressed (.xz, .zst) files the loader accepts
+    bool contains(const QString &name) const;
+    FirmwareFile file(const QString &name) const;
+    
+    // Computed on first use and cached with the rest of the entry. New
+    // hashes reach the disk cache with the next refresh(), flush() or quit.
+    QByteArray sha256(const QString &name);
+    void flush();
+
+private:
+    struct DirectoryEntry {
+        QString name;
+        bool isDirectory;
+    };
+    
+    struct Directory {
+        qint64 mtime = 0;
+        QList<DirectoryEntry> entries;
+    };
+    
+    struct FileState {
+        quint64 device = 0;
+        quint64 inode = 0;
+        qint64 size = 0;
+        qint64 mtime = 0;
+        bool isLink = false;
+    };
+    
+    struct Tree {
+        QHash<QString, Directory> directories;      // absolute path
+        QHash<QString, FileState> entries;          // absolute path, links included
+    };
+    
+    FirmwareIndex();
+    FirmwareIndex(const FirmwareIndex &) = delete;
+    FirmwareIndex &operator=(const FirmwareIndex &) = delete;
+    
+    static Tree walk(const QStringList &roots, const Tree &previous);
+    static void resolvePackages(QHash<QString, FirmwareFile> &files);
+    QString resolveName(const QString &name) const;
+    void load();
+    void save() const;
+    static QString cachePath();
+    
+    mutable QMutex m_mutex;
+    QMutex m_refreshMutex;
+    QStringList m_roots;
+    Tree m_tree;
+    QHash<QString, FirmwareFile> m_files;       // by real path
+    QHash<QString, QString> m_names;            // requested name -> real path
+    bool m_dirty;                               // m_files has changes the cache lacks
+};
+
+#endif // FIRMWAREINDEX_H
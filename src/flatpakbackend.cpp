@@ -0,0 +1,818 @@
+#include "flatpakbackend.h"
+#include "processrunner.h"
+#include <QThreadPool>
+#include <QStandardPaths>
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QMetaObject>
+#include <QUrl>
+#include <memory>
+
+#ifdef HAVE_LIBFLATPAK
+// GLib's headers use "signals" as an identifier, which Qt defines as a keyword
+#pragma push_macro("signals")
+#undef signals
+#include <flatpak.h>
+#pragma pop_macro("signals")
+#endif
+
+namespace {
+
+#ifdef HAVE_LIBFLATPAK
+const guint PROGRESS_INTERVAL_MS = 200;
+
+QString takeString(char *value)
+{
+    const QString result = QString::fromUtf8(value);
+    g_free(value);
+    return result;
+}
+
+QString takeError(GError *error)
+{
+    const QString message = error ? QString::fromUtf8(error->message) : QString("Unknown error");
+    if (error) g_error_free(error);
+    return message;
+}
+
+QString installationId(FlatpakInstallation *installation)
+{
+    if (flatpak_installation_get_is_user(installation)) return "user";
+    return QString::fromUtf8(flatpak_installation_get_id(installation));
+}
+
+FlatpakInstallation *openInstallation(const QString &id, bool isSystem, GError **error)
+{
+    if (!isSystem) return flatpak_installation_new_user(nullptr, error);
+    if (id.isEmpty() || id == "default") return flatpak_installation_new_system(nullptr, error);
+    return flatpak_installation_new_system_with_id(id.toUtf8().constData(), nullptr, error);
+}
+
+// Every system installation plus the per-user one; the caller unrefs them
+QList<FlatpakInstallation *> openInstallations(QString *error)
+{
+    QList<FlatpakInstallation *> installations;
+    GError *gerror = nullptr;
+    
+    if (GPtrArray *system = flatpak_get_system_installations(nullptr, &gerror)) {
+        for (guint i = 0; i < system->len; ++i) {
+            installations << FLATPAK_INSTALLATION(g_object_ref(g_ptr_array_index(system, i)));
+        }
+        g_ptr_array_unref(system);
+    } else {
+        *error = takeError(gerror);
+        gerror = nullptr;
+    }
+    
+    if (FlatpakInstallation *user = flatpak_installation_new_user(nullptr, &gerror)) {
+        installations << user;
+    } else {
+        *error = takeError(gerror);
+    }
+    
+    return installations;
+}
+
+FlatpakRefInfo refInfo(FlatpakInstalledRef *installed, const QString &installation, bool isSystem)
+{
+    FlatpakRef *ref = FLATPAK_REF(installed);
+    FlatpakRefInfo info;
+    info.kind = flatpak_ref_get_kind(ref) == FLATPAK_REF_KIND_APP ? FlatpakRefInfo::App : FlatpakRefInfo::Runtime;
+    info.name = QString::fromUtf8(flatpak_ref_get_name(ref));
+    info.arch = QString::fromUtf8(flatpak_ref_get_arch(ref));
+    info.branch = QString::fromUtf8(flatpak_ref_get_branch(ref));
+    info.commit = QString::fromUtf8(flatpak_ref_get_commit(ref));
+    info.origin = QString::fromUtf8(flatpak_installed_ref_get_origin(installed));
+    info.latestCommit = QString::fromUtf8(flatpak_installed_ref_get_latest_commit(installed));
+    info.installedSize = flatpak_installed_ref_get_installed_size(installed);
+    info.appName = QString::fromUtf8(flatpak_installed_ref_get_appdata_name(installed));
+    info.appVersion = QString::fromUtf8(flatpak_installed_ref_get_appdata_version(installed));
+    info.isSystem = isSystem;
+    info.installation = installation;
+    return info;
+}
+
+FlatpakProgress::Operation operationKind(FlatpakTransactionOperation *operation)
+{
+    switch (flatpak_transaction_operation_get_operation_type(operation)) {
+    case FLATPAK_TRANSACTION_OPERATION_UPDATE:
+        return FlatpakProgress::Update;
+    case FLATPAK_TRANSACTION_OPERATION_UNINSTALL:
+        return FlatpakProgress::Uninstall;
+    default:
+        return FlatpakProgress::Install;
+    }
+}
+
+// Callbacks run on the transaction's worker thread; progress reaches the
+// backend on the GUI thread through queued calls
+struct TransactionContext {
+    FlatpakBackend *backend;
+    int transaction;
+    int index;
+    QHash<FlatpakTransactionOperation *, quint64> transferred;
+};
+
+struct OperationContext {
+    TransactionContext *transaction;
+    FlatpakTransactionOperation *operation;
+    FlatpakProgress progress;
+};
+
+void emitProgress(FlatpakBackend *backend, const FlatpakProgress &progress)
+{
+    QMetaObject::invokeMethod(backend, [backend, progress]() {
+        emit backend->progress(progress);
+    }, Qt::QueuedConnection);
+}
+
+void progressChanged(FlatpakTransactionProgress *transactionProgress, gpointer userData)
+{
+    OperationContext *context = static_cast<OperationContext *>(userData);
+    FlatpakProgress &progress = context->progress;
+    progress.percent = flatpak_transaction_progress_get_is_estimating(transactionProgress)
+        ? -1 : flatpak_transaction_progress_get_progress(transactionProgress);
+    progress.bytesTransferred = flatpak_transaction_progress_get_bytes_transferred(transactionProgress);
+    progress.status = takeString(flatpak_transaction_progress_get_status(transactionProgress));
+    context->transaction->transferred.insert(context->operation, progress.bytesTransferred);
+    emitProgress(context->transaction->backend, progress);
+}
+
+void freeOperationContext(gpointer data, GClosure *closure)
+{
+    Q_UNUSED(closure);
+    delete static_cast<OperationContext *>(data);
+}
+
+void newOperation(FlatpakTransaction *transaction, FlatpakTransactionOperation *operation,
+                  FlatpakTransactionProgress *transactionProgress, gpointer userData)
+{
+    TransactionContext *transactionContext = static_cast<TransactionContext *>(userData);
+    OperationContext *context = new OperationContext{transactionContext, operation, FlatpakProgress()};
+    
+    FlatpakProgress &progress = context->progress;
+    progress.transaction = transactionContext->transaction;
+    progress.operation = operationKind(operation);
+    progress.ref = QString::fromUtf8(flatpak_transaction_operation_get_ref(operation));
+    progress.remote = QString::fromUtf8(flatpak_transaction_operation_get_remote(operation));
+    progress.downloadSize = flatpak_transaction_operation_get_download_size(operation);
+    progress.index = ++transactionContext->index;
+    
+    GList *operations = flatpak_transaction_get_operations(transaction);
+    progress.count = int(g_list_length(operations));
+    g_list_free_full(operations, g_object_unref);
+    
+    flatpak_transaction_progress_set_update_frequency(transactionProgress, PROGRESS_INTERVAL_MS);
+    g_signal_connect_data(transactionProgress, "changed", G_CALLBACK(progressChanged),
+                          context, freeOperationContext, GConnectFlags(0));
+    emitProgress(transactionContext->backend, progress);
+}
+
+void operationDone(FlatpakTransaction *transaction, FlatpakTransactionOperation *operation,
+                   const char *commit, FlatpakTransactionResult result, gpointer userData)
+{
+    Q_UNUSED(transaction);
+    Q_UNUSED(commit);
+    Q_UNUSED(result);
+    TransactionContext *context = static_cast<TransactionContext *>(userData);
+    
+    FlatpakProgress progress;
+    progress.transaction = context->transaction;
+    progress.operation = operationKind(operation);
+    progress.ref = QString::fromUtf8(flatpak_transaction_operation_get_ref(operation));
+    progress.remote = QString::fromUtf8(flatpak_transaction_operation_get_remote(operation));
+    progress.downloadSize = flatpak_transaction_operation_get_download_size(operation);
+    progress.bytesTransferred = context->transferred.value(operation);
+    progress.percent = 100;
+    progress.done = true;
+    emitProgress(context->backend, progress);
+}
+
+gboolean operationError(FlatpakTransaction *transaction, FlatpakTransactionOperation *operation,
+                        const GError *error, FlatpakTransactionErrorDetails details, gpointer userData)
+{
+    Q_UNUSED(transaction);
+    TransactionContext *context = static_cast<TransactionContext *>(userData);
+    
+    FlatpakProgress progress;
+    progress.transaction = context->transaction;
+    progress.operation = operationKind(operation);
+    progress.ref = QString::fromUtf8(flatpak_transaction_operation_get_ref(operation));
+    progress.status = QString::fromUtf8(error->message);
+    emitProgress(context->backend, progress);
+    
+    // Non-fatal errors, e.g. an extension that is no longer published, let the rest go on
+    return (details & FLATPAK_TRANSACTION_ERROR_DETAILS_NON_FATAL) ? TRUE : FALSE;
+}
+
+gboolean addNewRemote(FlatpakTransaction *transaction, FlatpakTransactionRemoteReason reason,
+                      const char *fromId, const char *remoteName, const char *url, gpointer userData)
+{
+    Q_UNUSED(transaction);
+    Q_UNUSED(reason);
+    Q_UNUSED(fromId);
+    Q_UNUSED(remoteName);
+    Q_UNUSED(url);
+    Q_UNUSED(userData);
+    return TRUE;  // what "flatpak install -y" does
+}
+
+QString runTransaction(FlatpakBackend *backend, FlatpakTransaction *transaction, int id)
+{
+    TransactionContext context{backend, id, 0};
+    g_signal_connect(transaction, "new-operation", G_CALLBACK(newOperation), &context);
+    g_signal_connect(transaction, "operation-done", G_CALLBACK(operationDone), &context);
+    g_signal_connect(transaction, "operation-error", G_CALLBACK(operationError), &context);
+    g_signal_connect(transaction, "add-new-remote", G_CALLBACK(addNewRemote), &context);
+    
+    GError *error = nullptr;
+    const bool success = flatpak_transaction_run(transaction, nullptr, &error);
+    g_signal_handlers_disconnect_by_data(transaction, &context);
+    return success ? QString() : takeError(error);
+}
+
+// The app's ref on the first enabled remote that has it, from the cached
+// summaries where possible; "stable" is preferred over other branches
+bool resolveApp(FlatpakInstallation *installation, const QString &appId, QString *remoteName, QString *ref, QString *error)
+{
+    GError *gerror = nullptr;
+    GPtrArray *remotes = flatpak_installation_list_remotes(installation, nullptr, &gerror);
+    if (!remotes) {
+        *error = takeError(gerror);
+        return false;
+    }
+    
+    const QByteArray name = appId.toUtf8();
+    const char *arch = flatpak_get_default_arch();
+    bool found = false;
+    
+    for (guint i = 0; i < remotes->len && !found; ++i) {
+        FlatpakRemote *remote = FLATPAK_REMOTE(g_ptr_array_index(remotes, i));
+        const QString candidate = QString::fromUtf8(flatpak_remote_get_name(remote));
+        if (flatpak_remote_get_disabled(remote) || (!remoteName->isEmpty() && candidate != *remoteName)) continue;
+        
+        GPtrArray *refs = flatpak_installation_list_remote_refs_sync_full(
+            installation, flatpak_remote_get_name(remote), FLATPAK_QUERY_FLAGS_ONLY_CACHED, nullptr, nullptr);
+        if (!refs) {
+            refs = flatpak_installation_list_remote_refs_sync(installation, flatpak_remote_get_name(remote), nullptr, nullptr);
+        }
+        if (!refs) continue;
+        
+        for (guint j = 0; j < refs->len; ++j) {
+            FlatpakRef *remoteRef = FLATPAK_REF(g_ptr_array_index(refs, j));
+            if (flatpak_ref_get_kind(remoteRef) != FLATPAK_REF_KIND_APP
+                || qstrcmp(flatpak_ref_get_name(remoteRef), name.constData()) != 0
+                || qstrcmp(flatpak_ref_get_arch(remoteRef), arch) != 0) {
+                continue;
+            }
+            const bool stable = qstrcmp(flatpak_ref_get_branch(remoteRef), "stable") == 0;
+            if (!found || stable) {
+                *ref = takeString(flatpak_ref_format_ref(remoteRef));
+                *remoteName = candidate;
+                found = true;
+            }
+            if (stable) break;
+        }
+        g_ptr_array_unref(refs);
+    }
+    
+    g_ptr_array_unref(remotes);
+    if (!found) {
+        *error = QString("%1 was not found on any enabled remote").arg(appId);
+    }
+    return found;
+}
+
+// Runs work against one installation and returns its error, if any
+QString withInstallation(const QString &id, bool isSystem, const std::function<bool(FlatpakInstallation *, GError **)> &work)
+{
+    GError *error = nullptr;
+    FlatpakInstallation *installation = openInstallation(id, isSystem, &error);
+    if (!installation) return takeError(error);
+    
+    const bool success = work(installation, &error);
+    g_object_unref(installation);
+    return success ? QString() : takeError(error);
+}
+#endif
+
+}
+
+// FlatpakBackend Implementation
+FlatpakBackend *FlatpakBackend::instance()
+{
+    static FlatpakBackend backend;
+    return &backend;
+}
+
+FlatpakBackend::FlatpakBackend(QObject *parent)
+    : QObject(parent)
+    , m_refreshing(false)
+    , m_refreshAgain(false)
+    , m_nextTransaction(1)
+    , m_network(new QNetworkAccessManager(this))
+{
+}
+
+bool FlatpakBackend::isAvailable()
+{
+    return !QStandardPaths::findExecutable("flatpak").isEmpty();
+}
+
+bool FlatpakBackend::isNative() const
+{
+#ifdef HAVE_LIBFLATPAK
+    return true;
+#else
+    return false;
+#endif
+}
+
+void FlatpakBackend::refresh()
+{
+    if (m_refreshing) {
+        m_refreshAgain = true;
+        return;
+    }
+    m_refreshing = true;
+    m_refreshAgain = false;
+    
+    if (isNative()) {
+        refreshNative();
+    } else {
+        refreshWithCli();
+    }
+}
+
+void FlatpakBackend::refreshNative()
+{
+#ifdef HAVE_LIBFLATPAK
+    QThreadPool::globalInstance()->start([this]() {
+        QList<FlatpakRemoteInfo> remotes;
+        QList<FlatpakRefInfo> refs;
+        QString error;
+        
+        const QList<FlatpakInstallation *> installations = openInstallations(&error);
+        for (FlatpakInstallation *installation : installations) {
+            const QString id = installationId(installation);
+            const bool isSystem = !flatpak_installation_get_is_user(installation);
+            GError *gerror = nullptr;
+            
+            if (GPtrArray *list = flatpak_installation_list_remotes(installation, nullptr, &gerror)) {
+                for (guint i = 0; i < list->len; ++i) {
+                    FlatpakRemote *remote = FLATPAK_REMOTE(g_ptr_array_index(list, i));
+                    FlatpakRemoteInfo info;
+                    info.name = QString::fromUtf8(flatpak_remote_get_name(remote));
+                    info.url = takeString(flatpak_remote_get_url(remote));
+                    info.title = takeString(flatpak_remote_get_title(remote));
+                    info.description = takeString(flatpak_remote_get_description(remote));
+                    info.filter = takeString(flatpak_remote_get_filter(remote));
+                    info.enabled = !flatpak_remote_get_disabled(remote);
+                    info.priority = flatpak_remote_get_prio(remote);
+                    info.isSystem = isSystem;
+                    info.installation = id;
+                    remotes << info;
+                }
+                g_ptr_array_unref(list);
+            } else {
+                error = takeError(gerror);
+                gerror = nullptr;
+            }
+            
+            if (GPtrArray *list = flatpak_installation_list_installed_refs(installation, nullptr, &gerror)) {
+                for (guint i = 0; i < list->len; ++i) {
+                    refs << refInfo(FLATPAK_INSTALLED_REF(g_ptr_array_index(list, i)), id, isSystem);
+                }
+                g_ptr_array_unref(list);
+            } else {
+                error = takeError(gerror);
+            }
+            
+            g_object_unref(installation);
+        }
+        
+        QMetaObject::invokeMethod(this, [this, remotes, refs, error]() {
+            finishRefresh(remotes, refs, error);
+        }, Qt::QueuedConnection);
+    });
+#endif
+}
+
+void FlatpakBackend::refreshWithCli()
+{
+    // Three listings run side by side; the last one to finish publishes
+    struct Pending {
+        QList<FlatpakRemoteInfo> remotes;
+        QList<FlatpakRefInfo> refs;
+        QString error;
+        int running = 0;
+    };
+    auto pending = std::make_shared<Pending>();
+    
+    auto run = [this, pending](const QStringList &args, const std::function<void(const QString &)> &parse) {
+        ++pending->running;
+        ProcessRunner::instance()->run("flatpak", args).then(this, [this, pending, parse](const ProcessResult &result) {
+            if (result.success()) {
+                parse(result.output());
+            } else {
+                pending->error = QString::fromUtf8(result.standardError).trimmed();
+                if (pending->error.isEmpty()) pending->error = result.errorString;
+            }
+            if (--pending->running == 0) {
+                finishRefresh(pending->remotes, pending->refs, pending->error);
+            }
+        });
+    };
+    
+    const QString remoteColumns = "--columns=name,title,url,filter,priority,options";
+    run(QStringList() << "remotes" << "--system" << remoteColumns, [pending](const QString &output) {
+        pending->remotes << parseRemotes(output, "default", true);
+    });
+    run(QStringList() << "remotes" << "--user" << remoteColumns, [pending](const QString &output) {
+        pending->remotes << parseRemotes(output, "user", false);
+    });
+    run(QStringList() << "list" << "--columns=installation,ref,origin,active,latest,name,version,options",
+        [pending](const QString &output) {
+        pending->refs = parseInstalled(output);
+    });
+}
+
+void FlatpakBackend::finishRefresh(const QList<FlatpakRemoteInfo> &remotes, const QList<FlatpakRefInfo> &refs, const QString &error)
+{
+    m_refreshing = false;
+    
+    // One installation failing (e.g. no per-user one yet) still leaves the others
+    if (!error.isEmpty() && remotes.isEmpty() && refs.isEmpty()) {
+        emit refreshFailed(error);
+    } else {
+        m_remotes = remotes;
+        m_installedRefs = refs;
+        emit refreshed();
+    }
+    
+    if (m_refreshAgain) {
+        refresh();
+    }
+}
+
+QList<FlatpakRemoteInfo> FlatpakBackend::parseRemotes(const QString &output, const QString &installation, bool isSystem)
+{
+    // Tab separated when not on a terminal: name, title, url, filter, priority, options
+    QList<FlatpakRemoteInfo> remotes;
+    for (const QString &line : output.split('\n', Qt::SkipEmptyParts)) {
+        const QStringList parts = line.split('\t');
+        if (parts.size() < 6 || parts[0] == "Name") continue;
+        
+        FlatpakRemoteInfo remote;
+        remote.name = parts[0].trimmed();
+        remote.title = parts[1].trimmed();
+        remote.url = parts[2].trimmed();
+        remote.filter = parts[3].trimmed();
+        remote.priority = parts[4].trimmed().toInt();
+        remote.enabled = !parts[5].contains("disabled");
+        remote.installation = installation;
+        remote.isSystem = isSystem;
+        remotes << remote;
+    }
+    return remotes;
+}
+
+QList<FlatpakRefInfo> FlatpakBackend::parseInstalled(const QString &output)
+{
+    // installation, ref (name/arch/branch), origin, active, latest, name, version, options
+    QList<FlatpakRefInfo> refs;
+    for (const QString &line : output.split('\n', Qt::SkipEmptyParts)) {
+        const QStringList parts = line.split('\t');
+        if (parts.size() < 8 || parts[0] == "Installation") continue;
+        
+        QStringList ref = parts[1].trimmed().split('/');
+        if (ref.size() == 4) ref.removeFirst();  // kind prefix, on some versions
+        if (ref.size() != 3) continue;
+        
+        FlatpakRefInfo info;
+        info.kind = parts[7].contains("runtime") ? FlatpakRefInfo::Runtime : FlatpakRefInfo::App;
+        info.name = ref[0];
+        info.arch = ref[1];
+        info.branch = ref[2];
+        info.origin = parts[2].trimmed();
+        info.commit = parts[3].trimmed();
+        info.latestCommit = parts[4].trimmed();
+        info.appName = parts[5].trimmed();
+        info.appVersion = parts[6].trimmed();
+        
+        const QString installation = parts[0].trimmed();
+        info.isSystem = installation != "user";
+        info.installation = installation == "system" ? "default" : installation;
+        refs << info;
+    }
+    return refs;
+}
+
+QStringList FlatpakBackend::installationArgs(const QString &installation, bool isSystem)
+{
+    if (!isSystem) return QStringList() << "--user";
+    if (installation.isEmpty() || installation == "default") return QStringList() << "--system";
+    return QStringList() << "--installation=" + installation;
+}
+
+int FlatpakBackend::installApp(const QString &appId, const QString &remote, bool user)
+{
+    if (!isNative()) {
+        QStringList args;
+        args << "install" << "--noninteractive" << "-y" << (user ? "--user" : "--system");
+        if (!remote.isEmpty()) args << remote;
+        return runCli(args << appId);
+    }
+
+#ifdef HAVE_LIBFLATPAK
+    return runNative([this, appId, remote, user](int id) -> QString {
+        GError *error = nullptr;
+        FlatpakInstallation *installation = openInstallation(QString(), !user, &error);
+        if (!installation) return takeError(error);
+        
+        QString remoteName = remote;
+        QString ref;
+        QString message;
+        if (resolveApp(installation, appId, &remoteName, &ref, &message)) {
+            FlatpakTransaction *transaction = flatpak_transaction_new_for_installation(installation, nullptr, &error);
+            if (!transaction) {
+                message = takeError(error);
+            } else if (!flatpak_transaction_add_install(transaction, remoteName.toUtf8().constData(),
+                                                        ref.toUtf8().constData(), nullptr, &error)) {
+                message = takeError(error);
+            } else {
+                message = runTransaction(this, transaction, id);
+            }
+            if (transaction) g_object_unref(transaction);
+        }
+        
+        g_object_unref(installation);
+        return message;
+    });
+#else
+    return 0;
+#endif
+}
+
+int FlatpakBackend::uninstallRef(const FlatpakRefInfo &ref)
+{
+    if (!isNative()) {
+        return runCli(QStringList() << "uninstall" << "--noninteractive" << "-y"
+                      << installationArgs(ref.installation, ref.isSystem) << ref.ref());
+    }
+
+#ifdef HAVE_LIBFLATPAK
+    return runNative([this, ref](int id) -> QString {
+        QString message;
+        const QString failure = withInstallation(ref.installation, ref.isSystem, [&](FlatpakInstallation *installation, GError **error) {
+            FlatpakTransaction *transaction = flatpak_transaction_new_for_installation(installation, nullptr, error);
+            if (!transaction) return false;
+            if (flatpak_transaction_add_uninstall(transaction, ref.ref().toUtf8().constData(), error)) {
+                message = runTransaction(this, transaction, id);
+            }
+            g_object_unref(transaction);
+            return *error == nullptr;
+        });
+        return failure.isEmpty() ? message : failure;
+    });
+#else
+    return 0;
+#endif
+}
+
+int FlatpakBackend::addRemote(const QString &name, const QString &url, bool user)
+{
+    if (!isNative()) {
+        return runCli(QStringList() << "remote-add" << "--if-not-exists" << (user ? "--user" : "--system") << name << url);
+    }
+
+#ifdef HAVE_LIBFLATPAK
+    auto add = [name, url, user](const QByteArray &repoFile) {
+        return withInstallation(QString(), !user, [&](FlatpakInstallation *installation, GError **error) {
+            FlatpakRemote *remote = nullptr;
+            if (repoFile.isEmpty()) {
+                remote = flatpak_remote_new(name.toUtf8().constData());
+                flatpak_remote_set_url(remote, url.toUtf8().constData());
+            } else {
+                GBytes *data = g_bytes_new(repoFile.constData(), gsize(repoFile.size()));
+                remote = flatpak_remote_new_from_file(name.toUtf8().constData(), data, error);
+                g_bytes_unref(data);
+                if (!remote) return false;
+            }
+            const bool success = flatpak_installation_add_remote(installation, remote, TRUE, nullptr, error);
+            g_object_unref(remote);
+            return success;
+        });
+    };
+    
+    // A .flatpakrepo carries the title and GPG key; fetch it here, the library will not
+    if (!url.endsWith(".flatpakrepo")) {
+        return runNative([add](int) { return add(QByteArray()); });
+    }
+    
+    const int id = m_nextTransaction++;
+    QNetworkReply *reply = m_network->get(QNetworkRequest(QUrl(url)));
+    connect(reply, &QNetworkReply::finished, this, [this, reply, id, add]() {
+        reply->deleteLater();
+        if (reply->error() != QNetworkReply::NoError) {
+            finishTransaction(id, reply->errorString());
+            return;
+        }
+        const QByteArray repoFile = reply->readAll();
+        runNative([add, repoFile](int) { return add(repoFile); }, id);
+    });
+    return id;
+#else
+    return 0;
+#endif
+}
+
+int FlatpakBackend::removeRemote(const FlatpakRemoteInfo &remote)
+{
+    if (!isNative()) {
+        return runCli(QStringList() << "remote-delete" << installationArgs(remote.installation, remote.isSystem) << remote.name);
+    }
+
+#ifdef HAVE_LIBFLATPAK
+    return runNative([remote](int) {
+        return withInstallation(remote.installation, remote.isSystem, [&](FlatpakInstallation *installation, GError **error) {
+            return bool(flatpak_installation_remove_remote(installation, remote.name.toUtf8().constData(), nullptr, error));
+        });
+    });
+#else
+    return 0;
+#endif
+}
+
+int FlatpakBackend::setRemoteEnabled(const FlatpakRemoteInfo &remote, bool enabled)
+{
+    if (!isNative()) {
+        return runCli(QStringList() << "remote-modify" << (enabled ? "--enable" : "--disable")
+                      << installationArgs(remote.installation, remote.isSystem) << remote.name);
+    }
+
+#ifdef HAVE_LIBFLATPAK
+    return runNative([remote, enabled](int) {
+        return withInstallation(remote.installation, remote.isSystem, [&](FlatpakInstallation *installation, GError **error) {
+            FlatpakRemote *handle = flatpak_installation_get_remote_by_name(installation, remote.name.toUtf8().constData(), nullptr, error);
+            if (!handle) return false;
+            flatpak_remote_set_disabled(handle, !enabled);
+            const bool success = flatpak_installation_modify_remote(installation, handle, nullptr, error);
+            g_object_unref(handle);
+            return success;
+        });
+    });
+#else
+    return 0;
+#endif
+}
+
+int FlatpakBackend::updateRefs(const QString &installation, bool isSystem, const QStringList &refs)
+{
+    if (refs.isEmpty()) return 0;
+    
+    if (!isNative()) {
+        return runCli(QStringList() << "update" << "--noninteractive" << "-y"
+                      << installationArgs(installation, isSystem) << refs);
+    }
+
+#ifdef HAVE_LIBFLATPAK
+    // One transaction resolves each runtime and extension once, however many apps share it
+    return runNative([this, installation, isSystem, refs](int id) -> QString {
+        QString message;
+        const QString failure = withInstallation(installation, isSystem, [&](FlatpakInstallation *handle, GError **error) {
+            FlatpakTransaction *transaction = flatpak_transaction_new_for_installation(handle, nullptr, error);
+            if (!transaction) return false;
+            
+            bool added = true;
+            for (const QString &ref : refs) {
+                if (!flatpak_transaction_add_update(transaction, ref.toUtf8().constData(), nullptr, nullptr, error)) {
+                    added = false;
+                    break;
+                }
+            }
+            if (added) {
+                message = runTransaction(this, transaction, id);
+            }
+            g_object_unref(transaction);
+            return added;
+        });
+        return failure.isEmpty() ? message : failure;
+    });
+#else
+    return 0;
+#endif
+}
+
+void FlatpakBackend::checkUpdates()
+{
+    if (!isNative()) {
+        // The CLI only knows the latest commits from the cached remote summaries
+        QList<FlatpakRefInfo> updates;
+        for (const FlatpakRefInfo &ref : std::as_const(m_installedRefs)) {
+            if (ref.hasUpdate()) updates << ref;
+        }
+        QMetaObject::invokeMethod(this, [this, updates]() {
+            emit updatesChecked(updates, QString());
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+#ifdef HAVE_LIBFLATPAK
+    QThreadPool::globalInstance()->start([this]() {
+        QList<FlatpakRefInfo> updates;
+        QString error;
+        
+        // Fetches each remote's current summary, so this sees what "flatpak update" would do
+        const QList<FlatpakInstallation *> installations = openInstallations(&error);
+        for (FlatpakInstallation *installation : installations) {
+            const QString id = installationId(installation);
+            const bool isSystem = !flatpak_installation_get_is_user(installation);
+            GError *gerror = nullptr;
+            
+            if (GPtrArray *list = flatpak_installation_list_installed_refs_for_update(installation, nullptr, &gerror)) {
+                for (guint i = 0; i < list->len; ++i) {
+                    updates << refInfo(FLATPAK_INSTALLED_REF(g_ptr_array_index(list, i)), id, isSystem);
+                }
+                g_ptr_array_unref(list);
+            } else {
+                error = takeError(gerror);
+            }
+            g_object_unref(installation);
+        }
+        
+        QMetaObject::invokeMethod(this, [this, updates, error]() {
+            emit updatesChecked(updates, error);
+        }, Qt::QueuedConnection);
+    });
+#endif
+}
+
+int FlatpakBackend::runNative(const std::function<QString(int)> &work, int transaction)
+{
+    const int id = transaction > 0 ? transaction : m_nextTransaction++;
+    QThreadPool::globalInstance()->start([this, work, id]() {
+#ifdef HAVE_LIBFLATPAK
+        // Without a context of its own a pool thread attaches transaction
+        // progress to the global one, whose callbacks run on the GUI thread
+        GMainContext *context = g_main_context_new();
+        g_main_context_push_thread_default(context);
+        const QString error = work(id);
+        g_main_context_pop_thread_default(context);
+        g_main_context_unref(context);
+#else
+        const QString error = work(id);
+#endif
+        QMetaObject::invokeMethod(this, [this, id, error]() {
+            finishTransaction(id, error);
+        }, Qt::QueuedConnection);
+    });
+    return id;
+}
+
+int FlatpakBackend::runCli(const QStringList &args)
+{
+    const int id = m_nextTransaction++;
+    auto buffer = std::make_shared<QByteArray>();
+    auto lastLines = std::make_shared<QStringList>();
+    
+    // Installs and updates download for as long as they need to
+    ProcessRequest request("flatpak", args);
+    request.channelMode = QProcess::MergedChannels;
+    request.timeoutMs = 0;
+    request.launcher = ProcessRequest::QtProcess;
+    // The backend lives as long as the application, so it is still there for every chunk
+    request.onOutput = [this, id, buffer, lastLines](const QByteArray &chunk) {
+        buffer->append(chunk);
+        int newline;
+        while ((newline = buffer->indexOf('\n')) >= 0) {
+            const QString line = QString::fromUtf8(buffer->left(newline)).trimmed();
+            buffer->remove(0, newline + 1);
+            if (line.isEmpty()) continue;
+            
+            FlatpakProgress progress;
+            progress.transaction = id;
+            progress.status = line;
+            emit this->progress(progress);
+            
+            *lastLines << line;
+            if (lastLines->size() > 5) lastLines->removeFirst();
+        }
+    };
+    
+    ProcessRunner::instance()->run(request).then(this, [this, id, lastLines](const ProcessResult &result) {
+        if (result.success()) {
+            finishTransaction(id, QString());
+        } else {
+            finishTransaction(id, result.started && !lastLines->isEmpty() ? lastLines->join('\n') : result.errorString);
+        }
+    });
+    return id;
+}
+
+void FlatpakBackend::finishTransaction(int transaction, const QString &error)
+{
+    emit transactionFinished(transaction, error.isEmpty(), error);
+    refresh();
+}
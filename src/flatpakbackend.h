@@ -0,0 +1,131 @@
+#ifndef FLATPAKBACKEND_H
+#define FLATPAKBACKEND_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QProcess>
+#include <functional>
+
+class QNetworkAccessManager;
+
+struct FlatpakRemoteInfo {
+    QString name;
+    QString url;
+    QString title;
+    QString description;
+    bool enabled = true;
+    bool isSystem = true;
+    QString installation;       // "default" and other system installations, or "user"
+    QString filter;
+    int priority = 1;
+};
+
+struct FlatpakRefInfo {
+    enum Kind { App, Runtime };
+    
+    Kind kind = App;
+    QString name;
+    QString arch;
+    QString branch;
+    QString origin;             // remote it was installed from
+    QString commit;
+    QString latestCommit;       // newest commit in the cached remote summary
+    QString installation;
+    bool isSystem = true;
+    quint64 installedSize = 0;
+    QString appName;            // from the installed appdata, if any
+    QString appVersion;
+    
+    QString ref() const { return QString("%1/%2/%3/%4").arg(kind == App ? "app" : "runtime", name, arch, branch); }
+    // The CLI lists shortened commits, so either may be a prefix of the other
+    bool hasUpdate() const
+    {
+        return !latestCommit.isEmpty() && latestCommit != "-" && !commit.isEmpty()
+            && !commit.startsWith(latestCommit) && !latestCommit.startsWith(commit);
+    }
+};
+
+// One step of a transaction: a ref being installed, updated or removed
+struct FlatpakProgress {
+    enum Operation { Install, Update, Uninstall };
+    
+    int transaction = 0;
+    Operation operation = Install;
+    QString ref;
+    QString remote;
+    int index = 0;              // 1-based position in the transaction
+    int count = 0;
+    int percent = -1;           // -1 while unknown
+    quint64 bytesTransferred = 0;
+    quint64 downloadSize = 0;   // what a full download would take, before deltas and local objects
+    QString status;
+    bool done = false;
+};
+
+// Flatpak installations, remotes and installed refs, and transactions on
+// them. Built with libflatpak, everything is read in-process on a worker
+// thread and transactions report typed progress per operation; system
+// installations go through flatpak's own polkit helper either way.
+// Without it the flatpak CLI is run asynchronously instead.
+class FlatpakBackend : public QObject
+{
+    Q_OBJECT
+
+public:
+    static FlatpakBackend *instance();
+    
+    static bool isAvailable();
+    bool isNative() const;
+    
+    // Reloads remotes and installed refs of every installation in the background
+    void refresh();
+    bool isRefreshing() const { return m_refreshing; }
+    QList<FlatpakRemoteInfo> remotes() const { return m_remotes; }
+    QList<FlatpakRefInfo> installedRefs() const { return m_installedRefs; }
+    
+    // Transactions return an id that the progress and finished signals carry
+    int installApp(const QString &appId, const QString &remote = QString(), bool user = false);
+    int uninstallRef(const FlatpakRefInfo &ref);
+    int addRemote(const QString &name, const QString &url, bool user = false);
+    int removeRemote(const FlatpakRemoteInfo &remote);
+    int setRemoteEnabled(const FlatpakRemoteInfo &remote, bool enabled);
+    // Updates the given refs of one installation in a single transaction
+    int updateRefs(const QString &installation, bool isSystem, const QStringList &refs);
+    
+    // Installed refs with a newer commit on their remote, across every installation
+    void checkUpdates();
+
+signals:
+    void refreshed();
+    void refreshFailed(const QString &error);
+    void progress(const FlatpakProgress &progress);
+    void transactionFinished(int transaction, bool success, const QString &error);
+    void updatesChecked(const QList<FlatpakRefInfo> &updates, const QString &error);
+
+private:
+    explicit FlatpakBackend(QObject *parent = nullptr);
+    
+    void refreshNative();
+    void refreshWithCli();
+    void finishRefresh(const QList<FlatpakRemoteInfo> &remotes, const QList<FlatpakRefInfo> &refs, const QString &error);
+    
+    int runNative(const std::function<QString(int)> &work, int transaction = 0);
+    int runCli(const QStringList &args);
+    void finishTransaction(int transaction, const QString &error);
+    
+    static QStringList installationArgs(const QString &installation, bool isSystem);
+    static QList<FlatpakRemoteInfo> parseRemotes(const QString &output, const QString &installation, bool isSystem);
+    static QList<FlatpakRefInfo> parseInstalled(const QString &output);
+    
+    QList<FlatpakRemoteInfo> m_remotes;
+    QList<FlatpakRefInfo> m_installedRefs;
+    bool m_refreshing;
+    bool m_refreshAgain;
+    int m_nextTransaction;
+    QNetworkAccessManager *m_network;
+};
+
+#endif // FLATPAKBACKEND_H
@@ -0,0 +1,203 @@
+#include "flatpakupdater.h"
+#include <QSet>
+#include <QPair>
+#include <QMap>
+
+// FlatpakUpdater Implementation
+FlatpakUpdater::FlatpakUpdater(QObject *parent)
+    : QObject(parent)
+    , m_checking(false)
+{
+    FlatpakBackend *backend = FlatpakBackend::instance();
+    connect(backend, &FlatpakBackend::updatesChecked, this, &FlatpakUpdater::onUpdatesChecked);
+    connect(backend, &FlatpakBackend::progress, this, &FlatpakUpdater::onProgress);
+    connect(backend, &FlatpakBackend::transactionFinished, this, &FlatpakUpdater::onTransactionFinished);
+}
+
+void FlatpakUpdater::checkForUpdates()
+{
+    if (m_checking) return;
+    m_checking = true;
+    FlatpakBackend::instance()->checkUpdates();
+}
+
+void FlatpakUpdater::onUpdatesChecked(const QList<FlatpakRefInfo> &updates, const QString &error)
+{
+    if (!m_checking) return;
+    m_checking = false;
+    
+    m_pending = updates;
+    emit updatesAvailable(m_pending.size(), error);
+}
+
+bool FlatpakUpdater::start()
+{
+    if (isRunning() || m_pending.isEmpty()) return false;
+    
+    m_items.clear();
+    m_errors.clear();
+    
+    // A ref can come up twice, e.g. a runtime reported by two checks; it is only asked for once
+    QMap<QPair<QString, bool>, QList<FlatpakRefInfo>> byInstallation;
+    QSet<QString> seen;
+    for (const FlatpakRefInfo &ref : std::as_const(m_pending)) {
+        const QString key = QString("%1/%2/%3").arg(ref.installation).arg(ref.isSystem).arg(ref.ref());
+        if (seen.contains(key)) continue;
+        seen.insert(key);
+        byInstallation[qMakePair(ref.installation, ref.isSystem)] << ref;
+    }
+    
+    // System installations go through flatpak's helper and the user one does not,
+    // so neither waits for the other
+    FlatpakBackend *backend = FlatpakBackend::instance();
+    for (auto it = byInstallation.constBegin(); it != byInstallation.constEnd(); ++it) {
+        const QString installation = it.key().first;
+        const bool isSystem = it.key().second;
+        
+        QStringList refs;
+        for (const FlatpakRefInfo &ref : it.value()) {
+            refs << ref.ref();
+        }
+        const int transaction = backend->updateRefs(installation, isSystem, refs);
+        if (transaction <= 0) continue;
+        
+        m_transactions.insert(transaction, isSystem ? installation : "user");
+        for (const FlatpakRefInfo &ref : it.value()) {
+            FlatpakUpdateItem item;
+            item.ref = ref.ref();
+            item.remote = ref.origin;
+            item.installation = installation;
+            item.isSystem = isSystem;
+            item.transaction = transaction;
+            item.status = "Waiting";
+            m_items << item;
+        }
+    }
+    
+    m_pending.clear();
+    return isRunning();
+}
+
+void FlatpakUpdater::onProgress(const FlatpakProgress &progress)
+{
+    if (!m_transactions.contains(progress.transaction)) return;
+    
+    // The CLI only reports lines of text for the transaction as a whole
+    if (progress.ref.isEmpty()) {
+        if (!progress.status.isEmpty()) {
+            emit statusChanged(QString("[%1] %2").arg(m_transactions.value(progress.transaction), progress.status));
+        }
+        return;
+    }
+    
+    int index = findItem(progress.transaction, progress.ref);
+    if (index < 0) {
+        // A runtime, extension or locale the transaction added for the requested apps
+        FlatpakUpdateItem item;
+        item.ref = progress.ref;
+        item.transaction = progress.transaction;
+        for (const FlatpakUpdateItem &other : std::as_const(m_items)) {
+            if (other.transaction != progress.transaction) continue;
+            item.installation = other.installation;
+            item.isSystem = other.isSystem;
+            break;
+        }
+        m_items << item;
+        index = m_items.size() - 1;
+        emit itemAdded(index);
+    }
+    
+    FlatpakUpdateItem &item = m_items[index];
+    if (!progress.remote.isEmpty()) item.remote = progress.remote;
+    if (progress.percent >= 0) item.percent = progress.percent;
+    if (progress.downloadSize > 0) item.downloadSize = progress.downloadSize;
+    item.bytesTransferred = qMax(item.bytesTransferred, progress.bytesTransferred);
+    if (!progress.status.isEmpty()) item.status = progress.status;
+    if (progress.done) {
+        item.done = true;
+        item.percent = 100;
+        item.status = "Updated";
+    }
+    emit itemChanged(index);
+}
+
+void FlatpakUpdater::onTransactionFinished(int transaction, bool success, const QString &error)
+{
+    if (!m_transactions.contains(transaction)) return;
+    const QString installation = m_transactions.take(transaction);
+    
+    for (int i = 0; i < m_items.size(); ++i) {
+        FlatpakUpdateItem &item = m_items[i];
+        if (item.transaction != transaction || item.done) continue;
+        
+        // Without per-ref progress, the transaction's outcome is all there is
+        if (success) {
+            item.done = true;
+            item.percent = 100;
+            item.status = "Updated";
+        } else {
+            item.status = "Failed";
+        }
+        emit itemChanged(i);
+    }
+    
+    if (!success) {
+        m_errors << QString("%1: %2").arg(installation, error);
+    }
+    
+    if (m_transactions.isEmpty()) {
+        emit finished(m_errors.isEmpty(), m_errors.join('\n'));
+    }
+}
+
+int FlatpakUpdater::overallPercent() const
+{
+    if (m_items.isEmpty()) return 0;
+    
+    // Weighted by download size where known; unknown sizes count as an average ref
+    quint64 knownTotal = 0;
+    int known = 0;
+    for (const FlatpakUpdateItem &item : m_items) {
+        if (item.downloadSize == 0) continue;
+        knownTotal += item.downloadSize;
+        ++known;
+    }
+    const double fallback = known > 0 ? double(knownTotal) / known : 1.0;
+    
+    double total = 0;
+    double completed = 0;
+    for (const FlatpakUpdateItem &item : m_items) {
+        const double weight = item.downloadSize > 0 ? double(item.downloadSize) : fallback;
+        total += weight;
+        completed += weight * item.percent / 100.0;
+    }
+    return total > 0 ? qRound(completed * 100 / total) : 0;
+}
+
+quint64 FlatpakUpdater::bytesTransferred() const
+{
+    quint64 total = 0;
+    for (const FlatpakUpdateItem &item : m_items) {
+        total += item.bytesTransferred;
+    }
+    return total;
+}
+
+quint64 FlatpakUpdater::bytesSaved() const
+{
+    quint64 total = 0;
+    for (const FlatpakUpdateItem &item : m_items) {
+        total += item.bytesSaved();
+    }
+    return total;
+}
+
+int FlatpakUpdater::findItem(int transaction, const QString &ref) const
+{
+    for (int i = 0; i < m_items.size(); ++i) {
+        if (m_items[i].transaction == transaction && m_items[i].ref == ref) {
+            return i;
+        }
+    }
+    return -1;
+}
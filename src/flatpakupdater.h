@@ -0,0 +1,75 @@
+#ifndef FLATPAKUPDATER_H
+#define FLATPAKUPDATER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include "flatpakbackend.h"
+
+// One ref in a running update, including runtimes and extensions flatpak
+// pulled in on its own
+struct FlatpakUpdateItem {
+    QString ref;
+    QString remote;
+    QString installation;
+    bool isSystem = true;
+    int transaction = 0;
+    int percent = 0;
+    quint64 downloadSize = 0;
+    quint64 bytesTransferred = 0;
+    bool done = false;
+    QString status;
+    
+    // Left undownloaded thanks to static deltas and objects already present
+    quint64 bytesSaved() const { return done && downloadSize > bytesTransferred ? downloadSize - bytesTransferred : 0; }
+};
+
+// Finds pending Flatpak updates in every installation and applies them
+// with one transaction per installation, all running at once. Each
+// transaction fetches a runtime shared by several apps only once; the
+// per-ref progress of all of them is folded into one list and one overall
+// figure.
+class FlatpakUpdater : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FlatpakUpdater(QObject *parent = nullptr);
+    
+    void checkForUpdates();
+    QList<FlatpakRefInfo> pendingUpdates() const { return m_pending; }
+    
+    // Updates everything checkForUpdates() found
+    bool start();
+    bool isRunning() const { return !m_transactions.isEmpty(); }
+    
+    QList<FlatpakUpdateItem> items() const { return m_items; }
+    int overallPercent() const;
+    quint64 bytesTransferred() const;
+    quint64 bytesSaved() const;
+
+signals:
+    void updatesAvailable(int count, const QString &error);
+    void itemChanged(int index);
+    void itemAdded(int index);
+    void statusChanged(const QString &status);
+    void finished(bool success, const QString &error);
+
+private slots:
+    void onUpdatesChecked(const QList<FlatpakRefInfo> &updates, const QString &error);
+    void onProgress(const FlatpakProgress &progress);
+    void onTransactionFinished(int transaction, bool success, const QString &error);
+
+private:
+    int findItem(int transaction, const QString &ref) const;
+    
+    QList<FlatpakRefInfo> m_pending;
+    QList<FlatpakUpdateItem> m_items;
+    QHash<int, QString> m_transactions;    // running transaction to its installation
+    QStringList m_errors;
+    bool m_checking;
+};
+
+#endif // FLATPAKUPDATER_H
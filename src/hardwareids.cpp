@@ -0,0 +1,295 @@
+#include "hardwareids.h"
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <algorithm>
+#include <cstring>
+
+// Index timings; enable with QT_LOGGING_RULES="oreon.hardwareids.debug=true"
+Q_LOGGING_CATEGORY(hardwareIdsLog, "oreon.hardwareids", QtInfoMsg)
+
+namespace {
+
+// Class keys carry their depth in the top byte so a subclass 0x00 does not
+// collide with the base class entry
+quint32 classKey(int depth, quint8 baseClass, quint8 subclass = 0, quint8 progIf = 0)
+{
+    return (quint32(depth) << 24) | (quint32(baseClass) << 16) | (quint32(subclass) << 8) | progIf;
+}
+
+// Returns the number of hex digits consumed from [begin, end)
+int parseHex(const char *begin, const char *end, quint32 *value)
+{
+    quint32 result = 0;
+    const char *p = begin;
+    for (; p < end; ++p) {
+        int nibble;
+        if (*p >= '0' && *p <= '9') nibble = *p - '0';
+        else if (*p >= 'a' && *p <= 'f') nibble = *p - 'a' + 10;
+        else if (*p >= 'A' && *p <= 'F') nibble = *p - 'A' + 10;
+        else break;
+        result = (result << 4) | quint32(nibble);
+    }
+    *value = result;
+    return int(p - begin);
+}
+
+// Entries are "<id>  <name>": the id ends at the first double space
+const char *findSeparator(const char *begin, const char *end)
+{
+    for (const char *p = begin; p + 1 < end; ++p) {
+        if (p[0] == ' ' && p[1] == ' ') return p;
+    }
+    return nullptr;
+}
+
+template <typename T>
+void sortIndex(std::vector<T> &index)
+{
+    // Stable, so the first definition of a duplicated id wins like it does for lspci
+    std::stable_sort(index.begin(), index.end(), [](const T &a, const T &b) { return a.key < b.key; });
+    index.shrink_to_fit();
+}
+
+}
+
+// HardwareIds Implementation
+const HardwareIds &HardwareIds::pci()
+{
+    static const HardwareIds ids(QStringList() << "/usr/share/hwdata/pci.ids"
+                                               << "/usr/share/misc/pci.ids"
+                                               << "/usr/share/pci.ids");
+    return ids;
+}
+
+const HardwareIds &HardwareIds::usb()
+{
+    static const HardwareIds ids(QStringList() << "/usr/share/hwdata/usb.ids"
+                                               << "/usr/share/misc/usb.ids"
+                                               << "/usr/share/usb.ids");
+    return ids;
+}
+
+HardwareIds::HardwareIds(const QStringList &candidates)
+    : m_data(nullptr)
+    , m_size(0)
+{
+    for (const QString &candidate : candidates) {
+        if (QFile::exists(candidate) && load(candidate)) {
+            break;
+        }
+    }
+}
+
+bool HardwareIds::load(const QString &path)
+{
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    
+    // The mapping lives as long as m_file stays open, i.e. for the whole process
+    m_size = m_file.size();
+    uchar *data = m_size > 0 ? m_file.map(0, m_size) : nullptr;
+    if (!data) {
+        m_file.close();
+        m_size = 0;
+        return false;
+    }
+    m_data = reinterpret_cast<const char *>(data);
+    
+    QElapsedTimer timer;
+    timer.start();
+    buildIndex();
+    qCDebug(hardwareIdsLog) << "Indexed" << path << ":" << m_vendors.size() << "vendors," << m_devices.size() << "devices,"
+             << m_subsystems.size() << "subsystems," << m_classes.size() << "classes in"
+             << timer.nsecsElapsed() / 1000 << "us";
+    
+    return true;
+}
+
+void HardwareIds::buildIndex()
+{
+    enum Section { Vendors, Classes, Other };
+    Section section = Vendors;
+    quint32 vendor = 0;
+    quint32 device = 0;
+    quint32 baseClass = 0;
+    quint32 subclass = 0;
+    
+    const char *end = m_data + m_size;
+    const char *p = m_data;
+    while (p < end) {
+        const char *lineEnd = static_cast<const char *>(std::memchr(p, '\n', size_t(end - p)));
+        if (!lineEnd) lineEnd = end;
+        const char *line = p;
+        p = lineEnd + 1;
+        
+        if (line == lineEnd || *line == '#') continue;
+        
+        int depth = 0;
+        while (line < lineEnd && *line == '\t') {
+            ++line;
+            ++depth;
+        }
+        
+        const char *separator = findSeparator(line, lineEnd);
+        if (!separator) continue;
+        const int idLength = int(separator - line);
+        const quint32 nameOffset = quint32(separator + 2 - m_data);
+        
+        quint32 value = 0;
+        if (depth == 0) {
+            if (idLength > 2 && line[0] == 'C' && line[1] == ' '
+                && parseHex(line + 2, separator, &value) == idLength - 2) {
+                section = Classes;
+                baseClass = value;
+                m_classes.push_back({ classKey(0, quint8(baseClass)), nameOffset });
+            } else if (idLength == 4 && parseHex(line, separator, &value) == 4) {
+                section = Vendors;
+                vendor = value;
+                m_vendors.push_back({ vendor, nameOffset });
+            } else {
+                // usb.ids carries HID usages, languages etc. after the classes
+                section = Other;
+            }
+            continue;
+        }
+        
+        if (section == Vendors) {
+            if (depth == 1 && idLength == 4 && parseHex(line, separator, &value) == 4) {
+                device = value;
+                m_devices.push_back({ (vendor << 16) | device, nameOffset });
+            } else if (depth == 2 && idLength == 9 && line[4] == ' ') {
+                // "<subvendor> <subdevice>"; usb.ids has interface lines here instead
+                quint32 subVendor = 0;
+                quint32 subDevice = 0;
+                if (parseHex(line, line + 4, &subVendor) == 4 && parseHex(line + 5, separator, &subDevice) == 4) {
+                    const quint64 key = (quint64(vendor) << 48) | (quint64(device) << 32)
+                                      | (quint64(subVendor) << 16) | subDevice;
+                    m_subsystems.push_back({ key, nameOffset });
+                }
+            }
+        } else if (section == Classes && parseHex(line, separator, &value) == idLength) {
+            if (depth == 1) {
+                subclass = value;
+                m_classes.push_back({ classKey(1, quint8(baseClass), quint8(subclass)), nameOffset });
+            } else if (depth == 2) {
+                m_classes.push_back({ classKey(2, quint8(baseClass), quint8(subclass), quint8(value)), nameOffset });
+            }
+        }
+    }
+    
+    sortIndex(m_vendors);
+    sortIndex(m_devices);
+    sortIndex(m_subsystems);
+    sortIndex(m_classes);
+}
+
+QString HardwareIds::nameAt(quint32 offset) const
+{
+    const char *name = m_data + offset;
+    const char *end = static_cast<const char *>(std::memchr(name, '\n', size_t(m_size - offset)));
+    return QString::fromUtf8(name, int((end ? end : m_data + m_size) - name));
+}
+
+QString HardwareIds::lookup(const std::vector<Entry> &index, quint32 key) const
+{
+    const auto it = std::lower_bound(index.begin(), index.end(), key,
+                                     [](const Entry &entry, quint32 k) { return entry.key < k; });
+    if (it == index.end() || it->key != key) {
+        return QString();
+    }
+    return nameAt(it->offset);
+}
+
+QString HardwareIds::lookup(const std::vector<WideEntry> &index, quint64 key) const
+{
+    const auto it = std::lower_bound(index.begin(), index.end(), key,
+                                     [](const WideEntry &entry, quint64 k) { return entry.key < k; });
+    if (it == index.end() || it->key != key) {
+        return QString();
+    }
+    return nameAt(it->offset);
+}
+
+QString HardwareIds::benchmark(int lookups)
+{
+    lookups = qMax(1, lookups);
+    QString report;
+    
+    for (int database = 0; database < 2; ++database) {
+        QElapsedTimer timer;
+        timer.start();
+        const HardwareIds &ids = database == 0 ? pci() : usb();
+        const qint64 loadNs = timer.nsecsElapsed();
+        if (!ids.isLoaded()) {
+            report += QString("%1: not found\n").arg(database == 0 ? "pci.ids" : "usb.ids");
+            continue;
+        }
+        
+        report += QString("%1: %2 KiB mapped and indexed in %3 us\n")
+            .arg(ids.path()).arg(ids.m_size / 1024).arg(loadNs / 1000.0, 0, 'f', 1);
+        report += ids.timeLookups("vendor", ids.m_vendors, lookups);
+        report += ids.timeLookups("device", ids.m_devices, lookups);
+        report += ids.timeLookups("subsystem", ids.m_subsystems, lookups);
+        report += ids.timeLookups("class", ids.m_classes, lookups);
+    }
+    
+    report.chop(1);
+    return report;
+}
+
+template <typename T>
+QString HardwareIds::timeLookups(const char *kind, const std::vector<T> &index, int lookups) const
+{
+    if (index.empty()) {
+        return QString("  %1 no entries\n").arg(QString(kind) + ":", -11);
+    }
+    
+    // Hits spread over the whole index, so successive searches do not share a path
+    qint64 decoded = 0;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < lookups; ++i) {
+        decoded += lookup(index, index[(quint64(i) * 7919) % index.size()].key).size();
+    }
+    const qint64 elapsedNs = timer.nsecsElapsed();
+    
+    return QString("  %1 %2 entries, %3 KiB of index; %4 ns per lookup (%5 chars decoded)\n")
+        .arg(QString(kind) + ":", -11)
+        .arg(index.size())
+        .arg(index.size() * sizeof(T) / 1024.0, 0, 'f', 1)
+        .arg(double(elapsedNs) / lookups, 0, 'f', 0)
+        .arg(decoded);
+}
+
+QString HardwareIds::vendorName(quint16 vendor) const
+{
+    return lookup(m_vendors, vendor);
+}
+
+QString HardwareIds::deviceName(quint16 vendor, quint16 device) const
+{
+    return lookup(m_devices, (quint32(vendor) << 16) | device);
+}
+
+QString HardwareIds::subsystemName(quint16 vendor, quint16 device, quint16 subVendor, quint16 subDevice) const
+{
+    const quint64 key = (quint64(vendor) << 48) | (quint64(device) << 32) | (quint64(subVendor) << 16) | subDevice;
+    return lookup(m_subsystems, key);
+}
+
+QString HardwareIds::className(quint8 baseClass) const
+{
+    return lookup(m_classes, classKey(0, baseClass));
+}
+
+QString HardwareIds::subclassName(quint8 baseClass, quint8 subclass) const
+{
+    return lookup(m_classes, classKey(1, baseClass, subclass));
+}
+
+QString HardwareIds::progIfName(quint8 baseClass, quint8 subclass, quint8 progIf) const
+{
+    return lookup(m_classes, classKey(2, baseClass, subclass, progIf));
+}
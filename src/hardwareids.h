@@ -0,0 +1,65 @@
+#ifndef HARDWAREIDS_H
+#define HARDWAREIDS_H
+
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+// Name lookups against the pci.ids / usb.ids databases shipped by hwdata.
+// The file is memory-mapped and indexed once, on first use: the index only
+// holds sorted (id, offset) pairs into the mapping, names are decoded when
+// they are looked up.
+class HardwareIds
+{
+public:
+    static const HardwareIds &pci();
+    static const HardwareIds &usb();
+    
+    bool isLoaded() const { return m_data != nullptr; }
+    QString path() const { return m_file.fileName(); }
+    
+    QString vendorName(quint16 vendor) const;
+    QString deviceName(quint16 vendor, quint16 device) const;
+    QString subsystemName(quint16 vendor, quint16 device, quint16 subVendor, quint16 subDevice) const;
+    QString className(quint8 baseClass) const;
+    QString subclassName(quint8 baseClass, quint8 subclass) const;
+    QString progIfName(quint8 baseClass, quint8 subclass, quint8 progIf) const;
+    
+    // Times loading both databases and <lookups> name lookups of each kind
+    static QString benchmark(int lookups);
+
+private:
+    struct Entry {
+        quint32 key;
+        quint32 offset;     // start of the name in the mapped file
+    };
+    
+    // 16 bytes, as the key's alignment pads it out
+    struct WideEntry {
+        quint64 key;
+        quint32 offset;
+    };
+    
+    explicit HardwareIds(const QStringList &candidates);
+    HardwareIds(const HardwareIds &) = delete;
+    HardwareIds &operator=(const HardwareIds &) = delete;
+    
+    bool load(const QString &path);
+    void buildIndex();
+    QString nameAt(quint32 offset) const;
+    QString lookup(const std::vector<Entry> &index, quint32 key) const;
+    QString lookup(const std::vector<WideEntry> &index, quint64 key) const;
+    template <typename T>
+    QString timeLookups(const char *kind, const std::vector<T> &index, int lookups) const;
+    
+    QFile m_file;
+    const char *m_data;
+    qint64 m_size;
+    std::vector<Entry> m_vendors;
+    std::vector<Entry> m_devices;
+    std::vector<WideEntry> m_subsystems;
+    std::vector<Entry> m_classes;
+};
+
+#endif // HARDWAREIDS_H
@@ -0,0 +1,248 @@
+#include "initramfsbuilder.h"
+#include "privilegedexecutor.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <QPromise>
+#include <QThread>
+#include <QThreadPool>
+#include <QCryptographicHash>
+#include <memory>
+
+namespace {
+
+// dracut compresses with every core it is given; two images per core pair
+// keeps the machine busy without thrashing
+const int CORES_PER_IMAGE = 2;
+
+// Run as root by PrivilegedBatch, one item per kernel
+const char *BUILD_COMMAND = R"(
+step "$1" dracut --force "/boot/initramfs-$1.img" "$1"
+)";
+
+// Configuration that is copied into every image, hashed by content
+const char *const CONFIG_FILES[] = {
+    "/etc/dracut.conf", "/etc/vconsole.conf", "/etc/locale.conf", "/etc/crypttab",
+};
+
+const char *const CONFIG_DIRS[] = {
+    "/etc/dracut.conf.d", "/usr/lib/dracut/dracut.conf.d", "/etc/modprobe.d", "/usr/lib/modprobe.d",
+};
+
+void addFile(QCryptographicHash &hash, const QString &path)
+{
+    QFile file(path);
+    if (file.open(QIODevice::ReadOnly)) {
+        hash.addData(path.toUtf8());
+        hash.addData(&file);
+    }
+}
+
+// Stands in for the contents of large files that are not read back
+void addMetadata(QCryptographicHash &hash, const QString &path)
+{
+    const QFileInfo info(path);
+    if (info.exists()) {
+        hash.addData(QString("%1:%2:%3").arg(path).arg(info.size())
+                     .arg(info.lastModified().toMSecsSinceEpoch()).toUtf8());
+    }
+}
+
+}
+
+// InitramfsBuilder Implementation
+InitramfsBuilder::InitramfsBuilder(QObject *parent)
+    : QObject(parent)
+    , m_batch(new PrivilegedBatch(this))
+    , m_built(0)
+    , m_failed(0)
+    , m_skipped(0)
+{
+    connect(m_batch, &PrivilegedBatch::stepStarted, this, &InitramfsBuilder::onStepStarted);
+    connect(m_batch, &PrivilegedBatch::stepOutput, this, &InitramfsBuilder::imageOutput);
+    connect(m_batch, &PrivilegedBatch::stepFinished, this, &InitramfsBuilder::onStepFinished);
+    connect(m_batch, &PrivilegedBatch::finished, this, &InitramfsBuilder::onBatchFinished);
+}
+
+bool InitramfsBuilder::isRunning() const
+{
+    return m_batch->isRunning();
+}
+
+int InitramfsBuilder::buildSlots(int kernels)
+{
+    return qBound(1, QThread::idealThreadCount() / CORES_PER_IMAGE, qMax(kernels, 1));
+}
+
+QByteArray InitramfsBuilder::sharedInputs()
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    
+    for (const char *path : CONFIG_FILES) {
+        addFile(hash, QString::fromLatin1(path));
+    }
+    for (const char *dir : CONFIG_DIRS) {
+        const QDir configDir(QString::fromLatin1(dir));
+        for (const QString &name : configDir.entryList(QStringList() << "*.conf", QDir::Files, QDir::Name)) {
+            addFile(hash, configDir.filePath(name));
+        }
+    }
+    
+    // dracut itself and its modules
+    addMetadata(hash, "/usr/bin/dracut");
+    addMetadata(hash, "/usr/lib/dracut/modules.d");
+    
+    // Firmware the images may pull in. Packages replace files by renaming,
+    // which touches the directory, so directory mtimes are enough to notice
+    const QString firmwareRoot = QFileInfo("/lib/firmware").canonicalFilePath();
+    if (!firmwareRoot.isEmpty()) {
+        QStringList dirs;
+        dirs << firmwareRoot;
+        QDirIterator it(firmwareRoot, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            dirs << it.next();
+        }
+        dirs.sort();
+        for (const QString &dir : dirs) {
+            addMetadata(hash, dir);
+        }
+    }
+    
+    return hash.result();
+}
+
+QString InitramfsBuilder::inputHash(const QString &kernel, const QByteArray &sharedInputs)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(sharedInputs);
+    
+    // depmod rewrites these whenever a module for this kernel is added or removed
+    const QString moduleDir = "/lib/modules/" + kernel;
+    addMetadata(hash, moduleDir + "/modules.dep");
+    addMetadata(hash, moduleDir + "/modules.alias");
+    addMetadata(hash, moduleDir + "/modules.builtin");
+    
+    // A DKMS or akmods rebuild replaces the module in place and depmod then
+    // writes the same files again, so the out-of-tree modules count themselves
+    for (const char *subdir : {"/extra", "/updates"}) {
+        QStringList modules;
+        QDirIterator it(moduleDir + subdir, QStringList() << "*.ko" << "*.ko.*", QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            modules << it.next();
+        }
+        modules.sort();
+        for (const QString &module : modules) {
+            addMetadata(hash, module);
+        }
+    }
+    
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QFuture<QList<InitramfsImage>> InitramfsBuilder::plan(const QStringList &kernels, bool force) const
+{
+    // Walking /lib/firmware and the module trees takes a while on a cold cache
+    auto promise = std::make_shared<QPromise<QList<InitramfsImage>>>();
+    QFuture<QList<InitramfsImage>> future = promise->future();
+    promise->start();
+    
+    QThreadPool::globalInstance()->start([promise, kernels, force]() {
+        QStringList targets = kernels;
+        if (targets.isEmpty()) {
+            // A kernel whose modules directory has a vmlinuz is installed, not a leftover
+            const QStringList releases = QDir("/lib/modules").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+            for (const QString &release : releases) {
+                if (QFileInfo::exists("/lib/modules/" + release + "/vmlinuz")
+                    || QFileInfo::exists("/boot/vmlinuz-" + release)) {
+                    targets << release;
+                }
+            }
+        }
+        
+        const QByteArray shared = sharedInputs();
+        QSettings settings;
+        QList<InitramfsImage> images;
+        
+        for (const QString &kernel : targets) {
+            InitramfsImage image;
+            image.kernel = kernel;
+            image.imagePath = "/boot/initramfs-" + kernel + ".img";
+            image.inputHash = inputHash(kernel, shared);
+            
+            const QString recorded = settings.value("Initramfs/" + kernel).toString();
+            image.needsRebuild = force || !QFileInfo::exists(image.imagePath) || recorded != image.inputHash;
+            images << image;
+        }
+        
+        promise->addResult(images);
+        promise->finish();
+    });
+    
+    return future;
+}
+
+bool InitramfsBuilder::start(const QList<InitramfsImage> &images)
+{
+    if (isRunning()) return false;
+    
+    m_images.clear();
+    m_timers.clear();
+    m_built = 0;
+    m_failed = 0;
+    m_skipped = 0;
+    
+    QStringList kernels;
+    for (const InitramfsImage &image : images) {
+        if (!image.needsRebuild) {
+            ++m_skipped;
+            continue;
+        }
+        kernels << image.kernel;
+        m_images.insert(image.kernel, image);
+    }
+    
+    if (kernels.isEmpty()) {
+        emit finished(0, 0, m_skipped);
+        return true;
+    }
+    
+    return m_batch->start(QString::fromLatin1(BUILD_COMMAND), 1, kernels, buildSlots(kernels.size()));
+}
+
+void InitramfsBuilder::onStepStarted(const QString &kernel)
+{
+    if (m_images.contains(kernel)) {
+        m_timers[kernel].start();
+        emit imageStarted(kernel);
+    }
+}
+
+void InitramfsBuilder::onStepFinished(const QString &kernel, bool success)
+{
+    if (!m_images.contains(kernel)) return;
+    
+    const qint64 elapsed = m_timers.value(kernel).isValid() ? m_timers.value(kernel).elapsed() : 0;
+    if (success) {
+        ++m_built;
+        QSettings settings;
+        settings.setValue("Initramfs/" + kernel, m_images.value(kernel).inputHash);
+    } else {
+        ++m_failed;
+    }
+    m_images.remove(kernel);
+    emit imageFinished(kernel, success, elapsed);
+}
+
+void InitramfsBuilder::onBatchFinished()
+{
+    // Kernels that never reported back were cancelled or never started
+    for (const QString &kernel : m_images.keys()) {
+        ++m_failed;
+        emit imageFinished(kernel, false, 0);
+    }
+    m_images.clear();
+    
+    emit finished(m_built, m_failed, m_skipped);
+}
@@ -0,0 +1,61 @@
+#ifndef INITRAMFSBUILDER_H
+#define INITRAMFSBUILDER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QFuture>
+
+class PrivilegedBatch;
+
+struct InitramfsImage {
+    QString kernel;
+    QString imagePath;
+    QString inputHash;      // dracut configuration, modules and firmware
+    bool needsRebuild = true;
+};
+
+// Regenerates dracut images, several kernels at a time under one
+// privileged helper. A kernel is skipped when its image exists and the
+// hash of its inputs matches the one recorded after its last build, and
+// the time each regeneration took is reported when it finishes.
+class InitramfsBuilder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit InitramfsBuilder(QObject *parent = nullptr);
+    
+    QFuture<QList<InitramfsImage>> plan(const QStringList &kernels = QStringList(), bool force = false) const;
+    bool start(const QList<InitramfsImage> &images);
+    bool isRunning() const;
+    
+    static int buildSlots(int kernels);
+
+signals:
+    void imageStarted(const QString &kernel);
+    void imageOutput(const QString &kernel, const QString &line);
+    void imageFinished(const QString &kernel, bool success, qint64 elapsedMs);
+    void finished(int built, int failed, int skipped);
+
+private slots:
+    void onStepStarted(const QString &kernel);
+    void onStepFinished(const QString &kernel, bool success);
+    void onBatchFinished();
+
+private:
+    static QString inputHash(const QString &kernel, const QByteArray &sharedInputs);
+    static QByteArray sharedInputs();
+    
+    PrivilegedBatch *m_batch;
+    QHash<QString, InitramfsImage> m_images;    // by kernel
+    QHash<QString, QElapsedTimer> m_timers;
+    int m_built;
+    int m_failed;
+    int m_skipped;
+};
+
+#endif // INITRAMFSBUILDER_H
@@ -0,0 +1,276 @@
+#include "kernellog.h"
+#include <QFile>
+#include <QProcess>
+#include <QSettings>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QMutexLocker>
+#include <QDebug>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// One /dev/kmsg record; the kernel caps a record at this size
+const int KMSG_RECORD_SIZE = 8192;
+
+// "i915 0000:00:02.0: Direct firmware load for i915/tgl_dmc.bin failed with error -2"
+// "firmware: failed to load iwlwifi-ty-a0-gf-a0-72.ucode (-2)"
+const QRegularExpression &firmwareFailure()
+{
+    static const QRegularExpression expression(
+        "^(?:(\\S+ \\S+): )?(?:Direct firmware load for (\\S+) failed with error (-?\\d+)"
+        "|firmware: failed to load (\\S+) \\((-?\\d+)\\))");
+    return expression;
+}
+
+// "[    5.123456] host kernel: message"
+const QRegularExpression &journalLine()
+{
+    static const QRegularExpression expression("^\\[\\s*(\\d+\\.\\d+)\\] \\S+ kernel: (.*)$");
+    return expression;
+}
+
+QString currentBootId()
+{
+    QFile file("/proc/sys/kernel/random/boot_id");
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+    return QString::fromLatin1(file.readAll().trimmed());
+}
+
+}
+
+// KernelLog Implementation
+KernelLog &KernelLog::instance()
+{
+    static KernelLog log;
+    return log;
+}
+
+KernelLog::KernelLog()
+    : m_bootId(currentBootId())
+    , m_kmsg(-1)
+    , m_sequence(0)
+{
+    load();
+}
+
+KernelLog::~KernelLog()
+{
+    if (m_kmsg >= 0) {
+        ::close(m_kmsg);
+    }
+}
+
+bool KernelLog::update()
+{
+    QMutexLocker locker(&m_mutex);
+    m_error.clear();
+    
+    const int before = m_missing.size();
+    const quint64 sequence = m_sequence;
+    const QString cursor = m_journalCursor;
+    
+    if (!readKmsg()) {
+        if (!readJournal()) {
+            return false;
+        }
+        m_error.clear();
+    }
+    
+    if (m_sequence != sequence || m_journalCursor != cursor || m_missing.size() != before) {
+        save();
+    }
+    return true;
+}
+
+QList<MissingFirmware> KernelLog::missingFirmware() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_missing.values();
+}
+
+QString KernelLog::errorString() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_error;
+}
+
+void KernelLog::forget(const QString &name)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_missing.remove(name) > 0) {
+        save();
+    }
+}
+
+bool KernelLog::readKmsg()
+{
+    // Kept open: every later read continues where the previous one stopped
+    if (m_kmsg < 0) {
+        m_kmsg = ::open("/dev/kmsg", O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (m_kmsg < 0) {
+            m_error = QString("Cannot read /dev/kmsg: %1").arg(strerror(errno));
+            return false;
+        }
+    }
+    
+    char record[KMSG_RECORD_SIZE];
+    for (;;) {
+        const ssize_t size = ::read(m_kmsg, record, sizeof(record) - 1);
+        if (size < 0) {
+            if (errno == EINTR || errno == EPIPE) continue;  // EPIPE: records overwritten while we were away
+            if (errno == EAGAIN) break;
+            
+            m_error = QString("Cannot read /dev/kmsg: %1").arg(strerror(errno));
+            ::close(m_kmsg);
+            m_kmsg = -1;
+            return false;
+        }
+        
+        // "6,1234,5123456,-;message\n KEY=value\n"
+        const char *header = record;
+        const char *end = record + size;
+        const char *separator = static_cast<const char *>(memchr(header, ';', size_t(size)));
+        if (!separator) continue;
+        
+        const char *field = static_cast<const char *>(memchr(header, ',', size_t(separator - header)));
+        if (!field) continue;
+        char *next = nullptr;
+        const quint64 sequence = strtoull(field + 1, &next, 10);
+        if (sequence <= m_sequence && m_sequence != 0) continue;  // parsed before a restart
+        m_sequence = sequence;
+        
+        const double timestamp = (*next == ',') ? strtoull(next + 1, nullptr, 10) / 1e6 : 0;
+        
+        const char *message = separator + 1;
+        const char *lineEnd = static_cast<const char *>(memchr(message, '\n', size_t(end - message)));
+        const QByteArray text = QByteArray::fromRawData(message, int((lineEnd ? lineEnd : end) - message));
+        processMessage(text, timestamp);
+    }
+    
+    return true;
+}
+
+bool KernelLog::readJournal()
+{
+    QStringList arguments;
+    arguments << "-k" << "-b" << "--no-pager" << "-q" << "-o" << "short-monotonic" << "--show-cursor";
+    if (!m_journalCursor.isEmpty()) {
+        arguments << "--after-cursor" << m_journalCursor;
+    }
+    
+    QProcess process;
+    process.start("journalctl", arguments);
+    if (!process.waitForFinished(30000) || process.exitCode() != 0) {
+        m_error += QString("; journal unavailable: %1")
+                       .arg(QString::fromLocal8Bit(process.readAllStandardError()).trimmed());
+        return false;
+    }
+    
+    const QList<QByteArray> lines = process.readAllStandardOutput().split('\n');
+    for (const QByteArray &line : lines) {
+        if (line.startsWith("-- cursor: ")) {
+            m_journalCursor = QString::fromUtf8(line.mid(11).trimmed());
+            continue;
+        }
+        if (!line.contains("firmware")) continue;
+        
+        const QRegularExpressionMatch match = journalLine().match(QString::fromUtf8(line));
+        if (match.hasMatch()) {
+            processMessage(match.captured(2).toUtf8(), match.captured(1).toDouble());
+        }
+    }
+    
+    return true;
+}
+
+void KernelLog::processMessage(const QByteArray &message, double timestamp)
+{
+    // Cheap prefilter; nearly every record is rejected here
+    if (!message.contains("firmware")) return;
+    
+    const QString text = QString::fromUtf8(message);
+    const QRegularExpressionMatch match = firmwareFailure().match(text);
+    if (!match.hasMatch()) return;
+    
+    const bool direct = !match.captured(2).isEmpty();
+    const QString name = direct ? match.captured(2) : match.captured(4);
+    
+    MissingFirmware &entry = m_missing[name];
+    if (entry.count == 0) {
+        entry.name = name;
+        entry.firstSeen = timestamp;
+    }
+    if (!match.captured(1).isEmpty()) {
+        entry.device = match.captured(1);
+    }
+    entry.message = text;
+    entry.error = (direct ? match.captured(3) : match.captured(5)).toInt();
+    entry.lastSeen = timestamp;
+    ++entry.count;
+}
+
+void KernelLog::load()
+{
+    QSettings settings;
+    settings.beginGroup("KernelLog");
+    
+    // Sequence numbers and journal cursors only mean something within one boot
+    if (settings.value("bootId").toString() != m_bootId || m_bootId.isEmpty()) {
+        settings.endGroup();
+        return;
+    }
+    
+    m_sequence = settings.value("sequence").toULongLong();
+    m_journalCursor = settings.value("journalCursor").toString();
+    
+    const QJsonArray entries = QJsonDocument::fromJson(settings.value("missingFirmware").toByteArray()).array();
+    for (const QJsonValue &value : entries) {
+        const QJsonObject object = value.toObject();
+        MissingFirmware entry;
+        entry.name = object["name"].toString();
+        entry.device = object["device"].toString();
+        entry.message = object["message"].toString();
+        entry.error = object["error"].toInt();
+        entry.firstSeen = object["first_seen"].toDouble();
+        entry.lastSeen = object["last_seen"].toDouble();
+        entry.count = object["count"].toInt();
+        if (!entry.name.isEmpty()) {
+            m_missing.insert(entry.name, entry);
+        }
+    }
+    
+    settings.endGroup();
+}
+
+void KernelLog::save() const
+{
+    QJsonArray entries;
+    for (const MissingFirmware &entry : m_missing) {
+        QJsonObject object;
+        object["name"] = entry.name;
+        object["device"] = entry.device;
+        object["message"] = entry.message;
+        object["error"] = entry.error;
+        object["first_seen"] = entry.firstSeen;
+        object["last_seen"] = entry.lastSeen;
+        object["count"] = entry.count;
+        entries.append(object);
+    }
+    
+    QSettings settings;
+    settings.beginGroup("KernelLog");
+    settings.setValue("bootId", m_bootId);
+    settings.setValue("sequence", m_sequence);
+    settings.setValue("journalCursor", m_journalCursor);
+    settings.setValue("missingFirmware", QJsonDocument(entries).toJson(QJsonDocument::Compact));
+    settings.endGroup();
+}
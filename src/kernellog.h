@@ -0,0 +1,60 @@
+#ifndef KERNELLOG_H
+#define KERNELLOG_H
+
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QByteArray>
+#include <QMutex>
+
+struct MissingFirmware {
+    QString name;           // relative to /lib/firmware
+    QString device;         // e.g. "iwlwifi 0000:00:14.3", empty if not logged
+    QString message;        // the kernel line of the latest failure
+    int error = 0;          // errno the loader returned, e.g. -2
+    double firstSeen = 0;   // seconds since boot
+    double lastSeen = 0;
+    int count = 0;
+};
+
+// Incremental reader of the kernel log for firmware-load failures. Records
+// come from /dev/kmsg, or from the journal when kmsg is restricted, and only
+// those after the persisted cursor are parsed; the set of missing firmware
+// is kept deduplicated across rescans and restarts within one boot.
+class KernelLog
+{
+public:
+    static KernelLog &instance();
+    
+    // Reads the records logged since the last call; false if neither
+    // source could be read
+    bool update();
+    
+    QList<MissingFirmware> missingFirmware() const;
+    QString errorString() const;
+    
+    // Drops an entry, e.g. once the firmware has been installed
+    void forget(const QString &name);
+
+private:
+    KernelLog();
+    ~KernelLog();
+    KernelLog(const KernelLog &) = delete;
+    KernelLog &operator=(const KernelLog &) = delete;
+    
+    bool readKmsg();
+    bool readJournal();
+    void processMessage(const QByteArray &message, double timestamp);
+    void load();
+    void save() const;
+    
+    mutable QMutex m_mutex;
+    QString m_bootId;
+    int m_kmsg;
+    quint64 m_sequence;         // last /dev/kmsg record parsed
+    QString m_journalCursor;
+    QHash<QString, MissingFirmware> m_missing;
+    QString m_error;
+};
+
+#endif // KERNELLOG_H
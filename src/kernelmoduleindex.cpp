@@ -0,0 +1,226 @@
+#include "kernelmoduleindex.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QSysInfo>
+#include <algorithm>
+#include <cstring>
+#include <fnmatch.h>
+
+namespace {
+
+// "kernel/drivers/net/e1000e/e1000e.ko.xz" -> "e1000e"
+QString moduleNameFromPath(const QByteArray &path)
+{
+    QString name = QString::fromUtf8(path.mid(path.lastIndexOf('/') + 1));
+    const int suffix = name.indexOf(".ko");
+    if (suffix > 0) {
+        name.truncate(suffix);
+    }
+    return KernelModuleIndex::normalizeName(name);
+}
+
+}
+
+// KernelModuleIndex Implementation
+KernelModuleIndex::KernelModuleIndex(const QString &kernelRelease)
+    : m_kernelRelease(kernelRelease.isEmpty() ? runningKernelRelease() : kernelRelease)
+    , m_valid(false)
+{
+    loadDependencies();
+    loadBuiltins();
+    loadAliases();
+    m_valid = !m_modules.isEmpty();
+}
+
+const KernelModuleIndex &KernelModuleIndex::runningKernel()
+{
+    static const KernelModuleIndex index;
+    return index;
+}
+
+QString KernelModuleIndex::runningKernelRelease()
+{
+    // uname -r, without forking it
+    return QSysInfo::kernelVersion();
+}
+
+QString KernelModuleIndex::normalizeName(const QString &name)
+{
+    // The kernel treats '-' and '_' in module names as the same character
+    return QString(name).replace('-', '_');
+}
+
+QString KernelModuleIndex::moduleDirectory() const
+{
+    return "/lib/modules/" + m_kernelRelease;
+}
+
+QStringList KernelModuleIndex::moduleNames() const
+{
+    QStringList names = m_modules.keys();
+    names.sort();
+    return names;
+}
+
+bool KernelModuleIndex::contains(const QString &module) const
+{
+    const QString name = normalizeName(module);
+    return m_modules.contains(name) || m_builtins.contains(name);
+}
+
+bool KernelModuleIndex::isBuiltin(const QString &module) const
+{
+    return m_builtins.contains(normalizeName(module));
+}
+
+QString KernelModuleIndex::modulePath(const QString &module) const
+{
+    const auto it = m_modules.constFind(normalizeName(module));
+    if (it == m_modules.constEnd()) {
+        return QString();
+    }
+    return moduleDirectory() + '/' + it->path;
+}
+
+QStringList KernelModuleIndex::dependencies(const QString &module) const
+{
+    return m_modules.value(normalizeName(module)).dependencies;
+}
+
+QStringList KernelModuleIndex::match(const QString &modalias) const
+{
+    if (modalias.isEmpty() || m_aliases.empty()) {
+        return QStringList();
+    }
+    
+    const QByteArray alias = modalias.toUtf8();
+    const auto byPrefix = [](const Alias &entry, const QByteArray &prefix) { return entry.prefix < prefix; };
+    
+    // Only patterns whose literal prefix is a prefix of the modalias can
+    // match: one binary search per prefix length instead of a linear scan
+    std::vector<const Alias *> hits;
+    for (int length = 0; length <= alias.size(); ++length) {
+        const QByteArray prefix = alias.left(length);
+        auto it = std::lower_bound(m_aliases.begin(), m_aliases.end(), prefix, byPrefix);
+        for (; it != m_aliases.end() && it->prefix == prefix; ++it) {
+            if (fnmatch(it->pattern.constData(), alias.constData(), 0) == 0) {
+                hits.push_back(&*it);
+            }
+        }
+    }
+    
+    std::sort(hits.begin(), hits.end(), [](const Alias *a, const Alias *b) { return a->order < b->order; });
+    
+    QStringList modules;
+    for (const Alias *hit : hits) {
+        const QString &module = m_aliasModules.at(hit->module);
+        if (!modules.contains(module)) {
+            modules << module;
+        }
+    }
+    return modules;
+}
+
+QStringList KernelModuleIndex::match(const QStringList &modaliases) const
+{
+    QStringList modules;
+    for (const QString &modalias : modaliases) {
+        for (const QString &module : match(modalias)) {
+            if (!modules.contains(module)) {
+                modules << module;
+            }
+        }
+    }
+    return modules;
+}
+
+bool KernelModuleIndex::isModuleLoaded(const QString &module)
+{
+    // Only loadable modules have an initstate; builtins may still show up in /sys/module
+    return QFileInfo::exists("/sys/module/" + normalizeName(module) + "/initstate");
+}
+
+void KernelModuleIndex::loadDependencies()
+{
+    // "kernel/foo/bar.ko.zst: kernel/foo/dep.ko.zst kernel/baz/dep2.ko.zst"
+    const QByteArray data = readFile(moduleDirectory() + "/modules.dep");
+    const QList<QByteArray> lines = data.split('\n');
+    m_modules.reserve(lines.size());
+    
+    for (const QByteArray &line : lines) {
+        const int colon = line.indexOf(':');
+        if (colon <= 0) continue;
+        
+        const QByteArray path = line.left(colon);
+        ModuleEntry entry;
+        entry.path = QString::fromUtf8(path);
+        
+        const QList<QByteArray> deps = line.mid(colon + 1).simplified().split(' ');
+        for (const QByteArray &dep : deps) {
+            if (!dep.isEmpty()) {
+                entry.dependencies << moduleNameFromPath(dep);
+            }
+        }
+        
+        m_modules.insert(moduleNameFromPath(path), entry);
+    }
+}
+
+void KernelModuleIndex::loadBuiltins()
+{
+    const QByteArray data = readFile(moduleDirectory() + "/modules.builtin");
+    const QList<QByteArray> lines = data.split('\n');
+    for (const QByteArray &line : lines) {
+        if (!line.isEmpty()) {
+            m_builtins.insert(moduleNameFromPath(line.trimmed()));
+        }
+    }
+}
+
+void KernelModuleIndex::loadAliases()
+{
+    // "alias pci:v00008086d000015B8sv*sd*bc*sc*i* e1000e"
+    const QByteArray data = readFile(moduleDirectory() + "/modules.alias");
+    const QList<QByteArray> lines = data.split('\n');
+    m_aliases.reserve(size_t(lines.size()));
+    
+    QHash<QString, int> moduleIds;
+    int order = 0;
+    for (const QByteArray &line : lines) {
+        if (!line.startsWith("alias ")) continue;
+        
+        const int patternEnd = line.indexOf(' ', 6);
+        if (patternEnd < 0) continue;
+        
+        const QString module = normalizeName(QString::fromUtf8(line.mid(patternEnd + 1).trimmed()));
+        auto id = moduleIds.constFind(module);
+        if (id == moduleIds.constEnd()) {
+            id = moduleIds.insert(module, m_aliasModules.size());
+            m_aliasModules << module;
+        }
+        
+        Alias alias;
+        alias.pattern = line.mid(6, patternEnd - 6);
+        int literal = 0;
+        while (literal < alias.pattern.size() && !strchr("*?[\\", alias.pattern.at(literal))) {
+            ++literal;
+        }
+        alias.prefix = alias.pattern.left(literal);
+        alias.module = id.value();
+        alias.order = order++;
+        
+        m_aliases.push_back(alias);
+    }
+    
+    std::sort(m_aliases.begin(), m_aliases.end(),
+              [](const Alias &a, const Alias &b) { return a.prefix < b.prefix; });
+}
+
+QByteArray KernelModuleIndex::readFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
@@ -0,0 +1,69 @@
+#ifndef KERNELMODULEINDEX_H
+#define KERNELMODULEINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <vector>
+
+// What depmod generated for one kernel release: modules.dep (path and
+// dependencies of every module, compressed or not), modules.builtin and
+// modules.alias. Aliases are kept sorted by their literal prefix, so matching
+// a modalias only runs fnmatch against the few patterns that can apply.
+class KernelModuleIndex
+{
+public:
+    explicit KernelModuleIndex(const QString &kernelRelease = QString());
+    
+    // Shared, read-only index for the kernel that is running; built on first use
+    static const KernelModuleIndex &runningKernel();
+    
+    static QString runningKernelRelease();
+    static QString normalizeName(const QString &name);
+    
+    bool isValid() const { return m_valid; }
+    QString kernelRelease() const { return m_kernelRelease; }
+    QString moduleDirectory() const;
+    
+    QStringList moduleNames() const;
+    bool contains(const QString &module) const;
+    bool isBuiltin(const QString &module) const;
+    QString modulePath(const QString &module) const;     // absolute, empty for builtins
+    QStringList dependencies(const QString &module) const;
+    
+    // Modules whose aliases match the modalias, in modules.alias order
+    QStringList match(const QString &modalias) const;
+    // The union over several, e.g. every interface of a USB device
+    QStringList match(const QStringList &modaliases) const;
+    
+    static bool isModuleLoaded(const QString &module);
+
+private:
+    struct Alias {
+        QByteArray prefix;      // pattern up to its first wildcard
+        QByteArray pattern;
+        int module;             // index into m_aliasModules
+        int order;
+    };
+    
+    struct ModuleEntry {
+        QString path;           // relative to moduleDirectory()
+        QStringList dependencies;
+    };
+    
+    void loadDependencies();
+    void loadBuiltins();
+    void loadAliases();
+    static QByteArray readFile(const QString &path);
+    
+    QString m_kernelRelease;
+    bool m_valid;
+    QHash<QString, ModuleEntry> m_modules;
+    QSet<QString> m_builtins;
+    QStringList m_aliasModules;
+    std::vector<Alias> m_aliases;
+};
+
+#endif // KERNELMODULEINDEX_H
@@ -0,0 +1,312 @@
+#include "latencyprofile.h"
+#include "processrunner.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTextStream>
+
+namespace {
+
+// PipeWire's own default for libpipewire-module-rt
+const int DEFAULT_RT_PRIORITY = 88;
+
+QStringList ratesToStrings(const QList<int> &rates)
+{
+    QStringList result;
+    for (int rate : rates) {
+        result << QString::number(rate);
+    }
+    return result;
+}
+
+}
+
+// LatencyProfile Implementation
+QList<LatencyProfile> LatencyProfile::builtinProfiles()
+{
+    QList<LatencyProfile> profiles;
+    
+    LatencyProfile standard;
+    standard.name = "Default";
+    profiles << standard;
+    
+    LatencyProfile lowLatency;
+    lowLatency.name = "Low Latency";
+    lowLatency.rate = 48000;
+    lowLatency.allowedRates = { 48000 };
+    lowLatency.quantum = 128;
+    lowLatency.minQuantum = 64;
+    lowLatency.maxQuantum = 256;
+    lowLatency.forceQuantum = true;
+    lowLatency.suspendOnIdle = false;
+    profiles << lowLatency;
+    
+    LatencyProfile quality;
+    quality.name = "High Quality";
+    quality.rate = 96000;
+    quality.allowedRates = { 44100, 48000, 88200, 96000 };
+    quality.quantum = 1024;
+    quality.minQuantum = 128;
+    quality.maxQuantum = 4096;
+    profiles << quality;
+    
+    LatencyProfile powerSaving;
+    powerSaving.name = "Power Saving";
+    powerSaving.rate = 48000;
+    powerSaving.allowedRates = { 44100, 48000 };
+    powerSaving.quantum = 2048;
+    powerSaving.minQuantum = 1024;
+    powerSaving.maxQuantum = 8192;
+    profiles << powerSaving;
+    
+    return profiles;
+}
+
+LatencyProfile LatencyProfile::builtin(const QString &name)
+{
+    const QList<LatencyProfile> profiles = builtinProfiles();
+    for (const LatencyProfile &profile : profiles) {
+        if (profile.name == name) {
+            return profile;
+        }
+    }
+    return profiles.first();
+}
+
+// LatencyProfileEngine Implementation
+LatencyProfileEngine::LatencyProfileEngine(QObject *parent)
+    : QObject(parent)
+    , m_metadataRunning(false)
+{
+    loadCurrent();
+}
+
+QString LatencyProfileEngine::pipeWireDropInPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation)
+           + "/pipewire/pipewire.conf.d/60-oreon-latency.conf";
+}
+
+QString LatencyProfileEngine::wirePlumberDropInPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation)
+           + "/wireplumber/wireplumber.conf.d/60-oreon-latency.conf";
+}
+
+QByteArray LatencyProfileEngine::pipeWireDropIn(const LatencyProfile &profile)
+{
+    QString config;
+    QTextStream out(&config);
+    
+    out << "# Generated by Oreon System Manager (" << profile.name << " latency profile).\n"
+        << "# This file is overwritten whenever a latency profile is applied.\n\n"
+        << "context.properties = {\n"
+        << "    default.clock.rate = " << profile.rate << "\n"
+        << "    default.clock.allowed-rates = [ " << ratesToStrings(profile.allowedRates).join(' ') << " ]\n"
+        << "    default.clock.quantum = " << profile.quantum << "\n"
+        << "    default.clock.min-quantum = " << profile.minQuantum << "\n"
+        << "    default.clock.max-quantum = " << profile.maxQuantum << "\n"
+        << "}\n";
+    
+    // Only override module-rt when asked to, the stock config already loads it
+    if (profile.rtPriority != DEFAULT_RT_PRIORITY) {
+        out << "\n"
+            << "context.modules = [\n"
+            << "    { name = libpipewire-module-rt\n"
+            << "        args = {\n"
+            << "            rt.prio = " << profile.rtPriority << "\n"
+            << "        }\n"
+            << "        flags = [ ifexists nofail ]\n"
+            << "    }\n"
+            << "]\n";
+    }
+    
+    out.flush();
+    return config.toUtf8();
+}
+
+QByteArray LatencyProfileEngine::wirePlumberDropIn(const LatencyProfile &profile)
+{
+    if (profile.alsaPeriodSize <= 0 && profile.suspendOnIdle) {
+        return QByteArray();
+    }
+    
+    QString config;
+    QTextStream out(&config);
+    
+    out << "# Generated by Oreon System Manager (" << profile.name << " latency profile).\n\n"
+        << "monitor.alsa.rules = [\n"
+        << "    {\n"
+        << "        matches = [\n"
+        << "            { node.name = \"~alsa_output.*\" }\n"
+        << "            { node.name = \"~alsa_input.*\" }\n"
+        << "        ]\n"
+        << "        actions = {\n"
+        << "            update-props = {\n";
+    if (profile.alsaPeriodSize > 0) {
+        out << "                api.alsa.period-size = " << profile.alsaPeriodSize << "\n"
+            << "                api.alsa.headroom = 0\n";
+    }
+    if (!profile.suspendOnIdle) {
+        out << "                session.suspend-timeout-seconds = 0\n";
+    }
+    out << "            }\n"
+        << "        }\n"
+        << "    }\n"
+        << "]\n";
+    
+    out.flush();
+    return config.toUtf8();
+}
+
+void LatencyProfileEngine::applyProfile(const LatencyProfile &profile)
+{
+    bool pipeWireChanged = false;
+    if (!writeIfChanged(pipeWireDropInPath(), pipeWireDropIn(profile), &pipeWireChanged)) {
+        return;
+    }
+    
+    bool wirePlumberChanged = false;
+    const QByteArray wirePlumberConfig = wirePlumberDropIn(profile);
+    if (wirePlumberConfig.isEmpty()) {
+        if (QFile::exists(wirePlumberDropInPath())) {
+            QFile::remove(wirePlumberDropInPath());
+            wirePlumberChanged = true;
+        }
+    } else if (!writeIfChanged(wirePlumberDropInPath(), wirePlumberConfig, &wirePlumberChanged)) {
+        return;
+    }
+    
+    // The clock settings go live right away; the drop-in keeps them across restarts
+    queueLiveSettings(profile);
+    
+    const bool restartPipeWire = pipeWireChanged && profile.rtPriority != m_current.rtPriority;
+    
+    m_current = profile;
+    saveCurrent();
+    
+    emit profileApplied(profile.name, restartPipeWire, wirePlumberChanged);
+}
+
+void LatencyProfileEngine::reapplyLive()
+{
+    queueLiveSettings(m_current);
+}
+
+bool LatencyProfileEngine::writeIfChanged(const QString &path, const QByteArray &content, bool *changed)
+{
+    *changed = false;
+    
+    QFile existing(path);
+    if (existing.open(QIODevice::ReadOnly) && existing.readAll() == content) {
+        return true;
+    }
+    existing.close();
+    
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    
+    // QSaveFile writes a temporary file and renames it over the target, so
+    // PipeWire never sees a half-written config
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(content) != content.size() || !file.commit()) {
+        emit errorOccurred(QString("Failed to write %1: %2").arg(path, file.errorString()));
+        return false;
+    }
+    
+    *changed = true;
+    return true;
+}
+
+void LatencyProfileEngine::queueLiveSettings(const LatencyProfile &profile)
+{
+    const QString allowedRates = "[ " + ratesToStrings(profile.allowedRates).join(' ') + " ]";
+    
+    // A newer profile replaces whatever is still pending from the previous one
+    m_metadataQueue.clear();
+    m_metadataQueue << (QStringList() << "clock.min-quantum" << QString::number(profile.minQuantum))
+                    << (QStringList() << "clock.max-quantum" << QString::number(profile.maxQuantum))
+                    << (QStringList() << "clock.quantum" << QString::number(profile.quantum))
+                    << (QStringList() << "clock.allowed-rates" << allowedRates)
+                    << (QStringList() << "clock.rate" << QString::number(profile.rate))
+                    << (QStringList() << "clock.force-quantum" << QString::number(profile.forceQuantum ? profile.quantum : 0))
+                    << (QStringList() << "clock.force-rate" << QString::number(profile.forceQuantum ? profile.rate : 0));
+    
+    if (!m_metadataRunning) {
+        runNextMetadataCommand();
+    }
+}
+
+void LatencyProfileEngine::runNextMetadataCommand()
+{
+    if (m_metadataQueue.isEmpty()) {
+        m_metadataRunning = false;
+        return;
+    }
+    m_metadataRunning = true;
+    
+    const QStringList setting = m_metadataQueue.takeFirst();
+    
+    ProcessRunner::instance()->run("pw-metadata", QStringList() << "-n" << "settings" << "0" << setting)
+        .then(this, [this, setting](const ProcessResult &result) {
+        if (!result.started) {
+            m_metadataQueue.clear();
+            m_metadataRunning = false;
+            emit errorOccurred("pw-metadata is not available; the profile applies after PipeWire restarts");
+            return;
+        }
+        if (!result.success()) {
+            emit errorOccurred(QString("Could not set %1 live: %2")
+                               .arg(setting.first(), QString::fromUtf8(result.standardError).trimmed()));
+        }
+        runNextMetadataCommand();
+    });
+}
+
+void LatencyProfileEngine::loadCurrent()
+{
+    QSettings settings;
+    settings.beginGroup("LatencyProfile");
+    
+    m_current = LatencyProfile::builtin(settings.value("name", "Default").toString());
+    if (settings.contains("quantum")) {
+        m_current.name = settings.value("name").toString();
+        m_current.rate = settings.value("rate", m_current.rate).toInt();
+        m_current.quantum = settings.value("quantum", m_current.quantum).toInt();
+        m_current.minQuantum = settings.value("minQuantum", m_current.minQuantum).toInt();
+        m_current.maxQuantum = settings.value("maxQuantum", m_current.maxQuantum).toInt();
+        m_current.forceQuantum = settings.value("forceQuantum", m_current.forceQuantum).toBool();
+        m_current.rtPriority = settings.value("rtPriority", m_current.rtPriority).toInt();
+        m_current.alsaPeriodSize = settings.value("alsaPeriodSize", m_current.alsaPeriodSize).toInt();
+        m_current.suspendOnIdle = settings.value("suspendOnIdle", m_current.suspendOnIdle).toBool();
+        
+        const QStringList rates = settings.value("allowedRates").toStringList();
+        if (!rates.isEmpty()) {
+            m_current.allowedRates.clear();
+            for (const QString &rate : rates) {
+                m_current.allowedRates << rate.toInt();
+            }
+        }
+    }
+    
+    settings.endGroup();
+}
+
+void LatencyProfileEngine::saveCurrent() const
+{
+    QSettings settings;
+    settings.beginGroup("LatencyProfile");
+    settings.setValue("name", m_current.name);
+    settings.setValue("rate", m_current.rate);
+    settings.setValue("allowedRates", ratesToStrings(m_current.allowedRates));
+    settings.setValue("quantum", m_current.quantum);
+    settings.setValue("minQuantum", m_current.minQuantum);
+    settings.setValue("maxQuantum", m_current.maxQuantum);
+    settings.setValue("forceQuantum", m_current.forceQuantum);
+    settings.setValue("rtPriority", m_current.rtPriority);
+    settings.setValue("alsaPeriodSize", m_current.alsaPeriodSize);
+    settings.setValue("suspendOnIdle", m_current.suspendOnIdle);
+    settings.endGroup();
+}
@@ -0,0 +1,63 @@
+#ifndef LATENCYPROFILE_H
+#define LATENCYPROFILE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QByteArray>
+
+struct LatencyProfile {
+    QString name;
+    int rate = 48000;
+    QList<int> allowedRates = { 44100, 48000 };
+    int quantum = 1024;
+    int minQuantum = 32;
+    int maxQuantum = 2048;
+    bool forceQuantum = false;  // pin the graph instead of following clients
+    int rtPriority = 88;        // libpipewire-module-rt rt.prio
+    int alsaPeriodSize = 0;     // 0 keeps the WirePlumber default
+    bool suspendOnIdle = true;
+    
+    static QList<LatencyProfile> builtinProfiles();
+    static LatencyProfile builtin(const QString &name);
+};
+
+// Turns a LatencyProfile into pipewire.conf.d and wireplumber.conf.d drop-ins
+// (written atomically, only when the content changes) and pushes the clock
+// settings into the running daemon through the "settings" metadata, so a
+// profile switch does not interrupt playback. Only the RT priority and ALSA
+// device properties need a service restart, which is reported, not forced.
+class LatencyProfileEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LatencyProfileEngine(QObject *parent = nullptr);
+    
+    LatencyProfile currentProfile() const { return m_current; }
+    void applyProfile(const LatencyProfile &profile);
+    void reapplyLive();
+    
+    static QString pipeWireDropInPath();
+    static QString wirePlumberDropInPath();
+    static QByteArray pipeWireDropIn(const LatencyProfile &profile);
+    static QByteArray wirePlumberDropIn(const LatencyProfile &profile);
+
+signals:
+    void profileApplied(const QString &name, bool restartPipeWire, bool restartWirePlumber);
+    void errorOccurred(const QString &error);
+
+private:
+    bool writeIfChanged(const QString &path, const QByteArray &content, bool *changed);
+    void queueLiveSettings(const LatencyProfile &profile);
+    void runNextMetadataCommand();
+    void loadCurrent();
+    void saveCurrent() const;
+    
+    LatencyProfile m_current;
+    QList<QStringList> m_metadataQueue;
+    bool m_metadataRunning;
+};
+
+#endif // LATENCYPROFILE_H
@@ -7,12 +7,19 @@
 #include <QSystemTrayIcon>
 #include <QIcon>
 #include "mainwindow.h"
+#include "processrunner.h"
+#include "hardwareids.h"
+#include "repohealth.h"
+#include "tracing.h"
 
 Q_LOGGING_CATEGORY(oreonApp, "oreon.app")
 
 int main(int argc, char *argv[])
 {
+    // Reading the trace clock starts it, so QApplication can be traced before --trace is parsed
+    const qint64 appStartUs = Trace::now();
     QApplication app(argc, argv);
+    const qint64 appReadyUs = Trace::now();
     
     // Set application properties
     app.setApplicationName("Oreon System Manager");
@@ -34,19 +41,72 @@ int main(int argc, char *argv[])
                                       "Start minimized to system tray");
     parser.addOption(minimizedOption);
     
+    QCommandLineOption benchmarkSpawnOption("benchmark-spawn",
+                                            "Compare posix_spawn and QProcess launch overhead over <count> runs of true, then exit",
+                                            "count");
+    parser.addOption(benchmarkSpawnOption);
+    
+    QCommandLineOption benchmarkIdsOption("benchmark-ids",
+                                          "Time loading pci.ids and usb.ids and <count> vendor, device, subsystem "
+                                          "and class lookups in each, then exit",
+                                          "count");
+    parser.addOption(benchmarkIdsOption);
+    
+    QCommandLineOption traceOption("trace",
+                                   "Record startup and refresh timings to <file> as Chrome trace JSON, for chrome://tracing or ui.perfetto.dev",
+                                   "file");
+    parser.addOption(traceOption);
+    
+    QCommandLineOption mirrorOverrideOption("mirror-override",
+                                            "Send repository health probes for URLs starting with <from> to <to> instead, "
+                                            "e.g. a local HTTP server; may be given more than once",
+                                            "from=to");
+    parser.addOption(mirrorOverrideOption);
+    
     parser.process(app);
     
+    for (const QString &value : parser.values(mirrorOverrideOption)) {
+        const int separator = value.indexOf('=');
+        if (separator <= 0) {
+            qWarning() << "Ignoring --mirror-override" << value << "- expected <from>=<to>";
+            continue;
+        }
+        RepoHealthProber::addUrlRewrite(value.left(separator), value.mid(separator + 1));
+    }
+    
+    if (parser.isSet(traceOption)) {
+        Trace::enable(parser.value(traceOption));
+        Trace::complete("QApplication", "startup", appStartUs, appReadyUs - appStartUs);
+    }
+    
+    if (parser.isSet(benchmarkIdsOption)) {
+        qInfo().noquote() << HardwareIds::benchmark(parser.value(benchmarkIdsOption).toInt());
+        return 0;
+    }
+    
+    if (parser.isSet(benchmarkSpawnOption)) {
+        ProcessRunner::instance()->benchmark(ProcessRequest("true"), parser.value(benchmarkSpawnOption).toInt())
+            .then(&app, [](const QString &report) {
+            qInfo().noquote() << report;
+            QCoreApplication::quit();
+        });
+        return app.exec();
+    }
+    
     // Check if system tray is available
     if (!QSystemTrayIcon::isSystemTrayAvailable()) {
         qCritical() << "System tray is not available on this system.";
     }
     
     // Create and show main window
+    const qint64 windowStartUs = Trace::now();
     MainWindow window;
+    Trace::complete("MainWindow", "startup", windowStartUs, Trace::now() - windowStartUs);
     
     if (parser.isSet(minimizedOption)) {
         window.hide();
     } else {
+        TraceSpan span("MainWindow::show");
         window.show();
     }
     
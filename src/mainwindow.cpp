@@ -5,6 +5,7 @@
 #include "audiomanager.h"
 #include "systemutils.h"
 #include "privilegedexecutor.h"
+#include "tracing.h"
 
 #include <QApplication>
 #include <QVBoxLayout>
@@ -33,6 +34,36 @@
 #include <QDateTime>
 #include <QScrollBar>
 
+namespace {
+
+struct TabInfo {
+    const char *key;
+    const char *title;
+    const char *icon;
+};
+
+// In tab order; the key is what the tab history in the settings remembers
+const TabInfo TABS[] = {
+    { "packages", "Packages", "system-software-install" },
+    { "repositories", "Repositories", "folder-remote" },
+    { "containers", "Containers", "application-x-ms-dos-executable" },
+    { "audio", "Audio", "audio-card" },
+};
+const int TAB_COUNT = int(sizeof(TABS) / sizeof(TABS[0]));
+
+// Gap between tabs built in the background, so each one's first refresh gets going alone
+const int WARM_UP_INTERVAL_MS = 1500;
+
+int tabIndex(const QString &key)
+{
+    for (int i = 0; i < TAB_COUNT; ++i) {
+        if (key == QLatin1String(TABS[i].key)) return i;
+    }
+    return -1;
+}
+
+}
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , m_tabWidget(nullptr)
@@ -44,6 +75,7 @@ MainWindow::MainWindow(QWidget *parent)
     , m_repositoryManager(nullptr)
     , m_containerManager(nullptr)
     , m_audioManager(nullptr)
+    , m_firstShow(true)
     , m_systemUtils(nullptr)
     , m_privilegedExecutor(nullptr)
     , m_currentTaskId(-1)
@@ -54,19 +86,34 @@ MainWindow::MainWindow(QWidget *parent)
     
     // Initialize settings
     // Initialize system components
-    m_systemUtils = new SystemUtils(this);
-    m_privilegedExecutor = new PrivilegedExecutor(this);
+    {
+        TraceSpan span("System components");
+        m_systemUtils = new SystemUtils(this);
+        m_privilegedExecutor = new PrivilegedExecutor(this);
+    }
     
     // Create UI
-    createUI();
-    createMenuBar();
-    createStatusBar();
-    createTabs();
+    {
+        TraceSpan span("MainWindow::createUI");
+        createUI();
+        createMenuBar();
+        createStatusBar();
+    }
+    {
+        TraceSpan span("MainWindow::createTabs");
+        createTabs();
+    }
     setupConnections();
     
     // Apply theme and KDE integration
-    setupKDEIntegration();
-    applyTheme();
+    {
+        TraceSpan span("MainWindow::setupKDEIntegration");
+        setupKDEIntegration();
+    }
+    {
+        TraceSpan span("MainWindow::applyTheme");
+        applyTheme();
+    }
     
     // Show startup message
     m_statusLabel->setText("Oreon System Manager ready");
@@ -86,6 +133,33 @@ void MainWindow::changeEvent(QEvent *event)
     QMainWindow::changeEvent(event);
 }
 
+void MainWindow::showEvent(QShowEvent *event)
+{
+    QMainWindow::showEvent(event);
+    if (!m_firstShow) return;
+    m_firstShow = false;
+    Trace::instant("First show", "startup");
+    
+    // Nothing is built while the window stays hidden (e.g. started minimized at login).
+    // Once shown, the placeholder paints first, then the visible tab is built, then
+    // the others follow in the background, most recently used first.
+    QTimer::singleShot(0, this, [this]() {
+        ensureTab(m_tabWidget->currentIndex());
+        Trace::instant("Visible tab ready", "startup");
+        
+        QSettings settings;
+        const QStringList history = settings.value("MainWindow/tabHistory").toStringList();
+        for (const QString &key : history) {
+            const int index = tabIndex(key);
+            if (index >= 0 && !m_warmUpQueue.contains(index)) m_warmUpQueue << index;
+        }
+        for (int i = 0; i < TAB_COUNT; ++i) {
+            if (!m_warmUpQueue.contains(i)) m_warmUpQueue << i;
+        }
+        QTimer::singleShot(WARM_UP_INTERVAL_MS, this, &MainWindow::warmUpNextTab);
+    });
+}
+
 // System tray methods removed
 
 void MainWindow::aboutApplication()
@@ -109,11 +183,31 @@ void MainWindow::aboutApplication()
 void MainWindow::onTabChanged(int index)
 {
     if (m_tabWidget && index >= 0 && index < m_tabWidget->count()) {
+        ensureTab(index);
+        rememberTab(index);
+        
         QString tabName = m_tabWidget->tabText(index);
         m_statusLabel->setText(QString("Switched to %1 tab").arg(tabName));
     }
 }
 
+void MainWindow::warmUpNextTab()
+{
+    // Tabs the user opened in the meantime are already built
+    while (!m_warmUpQueue.isEmpty()) {
+        const int index = m_warmUpQueue.takeFirst();
+        QWidget *page = m_tabWidget->widget(index);
+        if (page && !page->property("built").toBool()) {
+            ensureTab(index);
+            break;
+        }
+    }
+    
+    if (!m_warmUpQueue.isEmpty()) {
+        QTimer::singleShot(WARM_UP_INTERVAL_MS, this, &MainWindow::warmUpNextTab);
+    }
+}
+
 void MainWindow::onTaskStarted(int taskId, const QString &description)
 {
     m_currentTaskId = taskId;
@@ -208,26 +302,90 @@ void MainWindow::createStatusBar()
 
 void MainWindow::createTabs()
 {
-    // Create all manager tabs with full functionality
-    m_packageManager = new PackageManager(this);
-    m_packageManager->setSystemUtils(m_systemUtils);
-    m_packageManager->setPrivilegedExecutor(m_privilegedExecutor);
-    m_tabWidget->addTab(m_packageManager, QIcon::fromTheme("system-software-install"), "Packages");
+    // Each manager starts refreshes and probes as soon as it exists, so tabs
+    // begin as placeholders and ensureTab() builds the manager when it is needed
+    for (int i = 0; i < TAB_COUNT; ++i) {
+        QWidget *page = new QWidget();
+        QVBoxLayout *layout = new QVBoxLayout(page);
+        layout->setContentsMargins(0, 0, 0, 0);
+        
+        QLabel *placeholder = new QLabel(QString("Loading %1...").arg(QString::fromLatin1(TABS[i].title)));
+        placeholder->setAlignment(Qt::AlignCenter);
+        placeholder->setStyleSheet("color: #666;");
+        layout->addWidget(placeholder);
+        
+        m_tabWidget->addTab(page, QIcon::fromTheme(TABS[i].icon), TABS[i].title);
+    }
+    
+    // Open on the tab used last; connections are not set up yet, so nothing is built here
+    QSettings settings;
+    const QStringList history = settings.value("MainWindow/tabHistory").toStringList();
+    const int lastTab = history.isEmpty() ? -1 : tabIndex(history.first());
+    if (lastTab >= 0) {
+        m_tabWidget->setCurrentIndex(lastTab);
+    }
+}
+
+void MainWindow::ensureTab(int index)
+{
+    QWidget *page = m_tabWidget->widget(index);
+    if (!page || page->property("built").toBool()) return;
+    page->setProperty("built", true);
     
-    m_repositoryManager = new RepositoryManager(this);
-    m_repositoryManager->setSystemUtils(m_systemUtils);
-    m_repositoryManager->setPrivilegedExecutor(m_privilegedExecutor);
-    m_tabWidget->addTab(m_repositoryManager, QIcon::fromTheme("folder-remote"), "Repositories");
+    TraceSpan span("MainWindow::ensureTab");
+    if (span.isRecording()) {
+        span.setArg("tab", m_tabWidget->tabText(index));
+        span.setArg("visible", index == m_tabWidget->currentIndex());
+    }
     
-    m_containerManager = new ContainerManager(this);
-    m_containerManager->setSystemUtils(m_systemUtils);
-    m_containerManager->setPrivilegedExecutor(m_privilegedExecutor);
-    m_tabWidget->addTab(m_containerManager, QIcon::fromTheme("application-x-ms-dos-executable"), "Containers");
+    QWidget *manager = nullptr;
+    switch (index) {
+    case 0:
+        m_packageManager = new PackageManager(page);
+        m_packageManager->setSystemUtils(m_systemUtils);
+        m_packageManager->setPrivilegedExecutor(m_privilegedExecutor);
+        manager = m_packageManager;
+        break;
+    case 1:
+        m_repositoryManager = new RepositoryManager(page);
+        m_repositoryManager->setSystemUtils(m_systemUtils);
+        m_repositoryManager->setPrivilegedExecutor(m_privilegedExecutor);
+        manager = m_repositoryManager;
+        break;
+    case 2:
+        m_containerManager = new ContainerManager(page);
+        m_containerManager->setSystemUtils(m_systemUtils);
+        m_containerManager->setPrivilegedExecutor(m_privilegedExecutor);
+        manager = m_containerManager;
+        break;
+    case 3:
+        m_audioManager = new AudioManager(page);
+        m_audioManager->setSystemUtils(m_systemUtils);
+        m_audioManager->setPrivilegedExecutor(m_privilegedExecutor);
+        manager = m_audioManager;
+        break;
+    default:
+        return;
+    }
+    
+    // Swap the placeholder for the manager
+    QLayout *layout = page->layout();
+    while (QLayoutItem *item = layout->takeAt(0)) {
+        delete item->widget();
+        delete item;
+    }
+    layout->addWidget(manager);
+}
+
+void MainWindow::rememberTab(int index)
+{
+    if (index < 0 || index >= TAB_COUNT) return;
     
-    m_audioManager = new AudioManager(this);
-    m_audioManager->setSystemUtils(m_systemUtils);
-    m_audioManager->setPrivilegedExecutor(m_privilegedExecutor);
-    m_tabWidget->addTab(m_audioManager, QIcon::fromTheme("audio-card"), "Audio");
+    QSettings settings;
+    QStringList history = settings.value("MainWindow/tabHistory").toStringList();
+    history.removeAll(TABS[index].key);
+    history.prepend(TABS[index].key);
+    settings.setValue("MainWindow/tabHistory", history);
 }
 
 void MainWindow::setupConnections()
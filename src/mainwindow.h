@@ -11,6 +11,8 @@
 #include <QLabel>
 #include <QTimer>
 #include <QCloseEvent>
+#include <QShowEvent>
+#include <QList>
 // Settings removed
 
 QT_BEGIN_NAMESPACE
@@ -40,6 +42,7 @@ public:
 protected:
     void closeEvent(QCloseEvent *event) override;
     void changeEvent(QEvent *event) override;
+    void showEvent(QShowEvent *event) override;
 
 private slots:
     void aboutApplication();
@@ -48,12 +51,15 @@ private slots:
     void onTaskFinished(int taskId, int exitCode, const QString &output);
     void onTaskError(int taskId, const QString &error);
     void onTaskProgress(int taskId, const QString &progress);
+    void warmUpNextTab();
 
 private:
     void createUI();
     void createMenuBar();
     void createStatusBar();
     void createTabs();
+    void ensureTab(int index);
+    void rememberTab(int index);
     void setupConnections();
     void updateSystemInfo();
     void setupKDEIntegration();
@@ -76,6 +82,8 @@ private:
     RepositoryManager *m_repositoryManager;
     ContainerManager *m_containerManager;
     AudioManager *m_audioManager;
+    QList<int> m_warmUpQueue;       // tabs still to build in the background, most recently used first
+    bool m_firstShow;
     
     // System components
     SystemUtils *m_systemUtils;
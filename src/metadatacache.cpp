@@ -0,0 +1,275 @@
+#include "metadatacache.h"
+#include "privilegedexecutor.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QRegularExpression>
+#include <QPromise>
+#include <QThread>
+#include <QThreadPool>
+#include <memory>
+
+namespace {
+
+// dnf's default metadata_expire
+const qint64 DEFAULT_EXPIRE_SECONDS = 48 * 3600;
+
+// Refresh ahead of expiry, so the cache is never found cold
+const double EXPIRING_FRACTION = 0.75;
+
+const int MAX_REFRESH_SLOTS = 4;
+
+// Run as root by PrivilegedBatch, one item per repository
+const char *REFRESH_COMMAND = R"(
+step "$1" dnf makecache --quiet --repo "$1"
+)";
+
+// Runs as root with "enable" or "disable" and the makecache unit. The
+// drop-ins add a run between 01:00 and 05:00 to the distribution's timer
+// and keep the refresh at idle CPU and I/O priority on mains power.
+const char *SCHEDULE_SCRIPT = R"(
+action="$1"; unit="$2"
+timer="/etc/systemd/system/$unit.timer.d/50-oreon-offpeak.conf"
+service="/etc/systemd/system/$unit.service.d/50-oreon-idle.conf"
+if [ "$action" = enable ]; then
+    mkdir -p "${timer%/*}" "${service%/*}"
+    printf '[Timer]\nOnCalendar=*-*-* 01:00\nRandomizedDelaySec=4h\nPersistent=true\n' > "$timer"
+    printf '[Unit]\nConditionACPower=true\n[Service]\nNice=19\nIOSchedulingClass=idle\n' > "$service"
+    systemctl daemon-reload && systemctl enable --now "$unit.timer"
+else
+    rm -f "$timer" "$service"
+    systemctl daemon-reload && systemctl disable --now "$unit.timer"
+fi
+)";
+
+qint64 directorySize(const QString &path)
+{
+    qint64 size = 0;
+    QDirIterator it(path, QDir::Files | QDir::Hidden | QDir::NoSymLinks, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        size += it.fileInfo().size();
+    }
+    return size;
+}
+
+// Repositories dnf marked expired after a transaction, e.g. a local repository it rewrote
+QSet<QString> expiredRepositories(const QString &cacheDir)
+{
+    QSet<QString> expired;
+    QFile file(cacheDir + "/expired_repos.json");
+    if (file.open(QIODevice::ReadOnly)) {
+        for (const QJsonValue &value : QJsonDocument::fromJson(file.readAll()).array()) {
+            expired.insert(value.toString());
+        }
+    }
+    return expired;
+}
+
+}
+
+// MetadataCache Implementation
+MetadataCache::MetadataCache(QObject *parent)
+    : QObject(parent)
+    , m_batch(new PrivilegedBatch(this))
+    , m_refreshed(0)
+    , m_failed(0)
+{
+    connect(m_batch, &PrivilegedBatch::stepStarted, this, &MetadataCache::onStepStarted);
+    connect(m_batch, &PrivilegedBatch::stepOutput, this, &MetadataCache::repoOutput);
+    connect(m_batch, &PrivilegedBatch::stepFinished, this, &MetadataCache::onStepFinished);
+    connect(m_batch, &PrivilegedBatch::finished, this, &MetadataCache::onBatchFinished);
+}
+
+bool MetadataCache::isDnf5()
+{
+    return QFileInfo("/usr/bin/dnf").canonicalFilePath().endsWith("dnf5");
+}
+
+QString MetadataCache::cacheDirectory()
+{
+    return isDnf5() ? "/var/cache/libdnf5" : "/var/cache/dnf";
+}
+
+qint64 MetadataCache::expireSeconds(const QString &metadataExpire)
+{
+    const QString value = metadataExpire.trimmed().toLower();
+    if (value.isEmpty()) return DEFAULT_EXPIRE_SECONDS;
+    if (value == "never" || value == "-1") return -1;
+    
+    static const QRegularExpression pattern("^(\\d+)\\s*([smhd]?)$");
+    const QRegularExpressionMatch match = pattern.match(value);
+    if (!match.hasMatch()) return DEFAULT_EXPIRE_SECONDS;
+    
+    const qint64 amount = match.captured(1).toLongLong();
+    const QString unit = match.captured(2);
+    if (unit == "m") return amount * 60;
+    if (unit == "h") return amount * 3600;
+    if (unit == "d") return amount * 86400;
+    return amount;
+}
+
+QList<RepoCacheInfo> MetadataCache::inspect(const QList<RepositoryInfo> &repositories)
+{
+    const QString cacheDir = cacheDirectory();
+    const QSet<QString> expired = expiredRepositories(cacheDir);
+    
+    // Cache directories are "<repoid>-<16 hex digits>", the hash of the
+    // repository's URLs; old ones linger after a URL changes
+    static const QRegularExpression suffix("-[0-9a-f]{16}$");
+    QHash<QString, QStringList> directories;
+    for (const QString &name : QDir(cacheDir).entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        const QRegularExpressionMatch match = suffix.match(name);
+        if (match.hasMatch()) {
+            directories[name.left(match.capturedStart())] << cacheDir + "/" + name;
+        }
+    }
+    
+    QList<RepoCacheInfo> caches;
+    for (const RepositoryInfo &repo : repositories) {
+        if (!repo.enabled) continue;
+        
+        RepoCacheInfo info;
+        info.repoId = repo.id;
+        info.expireSeconds = expireSeconds(repo.metadataExpire);
+        
+        // dnf touches repomd.xml whenever it confirms the metadata is current
+        for (const QString &dir : directories.value(repo.id)) {
+            const QFileInfo repomd(dir + "/repodata/repomd.xml");
+            if (repomd.exists() && (!info.refreshed.isValid() || repomd.lastModified() > info.refreshed)) {
+                info.refreshed = repomd.lastModified();
+                info.path = dir;
+            }
+        }
+        
+        if (!info.path.isEmpty()) {
+            info.sizeBytes = directorySize(info.path);
+            const qint64 age = info.ageSeconds();
+            if (expired.contains(repo.id) || (info.expireSeconds >= 0 && age >= info.expireSeconds)) {
+                info.state = RepoCacheInfo::Expired;
+            } else if (info.expireSeconds >= 0 && age >= info.expireSeconds * EXPIRING_FRACTION) {
+                info.state = RepoCacheInfo::Expiring;
+            } else {
+                info.state = RepoCacheInfo::Fresh;
+            }
+        }
+        caches << info;
+    }
+    
+    return caches;
+}
+
+QFuture<QList<RepoCacheInfo>> MetadataCache::inspectAsync(const QList<RepositoryInfo> &repositories)
+{
+    auto promise = std::make_shared<QPromise<QList<RepoCacheInfo>>>();
+    QFuture<QList<RepoCacheInfo>> future = promise->future();
+    promise->start();
+    
+    QThreadPool::globalInstance()->start([promise, repositories]() {
+        promise->addResult(inspect(repositories));
+        promise->finish();
+    });
+    
+    return future;
+}
+
+bool MetadataCache::isWarm(const QList<RepositoryInfo> &repositories)
+{
+    const QList<RepoCacheInfo> caches = inspect(repositories);
+    for (const RepoCacheInfo &info : caches) {
+        if (info.state == RepoCacheInfo::Missing || info.state == RepoCacheInfo::Expired) {
+            return false;
+        }
+    }
+    return !caches.isEmpty();
+}
+
+int MetadataCache::refreshSlots(int repositories)
+{
+    // dnf 4 holds one metadata lock for the whole makecache, so parallel
+    // runs would only queue behind it
+    if (!isDnf5()) return 1;
+    return qBound(1, qMin(QThread::idealThreadCount(), MAX_REFRESH_SLOTS), qMax(repositories, 1));
+}
+
+bool MetadataCache::start(const QStringList &repoIds)
+{
+    if (isRunning()) return false;
+    
+    m_pending = QSet<QString>(repoIds.begin(), repoIds.end());
+    m_refreshed = 0;
+    m_failed = 0;
+    
+    if (repoIds.isEmpty()) {
+        emit finished(0, 0);
+        return true;
+    }
+    
+    return m_batch->start(QString::fromLatin1(REFRESH_COMMAND), 1, repoIds, refreshSlots(repoIds.size()));
+}
+
+void MetadataCache::cancel()
+{
+    m_batch->cancel();
+}
+
+bool MetadataCache::isRunning() const
+{
+    return m_batch->isRunning();
+}
+
+void MetadataCache::onStepStarted(const QString &repoId)
+{
+    if (m_pending.contains(repoId)) {
+        emit repoStarted(repoId);
+    }
+}
+
+void MetadataCache::onStepFinished(const QString &repoId, bool success)
+{
+    if (!m_pending.remove(repoId)) return;
+    
+    success ? ++m_refreshed : ++m_failed;
+    emit repoFinished(repoId, success);
+}
+
+void MetadataCache::onBatchFinished()
+{
+    // Repositories that never reported back were cancelled or never started
+    for (const QString &repoId : std::as_const(m_pending)) {
+        ++m_failed;
+        emit repoFinished(repoId, false);
+    }
+    m_pending.clear();
+    
+    emit finished(m_refreshed, m_failed);
+}
+
+void MetadataCache::setAutomatic(bool enabled)
+{
+    ProcessRequest request("sh", QStringList() << "-c" << QString::fromLatin1(SCHEDULE_SCRIPT) << "makecache-schedule"
+                                               << (enabled ? "enable" : "disable") << makecacheUnit());
+    request.channelMode = QProcess::MergedChannels;
+    request.timeoutMs = 0;
+    
+    PrivilegedExecutor::runElevated(request).then(this, [this](const ProcessResult &result) {
+        if (!result.success()) {
+            const QString error = result.output().trimmed();
+            emit repoOutput(QString(), error.isEmpty() ? result.errorString : error);
+        }
+        emit automaticChanged(isAutomatic());
+    });
+}
+
+bool MetadataCache::isAutomatic()
+{
+    return QFileInfo::exists("/etc/systemd/system/timers.target.wants/" + makecacheUnit() + ".timer");
+}
+
+QString MetadataCache::makecacheUnit()
+{
+    return isDnf5() ? "dnf5-makecache" : "dnf-makecache";
+}
@@ -0,0 +1,83 @@
+#ifndef METADATACACHE_H
+#define METADATACACHE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QSet>
+#include <QDateTime>
+#include <QFuture>
+#include "repofiles.h"
+
+class PrivilegedBatch;
+
+struct RepoCacheInfo {
+    enum State { Missing, Fresh, Expiring, Expired };
+    
+    QString repoId;
+    QString path;               // <cachedir>/<repoid>-<hash>
+    qint64 sizeBytes = 0;
+    QDateTime refreshed;        // when dnf last fetched or confirmed repomd.xml
+    qint64 expireSeconds = 0;   // metadata_expire, -1 for never
+    State state = Missing;
+    
+    qint64 ageSeconds() const { return refreshed.isValid() ? refreshed.secsTo(QDateTime::currentDateTime()) : -1; }
+};
+
+// Reports how old and how large each repository's cached metadata is, and
+// refreshes it with "dnf makecache" before it expires. Refreshes run under
+// one privileged helper, several repositories at a time. Automatic
+// refreshes are left to the system's makecache timer, pointed at the
+// night and the idle I/O class, so package queries find warm metadata
+// without this application ever asking for a password unprompted.
+class MetadataCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MetadataCache(QObject *parent = nullptr);
+    
+    // libdnf5's cache when dnf5 is in use, dnf's otherwise
+    static QString cacheDirectory();
+    static bool isDnf5();
+    
+    static QList<RepoCacheInfo> inspect(const QList<RepositoryInfo> &repositories);
+    // The same on a pool thread; sizing the caches walks every file in them
+    static QFuture<QList<RepoCacheInfo>> inspectAsync(const QList<RepositoryInfo> &repositories);
+    static bool isWarm(const QList<RepositoryInfo> &repositories);
+    static qint64 expireSeconds(const QString &metadataExpire);
+    
+    bool start(const QStringList &repoIds);
+    void cancel();
+    bool isRunning() const;
+    
+    // Enables or disables the makecache timer; asks for a password, so
+    // only call it for a user action. automaticChanged() has the outcome.
+    void setAutomatic(bool enabled);
+    static bool isAutomatic();
+    // "dnf5-makecache" or "dnf-makecache", for its .timer and .service
+    static QString makecacheUnit();
+    
+    static int refreshSlots(int repositories);
+
+signals:
+    void repoStarted(const QString &repoId);
+    void repoOutput(const QString &repoId, const QString &line);
+    void repoFinished(const QString &repoId, bool success);
+    void finished(int refreshed, int failed);
+    void automaticChanged(bool enabled);
+
+private slots:
+    void onStepStarted(const QString &repoId);
+    void onStepFinished(const QString &repoId, bool success);
+    void onBatchFinished();
+
+private:
+    PrivilegedBatch *m_batch;
+    QSet<QString> m_pending;
+    int m_refreshed;
+    int m_failed;
+};
+
+#endif // METADATACACHE_H
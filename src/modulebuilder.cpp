@@ -0,0 +1,298 @@
+#include "modulebuilder.h"
+#include "privilegedexecutor.h"
+#include "processrunner.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QSettings>
+#include <QSysInfo>
+#include <QPromise>
+#include <QThread>
+#include <QCryptographicHash>
+#include <algorithm>
+
+namespace {
+
+// Make jobs one build gets; kernel module builds rarely scale past this
+const int MAKE_JOBS_PER_SLOT = 4;
+
+// Run as root by PrivilegedBatch, one item per module with the fields
+// kind, module, version, comma-separated kernels and make jobs. DKMS
+// builds every kernel of a module in the same build directory, so those
+// run one after another within the item.
+const char *BUILD_COMMAND = R"(
+kind="$1"; module="$2"; version="$3"; jobs="$5"
+IFS=, read -ra kernels <<< "$4"
+for kernel in "${kernels[@]}"; do
+    if [ "$kind" = dkms ]; then
+        step "$module/$version $kernel" dkms install --force -m "$module" -v "$version" -k "$kernel" -j "$jobs"
+    else
+        step "$module/$version $kernel" akmods --force --kernels "$kernel" --akmod "$module"
+    fi
+done
+)";
+
+QString settingsKey(const ModuleBuild &build)
+{
+    return QString("ModuleBuilds/%1/%2/%3")
+        .arg(build.kind == ModuleBuild::Dkms ? "dkms" : "akmod", build.module, build.kernel);
+}
+
+}
+
+// ModuleBuilder Implementation
+ModuleBuilder::ModuleBuilder(QObject *parent)
+    : QObject(parent)
+    , m_batch(new PrivilegedBatch(this))
+    , m_built(0)
+    , m_failed(0)
+    , m_skipped(0)
+{
+    connect(m_batch, &PrivilegedBatch::stepStarted, this, &ModuleBuilder::onStepStarted);
+    connect(m_batch, &PrivilegedBatch::stepOutput, this, &ModuleBuilder::buildOutput);
+    connect(m_batch, &PrivilegedBatch::stepFinished, this, &ModuleBuilder::onStepFinished);
+    connect(m_batch, &PrivilegedBatch::finished, this, &ModuleBuilder::onBatchFinished);
+}
+
+QStringList ModuleBuilder::buildableKernels()
+{
+    const QString running = QSysInfo::kernelVersion();
+    QStringList kernels;
+    
+    const QStringList releases = QDir("/lib/modules").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &release : releases) {
+        // kernel-devel provides the build tree; without it nothing can be built
+        if (QFileInfo::exists("/lib/modules/" + release + "/build/Makefile")) {
+            kernels << release;
+        }
+    }
+    
+    // The running kernel first, so its modules are usable soonest
+    std::stable_partition(kernels.begin(), kernels.end(),
+                          [&running](const QString &kernel) { return kernel == running; });
+    return kernels;
+}
+
+int ModuleBuilder::buildSlots()
+{
+    return qMax(1, QThread::idealThreadCount() / MAKE_JOBS_PER_SLOT);
+}
+
+int ModuleBuilder::makeJobs()
+{
+    return qMax(1, QThread::idealThreadCount() / buildSlots());
+}
+
+QFuture<QList<ModuleBuild>> ModuleBuilder::plan(const QStringList &kernels, bool force) const
+{
+    const QStringList targets = kernels.isEmpty() ? buildableKernels() : kernels;
+    const QString arch = QSysInfo::currentCpuArchitecture();
+    QList<ModuleBuild> builds;
+    
+    // /var/lib/dkms/<module>/<version>/source, plus kernel-<release>-<arch>
+    // links to the version installed for each kernel
+    const QDir dkmsDir("/var/lib/dkms");
+    for (const QString &module : dkmsDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        const QDir moduleDir(dkmsDir.filePath(module));
+        for (const QString &version : moduleDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks)) {
+            const QString source = QFileInfo(moduleDir.filePath(version + "/source")).canonicalFilePath();
+            if (source.isEmpty()) continue;
+            
+            const QString hash = sourceHash(source);
+            for (const QString &kernel : targets) {
+                ModuleBuild build;
+                build.kind = ModuleBuild::Dkms;
+                build.module = module;
+                build.version = version;
+                build.kernel = kernel;
+                build.sourceHash = hash;
+                
+                const QFileInfo installed(moduleDir.filePath(QString("kernel-%1-%2").arg(kernel, arch)));
+                const bool upToDate = installed.exists()
+                                   && installed.symLinkTarget().contains("/" + version + "/");
+                const QString recorded = recordedHash(build);
+                if (!force && upToDate && (recorded.isEmpty() || recorded == hash)) {
+                    build.state = ModuleBuild::Skipped;
+                }
+                builds << build;
+            }
+        }
+    }
+    
+    // /usr/src/akmods/<name>-kmod.latest points at the newest source RPM;
+    // akmods installs the result as kmod-<name>-<release>
+    const QDir akmodsDir("/usr/src/akmods");
+    const QStringList latest = akmodsDir.entryList(QStringList() << "*-kmod.latest", QDir::Files);
+    if (latest.isEmpty()) {
+        QPromise<QList<ModuleBuild>> promise;
+        promise.start();
+        promise.addResult(builds);
+        promise.finish();
+        return promise.future();
+    }
+    
+    // Which kmods are installed is the only part that needs rpm; the rest of the plan waits for it
+    return ProcessRunner::instance()->run("rpm", QStringList() << "-qa" << "--qf" << "%{NAME}\\n" << "kmod-*")
+        .then([builds, latest, targets, force, akmodsDir](const ProcessResult &result) mutable {
+        const QStringList kmods = result.output().split('\n', Qt::SkipEmptyParts);
+        
+        for (const QString &link : latest) {
+            const QFileInfo srpm(QFileInfo(akmodsDir.filePath(link)).canonicalFilePath());
+            if (!srpm.exists()) continue;
+            
+            const QString module = link.left(link.size() - QString("-kmod.latest").size());
+            const QString hash = QString::fromLatin1(QCryptographicHash::hash(
+                QString("%1:%2:%3").arg(srpm.fileName()).arg(srpm.size())
+                    .arg(srpm.lastModified().toMSecsSinceEpoch()).toUtf8(),
+                QCryptographicHash::Sha1).toHex());
+            
+            for (const QString &kernel : targets) {
+                ModuleBuild build;
+                build.kind = ModuleBuild::Akmod;
+                build.module = module;
+                build.version = srpm.fileName();
+                build.kernel = kernel;
+                build.sourceHash = hash;
+                
+                const bool upToDate = kmods.contains(QString("kmod-%1-%2").arg(module, kernel));
+                const QString recorded = recordedHash(build);
+                if (!force && upToDate && (recorded.isEmpty() || recorded == hash)) {
+                    build.state = ModuleBuild::Skipped;
+                }
+                builds << build;
+            }
+        }
+        return builds;
+    });
+}
+
+bool ModuleBuilder::start(const QList<ModuleBuild> &builds)
+{
+    if (isRunning()) return false;
+    
+    m_builds.clear();
+    m_built = 0;
+    m_failed = 0;
+    m_skipped = 0;
+    
+    // One xargs job per module, kernels in plan order
+    QStringList moduleOrder;
+    QHash<QString, ModuleBuild> firstBuild;
+    QHash<QString, QStringList> kernelsByModule;
+    for (const ModuleBuild &build : builds) {
+        if (build.state == ModuleBuild::Skipped) {
+            ++m_skipped;
+            if (recordedHash(build).isEmpty()) {
+                recordHash(build);  // built before we were tracking it
+            }
+            continue;
+        }
+        
+        const QString key = build.module + "/" + build.version;
+        if (!kernelsByModule.contains(key)) {
+            moduleOrder << key;
+            firstBuild.insert(key, build);
+        }
+        kernelsByModule[key] << build.kernel;
+        m_builds.insert(build.tag(), build);
+    }
+    
+    if (m_builds.isEmpty()) {
+        emit finished(0, 0, m_skipped);
+        return true;
+    }
+    
+    QStringList items;
+    const QString jobs = QString::number(makeJobs());
+    for (const QString &key : moduleOrder) {
+        const ModuleBuild &build = firstBuild[key];
+        items << (build.kind == ModuleBuild::Dkms ? "dkms" : "akmod")
+              << build.module << build.version << kernelsByModule[key].join(',') << jobs;
+    }
+    
+    return m_batch->start(QString::fromLatin1(BUILD_COMMAND), 5, items, buildSlots());
+}
+
+void ModuleBuilder::cancel()
+{
+    m_batch->cancel();
+}
+
+bool ModuleBuilder::isRunning() const
+{
+    return m_batch->isRunning();
+}
+
+void ModuleBuilder::onStepStarted(const QString &tag)
+{
+    if (m_builds.contains(tag)) {
+        m_builds[tag].state = ModuleBuild::Building;
+        emit buildStarted(tag);
+    }
+}
+
+void ModuleBuilder::onStepFinished(const QString &tag, bool success)
+{
+    if (!m_builds.contains(tag)) return;
+    
+    ModuleBuild &build = m_builds[tag];
+    build.state = success ? ModuleBuild::Built : ModuleBuild::Failed;
+    if (success) {
+        ++m_built;
+        recordHash(build);
+    } else {
+        ++m_failed;
+    }
+    emit buildFinished(tag, success);
+}
+
+void ModuleBuilder::onBatchFinished()
+{
+    // Anything that never reported back was cancelled or never started
+    for (auto it = m_builds.begin(); it != m_builds.end(); ++it) {
+        if (it->state == ModuleBuild::Pending || it->state == ModuleBuild::Building) {
+            it->state = ModuleBuild::Failed;
+            ++m_failed;
+            emit buildFinished(it.key(), false);
+        }
+    }
+    
+    emit finished(m_built, m_failed, m_skipped);
+}
+
+QString ModuleBuilder::sourceHash(const QString &sourceDir)
+{
+    // Names, sizes and mtimes of every file stand in for the contents; a
+    // package update or a local edit changes at least one of them
+    QStringList entries;
+    QDirIterator it(sourceDir, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        const QFileInfo info = it.fileInfo();
+        entries << QString("%1:%2:%3").arg(path.mid(sourceDir.size() + 1)).arg(info.size())
+                                      .arg(info.lastModified().toMSecsSinceEpoch());
+    }
+    entries.sort();
+    
+    return QString::fromLatin1(QCryptographicHash::hash(entries.join('\n').toUtf8(),
+                                                        QCryptographicHash::Sha1).toHex());
+}
+
+QString ModuleBuilder::recordedHash(const ModuleBuild &build)
+{
+    QSettings settings;
+    const QString value = settings.value(settingsKey(build)).toString();
+    
+    // "<version>:<hash>"; a different version is a different source
+    const int separator = value.lastIndexOf(':');
+    if (separator < 0 || value.left(separator) != build.version) {
+        return QString();
+    }
+    return value.mid(separator + 1);
+}
+
+void ModuleBuilder::recordHash(const ModuleBuild &build)
+{
+    QSettings settings;
+    settings.setValue(settingsKey(build), build.version + ":" + build.sourceHash);
+}
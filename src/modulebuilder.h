@@ -0,0 +1,76 @@
+#ifndef MODULEBUILDER_H
+#define MODULEBUILDER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QFuture>
+
+class PrivilegedBatch;
+
+struct ModuleBuild {
+    enum Kind { Dkms, Akmod };
+    enum State { Pending, Skipped, Building, Built, Failed };
+    
+    Kind kind = Dkms;
+    QString module;
+    QString version;        // DKMS version, or the akmod source RPM
+    QString kernel;
+    QString sourceHash;
+    State state = Pending;
+    
+    QString tag() const { return module + "/" + version + " " + kernel; }
+};
+
+// Builds out-of-tree kernel modules (DKMS trees and akmods source RPMs)
+// for every kernel that has headers installed. Independent builds run in
+// parallel under one privileged helper, so there is a single password
+// prompt, and every output line is tagged with its build. A build is
+// skipped when its module is installed for that kernel and its source
+// hash matches the one recorded after the last successful build.
+class ModuleBuilder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ModuleBuilder(QObject *parent = nullptr);
+    
+    // Kernels under /lib/modules that modules can be built against
+    static QStringList buildableKernels();
+    
+    // Ready once rpm has said which kmods are installed, when there are akmods at all
+    QFuture<QList<ModuleBuild>> plan(const QStringList &kernels = QStringList(), bool force = false) const;
+    bool start(const QList<ModuleBuild> &builds);
+    void cancel();
+    bool isRunning() const;
+    
+    // Concurrent builds, and make jobs for each, so the two multiply to the core count
+    static int buildSlots();
+    static int makeJobs();
+
+signals:
+    void buildStarted(const QString &tag);
+    void buildOutput(const QString &tag, const QString &line);
+    void buildFinished(const QString &tag, bool success);
+    void finished(int built, int failed, int skipped);
+
+private slots:
+    void onStepStarted(const QString &tag);
+    void onStepFinished(const QString &tag, bool success);
+    void onBatchFinished();
+
+private:
+    static QString sourceHash(const QString &sourceDir);
+    static QString recordedHash(const ModuleBuild &build);
+    void recordHash(const ModuleBuild &build);
+    
+    PrivilegedBatch *m_batch;
+    QHash<QString, ModuleBuild> m_builds;       // by tag
+    int m_built;
+    int m_failed;
+    int m_skipped;
+};
+
+#endif // MODULEBUILDER_H
@@ -0,0 +1,118 @@
+#include "moduleinventory.h"
+#include "kernelmoduleindex.h"
+#include <QDir>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+
+namespace {
+
+QMutex snapshotMutex;
+QSharedPointer<const ModuleInventory> currentSnapshot;
+QElapsedTimer snapshotAge;
+
+}
+
+// ModuleInventory Implementation
+QSharedPointer<const ModuleInventory> ModuleInventory::snapshot(int maxAgeMs)
+{
+    QMutexLocker locker(&snapshotMutex);
+    if (!currentSnapshot || !snapshotAge.isValid() || snapshotAge.elapsed() > maxAgeMs) {
+        currentSnapshot = QSharedPointer<const ModuleInventory>(new ModuleInventory());
+        snapshotAge.start();
+    }
+    return currentSnapshot;
+}
+
+void ModuleInventory::invalidate()
+{
+    QMutexLocker locker(&snapshotMutex);
+    currentSnapshot.reset();
+}
+
+ModuleInventory::ModuleInventory()
+    : m_totalSize(0)
+{
+    // "nvidia_drm 139264 12 - Live 0x0000000000000000 (POE)"
+    // "snd 135168 15 snd_hda_codec,snd_hwdep,snd_pcm, Live 0x0000000000000000"
+    QFile file("/proc/modules");
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    
+    const QList<QByteArray> lines = file.readAll().split('\n');
+    m_loaded.reserve(lines.size());
+    
+    for (const QByteArray &line : lines) {
+        const QList<QByteArray> fields = line.split(' ');
+        if (fields.size() < 5) continue;
+        
+        LoadedModule module;
+        module.name = QString::fromUtf8(fields[0]);
+        module.size = fields[1].toLongLong();
+        module.refCount = fields[2].toInt();
+        if (fields[3] != "-") {
+            const QList<QByteArray> holders = fields[3].split(',');
+            for (const QByteArray &holder : holders) {
+                if (!holder.isEmpty()) {
+                    module.usedBy << QString::fromUtf8(holder);
+                }
+            }
+        }
+        module.state = QString::fromUtf8(fields[4]);
+        if (fields.size() > 6) {
+            module.taint = QString::fromUtf8(fields[6]);
+        }
+        
+        // Reverse edges, so both directions of the graph are a lookup
+        for (const QString &holder : module.usedBy) {
+            m_uses[holder] << module.name;
+        }
+        
+        m_totalSize += module.size;
+        m_order << module.name;
+        m_loaded.insert(module.name, module);
+    }
+}
+
+QList<LoadedModule> ModuleInventory::loadedModules() const
+{
+    QList<LoadedModule> modules;
+    modules.reserve(m_order.size());
+    for (const QString &name : m_order) {
+        modules << m_loaded.value(name);
+    }
+    return modules;
+}
+
+bool ModuleInventory::isLoaded(const QString &module) const
+{
+    return m_loaded.contains(KernelModuleIndex::normalizeName(module));
+}
+
+LoadedModule ModuleInventory::module(const QString &module) const
+{
+    return m_loaded.value(KernelModuleIndex::normalizeName(module));
+}
+
+QStringList ModuleInventory::uses(const QString &module) const
+{
+    return m_uses.value(KernelModuleIndex::normalizeName(module));
+}
+
+QMap<QString, QString> ModuleInventory::parameters(const QString &module)
+{
+    QMap<QString, QString> values;
+    
+    const QDir dir("/sys/module/" + KernelModuleIndex::normalizeName(module) + "/parameters");
+    const QStringList names = dir.entryList(QDir::Files | QDir::System);
+    for (const QString &name : names) {
+        QFile file(dir.filePath(name));
+        if (file.open(QIODevice::ReadOnly)) {
+            values.insert(name, QString::fromUtf8(file.readAll().trimmed()));
+        }
+    }
+    
+    return values;
+}
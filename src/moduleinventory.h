@@ -0,0 +1,48 @@
+#ifndef MODULEINVENTORY_H
+#define MODULEINVENTORY_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QMap>
+#include <QSharedPointer>
+
+struct LoadedModule {
+    QString name;
+    qint64 size = 0;
+    int refCount = 0;
+    QStringList usedBy;     // modules holding a reference to this one
+    QString state;          // Live, Loading or Unloading
+    QString taint;          // e.g. "(POE)" for out-of-tree proprietary modules
+};
+
+// One parsed read of /proc/modules, shared by every caller that asks within
+// a short window instead of each forking lsmod. Static data (paths,
+// dependencies, builtins) comes from KernelModuleIndex.
+class ModuleInventory
+{
+public:
+    static QSharedPointer<const ModuleInventory> snapshot(int maxAgeMs = 1000);
+    static void invalidate();
+    
+    QStringList loadedModuleNames() const { return m_order; }
+    QList<LoadedModule> loadedModules() const;
+    bool isLoaded(const QString &module) const;
+    LoadedModule module(const QString &module) const;
+    QStringList uses(const QString &module) const;
+    qint64 totalSize() const { return m_totalSize; }
+    
+    // Read from /sys/module/<name>/parameters when asked for; unreadable
+    // (write-only) parameters are skipped
+    static QMap<QString, QString> parameters(const QString &module);
+
+private:
+    ModuleInventory();
+    
+    QHash<QString, LoadedModule> m_loaded;
+    QHash<QString, QStringList> m_uses;
+    QStringList m_order;
+    qint64 m_totalSize;
+};
+
+#endif // MODULEINVENTORY_H
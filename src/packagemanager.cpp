@@ -1,6 +1,8 @@
 #include "packagemanager.h"
 #include "systemutils.h"
 #include "privilegedexecutor.h"
+#include "metadatacache.h"
+#include "tracing.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -69,6 +71,8 @@ PackageManager::PackageManager(QWidget *parent)
     , m_searchTimer(nullptr)
     , m_isSearching(false)
 {
+    TraceSpan span("PackageManager::PackageManager");
+    
     m_systemUtils = new SystemUtils(this);
     m_privilegedExecutor = new PrivilegedExecutor(this);
     
@@ -738,7 +742,6 @@ void PackageManager::hideProgress()
 
 PackageSearchWorker::PackageSearchWorker(QObject *parent)
     : QObject(parent)
-    , m_process(nullptr)
     , m_cancelled(false)
 {
 }
@@ -748,34 +751,29 @@ void PackageSearchWorker::searchPackages(const QString &searchTerm, const QStrin
     QMutexLocker locker(&m_mutex);
     m_cancelled = false;
     
-    if (m_process) {
-        m_process->kill();
-        m_process->deleteLater();
-    }
-    
-    m_process = new QProcess(this);
-    m_process->setProcessChannelMode(QProcess::MergedChannels);
+    // A new search replaces the one still running
+    m_token.cancel();
+    m_token = CancellationToken();
     
     QStringList args;
     args << "search" << "--quiet" << searchTerm;
     
-    connect(m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            [this](int exitCode, QProcess::ExitStatus exitStatus) {
-                if (m_cancelled) return;
-                
-                if (exitCode == 0) {
-                    QString output = m_process->readAll();
-                    QList<PackageInfo> packages = parsePackageList(output);
-                    emit searchFinished(packages);
-                } else {
-                    emit searchError("Search failed");
-                }
-                
-                m_process->deleteLater();
-                m_process = nullptr;
-            });
+    // dnf may have to fetch metadata first, which takes as long as the mirrors do
+    ProcessRequest request("dnf", args);
+    request.channelMode = QProcess::MergedChannels;
+    request.timeoutMs = 0;
     
-    m_process->start("dnf", args);
+    const CancellationToken token = m_token;
+    ProcessRunner::instance()->run(request, token).then(this, [this, token](const ProcessResult &result) {
+        if (m_cancelled || token.isCancelled()) return;
+        
+        if (result.success()) {
+            QList<PackageInfo> packages = parsePackageList(result.output());
+            emit searchFinished(packages);
+        } else {
+            emit searchError("Search failed");
+        }
+    });
 }
 
 void PackageSearchWorker::refreshAllPackages()
@@ -785,19 +783,30 @@ void PackageSearchWorker::refreshAllPackages()
     
     emit searchProgress("Loading package information...");
     
+    // With every enabled repository's metadata current, skip dnf's own
+    // expiry checks and mirror round trips
+    QStringList cacheArgs;
+    if (MetadataCache::isWarm(RepoFiles::readAll())) {
+        cacheArgs << "--cacheonly";
+    }
+    
+    m_token = CancellationToken();
+    const CancellationToken token = m_token;
+    
+    ProcessRequest installedRequest("dnf", QStringList() << "list" << "installed" << "--quiet" << cacheArgs);
+    installedRequest.timeoutMs = 0;
+    installedRequest.expectedOutputSize = 1024 * 1024;
+    
     // Get installed packages first
-    QProcess *installedProcess = new QProcess(this);
-    connect(installedProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, installedProcess](int exitCode, QProcess::ExitStatus exitStatus) {
-        if (m_cancelled) {
-            installedProcess->deleteLater();
+    ProcessRunner::instance()->run(installedRequest, token).then(this, [this, token, cacheArgs](const ProcessResult &installed) {
+        if (m_cancelled || token.isCancelled()) {
             return;
         }
         
         QMap<QString, PackageInfo> packageMap;
         
-        if (exitCode == 0) {
-            QString installedOutput = installedProcess->readAllStandardOutput();
+        if (installed.success()) {
+            QString installedOutput = installed.output();
             QList<PackageInfo> installedPackages = parsePackageList(installedOutput, true);
             
             // Add installed packages to map
@@ -806,21 +815,20 @@ void PackageSearchWorker::refreshAllPackages()
             }
         }
         
-        installedProcess->deleteLater();
-        
         emit searchProgress("Checking for available updates...");
         
+        ProcessRequest availableRequest("dnf", QStringList() << "list" << "available" << "--quiet" << cacheArgs);
+        availableRequest.timeoutMs = 0;
+        availableRequest.expectedOutputSize = 8 * 1024 * 1024;
+        
         // Get available packages
-        QProcess *availableProcess = new QProcess(this);
-        connect(availableProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-                this, [this, availableProcess, packageMap](int exitCode, QProcess::ExitStatus exitStatus) mutable {
-            if (m_cancelled) {
-                availableProcess->deleteLater();
+        ProcessRunner::instance()->run(availableRequest, token).then(this, [this, token, packageMap](const ProcessResult &available) mutable {
+            if (m_cancelled || token.isCancelled()) {
                 return;
             }
             
-            if (exitCode == 0) {
-                QString availableOutput = availableProcess->readAllStandardOutput();
+            if (available.success()) {
+                QString availableOutput = available.output();
                 QList<PackageInfo> availablePackages = parsePackageList(availableOutput, false);
                 
                 // Merge available packages with installed ones
@@ -839,26 +847,17 @@ void PackageSearchWorker::refreshAllPackages()
                 }
             }
             
-            availableProcess->deleteLater();
-            
             QList<PackageInfo> allPackages = packageMap.values();
             emit searchFinished(allPackages);
         });
-        
-        availableProcess->start("dnf", QStringList() << "list" << "available" << "--quiet");
     });
-    
-    installedProcess->start("dnf", QStringList() << "list" << "installed" << "--quiet");
 }
 
 void PackageSearchWorker::cancel()
 {
     QMutexLocker locker(&m_mutex);
     m_cancelled = true;
-    
-    if (m_process) {
-        m_process->kill();
-    }
+    m_token.cancel();
 }
 
 QList<PackageInfo> PackageSearchWorker::parsePackageList(const QString &output, bool installedOnly)
@@ -953,4 +952,3 @@ QString PackageSearchWorker::formatPackageSize(qint64 bytes)
     return QString("%1 %2").arg(QString::number(size, 'f', 1)).arg(units[unitIndex]);
 }
 
- 
\ No newline at end of file
@@ -20,6 +20,7 @@
 #include <QThread>
 #include <QProcess>
 #include <QMutex>
+#include "processrunner.h"
 
 class SystemUtils;
 class PrivilegedExecutor;
@@ -158,7 +159,7 @@ class PackageSearchWorker : public QObject
 
 public:
     explicit PackageSearchWorker(QObject *parent = nullptr);
-    
+
 public slots:
     void searchPackages(const QString &searchTerm, const QString &searchType);
     void refreshAllPackages();
@@ -175,7 +176,7 @@ private:
     PackageInfo parsePackageInfoBlock(const QString &block);
     QString formatPackageSize(qint64 bytes);
     
-    QProcess *m_process;
+    CancellationToken m_token;
     bool m_cancelled;
     QMutex m_mutex;
 };
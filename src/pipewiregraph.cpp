@@ -0,0 +1,1037 @@
+#include "pipewiregraph.h"
+#include "processrunner.h"
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonValue>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPainterPathStroker>
+#include <QStyleOptionGraphicsItem>
+#include <QFontMetricsF>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QScrollBar>
+#include <QPointer>
+#include <QDebug>
+#include <algorithm>
+#include <utility>
+
+// PipeWireGraphModel Implementation
+PipeWireGraphModel::PipeWireGraphModel(QObject *parent)
+    : QObject(parent)
+    , m_monitoring(false)
+    , m_scanPos(0)
+    , m_docStart(-1)
+    , m_depth(0)
+    , m_inString(false)
+    , m_escape(false)
+{
+}
+
+PipeWireGraphModel::~PipeWireGraphModel()
+{
+    m_monitorToken.cancel();
+}
+
+void PipeWireGraphModel::start()
+{
+    if (isRunning()) return;
+    
+    resetParser();
+    m_monitoring = true;
+    m_monitorToken = CancellationToken();
+    
+    // One registry connection for the lifetime of the view; pw-dump prints the
+    // full graph once and then only the objects that changed.
+    ProcessRequest request("pw-dump", QStringList() << "--monitor" << "--no-colors");
+    request.timeoutMs = 0;
+    request.launcher = ProcessRequest::QtProcess;
+    request.pooled = false;
+    
+    // Output of a monitor we already stopped, or that outlived us, is dropped
+    QPointer<PipeWireGraphModel> self(this);
+    const CancellationToken token = m_monitorToken;
+    request.onOutput = [self, token](const QByteArray &chunk) {
+        if (self && !token.isCancelled()) self->readOutput(chunk);
+    };
+    
+    ProcessRunner::instance()->run(request, token).then(this, [this, token](const ProcessResult &result) {
+        if (token.isCancelled()) return;
+        
+        m_monitoring = false;
+        if (!result.started) {
+            emit errorOccurred("pw-dump is not available. Install pipewire-utils to use the graph view.");
+        } else if (!result.success()) {
+            emit errorOccurred(QString("PipeWire monitor exited: %1")
+                               .arg(QString::fromUtf8(result.standardError).trimmed()));
+        }
+    });
+}
+
+void PipeWireGraphModel::stop()
+{
+    // A deliberate stop is not an error, so the monitor is cancelled before it
+    // dies and whatever it still reports is ignored. The next start() sets up a fresh one.
+    if (m_monitoring) {
+        m_monitorToken.cancel();
+        m_monitoring = false;
+    }
+    
+    const QList<quint32> linkIds = m_links.keys();
+    const QList<quint32> nodeIds = m_nodes.keys();
+    m_links.clear();
+    m_ports.clear();
+    m_nodes.clear();
+    m_nodePorts.clear();
+    m_portLinks.clear();
+    
+    for (quint32 id : linkIds) {
+        emit linkRemoved(id);
+    }
+    for (quint32 id : nodeIds) {
+        emit nodeRemoved(id);
+    }
+}
+
+bool PipeWireGraphModel::isRunning() const
+{
+    return m_monitoring;
+}
+
+QList<quint32> PipeWireGraphModel::portsForNode(quint32 nodeId) const
+{
+    QList<quint32> ports = m_nodePorts.values(nodeId);
+    std::sort(ports.begin(), ports.end());
+    return ports;
+}
+
+QList<quint32> PipeWireGraphModel::linksForPort(quint32 portId) const
+{
+    return m_portLinks.values(portId);
+}
+
+void PipeWireGraphModel::readOutput(const QByteArray &chunk)
+{
+    m_buffer.append(chunk);
+    
+    // Split the stream into complete top-level JSON documents without
+    // rescanning bytes that were already looked at.
+    int consumed = 0;
+    const int size = m_buffer.size();
+    const char *data = m_buffer.constData();
+    
+    for (; m_scanPos < size; ++m_scanPos) {
+        const char c = data[m_scanPos];
+        
+        if (m_inString) {
+            if (m_escape) {
+                m_escape = false;
+            } else if (c == '\\') {
+                m_escape = true;
+            } else if (c == '"') {
+                m_inString = false;
+            }
+            continue;
+        }
+        
+        if (c == '"') {
+            m_inString = true;
+        } else if (c == '[' || c == '{') {
+            if (m_depth == 0) {
+                m_docStart = m_scanPos;
+            }
+            ++m_depth;
+        } else if (c == ']' || c == '}') {
+            if (m_depth > 0 && --m_depth == 0 && m_docStart >= 0) {
+                processDocument(m_buffer.mid(m_docStart, m_scanPos - m_docStart + 1));
+                consumed = m_scanPos + 1;
+                m_docStart = -1;
+            }
+        }
+    }
+    
+    if (consumed > 0) {
+        m_buffer.remove(0, consumed);
+        m_scanPos -= consumed;
+    }
+}
+
+void PipeWireGraphModel::resetParser()
+{
+    m_buffer.clear();
+    m_scanPos = 0;
+    m_docStart = -1;
+    m_depth = 0;
+    m_inString = false;
+    m_escape = false;
+}
+
+void PipeWireGraphModel::processDocument(const QByteArray &document)
+{
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(document, &error);
+    if (error.error != QJsonParseError::NoError) {
+        qWarning() << "Failed to parse pw-dump output:" << error.errorString();
+        return;
+    }
+    
+    if (doc.isArray()) {
+        const QJsonArray objects = doc.array();
+        for (const QJsonValue &value : objects) {
+            applyObject(value.toObject());
+        }
+    } else if (doc.isObject()) {
+        applyObject(doc.object());
+    }
+}
+
+void PipeWireGraphModel::applyObject(const QJsonObject &object)
+{
+    if (!object.contains("id")) return;
+    
+    const quint32 id = static_cast<quint32>(object.value("id").toDouble());
+    const QJsonValue info = object.value("info");
+    
+    // Removed globals are reported as {"id": N, "info": null}
+    if (info.isNull()) {
+        removeObject(id);
+        return;
+    }
+    if (!info.isObject()) return;
+    
+    QString type = object.value("type").toString();
+    if (type.isEmpty()) {
+        if (m_nodes.contains(id)) type = "PipeWire:Interface:Node";
+        else if (m_ports.contains(id)) type = "PipeWire:Interface:Port";
+        else if (m_links.contains(id)) type = "PipeWire:Interface:Link";
+    }
+    
+    if (type == "PipeWire:Interface:Node") {
+        applyNode(id, info.toObject());
+    } else if (type == "PipeWire:Interface:Port") {
+        applyPort(id, info.toObject());
+    } else if (type == "PipeWire:Interface:Link") {
+        applyLink(id, info.toObject());
+    }
+}
+
+void PipeWireGraphModel::applyNode(quint32 id, const QJsonObject &info)
+{
+    const bool exists = m_nodes.contains(id);
+    PipeWireNode node = m_nodes.value(id);
+    node.id = id;
+    
+    if (info.contains("props")) {
+        const QJsonObject props = info.value("props").toObject();
+        node.name = props.value("node.name").toString();
+        node.mediaClass = props.value("media.class").toString();
+        
+        QString description = props.value("node.description").toString();
+        if (node.mediaClass.startsWith("Stream/")) {
+            const QString application = props.value("application.name").toString();
+            if (!application.isEmpty()) {
+                description = application;
+            }
+        }
+        if (description.isEmpty()) description = props.value("node.nick").toString();
+        if (description.isEmpty()) description = node.name;
+        node.description = description;
+    }
+    if (info.contains("state")) {
+        node.state = info.value("state").toString();
+    }
+    
+    // Drivers and other port-less helper nodes have no media class
+    if (node.mediaClass.isEmpty()) {
+        if (exists) removeObject(id);
+        return;
+    }
+    
+    if (exists) {
+        const PipeWireNode &old = m_nodes[id];
+        if (old.name == node.name && old.description == node.description
+            && old.mediaClass == node.mediaClass && old.state == node.state) {
+            return;
+        }
+    }
+    
+    m_nodes.insert(id, node);
+    if (exists) {
+        emit nodeChanged(id);
+    } else {
+        emit nodeAdded(id);
+    }
+}
+
+void PipeWireGraphModel::applyPort(quint32 id, const QJsonObject &info)
+{
+    const bool exists = m_ports.contains(id);
+    PipeWirePort port = m_ports.value(id);
+    const quint32 previousNode = port.nodeId;
+    port.id = id;
+    
+    if (info.contains("direction")) {
+        port.isOutput = info.value("direction").toString() == "output";
+    }
+    if (info.contains("props")) {
+        const QJsonObject props = info.value("props").toObject();
+        port.nodeId = props.value("node.id").toVariant().toUInt();
+        port.name = props.value("port.name").toString();
+        port.alias = props.value("port.alias").toString();
+        port.isMonitor = props.value("port.monitor").toVariant().toBool();
+        
+        const QString format = props.value("format.dsp").toString();
+        if (format.contains("midi")) {
+            port.mediaType = "midi";
+        } else if (format.contains("video")) {
+            port.mediaType = "video";
+        } else {
+            port.mediaType = "audio";
+        }
+    }
+    
+    if (exists) {
+        const PipeWirePort &old = m_ports[id];
+        if (old.nodeId == port.nodeId && old.name == port.name && old.alias == port.alias
+            && old.isOutput == port.isOutput && old.isMonitor == port.isMonitor
+            && old.mediaType == port.mediaType) {
+            return;
+        }
+        if (previousNode != port.nodeId) {
+            m_nodePorts.remove(previousNode, id);
+            m_nodePorts.insert(port.nodeId, id);
+        }
+    } else {
+        m_nodePorts.insert(port.nodeId, id);
+    }
+    
+    m_ports.insert(id, port);
+    if (exists) {
+        emit portChanged(id);
+    } else {
+        emit portAdded(id);
+    }
+}
+
+void PipeWireGraphModel::applyLink(quint32 id, const QJsonObject &info)
+{
+    const bool exists = m_links.contains(id);
+    PipeWireLink link = m_links.value(id);
+    link.id = id;
+    
+    if (info.contains("output-port-id")) {
+        link.outputNodeId = static_cast<quint32>(info.value("output-node-id").toDouble());
+        link.outputPortId = static_cast<quint32>(info.value("output-port-id").toDouble());
+        link.inputNodeId = static_cast<quint32>(info.value("input-node-id").toDouble());
+        link.inputPortId = static_cast<quint32>(info.value("input-port-id").toDouble());
+    }
+    if (info.contains("state")) {
+        link.state = info.value("state").toString();
+    }
+    
+    if (exists) {
+        const PipeWireLink &old = m_links[id];
+        if (old.outputPortId == link.outputPortId && old.inputPortId == link.inputPortId
+            && old.state == link.state) {
+            return;
+        }
+        m_portLinks.remove(old.outputPortId, id);
+        m_portLinks.remove(old.inputPortId, id);
+    }
+    
+    m_portLinks.insert(link.outputPortId, id);
+    m_portLinks.insert(link.inputPortId, id);
+    m_links.insert(id, link);
+    
+    if (exists) {
+        emit linkChanged(id);
+    } else {
+        emit linkAdded(id);
+    }
+}
+
+void PipeWireGraphModel::removeObject(quint32 id)
+{
+    if (m_nodes.remove(id)) {
+        emit nodeRemoved(id);
+        return;
+    }
+    
+    auto portIt = m_ports.find(id);
+    if (portIt != m_ports.end()) {
+        const quint32 nodeId = portIt->nodeId;
+        m_nodePorts.remove(nodeId, id);
+        m_ports.erase(portIt);
+        emit portRemoved(id, nodeId);
+        return;
+    }
+    
+    auto linkIt = m_links.find(id);
+    if (linkIt != m_links.end()) {
+        m_portLinks.remove(linkIt->outputPortId, id);
+        m_portLinks.remove(linkIt->inputPortId, id);
+        m_links.erase(linkIt);
+        emit linkRemoved(id);
+    }
+}
+
+// PipeWireNodeItem Implementation
+PipeWireNodeItem::PipeWireNodeItem(quint32 nodeId)
+    : m_nodeId(nodeId)
+    , m_width(MIN_WIDTH)
+    , m_height(TITLE_HEIGHT)
+{
+    setFlag(QGraphicsItem::ItemIsMovable);
+    setFlag(QGraphicsItem::ItemIsSelectable);
+    setFlag(QGraphicsItem::ItemSendsGeometryChanges);
+    // Nodes only repaint when their ports or title change
+    setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+    setZValue(1);
+}
+
+void PipeWireNodeItem::setNode(const PipeWireNode &node)
+{
+    if (m_title == node.description && m_mediaClass == node.mediaClass) return;
+    
+    m_title = node.description;
+    m_mediaClass = node.mediaClass;
+    setToolTip(QString("%1\n%2 (id %3)").arg(node.name, node.mediaClass).arg(node.id));
+    relayout();
+}
+
+void PipeWireNodeItem::setPorts(const QList<PortEntry> &ports)
+{
+    QList<PortEntry> inputs;
+    QList<PortEntry> outputs;
+    for (const PortEntry &port : ports) {
+        if (port.isOutput) {
+            outputs.append(port);
+        } else {
+            inputs.append(port);
+        }
+    }
+    
+    m_inputs = inputs;
+    m_outputs = outputs;
+    relayout();
+}
+
+void PipeWireNodeItem::relayout()
+{
+    QFontMetricsF metrics{QFont()};
+    qreal width = metrics.horizontalAdvance(m_title) + 24;
+    
+    const int rows = m_inputs.size() + m_outputs.size();
+    for (const PortEntry &port : m_inputs) {
+        width = qMax(width, metrics.horizontalAdvance(port.label) + 24);
+    }
+    for (const PortEntry &port : m_outputs) {
+        width = qMax(width, metrics.horizontalAdvance(port.label) + 24);
+    }
+    
+    prepareGeometryChange();
+    m_width = qBound(MIN_WIDTH, width, 280.0);
+    m_height = TITLE_HEIGHT + rows * PORT_HEIGHT + 6;
+    update();
+    
+    for (PipeWireLinkItem *link : std::as_const(m_links)) {
+        link->updatePath();
+    }
+}
+
+QPointF PipeWireNodeItem::portAnchor(quint32 portId) const
+{
+    for (int i = 0; i < m_inputs.size(); ++i) {
+        if (m_inputs[i].id == portId) {
+            return QPointF(0, TITLE_HEIGHT + i * PORT_HEIGHT + PORT_HEIGHT / 2);
+        }
+    }
+    for (int i = 0; i < m_outputs.size(); ++i) {
+        if (m_outputs[i].id == portId) {
+            return QPointF(m_width, TITLE_HEIGHT + (m_inputs.size() + i) * PORT_HEIGHT + PORT_HEIGHT / 2);
+        }
+    }
+    return QPointF(m_width / 2, TITLE_HEIGHT / 2);
+}
+
+quint32 PipeWireNodeItem::portAt(const QPointF &localPos, bool *isOutput) const
+{
+    if (localPos.y() < TITLE_HEIGHT || localPos.x() < -6 || localPos.x() > m_width + 6) {
+        return 0;
+    }
+    
+    const int row = static_cast<int>((localPos.y() - TITLE_HEIGHT) / PORT_HEIGHT);
+    if (row < m_inputs.size()) {
+        if (isOutput) *isOutput = false;
+        return m_inputs[row].id;
+    }
+    
+    const int outputRow = row - m_inputs.size();
+    if (outputRow >= 0 && outputRow < m_outputs.size()) {
+        if (isOutput) *isOutput = true;
+        return m_outputs[outputRow].id;
+    }
+    return 0;
+}
+
+bool PipeWireNodeItem::hasPort(quint32 portId) const
+{
+    for (const PortEntry &port : m_inputs) {
+        if (port.id == portId) return true;
+    }
+    for (const PortEntry &port : m_outputs) {
+        if (port.id == portId) return true;
+    }
+    return false;
+}
+
+void PipeWireNodeItem::addLink(PipeWireLinkItem *link)
+{
+    m_links.insert(link);
+}
+
+void PipeWireNodeItem::removeLink(PipeWireLinkItem *link)
+{
+    m_links.remove(link);
+}
+
+QRectF PipeWireNodeItem::boundingRect() const
+{
+    return QRectF(-5, 0, m_width + 10, m_height);
+}
+
+void PipeWireNodeItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget);
+    
+    const QPalette &palette = option->palette;
+    const QRectF body(0, 0, m_width, m_height);
+    
+    QColor accent("#3daee9");
+    if (m_mediaClass.contains("Sink") || m_mediaClass.startsWith("Stream/Input")) {
+        accent = QColor("#1d99f3");
+    } else if (m_mediaClass.contains("Source") || m_mediaClass.startsWith("Stream/Output")) {
+        accent = QColor("#27ae60");
+    } else if (m_mediaClass.startsWith("Midi")) {
+        accent = QColor("#f67400");
+    }
+    
+    painter->setPen(QPen(isSelected() ? palette.highlight().color() : palette.mid().color(), 1));
+    painter->setBrush(palette.base());
+    painter->drawRoundedRect(body, 4, 4);
+    
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(accent);
+    painter->drawRoundedRect(QRectF(0, 0, m_width, TITLE_HEIGHT), 4, 4);
+    
+    QFont titleFont = painter->font();
+    titleFont.setBold(true);
+    painter->setFont(titleFont);
+    painter->setPen(Qt::white);
+    painter->drawText(QRectF(8, 0, m_width - 16, TITLE_HEIGHT), Qt::AlignVCenter | Qt::AlignLeft,
+                      QFontMetricsF(titleFont).elidedText(m_title, Qt::ElideRight, m_width - 16));
+    
+    titleFont.setBold(false);
+    painter->setFont(titleFont);
+    
+    auto drawPort = [&](const PortEntry &port, int row, bool output) {
+        const qreal y = TITLE_HEIGHT + row * PORT_HEIGHT;
+        const QPointF anchor(output ? m_width : 0, y + PORT_HEIGHT / 2);
+        
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(port.isMidi ? QColor("#f67400") : accent);
+        painter->drawEllipse(anchor, 4, 4);
+        
+        painter->setPen(palette.text().color());
+        painter->drawText(QRectF(8, y, m_width - 16, PORT_HEIGHT),
+                          Qt::AlignVCenter | (output ? Qt::AlignRight : Qt::AlignLeft), port.label);
+    };
+    
+    for (int i = 0; i < m_inputs.size(); ++i) {
+        drawPort(m_inputs[i], i, false);
+    }
+    for (int i = 0; i < m_outputs.size(); ++i) {
+        drawPort(m_outputs[i], m_inputs.size() + i, true);
+    }
+}
+
+QVariant PipeWireNodeItem::itemChange(GraphicsItemChange change, const QVariant &value)
+{
+    if (change == QGraphicsItem::ItemPositionHasChanged) {
+        for (PipeWireLinkItem *link : std::as_const(m_links)) {
+            link->updatePath();
+        }
+    }
+    return QGraphicsItem::itemChange(change, value);
+}
+
+// PipeWireLinkItem Implementation
+PipeWireLinkItem::PipeWireLinkItem(quint32 linkId, PipeWireNodeItem *outputNode, quint32 outputPortId,
+                                   PipeWireNodeItem *inputNode, quint32 inputPortId)
+    : m_linkId(linkId)
+    , m_outputNode(outputNode)
+    , m_outputPortId(outputPortId)
+    , m_inputNode(inputNode)
+    , m_inputPortId(inputPortId)
+{
+    setZValue(0);
+    setToolTip("Double-click to disconnect");
+    setLinkActive(true);
+    updatePath();
+}
+
+QPainterPath PipeWireLinkItem::shape() const
+{
+    // Hit-test the curve itself rather than the area it encloses
+    QPainterPathStroker stroker;
+    stroker.setWidth(8);
+    return stroker.createStroke(path());
+}
+
+void PipeWireLinkItem::setLinkActive(bool active)
+{
+    QPen linkPen(active ? QColor("#3daee9") : QColor("#7f8c8d"), 2);
+    if (!active) {
+        linkPen.setStyle(Qt::DashLine);
+    }
+    setPen(linkPen);
+}
+
+void PipeWireLinkItem::updatePath()
+{
+    const QPointF from = m_outputNode->mapToScene(m_outputNode->portAnchor(m_outputPortId));
+    const QPointF to = m_inputNode->mapToScene(m_inputNode->portAnchor(m_inputPortId));
+    setPath(bezier(from, to));
+}
+
+QPainterPath PipeWireLinkItem::bezier(const QPointF &from, const QPointF &to)
+{
+    const qreal dx = qMax(40.0, qAbs(to.x() - from.x()) / 2);
+    QPainterPath path(from);
+    path.cubicTo(from + QPointF(dx, 0), to - QPointF(dx, 0), to);
+    return path;
+}
+
+// PipeWireGraphView Implementation
+PipeWireGraphView::PipeWireGraphView(PipeWireGraphModel *model, QWidget *parent)
+    : QGraphicsView(parent)
+    , m_model(model)
+    , m_scene(new QGraphicsScene(this))
+    , m_flushTimer(new QTimer(this))
+    , m_dragPath(nullptr)
+    , m_dragPortId(0)
+    , m_dragFromOutput(true)
+{
+    m_columnBottom[0] = m_columnBottom[1] = m_columnBottom[2] = 0;
+    
+    setScene(m_scene);
+    setRenderHint(QPainter::Antialiasing);
+    setViewportUpdateMode(QGraphicsView::SmartViewportUpdate);
+    setOptimizationFlags(QGraphicsView::DontSavePainterState | QGraphicsView::DontAdjustForAntialiasing);
+    setCacheMode(QGraphicsView::CacheBackground);
+    setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
+    setDragMode(QGraphicsView::ScrollHandDrag);
+    
+    // Registry bursts (e.g. a device appearing with dozens of ports) are
+    // folded into one scene update per frame.
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(FLUSH_INTERVAL_MS);
+    connect(m_flushTimer, &QTimer::timeout, this, &PipeWireGraphView::flushPendingUpdates);
+    
+    connect(m_model, &PipeWireGraphModel::nodeAdded, this, &PipeWireGraphView::markNodeDirty);
+    connect(m_model, &PipeWireGraphModel::nodeChanged, this, &PipeWireGraphView::markNodeDirty);
+    connect(m_model, &PipeWireGraphModel::nodeRemoved, this, &PipeWireGraphView::markNodeDirty);
+    connect(m_model, &PipeWireGraphModel::portAdded, this, [this](quint32 id) {
+        markNodeDirty(m_model->ports().value(id).nodeId);
+    });
+    connect(m_model, &PipeWireGraphModel::portChanged, this, [this](quint32 id) {
+        markNodeDirty(m_model->ports().value(id).nodeId);
+    });
+    connect(m_model, &PipeWireGraphModel::portRemoved, this, &PipeWireGraphView::onPortRemoved);
+    connect(m_model, &PipeWireGraphModel::linkAdded, this, &PipeWireGraphView::markLinkDirty);
+    connect(m_model, &PipeWireGraphModel::linkChanged, this, &PipeWireGraphView::markLinkDirty);
+    connect(m_model, &PipeWireGraphModel::linkRemoved, this, &PipeWireGraphView::markLinkDirty);
+    
+    // Pick up anything the model already knows about
+    for (auto it = m_model->nodes().cbegin(); it != m_model->nodes().cend(); ++it) {
+        markNodeDirty(it.key());
+    }
+    for (auto it = m_model->links().cbegin(); it != m_model->links().cend(); ++it) {
+        markLinkDirty(it.key());
+    }
+}
+
+void PipeWireGraphView::relayoutAll()
+{
+    m_columnBottom[0] = m_columnBottom[1] = m_columnBottom[2] = 0;
+    
+    QList<quint32> ids = m_nodeItems.keys();
+    std::sort(ids.begin(), ids.end());
+    for (quint32 id : ids) {
+        placeNode(m_nodeItems.value(id), m_model->nodes().value(id).mediaClass);
+    }
+}
+
+void PipeWireGraphView::markNodeDirty(quint32 nodeId)
+{
+    if (nodeId == 0) return;
+    m_dirtyNodes.insert(nodeId);
+    scheduleFlush();
+}
+
+void PipeWireGraphView::onPortRemoved(quint32 portId, quint32 nodeId)
+{
+    Q_UNUSED(portId);
+    markNodeDirty(nodeId);
+}
+
+void PipeWireGraphView::markLinkDirty(quint32 linkId)
+{
+    m_dirtyLinks.insert(linkId);
+    scheduleFlush();
+}
+
+void PipeWireGraphView::scheduleFlush()
+{
+    if (!m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+}
+
+void PipeWireGraphView::flushPendingUpdates()
+{
+    const QSet<quint32> dirtyNodes = m_dirtyNodes;
+    const QSet<quint32> dirtyLinks = m_dirtyLinks;
+    m_dirtyNodes.clear();
+    m_dirtyLinks.clear();
+    
+    // Nodes first so new links always find both endpoints
+    for (quint32 nodeId : dirtyNodes) {
+        syncNode(nodeId);
+    }
+    for (quint32 linkId : dirtyLinks) {
+        syncLink(linkId);
+    }
+}
+
+void PipeWireGraphView::syncNode(quint32 nodeId)
+{
+    auto nodeIt = m_model->nodes().constFind(nodeId);
+    if (nodeIt == m_model->nodes().cend()) {
+        m_pendingLinks.remove(nodeId);
+        removeNodeItem(nodeId);
+        return;
+    }
+    
+    PipeWireNodeItem *item = m_nodeItems.value(nodeId);
+    const bool isNew = (item == nullptr);
+    if (isNew) {
+        item = new PipeWireNodeItem(nodeId);
+        m_scene->addItem(item);
+        m_nodeItems.insert(nodeId, item);
+    }
+    
+    const qreal oldHeight = item->boundingRect().height();
+    item->setNode(*nodeIt);
+    
+    QList<PipeWireNodeItem::PortEntry> entries;
+    const QList<quint32> portIds = m_model->portsForNode(nodeId);
+    for (quint32 portId : portIds) {
+        const PipeWirePort port = m_model->ports().value(portId);
+        PipeWireNodeItem::PortEntry entry;
+        entry.id = portId;
+        entry.label = port.name.isEmpty() ? port.alias : port.name;
+        entry.isOutput = port.isOutput;
+        entry.isMidi = port.mediaType == "midi";
+        entries.append(entry);
+    }
+    item->setPorts(entries);
+    
+    if (isNew) {
+        placeNode(item, nodeIt->mediaClass);
+        const QList<quint32> pending = m_pendingLinks.values(nodeId);
+        m_pendingLinks.remove(nodeId);
+        for (quint32 linkId : pending) {
+            syncLink(linkId);
+        }
+    } else if (item->boundingRect().height() > oldHeight) {
+        pushColumnDown(item);
+    }
+}
+
+void PipeWireGraphView::syncLink(quint32 linkId)
+{
+    auto linkIt = m_model->links().constFind(linkId);
+    if (linkIt == m_model->links().cend()) {
+        removeLinkItem(linkId);
+        return;
+    }
+    
+    PipeWireLinkItem *item = m_linkItems.value(linkId);
+    if (item) {
+        item->setLinkActive(linkIt->state != "paused" && linkIt->state != "error");
+        item->setVisible(true);
+        item->updatePath();
+        return;
+    }
+    
+    PipeWireNodeItem *outputNode = m_nodeItems.value(linkIt->outputNodeId);
+    PipeWireNodeItem *inputNode = m_nodeItems.value(linkIt->inputNodeId);
+    if (!outputNode || !inputNode) {
+        // The link can arrive before its nodes; it is created with the last of them
+        const quint32 missing = outputNode ? linkIt->inputNodeId : linkIt->outputNodeId;
+        if (!m_pendingLinks.contains(missing, linkId)) {
+            m_pendingLinks.insert(missing, linkId);
+        }
+        return;
+    }
+    
+    item = new PipeWireLinkItem(linkId, outputNode, linkIt->outputPortId, inputNode, linkIt->inputPortId);
+    item->setLinkActive(linkIt->state != "paused" && linkIt->state != "error");
+    m_scene->addItem(item);
+    m_linkItems.insert(linkId, item);
+    outputNode->addLink(item);
+    inputNode->addLink(item);
+}
+
+void PipeWireGraphView::removeNodeItem(quint32 nodeId)
+{
+    PipeWireNodeItem *item = m_nodeItems.take(nodeId);
+    if (!item) return;
+    
+    const QList<PipeWireLinkItem*> links = item->linkItems();
+    for (PipeWireLinkItem *link : links) {
+        removeLinkItem(link->linkId());
+    }
+    
+    m_nodeColumns.remove(nodeId);
+    m_scene->removeItem(item);
+    delete item;
+}
+
+void PipeWireGraphView::removeLinkItem(quint32 linkId)
+{
+    PipeWireLinkItem *item = m_linkItems.take(linkId);
+    if (!item) return;
+    
+    item->outputNode()->removeLink(item);
+    item->inputNode()->removeLink(item);
+    m_scene->removeItem(item);
+    delete item;
+}
+
+int PipeWireGraphView::columnForClass(const QString &mediaClass) const
+{
+    // Producers on the left, consumers on the right, everything else between
+    if (mediaClass.startsWith("Stream/Output") || mediaClass.endsWith("/Source")) {
+        return 0;
+    }
+    if (mediaClass.startsWith("Stream/Input") || mediaClass.endsWith("/Sink")) {
+        return 2;
+    }
+    return 1;
+}
+
+void PipeWireGraphView::placeNode(PipeWireNodeItem *item, const QString &mediaClass)
+{
+    const int column = columnForClass(mediaClass);
+    m_nodeColumns.insert(item->nodeId(), column);
+    
+    item->setPos(column * COLUMN_WIDTH, m_columnBottom[column]);
+    m_columnBottom[column] += item->boundingRect().height() + NODE_SPACING;
+}
+
+void PipeWireGraphView::pushColumnDown(PipeWireNodeItem *item)
+{
+    const int column = m_nodeColumns.value(item->nodeId(), 1);
+    
+    QList<PipeWireNodeItem*> below;
+    for (auto it = m_nodeColumns.cbegin(); it != m_nodeColumns.cend(); ++it) {
+        PipeWireNodeItem *other = m_nodeItems.value(it.key());
+        if (it.value() == column && other && other != item && other->y() >= item->y()) {
+            below.append(other);
+        }
+    }
+    std::sort(below.begin(), below.end(), [](PipeWireNodeItem *a, PipeWireNodeItem *b) {
+        return a->y() < b->y();
+    });
+    
+    // Only the nodes that now overlap are moved
+    qreal bottom = item->y() + item->boundingRect().height() + NODE_SPACING;
+    for (PipeWireNodeItem *other : below) {
+        if (other->y() >= bottom) break;
+        other->setY(bottom);
+        bottom += other->boundingRect().height() + NODE_SPACING;
+    }
+    m_columnBottom[column] = qMax(m_columnBottom[column], bottom);
+}
+
+bool PipeWireGraphView::isLinked(quint32 outputPortId, quint32 inputPortId) const
+{
+    const QList<quint32> existing = m_model->linksForPort(outputPortId);
+    for (quint32 linkId : existing) {
+        if (m_model->links().value(linkId).inputPortId == inputPortId) {
+            return true;
+        }
+    }
+    return false;
+}
+
+PipeWireNodeItem *PipeWireGraphView::nodeItemAt(const QPointF &scenePos) const
+{
+    const QList<QGraphicsItem*> hits = m_scene->items(scenePos);
+    for (QGraphicsItem *hit : hits) {
+        if (PipeWireNodeItem *node = qgraphicsitem_cast<PipeWireNodeItem*>(hit)) {
+            return node;
+        }
+    }
+    return nullptr;
+}
+
+PipeWireLinkItem *PipeWireGraphView::linkItemAt(const QPointF &scenePos) const
+{
+    const QList<QGraphicsItem*> hits = m_scene->items(scenePos);
+    for (QGraphicsItem *hit : hits) {
+        if (PipeWireLinkItem *link = qgraphicsitem_cast<PipeWireLinkItem*>(hit)) {
+            return link;
+        }
+    }
+    return nullptr;
+}
+
+void PipeWireGraphView::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        const QPointF scenePos = mapToScene(event->pos());
+        PipeWireNodeItem *node = nodeItemAt(scenePos);
+        bool isOutput = false;
+        const quint32 portId = node ? node->portAt(node->mapFromScene(scenePos), &isOutput) : 0;
+        
+        if (portId != 0) {
+            m_detachedLinks.clear();
+            m_dragPortId = portId;
+            m_dragFromOutput = isOutput;
+            m_dragAnchor = node->mapToScene(node->portAnchor(portId));
+            
+            // Grabbing a connected input picks all of its links up for re-routing;
+            // the preview is drawn from the first source
+            if (!isOutput) {
+                const QList<quint32> links = m_model->linksForPort(portId);
+                if (!links.isEmpty()) {
+                    const PipeWireLink link = m_model->links().value(links.first());
+                    PipeWireNodeItem *source = m_nodeItems.value(link.outputNodeId);
+                    if (source) {
+                        m_detachedLinks = links;
+                        m_dragPortId = link.outputPortId;
+                        m_dragFromOutput = true;
+                        m_dragAnchor = source->mapToScene(source->portAnchor(link.outputPortId));
+                        for (quint32 linkId : links) {
+                            if (PipeWireLinkItem *item = m_linkItems.value(linkId)) {
+                                item->setVisible(false);
+                            }
+                        }
+                    }
+                }
+            }
+            
+            m_dragPath = new QGraphicsPathItem();
+            m_dragPath->setPen(QPen(palette().highlight().color(), 2, Qt::DashLine));
+            m_dragPath->setZValue(2);
+            m_scene->addItem(m_dragPath);
+            event->accept();
+            return;
+        }
+    }
+    
+    QGraphicsView::mousePressEvent(event);
+}
+
+void PipeWireGraphView::mouseMoveEvent(QMouseEvent *event)
+{
+    if (m_dragPath) {
+        const QPointF scenePos = mapToScene(event->pos());
+        m_dragPath->setPath(m_dragFromOutput ? PipeWireLinkItem::bezier(m_dragAnchor, scenePos)
+                                             : PipeWireLinkItem::bezier(scenePos, m_dragAnchor));
+        event->accept();
+        return;
+    }
+    
+    QGraphicsView::mouseMoveEvent(event);
+}
+
+void PipeWireGraphView::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (!m_dragPath || event->button() != Qt::LeftButton) {
+        QGraphicsView::mouseReleaseEvent(event);
+        return;
+    }
+    
+    m_scene->removeItem(m_dragPath);
+    delete m_dragPath;
+    m_dragPath = nullptr;
+    
+    const QPointF scenePos = mapToScene(event->pos());
+    PipeWireNodeItem *node = nodeItemAt(scenePos);
+    bool targetIsOutput = false;
+    const quint32 targetPort = node ? node->portAt(node->mapFromScene(scenePos), &targetIsOutput) : 0;
+    const bool validTarget = targetPort != 0 && targetIsOutput != m_dragFromOutput;
+    
+    const quint32 inputPort = m_dragFromOutput ? targetPort : m_dragPortId;
+    
+    // Every source of a grabbed input follows it to the new one
+    QList<quint32> outputPorts;
+    bool droppedBack = false;
+    for (quint32 linkId : std::as_const(m_detachedLinks)) {
+        auto link = m_model->links().constFind(linkId);
+        if (link == m_model->links().cend()) continue;
+        if (!outputPorts.contains(link->outputPortId)) {
+            outputPorts << link->outputPortId;
+        }
+        if (validTarget && link->inputPortId == inputPort) {
+            droppedBack = true;
+        }
+    }
+    if (outputPorts.isEmpty()) {
+        outputPorts << (m_dragFromOutput ? m_dragPortId : targetPort);
+    }
+    
+    if (droppedBack) {
+        for (quint32 linkId : std::as_const(m_detachedLinks)) {
+            if (PipeWireLinkItem *item = m_linkItems.value(linkId)) {
+                item->setVisible(true);
+            }
+        }
+    } else {
+        for (quint32 linkId : std::as_const(m_detachedLinks)) {
+            emit unlinkRequested(linkId);
+        }
+        for (quint32 outputPort : std::as_const(outputPorts)) {
+            if (validTarget && !isLinked(outputPort, inputPort)) {
+                emit linkRequested(outputPort, inputPort);
+            }
+        }
+    }
+    
+    m_detachedLinks.clear();
+    m_dragPortId = 0;
+    event->accept();
+}
+
+void PipeWireGraphView::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    PipeWireLinkItem *link = linkItemAt(mapToScene(event->pos()));
+    if (link && !nodeItemAt(mapToScene(event->pos()))) {
+        emit unlinkRequested(link->linkId());
+        event->accept();
+        return;
+    }
+    
+    QGraphicsView::mouseDoubleClickEvent(event);
+}
+
+void PipeWireGraphView::wheelEvent(QWheelEvent *event)
+{
+    const qreal factor = event->angleDelta().y() > 0 ? 1.15 : 1.0 / 1.15;
+    scale(factor, factor);
+    event->accept();
+}
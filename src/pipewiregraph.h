@@ -0,0 +1,250 @@
+#ifndef PIPEWIREGRAPH_H
+#define PIPEWIREGRAPH_H
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QMultiHash>
+#include <QSet>
+#include <QList>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QTimer>
+#include <QPointF>
+#include <QGraphicsView>
+#include <QGraphicsScene>
+#include <QGraphicsItem>
+#include <QGraphicsPathItem>
+#include "processrunner.h"
+
+struct PipeWireNode {
+    quint32 id = 0;
+    QString name;
+    QString description;
+    QString mediaClass;
+    QString state;
+};
+
+struct PipeWirePort {
+    quint32 id = 0;
+    quint32 nodeId = 0;
+    QString name;
+    QString alias;
+    QString mediaType;
+    bool isOutput = false;
+    bool isMonitor = false;
+};
+
+struct PipeWireLink {
+    quint32 id = 0;
+    quint32 outputNodeId = 0;
+    quint32 outputPortId = 0;
+    quint32 inputNodeId = 0;
+    quint32 inputPortId = 0;
+    QString state;
+};
+
+// Live mirror of the PipeWire registry fed by a single long-running
+// `pw-dump --monitor` process. Only objects whose info actually changed
+// are reported, so views can update incrementally.
+class PipeWireGraphModel : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PipeWireGraphModel(QObject *parent = nullptr);
+    ~PipeWireGraphModel();
+    
+    void start();
+    void stop();
+    bool isRunning() const;
+    
+    const QHash<quint32, PipeWireNode> &nodes() const { return m_nodes; }
+    const QHash<quint32, PipeWirePort> &ports() const { return m_ports; }
+    const QHash<quint32, PipeWireLink> &links() const { return m_links; }
+    QList<quint32> portsForNode(quint32 nodeId) const;
+    QList<quint32> linksForPort(quint32 portId) const;
+
+signals:
+    void nodeAdded(quint32 id);
+    void nodeChanged(quint32 id);
+    void nodeRemoved(quint32 id);
+    void portAdded(quint32 id);
+    void portChanged(quint32 id);
+    void portRemoved(quint32 id, quint32 nodeId);
+    void linkAdded(quint32 id);
+    void linkChanged(quint32 id);
+    void linkRemoved(quint32 id);
+    void errorOccurred(const QString &error);
+
+private:
+    void readOutput(const QByteArray &chunk);
+    void resetParser();
+    void processDocument(const QByteArray &document);
+    void applyObject(const QJsonObject &object);
+    void applyNode(quint32 id, const QJsonObject &info);
+    void applyPort(quint32 id, const QJsonObject &info);
+    void applyLink(quint32 id, const QJsonObject &info);
+    void removeObject(quint32 id);
+    
+    CancellationToken m_monitorToken;
+    bool m_monitoring;
+    
+    // Incremental splitter for the stream of top-level JSON arrays
+    QByteArray m_buffer;
+    int m_scanPos;
+    int m_docStart;
+    int m_depth;
+    bool m_inString;
+    bool m_escape;
+    
+    QHash<quint32, PipeWireNode> m_nodes;
+    QHash<quint32, PipeWirePort> m_ports;
+    QHash<quint32, PipeWireLink> m_links;
+    QMultiHash<quint32, quint32> m_nodePorts;
+    QMultiHash<quint32, quint32> m_portLinks;
+};
+
+class PipeWireLinkItem;
+
+class PipeWireNodeItem : public QGraphicsItem
+{
+public:
+    struct PortEntry {
+        quint32 id;
+        QString label;
+        bool isOutput;
+        bool isMidi;
+    };
+    
+    enum { Type = UserType + 1 };
+    
+    explicit PipeWireNodeItem(quint32 nodeId);
+    
+    int type() const override { return Type; }
+    quint32 nodeId() const { return m_nodeId; }
+    void setNode(const PipeWireNode &node);
+    void setPorts(const QList<PortEntry> &ports);
+    QPointF portAnchor(quint32 portId) const;
+    quint32 portAt(const QPointF &localPos, bool *isOutput = nullptr) const;
+    bool hasPort(quint32 portId) const;
+    
+    void addLink(PipeWireLinkItem *link);
+    void removeLink(PipeWireLinkItem *link);
+    QList<PipeWireLinkItem*> linkItems() const { return m_links.values(); }
+    
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+protected:
+    QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
+
+private:
+    void relayout();
+    
+    quint32 m_nodeId;
+    QString m_title;
+    QString m_mediaClass;
+    QList<PortEntry> m_inputs;
+    QList<PortEntry> m_outputs;
+    QSet<PipeWireLinkItem*> m_links;
+    qreal m_width;
+    qreal m_height;
+    
+    static constexpr qreal TITLE_HEIGHT = 22.0;
+    static constexpr qreal PORT_HEIGHT = 18.0;
+    static constexpr qreal MIN_WIDTH = 160.0;
+};
+
+class PipeWireLinkItem : public QGraphicsPathItem
+{
+public:
+    enum { Type = UserType + 2 };
+    
+    PipeWireLinkItem(quint32 linkId, PipeWireNodeItem *outputNode, quint32 outputPortId,
+                     PipeWireNodeItem *inputNode, quint32 inputPortId);
+    
+    int type() const override { return Type; }
+    QPainterPath shape() const override;
+    quint32 linkId() const { return m_linkId; }
+    PipeWireNodeItem *outputNode() const { return m_outputNode; }
+    PipeWireNodeItem *inputNode() const { return m_inputNode; }
+    void setLinkActive(bool active);
+    void updatePath();
+    
+    static QPainterPath bezier(const QPointF &from, const QPointF &to);
+
+private:
+    quint32 m_linkId;
+    PipeWireNodeItem *m_outputNode;
+    quint32 m_outputPortId;
+    PipeWireNodeItem *m_inputNode;
+    quint32 m_inputPortId;
+};
+
+// Node/port graph of the PipeWire session. Model updates are coalesced and
+// flushed at most once per frame, and only nodes that changed are rebuilt.
+class PipeWireGraphView : public QGraphicsView
+{
+    Q_OBJECT
+
+public:
+    explicit PipeWireGraphView(PipeWireGraphModel *model, QWidget *parent = nullptr);
+    
+    void relayoutAll();
+
+signals:
+    void linkRequested(quint32 outputPortId, quint32 inputPortId);
+    void unlinkRequested(quint32 linkId);
+
+protected:
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+
+private slots:
+    void markNodeDirty(quint32 nodeId);
+    void onPortRemoved(quint32 portId, quint32 nodeId);
+    void markLinkDirty(quint32 linkId);
+    void flushPendingUpdates();
+
+private:
+    bool isLinked(quint32 outputPortId, quint32 inputPortId) const;
+    PipeWireNodeItem *nodeItemAt(const QPointF &scenePos) const;
+    PipeWireLinkItem *linkItemAt(const QPointF &scenePos) const;
+    void syncNode(quint32 nodeId);
+    void syncLink(quint32 linkId);
+    void removeNodeItem(quint32 nodeId);
+    void removeLinkItem(quint32 linkId);
+    void placeNode(PipeWireNodeItem *item, const QString &mediaClass);
+    void pushColumnDown(PipeWireNodeItem *item);
+    int columnForClass(const QString &mediaClass) const;
+    void scheduleFlush();
+    
+    PipeWireGraphModel *m_model;
+    QGraphicsScene *m_scene;
+    QTimer *m_flushTimer;
+    
+    QHash<quint32, PipeWireNodeItem*> m_nodeItems;
+    QHash<quint32, PipeWireLinkItem*> m_linkItems;
+    QHash<quint32, int> m_nodeColumns;
+    QSet<quint32> m_dirtyNodes;
+    QSet<quint32> m_dirtyLinks;
+    QMultiHash<quint32, quint32> m_pendingLinks;    // by the node they wait for
+    qreal m_columnBottom[3];
+    
+    // Drag-to-link state
+    QGraphicsPathItem *m_dragPath;
+    quint32 m_dragPortId;
+    bool m_dragFromOutput;
+    QPointF m_dragAnchor;
+    QList<quint32> m_detachedLinks;
+    
+    static constexpr int FLUSH_INTERVAL_MS = 16;
+    static constexpr qreal COLUMN_WIDTH = 320.0;
+    static constexpr qreal NODE_SPACING = 16.0;
+};
+
+#endif // PIPEWIREGRAPH_H
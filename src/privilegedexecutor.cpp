@@ -4,12 +4,31 @@
 #include <QTemporaryFile>
 #include <QStandardPaths>
 #include <QDir>
+#include <QPointer>
+
+namespace {
+
+// Runs as root: one xargs job per item, each of which gets the item's
+// fields as $1... and the item command as $0 to evaluate
+const char *BATCH_SCRIPT = R"(
+slots="$1"; fields="$2"; command="$3"; shift 3
+printf '%s\0' "$@" | xargs -0 -n "$fields" -P "$slots" bash -c '
+    step() {
+        local tag="$1"; shift
+        echo "@@start $tag"
+        "$@" 2>&1 | while IFS= read -r line; do printf "%s\t%s\n" "$tag" "$line"; done
+        echo "@@status ${PIPESTATUS[0]} $tag"
+    }
+    eval "$0"
+' "$command"
+)";
+
+}
 
 QString PrivilegedExecutor::s_privilegeMethod;
 
 PrivilegedExecutor::PrivilegedExecutor(QObject *parent)
     : QObject(parent)
-    , m_currentProcess(nullptr)
     , m_isRunning(false)
     , m_nextTaskId(1)
     , m_processTimer(new QTimer(this))
@@ -19,23 +38,32 @@ PrivilegedExecutor::PrivilegedExecutor(QObject *parent)
     connect(m_processTimer, &QTimer::timeout, this, &PrivilegedExecutor::processNextTask);
 }
 
-int PrivilegedExecutor::executeCommand(const QString &command, const QStringList &args)
+QFuture<ProcessResult> PrivilegedExecutor::executeCommand(const QString &command, const QStringList &args)
 {
-    QString privilegeMethod = getPrivilegeMethod();
+    // pkexec waits for the user to authenticate, so there is no deadline
+    ProcessRequest request(command, args);
+    request.channelMode = QProcess::MergedChannels;
+    request.timeoutMs = 0;
+    return runElevated(request);
+}
+
+QFuture<ProcessResult> PrivilegedExecutor::runElevated(ProcessRequest request, const CancellationToken &token)
+{
+    const QString privilegeMethod = getPrivilegeMethod();
     if (privilegeMethod.isEmpty()) {
         qWarning() << "No privilege escalation method available";
-        return -1;
+        return ProcessRunner::failed("No privilege escalation method available");
     }
     
     QStringList fullArgs;
-    if (privilegeMethod == "pkexec") {
-        fullArgs << command << args;
-    } else if (privilegeMethod == "sudo") {
-        fullArgs << "-n" << command << args;
+    if (privilegeMethod == "sudo") {
+        fullArgs << "-n";
     }
+    fullArgs << request.program << request.arguments;
     
-    auto result = SystemUtils::runCommand(privilegeMethod, fullArgs);
-    return result.first;
+    request.program = privilegeMethod;
+    request.arguments = fullArgs;
+    return ProcessRunner::instance()->run(request, token);
 }
 
 void PrivilegedExecutor::executeCommandAsync(const QString &command, const QStringList &args,
@@ -199,9 +227,7 @@ void PrivilegedExecutor::cancelTask(int taskId)
     QMutexLocker locker(&m_taskMutex);
     
     if (m_isRunning && m_currentTask.taskId == taskId) {
-        if (m_currentProcess) {
-            m_currentProcess->kill();
-        }
+        m_currentToken.cancel();
         emit taskCancelled(taskId);
         return;
     }
@@ -220,8 +246,8 @@ void PrivilegedExecutor::cancelAllTasks()
 {
     QMutexLocker locker(&m_taskMutex);
     
-    if (m_isRunning && m_currentProcess) {
-        m_currentProcess->kill();
+    if (m_isRunning) {
+        m_currentToken.cancel();
         emit taskCancelled(m_currentTask.taskId);
     }
     
@@ -256,14 +282,12 @@ QStringList PrivilegedExecutor::getRunningTasks()
 
 bool PrivilegedExecutor::isPkexecAvailable()
 {
-    auto result = SystemUtils::runCommand("which", {"pkexec"});
-    return result.first == 0;
+    return !QStandardPaths::findExecutable("pkexec").isEmpty();
 }
 
 bool PrivilegedExecutor::isSudoAvailable()
 {
-    auto result = SystemUtils::runCommand("which", {"sudo"});
-    return result.first == 0;
+    return !QStandardPaths::findExecutable("sudo").isEmpty();
 }
 
 QString PrivilegedExecutor::getPrivilegeMethod()
@@ -281,28 +305,11 @@ QString PrivilegedExecutor::getPrivilegeMethod()
     return s_privilegeMethod;
 }
 
-void PrivilegedExecutor::onProcessStarted()
-{
-    emit taskStarted(m_currentTask.taskId, m_currentTask.description);
-}
-
-void PrivilegedExecutor::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
+void PrivilegedExecutor::readTaskOutput(const QByteArray &chunk)
 {
-    QString output = m_currentProcess->readAllStandardOutput();
-    finishCurrentTask(exitCode, output);
-}
-
-void PrivilegedExecutor::onProcessError(QProcess::ProcessError error)
-{
-    QString errorString = m_currentProcess->errorString();
-    errorCurrentTask(errorString);
-}
-
-void PrivilegedExecutor::onProcessReadyRead()
-{
-    if (!m_currentProcess) return;
+    m_currentOutput += chunk;
     
-    QString output = m_currentProcess->readAllStandardOutput();
+    QString output = QString::fromLocal8Bit(chunk);
     if (!output.isEmpty()) {
         // Emit the signal for lambda connections
         emit taskProgress(m_currentTask.taskId, output.trimmed());
@@ -357,24 +364,29 @@ void PrivilegedExecutor::startTask(const PrivilegedTask &task)
         return;
     }
     
-    m_currentProcess = new QProcess(this);
-    m_currentProcess->setProcessChannelMode(QProcess::MergedChannels);
+    m_currentToken = CancellationToken();
+    m_currentOutput.clear();
     
-    connect(m_currentProcess, &QProcess::started, this, &PrivilegedExecutor::onProcessStarted);
-    connect(m_currentProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, &PrivilegedExecutor::onProcessFinished);
-    connect(m_currentProcess, &QProcess::errorOccurred, this, &PrivilegedExecutor::onProcessError);
-    connect(m_currentProcess, &QProcess::readyReadStandardOutput, this, &PrivilegedExecutor::onProcessReadyRead);
-    
-    QStringList fullArgs;
-    if (privilegeMethod == "pkexec") {
-        fullArgs << task.command << task.args;
-    } else if (privilegeMethod == "sudo") {
-        fullArgs << "-n" << task.command << task.args;
-    }
+    // No deadline, as with executeCommand(); output goes to the task as it arrives
+    ProcessRequest request(task.command, task.args);
+    request.channelMode = QProcess::MergedChannels;
+    request.timeoutMs = 0;
+    request.launcher = ProcessRequest::QtProcess;
+    QPointer<PrivilegedExecutor> self(this);
+    request.onOutput = [self](const QByteArray &chunk) {
+        if (self) self->readTaskOutput(chunk);
+    };
     
+    emit taskStarted(task.taskId, task.description);
     m_processTimer->start();
-    m_currentProcess->start(privilegeMethod, fullArgs);
+    runElevated(request, m_currentToken).then(this, [this](const ProcessResult &result) {
+        if (!result.started) {
+            errorCurrentTask(result.errorString);
+            return;
+        }
+        finishCurrentTask(result.exitStatus == QProcess::NormalExit ? result.exitCode : -1,
+                          QString::fromLocal8Bit(m_currentOutput));
+    });
 }
 
 void PrivilegedExecutor::finishCurrentTask(int exitCode, const QString &output)
@@ -393,11 +405,6 @@ void PrivilegedExecutor::finishCurrentTask(int exitCode, const QString &output)
     
     emit taskFinished(m_currentTask.taskId, exitCode, output);
     
-    if (m_currentProcess) {
-        m_currentProcess->deleteLater();
-        m_currentProcess = nullptr;
-    }
-    
     m_isRunning = false;
     QMetaObject::invokeMethod(this, "processNextTask", Qt::QueuedConnection);
 }
@@ -413,11 +420,99 @@ void PrivilegedExecutor::errorCurrentTask(const QString &error)
     
     emit taskError(m_currentTask.taskId, error);
     
-    if (m_currentProcess) {
-        m_currentProcess->deleteLater();
-        m_currentProcess = nullptr;
-    }
-    
     m_isRunning = false;
     QMetaObject::invokeMethod(this, "processNextTask", Qt::QueuedConnection);
-} 
\ No newline at end of file
+}
+
+// PrivilegedBatch Implementation
+PrivilegedBatch::PrivilegedBatch(QObject *parent)
+    : QObject(parent)
+    , m_running(false)
+{
+}
+
+PrivilegedBatch::~PrivilegedBatch()
+{
+    cancel();
+}
+
+bool PrivilegedBatch::start(const QString &itemCommand, int fieldsPerItem, const QStringList &items, int slots)
+{
+    if (m_running || fieldsPerItem < 1 || items.size() % fieldsPerItem != 0) return false;
+    if (PrivilegedExecutor::getPrivilegeMethod().isEmpty()) {
+        qWarning() << "No privilege escalation method available";
+        return false;
+    }
+    
+    m_running = true;
+    m_buffer.clear();
+    m_token = CancellationToken();
+    
+    ProcessRequest request("bash", QStringList() << "-c" << QString::fromLatin1(BATCH_SCRIPT) << "privileged-batch"
+                                                 << QString::number(qMax(slots, 1)) << QString::number(fieldsPerItem)
+                                                 << itemCommand << items);
+    request.channelMode = QProcess::MergedChannels;
+    request.timeoutMs = 0;
+    request.launcher = ProcessRequest::QtProcess;
+    
+    // The runner may still have output in hand after we are gone
+    QPointer<PrivilegedBatch> self(this);
+    request.onOutput = [self](const QByteArray &chunk) {
+        if (self) self->readOutput(chunk);
+    };
+    
+    PrivilegedExecutor::runElevated(request, m_token).then(this, [this](const ProcessResult &result) {
+        if (!m_buffer.isEmpty()) {
+            handleLine(QString::fromUtf8(m_buffer));
+            m_buffer.clear();
+        }
+        if (!result.started) {
+            emit stepOutput(QString(), result.errorString);
+        }
+        
+        m_running = false;
+        emit finished();
+    });
+    return true;
+}
+
+void PrivilegedBatch::cancel()
+{
+    if (m_running) {
+        m_token.cancel();
+    }
+}
+
+void PrivilegedBatch::readOutput(const QByteArray &chunk)
+{
+    m_buffer += chunk;
+    
+    int newline;
+    while ((newline = m_buffer.indexOf('\n')) >= 0) {
+        handleLine(QString::fromUtf8(m_buffer.left(newline)));
+        m_buffer.remove(0, newline + 1);
+    }
+}
+
+void PrivilegedBatch::handleLine(const QString &line)
+{
+    // "@@start <tag>", "@@status <code> <tag>" or "<tag>\t<output>"
+    if (line.startsWith("@@start ")) {
+        emit stepStarted(line.mid(8));
+        return;
+    }
+    
+    if (line.startsWith("@@status ")) {
+        const int space = line.indexOf(' ', 9);
+        const bool success = line.mid(9, space - 9).toInt() == 0;
+        emit stepFinished(line.mid(space + 1), success);
+        return;
+    }
+    
+    const int tab = line.indexOf('\t');
+    if (tab > 0) {
+        emit stepOutput(line.left(tab), line.mid(tab + 1));
+    } else if (!line.isEmpty()) {
+        emit stepOutput(QString(), line);
+    }
+}
@@ -8,6 +8,8 @@
 #include <QTimer>
 #include <QMutex>
 #include <QQueue>
+#include <QFuture>
+#include "processrunner.h"
 
 struct PrivilegedTask {
     QString command;
@@ -27,8 +29,11 @@ class PrivilegedExecutor : public QObject
 public:
     explicit PrivilegedExecutor(QObject *parent = nullptr);
     
-    // Execute commands with elevated privileges
-    int executeCommand(const QString &command, const QStringList &args = QStringList());
+    // Execute commands with elevated privileges; the result arrives through the future
+    QFuture<ProcessResult> executeCommand(const QString &command, const QStringList &args = QStringList());
+    // Runs the request's program through pkexec or sudo, otherwise as requested
+    static QFuture<ProcessResult> runElevated(ProcessRequest request,
+                                              const CancellationToken &token = CancellationToken());
     void executeCommandAsync(const QString &command, const QStringList &args,
                            const QString &description, QObject *receiver,
                            const char* successSlot, const char* errorSlot,
@@ -86,21 +91,19 @@ signals:
     void taskCancelled(int taskId);
 
 private slots:
-    void onProcessStarted();
-    void onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
-    void onProcessError(QProcess::ProcessError error);
-    void onProcessReadyRead();
     void processNextTask();
 
 private:
     void enqueueTask(const PrivilegedTask &task);
     QString buildCommand(const QString &command, const QStringList &args);
     void startTask(const PrivilegedTask &task);
+    void readTaskOutput(const QByteArray &chunk);
     void finishCurrentTask(int exitCode, const QString &output);
     void errorCurrentTask(const QString &error);
     
     QQueue<PrivilegedTask> m_taskQueue;
-    QProcess *m_currentProcess;
+    CancellationToken m_currentToken;
+    QByteArray m_currentOutput;
     PrivilegedTask m_currentTask;
     bool m_isRunning;
     int m_nextTaskId;
@@ -110,4 +113,37 @@ private:
     static QString s_privilegeMethod;
 };
 
+// Runs one step per item as root, several items at a time, under a single
+// privileged helper so there is only one password prompt. The item command
+// is a bash snippet that sees the item's fields as $1, $2, ... and runs its
+// work as "step <tag> <command...>"; each step is reported when it starts
+// and finishes, and every line it prints is tagged with it.
+class PrivilegedBatch : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PrivilegedBatch(QObject *parent = nullptr);
+    ~PrivilegedBatch();
+    
+    bool start(const QString &itemCommand, int fieldsPerItem, const QStringList &items, int slots);
+    // The helper runs as root, so this only works where we may signal it (sudo)
+    void cancel();
+    bool isRunning() const { return m_running; }
+
+signals:
+    void stepStarted(const QString &tag);
+    void stepOutput(const QString &tag, const QString &line);   // an empty tag is pkexec, sudo or xargs itself
+    void stepFinished(const QString &tag, bool success);
+    void finished();
+
+private:
+    void readOutput(const QByteArray &chunk);
+    void handleLine(const QString &line);
+    
+    bool m_running;
+    QByteArray m_buffer;
+    CancellationToken m_token;
+};
+
 #endif // PRIVILEGEDEXECUTOR_H 
\ No newline at end of file
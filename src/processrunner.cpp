@@ -0,0 +1,670 @@
+#include "processrunner.h"
+#include "tracing.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QTimer>
+#include <QMetaObject>
+#include <QSocketNotifier>
+#include <QFile>
+#include <QVector>
+#include <QDebug>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+namespace {
+
+// Pipes hold 64 KiB by default; past the reserved buffer, reads grow by that much
+const int PIPE_CHUNK = 64 * 1024;
+
+// How often a spawned child is polled for its exit when there is no pidfd to watch
+const int REAP_POLL_MS = 10;
+
+// How long a cancelled process has to exit after SIGTERM before it is killed
+const int CANCEL_GRACE_MS = 3000;
+
+int openPidFd(pid_t pid)
+{
+#ifdef SYS_pidfd_open
+    return int(::syscall(SYS_pidfd_open, pid, 0));
+#else
+    Q_UNUSED(pid);
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+// Stops watching a descriptor before it is closed, so its number can be reused safely
+void unwatch(QObject *handle, int fd)
+{
+    for (QSocketNotifier *notifier : handle->findChildren<QSocketNotifier *>()) {
+        if (fd < 0 || notifier->socket() == fd) {
+            notifier->setEnabled(false);
+        }
+    }
+}
+
+void closeFd(int &fd)
+{
+    if (fd < 0) return;
+    ::close(fd);
+    fd = -1;
+}
+
+}
+
+// CancellationToken Implementation
+CancellationToken::CancellationToken()
+    : m_state(std::make_shared<State>())
+{
+}
+
+void CancellationToken::cancel()
+{
+    if (m_state->cancelled.exchange(true)) return;
+    
+    std::shared_ptr<State> state = m_state;
+    ProcessRunner *runner = ProcessRunner::instance();
+    QMetaObject::invokeMethod(runner, [runner, state]() {
+        runner->cancelJobs(state);
+    }, Qt::QueuedConnection);
+}
+
+bool CancellationToken::isCancelled() const
+{
+    return m_state->cancelled.load();
+}
+
+// ProcessRunner Implementation
+ProcessRunner *ProcessRunner::instance()
+{
+    static ProcessRunner runner;
+    return &runner;
+}
+
+ProcessRunner::ProcessRunner(QObject *parent)
+    : QObject(parent)
+    , m_maxConcurrent(qMax(4, QThread::idealThreadCount()))
+    , m_unpooled(0)
+{
+    // Processes are started and reaped by the GUI thread's event loop, whoever asks first
+    if (QCoreApplication::instance()) {
+        moveToThread(QCoreApplication::instance()->thread());
+    }
+}
+
+QFuture<ProcessResult> ProcessRunner::run(const ProcessRequest &request, const CancellationToken &token)
+{
+    Job job;
+    job.request = request;
+    job.token = token;
+    job.promise = std::make_shared<QPromise<ProcessResult>>();
+    job.promise->start();
+    job.queuedAtUs = Trace::now();
+    QFuture<ProcessResult> future = job.promise->future();
+    
+    if (QThread::currentThread() == thread()) {
+        enqueue(job);
+    } else {
+        QMetaObject::invokeMethod(this, [this, job]() {
+            enqueue(job);
+        }, Qt::QueuedConnection);
+    }
+    return future;
+}
+
+QFuture<ProcessResult> ProcessRunner::run(const QString &program, const QStringList &arguments, int timeoutMs)
+{
+    ProcessRequest request(program, arguments);
+    request.timeoutMs = timeoutMs;
+    return run(request);
+}
+
+QFuture<ProcessResult> ProcessRunner::failed(const QString &error)
+{
+    ProcessResult result;
+    result.errorString = error;
+    
+    QPromise<ProcessResult> promise;
+    promise.start();
+    promise.addResult(result);
+    promise.finish();
+    return promise.future();
+}
+
+void ProcessRunner::setMaxConcurrent(int count)
+{
+    m_maxConcurrent = qMax(1, count);
+    startNext();
+}
+
+void ProcessRunner::enqueue(const Job &job)
+{
+    if (!job.request.pooled && !job.token.isCancelled()) {
+        launch(job);
+        return;
+    }
+    m_queue.enqueue(job);
+    startNext();
+}
+
+void ProcessRunner::startNext()
+{
+    while (m_running.size() - m_unpooled < m_maxConcurrent && !m_queue.isEmpty()) {
+        Job job = m_queue.dequeue();
+        if (job.token.isCancelled()) {
+            job.result.cancelled = true;
+            job.result.errorString = "Cancelled before it started";
+            job.promise->addResult(job.result);
+            job.promise->finish();
+            continue;
+        }
+        launch(job);
+    }
+}
+
+void ProcessRunner::launch(Job job)
+{
+    if (job.request.launcher != ProcessRequest::QtProcess && canSpawn(job.request)) {
+        launchSpawned(job);
+        return;
+    }
+    
+    QElapsedTimer launchClock;
+    launchClock.start();
+    
+    QProcess *process = new QProcess(this);
+    job.process = process;
+    process->setProcessChannelMode(job.request.channelMode);
+    if (!job.request.workingDirectory.isEmpty()) {
+        process->setWorkingDirectory(job.request.workingDirectory);
+    }
+    job.result.standardOutput.reserve(job.request.expectedOutputSize);
+    
+    connect(process, &QProcess::started, this, [this, process]() {
+        auto it = m_running.find(process);
+        if (it != m_running.end()) it->result.started = true;
+    });
+    connect(process, &QProcess::readyReadStandardOutput, this, [this, process]() {
+        readOutput(process);
+    });
+    connect(process, &QProcess::readyReadStandardError, this, [this, process]() {
+        auto it = m_running.find(process);
+        if (it != m_running.end()) it->result.standardError += process->readAllStandardError();
+    });
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, [this, process](int, QProcess::ExitStatus) {
+        finish(process);
+    });
+    connect(process, &QProcess::errorOccurred, this, [this, process](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) finish(process);
+    });
+    
+    if (job.request.timeoutMs > 0) {
+        QTimer *timer = new QTimer(process);
+        timer->setSingleShot(true);
+        connect(timer, &QTimer::timeout, this, [this, process]() {
+            auto it = m_running.find(process);
+            if (it == m_running.end()) return;
+            it->result.timedOut = true;
+            killJob(*it);
+        });
+        timer->start(job.request.timeoutMs);
+    }
+    
+    job.clock.start();
+    job.startedAtUs = Trace::now();
+    const QByteArray input = job.request.standardInput;
+    m_running.insert(process, job);
+    if (!job.request.pooled) ++m_unpooled;
+    process->start(job.request.program, job.request.arguments);
+    
+    // Nothing to say means end of input, so nothing sits waiting on stdin
+    if (!input.isEmpty()) process->write(input);
+    process->closeWriteChannel();
+    
+    const qint64 launchNs = launchClock.nsecsElapsed();
+    auto it = m_running.find(process);
+    if (it != m_running.end()) it->result.launchNs = launchNs;
+    recordLaunch(ProcessRequest::QtProcess, launchNs);
+}
+
+void ProcessRunner::launchSpawned(Job job)
+{
+    QElapsedTimer launchClock;
+    launchClock.start();
+    job.clock.start();
+    job.startedAtUs = Trace::now();
+    job.result.standardOutput.reserve(job.request.expectedOutputSize);
+    
+    const bool merged = job.request.channelMode == QProcess::MergedChannels;
+    int outPipe[2] = { -1, -1 };
+    int errPipe[2] = { -1, -1 };
+    int error = 0;
+    if (::pipe2(outPipe, O_CLOEXEC) != 0 || (!merged && ::pipe2(errPipe, O_CLOEXEC) != 0)) {
+        error = errno;
+    }
+    
+    pid_t pid = -1;
+    if (error == 0) {
+        // dup2 clears close-on-exec on the copies it makes, so the child
+        // inherits its three standard descriptors and nothing else of ours
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+        posix_spawn_file_actions_adddup2(&actions, outPipe[1], STDOUT_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, merged ? outPipe[1] : errPipe[1], STDERR_FILENO);
+        
+        // Same clean slate QProcess gives its children: nothing blocked, SIGPIPE not ignored
+        posix_spawnattr_t attributes;
+        posix_spawnattr_init(&attributes);
+        sigset_t signals;
+        sigemptyset(&signals);
+        posix_spawnattr_setsigmask(&attributes, &signals);
+        sigaddset(&signals, SIGPIPE);
+        posix_spawnattr_setsigdefault(&attributes, &signals);
+        posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+        
+        QList<QByteArray> arguments;
+        arguments.reserve(job.request.arguments.size() + 1);
+        arguments << QFile::encodeName(job.request.program);
+        for (const QString &argument : std::as_const(job.request.arguments)) {
+            arguments << argument.toLocal8Bit();
+        }
+        QVector<char *> argv;
+        argv.reserve(arguments.size() + 1);
+        for (QByteArray &argument : arguments) {
+            argv << argument.data();
+        }
+        argv << nullptr;
+        
+        // glibc vforks here and reports a failed exec as the return value
+        error = ::posix_spawnp(&pid, argv.first(), &actions, &attributes, argv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        posix_spawnattr_destroy(&attributes);
+    }
+    closeFd(outPipe[1]);
+    closeFd(errPipe[1]);
+    
+    if (error != 0) {
+        closeFd(outPipe[0]);
+        closeFd(errPipe[0]);
+        job.result.launchNs = launchClock.nsecsElapsed();
+        job.result.elapsedMs = job.clock.elapsed();
+        job.result.errorString = QString("Could not start %1: %2")
+            .arg(job.request.program, QString::fromLocal8Bit(std::strerror(error)));
+        recordLaunch(ProcessRequest::Spawn, job.result.launchNs);
+        traceJob(job);
+        job.promise->addResult(job.result);
+        job.promise->finish();
+        return;
+    }
+    
+    job.result.started = true;
+    job.pid = pid;
+    job.pidFd = openPidFd(pid);
+    job.stdoutFd = outPipe[0];
+    job.stderrFd = errPipe[0];
+    
+    // Stands in for the QProcess: owns the notifiers and timer, keys the job
+    QObject *handle = new QObject(this);
+    for (int fd : { job.stdoutFd, job.stderrFd }) {
+        if (fd < 0) continue;
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        QSocketNotifier *notifier = new QSocketNotifier(fd, QSocketNotifier::Read, handle);
+        connect(notifier, &QSocketNotifier::activated, this, [this, handle, fd]() {
+            readSpawned(handle, fd);
+        });
+    }
+    if (job.pidFd >= 0) {
+        // Readable once the child has exited
+        QSocketNotifier *notifier = new QSocketNotifier(job.pidFd, QSocketNotifier::Read, handle);
+        connect(notifier, &QSocketNotifier::activated, this, [this, handle]() {
+            reapSpawned(handle);
+        });
+    }
+    
+    if (job.request.timeoutMs > 0) {
+        QTimer *timer = new QTimer(handle);
+        timer->setSingleShot(true);
+        connect(timer, &QTimer::timeout, this, [this, handle]() {
+            auto it = m_running.find(handle);
+            if (it == m_running.end()) return;
+            it->result.timedOut = true;
+            killJob(*it);
+        });
+        timer->start(job.request.timeoutMs);
+    }
+    
+    job.result.launchNs = launchClock.nsecsElapsed();
+    recordLaunch(ProcessRequest::Spawn, job.result.launchNs);
+    m_running.insert(handle, job);
+    if (!job.request.pooled) ++m_unpooled;
+}
+
+void ProcessRunner::readOutput(QObject *handle)
+{
+    auto it = m_running.find(handle);
+    if (it == m_running.end()) return;
+    
+    QProcess *process = it->process;
+    if (!process) {
+        readSpawned(handle, it->stdoutFd);
+        readSpawned(handle, it->stderrFd);
+        return;
+    }
+    
+    // Read straight into the reserved buffer instead of through a temporary
+    QByteArray &output = it->result.standardOutput;
+    const qint64 available = process->bytesAvailable();
+    if (available <= 0) return;
+    
+    const int offset = output.size();
+    output.resize(offset + int(available));
+    const qint64 read = process->read(output.data() + offset, available);
+    output.resize(offset + int(qMax<qint64>(read, 0)));
+    
+    if (it->request.onOutput && output.size() > offset) {
+        const QByteArray chunk = output.mid(offset);
+        output.truncate(offset);
+        it->request.onOutput(chunk);
+    }
+}
+
+void ProcessRunner::readSpawned(QObject *handle, int fd)
+{
+    auto it = m_running.find(handle);
+    if (it == m_running.end() || fd < 0) return;
+    
+    const bool isStdout = fd == it->stdoutFd;
+    QByteArray &buffer = isStdout ? it->result.standardOutput : it->result.standardError;
+    const int offset = buffer.size();
+    bool atEnd = false;
+    
+    for (;;) {
+        // Fill the reserved capacity first, then grow a pipe's worth at a time
+        const int size = buffer.size();
+        const int room = qMax(int(buffer.capacity()) - size, PIPE_CHUNK);
+        buffer.resize(size + room);
+        const ssize_t count = ::read(fd, buffer.data() + size, size_t(room));
+        buffer.resize(size + int(qMax<ssize_t>(count, 0)));
+        
+        if (count > 0) continue;
+        if (count < 0 && errno == EINTR) continue;
+        atEnd = count == 0 || errno != EAGAIN;
+        break;
+    }
+    
+    if (isStdout && it->request.onOutput && buffer.size() > offset) {
+        const QByteArray chunk = buffer.mid(offset);
+        buffer.truncate(offset);
+        it->request.onOutput(chunk);
+        
+        // The callback may have started another process and moved the job
+        it = m_running.find(handle);
+        if (it == m_running.end()) return;
+    }
+    
+    if (atEnd) {
+        unwatch(handle, fd);
+        closeFd(isStdout ? it->stdoutFd : it->stderrFd);
+        
+        // Without a pidfd, the end of output is the cue to look for the exit
+        if (it->pidFd < 0 && it->stdoutFd < 0 && it->stderrFd < 0) {
+            reapSpawned(handle);
+        }
+    }
+}
+
+void ProcessRunner::reapSpawned(QObject *handle)
+{
+    auto it = m_running.find(handle);
+    if (it == m_running.end() || it->exited) return;
+    
+    int status = 0;
+    const pid_t reaped = ::waitpid(it->pid, &status, WNOHANG);
+    if (reaped == 0) {
+        if (it->pidFd < 0) {
+            QTimer::singleShot(REAP_POLL_MS, handle, [this, handle]() {
+                reapSpawned(handle);
+            });
+        }
+        return;
+    }
+    
+    it->exited = true;
+    if (reaped == it->pid) {
+        it->waitStatus = status;
+    } else {
+        // Reaped by someone else; the exit code is gone with it
+        it->result.exitStatus = QProcess::CrashExit;
+    }
+    finish(handle);
+}
+
+void ProcessRunner::finish(QObject *handle)
+{
+    if (!m_running.contains(handle)) return;
+    readOutput(handle);
+    Job job = m_running.take(handle);
+    if (!job.request.pooled) --m_unpooled;
+    
+    ProcessResult &result = job.result;
+    result.elapsedMs = job.clock.elapsed();
+    QString failure;
+    if (QProcess *process = job.process) {
+        result.standardError += process->readAllStandardError();
+        if (result.started) {
+            result.exitCode = process->exitCode();
+            result.exitStatus = process->exitStatus();
+        }
+        failure = process->errorString();
+        
+        process->disconnect(this);
+        process->deleteLater();
+    } else {
+        if (result.exitStatus == QProcess::CrashExit) {
+            failure = "The process was reaped elsewhere";
+        } else if (WIFEXITED(job.waitStatus)) {
+            result.exitCode = WEXITSTATUS(job.waitStatus);
+        } else {
+            result.exitStatus = QProcess::CrashExit;
+            if (WIFSIGNALED(job.waitStatus)) {
+                result.exitCode = WTERMSIG(job.waitStatus);
+                failure = QString("Killed by signal %1").arg(result.exitCode);
+            }
+        }
+        
+        // Output a grandchild still holds open is not waited for, as with QProcess
+        unwatch(handle, -1);
+        closeFd(job.stdoutFd);
+        closeFd(job.stderrFd);
+        closeFd(job.pidFd);
+        handle->deleteLater();
+    }
+    
+    if (result.cancelled) {
+        result.errorString = "Cancelled";
+    } else if (result.timedOut) {
+        result.errorString = QString("Timed out after %1 ms").arg(job.request.timeoutMs);
+    } else if (!result.started || result.exitStatus != QProcess::NormalExit) {
+        result.errorString = failure;
+    }
+    
+    traceJob(job);
+    job.promise->addResult(result);
+    job.promise->finish();
+    startNext();
+}
+
+void ProcessRunner::killJob(Job &job)
+{
+    if (job.process) {
+        job.process->kill();
+    } else if (job.pid > 0 && !job.exited) {
+        ::kill(job.pid, SIGKILL);
+    }
+}
+
+void ProcessRunner::traceJob(const Job &job)
+{
+    if (!Trace::isEnabled()) return;
+    
+    const ProcessResult &result = job.result;
+    const QString name = QString("%1 %2").arg(job.request.program, job.request.arguments.value(0)).trimmed();
+    QJsonObject args{
+        { "command", (QStringList(job.request.program) + job.request.arguments).join(' ') },
+        { "launcher", job.process ? "QProcess" : "posix_spawn" },
+        { "queuedUs", job.startedAtUs - job.queuedAtUs },
+        { "launchUs", result.launchNs / 1000 },
+        { "exitCode", result.exitCode },
+        { "outputBytes", qint64(result.standardOutput.size()) },
+    };
+    if (!result.errorString.isEmpty()) args.insert("error", result.errorString);
+    Trace::async(name, "process", job.startedAtUs, Trace::now() - job.startedAtUs, args);
+}
+
+bool ProcessRunner::canSpawn(const ProcessRequest &request)
+{
+    // Input, a working directory or forwarded channels are what QProcess is for
+    return request.standardInput.isEmpty()
+        && request.workingDirectory.isEmpty()
+        && (request.channelMode == QProcess::SeparateChannels
+            || request.channelMode == QProcess::MergedChannels);
+}
+
+void ProcessRunner::recordLaunch(ProcessRequest::Launcher launcher, qint64 ns)
+{
+    LaunchStats &stats = m_launchStats[launcher];
+    ++stats.launches;
+    stats.totalNs += ns;
+    stats.maxNs = qMax(stats.maxNs, ns);
+}
+
+ProcessRunner::LaunchStats ProcessRunner::launchStats(ProcessRequest::Launcher launcher) const
+{
+    return m_launchStats.value(launcher);
+}
+
+struct ProcessRunner::Benchmark {
+    ProcessRequest request;
+    int iterations = 0;
+    int round = 0;              // 0 for posix_spawn, 1 for QProcess, 2 when done
+    int done = 0;
+    QElapsedTimer clock;
+    qint64 launchNs[2] = { 0, 0 };
+    qint64 maxLaunchNs[2] = { 0, 0 };
+    qint64 roundTripNs[2] = { 0, 0 };
+    int failed[2] = { 0, 0 };
+    QPromise<QString> promise;
+};
+
+QFuture<QString> ProcessRunner::benchmark(const ProcessRequest &request, int iterations)
+{
+    auto bench = std::make_shared<Benchmark>();
+    bench->request = request;
+    bench->iterations = qMax(1, iterations);
+    bench->promise.start();
+    QFuture<QString> future = bench->promise.future();
+    
+    QMetaObject::invokeMethod(this, [this, bench]() {
+        runBenchmark(bench);
+    }, Qt::QueuedConnection);
+    return future;
+}
+
+void ProcessRunner::runBenchmark(const std::shared_ptr<Benchmark> &bench)
+{
+    if (bench->round < 2) {
+        // One at a time, so neither launcher competes with the other for the CPU
+        ProcessRequest request = bench->request;
+        request.launcher = bench->round == 0 ? ProcessRequest::Spawn : ProcessRequest::QtProcess;
+        bench->clock.start();
+        run(request).then(this, [this, bench](const ProcessResult &result) {
+            const int round = bench->round;
+            bench->roundTripNs[round] += bench->clock.nsecsElapsed();
+            bench->launchNs[round] += result.launchNs;
+            bench->maxLaunchNs[round] = qMax(bench->maxLaunchNs[round], result.launchNs);
+            if (!result.success()) ++bench->failed[round];
+            
+            if (++bench->done == bench->iterations) {
+                bench->done = 0;
+                ++bench->round;
+            }
+            runBenchmark(bench);
+        });
+        return;
+    }
+    
+    const double runs = bench->iterations;
+    QString report = QString("%1 run %2 times with each launcher\n")
+        .arg((QStringList(bench->request.program) + bench->request.arguments).join(' ')).arg(bench->iterations);
+    const char *names[2] = { "posix_spawn", "QProcess" };
+    for (int i = 0; i < 2; ++i) {
+        report += QString("%1 launch %2 us avg, %3 us max; round trip %4 us avg; %5 failed\n")
+            .arg(QString(names[i]) + ":", -13)
+            .arg(bench->launchNs[i] / 1000.0 / runs, 0, 'f', 1)
+            .arg(bench->maxLaunchNs[i] / 1000.0, 0, 'f', 1)
+            .arg(bench->roundTripNs[i] / 1000.0 / runs, 0, 'f', 1)
+            .arg(bench->failed[i]);
+    }
+    
+    const double saved = (bench->launchNs[1] - bench->launchNs[0]) / 1000.0 / runs;
+    report += QString("posix_spawn saves %1 us per launch (%2x)")
+        .arg(saved, 0, 'f', 1)
+        .arg(bench->launchNs[0] > 0 ? double(bench->launchNs[1]) / bench->launchNs[0] : 0.0, 0, 'f', 2);
+    
+    bench->promise.addResult(report);
+    bench->promise.finish();
+}
+
+void ProcessRunner::cancelJobs(const std::shared_ptr<CancellationToken::State> &state)
+{
+    for (auto it = m_queue.begin(); it != m_queue.end();) {
+        if (it->token.m_state != state) {
+            ++it;
+            continue;
+        }
+        it->result.cancelled = true;
+        it->result.errorString = "Cancelled before it started";
+        it->promise->addResult(it->result);
+        it->promise->finish();
+        it = m_queue.erase(it);
+    }
+    
+    for (auto it = m_running.begin(); it != m_running.end(); ++it) {
+        if (it->token.m_state != state) continue;
+        it->result.cancelled = true;
+        
+        // A chance to clean up first; sudo also passes SIGTERM on to what it runs
+        if (it->process) {
+            terminate(it->process, CANCEL_GRACE_MS);
+        } else if (it->pid > 0 && !it->exited) {
+            ::kill(it->pid, SIGTERM);
+            QObject *handle = it.key();
+            QTimer::singleShot(CANCEL_GRACE_MS, handle, [this, handle]() {
+                auto job = m_running.find(handle);
+                if (job != m_running.end()) killJob(*job);
+            });
+        }
+    }
+}
+
+void ProcessRunner::terminate(QProcess *process, int graceMs)
+{
+    if (!process || process->state() == QProcess::NotRunning) return;
+    
+    process->terminate();
+    QTimer::singleShot(graceMs, process, [process]() {
+        if (process->state() != QProcess::NotRunning) {
+            process->kill();
+        }
+    });
+}
@@ -0,0 +1,170 @@
+#ifndef PROCESSRUNNER_H
+#define PROCESSRUNNER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QProcess>
+#include <QFuture>
+#include <QPromise>
+#include <QQueue>
+#include <QHash>
+#include <QElapsedTimer>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+struct ProcessResult {
+    int exitCode = -1;
+    QProcess::ExitStatus exitStatus = QProcess::NormalExit;
+    QByteArray standardOutput;
+    QByteArray standardError;
+    bool started = false;
+    bool timedOut = false;
+    bool cancelled = false;
+    QString errorString;
+    qint64 elapsedMs = 0;
+    qint64 launchNs = 0;        // time the runner's thread spent starting the child
+    
+    bool success() const { return started && !timedOut && !cancelled && exitStatus == QProcess::NormalExit && exitCode == 0; }
+    QString output() const { return QString::fromLocal8Bit(standardOutput); }
+};
+
+struct ProcessRequest {
+    // Spawn: posix_spawn() with bare pipes, for commands that take no input.
+    // QtProcess: a full QProcess. Auto picks Spawn whenever the request allows it.
+    enum Launcher { Auto, Spawn, QtProcess };
+    
+    ProcessRequest(const QString &program = QString(), const QStringList &arguments = QStringList())
+        : program(program), arguments(arguments) {}
+    
+    QString program;
+    QStringList arguments;
+    int timeoutMs = 30000;                  // 0 waits for as long as it takes
+    int expectedOutputSize = 16 * 1024;     // reserved up front, so output rarely reallocates
+    QProcess::ProcessChannelMode channelMode = QProcess::SeparateChannels;
+    QString workingDirectory;
+    QByteArray standardInput;
+    // Each chunk of standard output as it arrives, on the runner's thread. It
+    // is handed over instead of collected, so result.standardOutput stays
+    // empty and a long-lived process does not pile up its whole output.
+    std::function<void(const QByteArray &)> onOutput;
+    Launcher launcher = Auto;
+    // Monitors that run for as long as they are wanted start at once and do
+    // not count against maxConcurrent(), so they never hold up short commands
+    bool pooled = true;
+};
+
+// Handed to ProcessRunner::run(); cancel() asks the process to terminate and
+// kills it if it is still there a few seconds later, or drops it if it is
+// still waiting for a slot. Copies share the same state.
+class CancellationToken
+{
+public:
+    CancellationToken();
+    
+    void cancel();
+    bool isCancelled() const;
+
+private:
+    friend class ProcessRunner;
+    struct State {
+        std::atomic<bool> cancelled{false};
+    };
+    std::shared_ptr<State> m_state;
+};
+
+// Runs child processes without ever waiting on them: each run() returns a
+// future that is fulfilled from the event loop, so callers attach a
+// continuation with QFuture::then(context, ...). At most maxConcurrent()
+// pooled processes run at once, the rest queue in order. Worker threads may block
+// on the future; the GUI thread must not.
+//
+// Short helpers that need no input are started with posix_spawn(), which
+// vforks, and are watched through their pipes and a pidfd instead of a
+// QProcess with its notifiers and startup handshake.
+class ProcessRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    static ProcessRunner *instance();
+    
+    QFuture<ProcessResult> run(const ProcessRequest &request, const CancellationToken &token = CancellationToken());
+    QFuture<ProcessResult> run(const QString &program, const QStringList &arguments, int timeoutMs = 30000);
+    // An already finished future for a process that could not even be attempted
+    static QFuture<ProcessResult> failed(const QString &error);
+    
+    // Asks a process to terminate and kills it if it is still there after graceMs
+    static void terminate(QProcess *process, int graceMs = 3000);
+    
+    void setMaxConcurrent(int count);
+    int maxConcurrent() const { return m_maxConcurrent; }
+    int runningCount() const { return m_running.size(); }
+    int queuedCount() const { return m_queue.size(); }
+    
+    // What starting a child has cost so far, per launcher
+    struct LaunchStats {
+        int launches = 0;
+        qint64 totalNs = 0;
+        qint64 maxNs = 0;
+        
+        double averageUs() const { return launches > 0 ? totalNs / 1000.0 / launches : 0.0; }
+    };
+    LaunchStats launchStats(ProcessRequest::Launcher launcher) const;
+    
+    // Runs the request `iterations` times in a row with each launcher and
+    // reports their launch and round-trip times side by side
+    QFuture<QString> benchmark(const ProcessRequest &request, int iterations);
+
+private:
+    explicit ProcessRunner(QObject *parent = nullptr);
+    
+    struct Job {
+        ProcessRequest request;
+        CancellationToken token;
+        std::shared_ptr<QPromise<ProcessResult>> promise;
+        ProcessResult result;
+        QElapsedTimer clock;
+        qint64 queuedAtUs = 0;      // on the trace clock
+        qint64 startedAtUs = 0;
+        
+        // A QProcess launch
+        QProcess *process = nullptr;
+        
+        // A posix_spawn launch, done once the child has been reaped
+        int pid = -1;
+        int pidFd = -1;
+        int stdoutFd = -1;
+        int stderrFd = -1;
+        bool exited = false;
+        int waitStatus = 0;
+    };
+    struct Benchmark;
+    
+    void enqueue(const Job &job);
+    void startNext();
+    void launch(Job job);
+    void launchSpawned(Job job);
+    void readOutput(QObject *handle);
+    void readSpawned(QObject *handle, int fd);
+    void reapSpawned(QObject *handle);
+    void finish(QObject *handle);
+    void killJob(Job &job);
+    void recordLaunch(ProcessRequest::Launcher launcher, qint64 ns);
+    static void traceJob(const Job &job);
+    void runBenchmark(const std::shared_ptr<Benchmark> &bench);
+    void cancelJobs(const std::shared_ptr<CancellationToken::State> &state);
+    static bool canSpawn(const ProcessRequest &request);
+    
+    QQueue<Job> m_queue;
+    QHash<QObject *, Job> m_running;    // keyed by the QProcess, or a stand-in object for a spawned child
+    QHash<int, LaunchStats> m_launchStats;
+    int m_maxConcurrent;
+    int m_unpooled;                     // running jobs that do not take a slot
+    
+    friend class CancellationToken;
+};
+
+#endif // PROCESSRUNNER_H
@@ -0,0 +1,411 @@
+#include "realtimediagnostics.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QMutexLocker>
+#include <sys/resource.h>
+#include <pwd.h>
+#include <unistd.h>
+#include <sched.h>
+#include <algorithm>
+
+namespace {
+
+// Priority PipeWire's module-rt asks for by default
+const int PIPEWIRE_RT_PRIORITY = 88;
+
+QString policyName(int policy)
+{
+    switch (policy) {
+    case SCHED_FIFO: return "SCHED_FIFO";
+    case SCHED_RR: return "SCHED_RR";
+    case SCHED_BATCH: return "SCHED_BATCH";
+    case SCHED_IDLE: return "SCHED_IDLE";
+    default: return "SCHED_OTHER";
+    }
+}
+
+bool isRealtimePolicy(int policy)
+{
+    return policy == SCHED_FIFO || policy == SCHED_RR;
+}
+
+// The login name of the real user; $USER is whatever the environment says
+QString currentUserName()
+{
+    const struct passwd *pw = getpwuid(getuid());
+    return pw ? QString::fromLocal8Bit(pw->pw_name) : QString();
+}
+
+// Single-quotes a value for sh, so it stays one word whatever it contains
+QString shellQuote(const QString &value)
+{
+    QString quoted = value;
+    quoted.replace('\'', "'\\''");
+    return '\'' + quoted + '\'';
+}
+
+}
+
+RealtimeDiagnostics::RealtimeDiagnostics(QObject *parent)
+    : QThread(parent)
+{
+}
+
+QList<RealtimeFinding> RealtimeDiagnostics::findings() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_findings;
+}
+
+QString RealtimeDiagnostics::severityName(RealtimeFinding::Severity severity)
+{
+    switch (severity) {
+    case RealtimeFinding::Ok: return "OK";
+    case RealtimeFinding::Info: return "Info";
+    case RealtimeFinding::Warning: return "Warning";
+    case RealtimeFinding::Critical: return "Critical";
+    }
+    return QString();
+}
+
+void RealtimeDiagnostics::run()
+{
+    QList<RealtimeFinding> findings;
+    const int pipeWirePid = findProcess("pipewire");
+    int dataLoopPriority = 0;
+    
+    checkRtLimits(pipeWirePid, findings);
+    checkRtkit(findings);
+    checkDataLoop(pipeWirePid, findings, &dataLoopPriority);
+    checkGovernor(findings);
+    checkIrqThreads(dataLoopPriority, findings);
+    checkKernel(findings);
+    
+    // Most severe first
+    std::stable_sort(findings.begin(), findings.end(), [](const RealtimeFinding &a, const RealtimeFinding &b) {
+        return a.severity > b.severity;
+    });
+    
+    QMutexLocker locker(&m_mutex);
+    m_findings = findings;
+}
+
+void RealtimeDiagnostics::checkRtLimits(int pipeWirePid, QList<RealtimeFinding> &findings)
+{
+    RealtimeFinding finding;
+    finding.title = "Real-time priority limit";
+    
+    // The daemon's own limits matter; fall back to ours (same login session)
+    qint64 limit = -1;
+    if (pipeWirePid > 0) {
+        const QList<QByteArray> lines = readProcFile(QString("/proc/%1/limits").arg(pipeWirePid)).split('\n');
+        for (const QByteArray &line : lines) {
+            if (line.startsWith("Max realtime priority")) {
+                const QList<QByteArray> fields = line.mid(21).simplified().split(' ');
+                limit = fields.value(0) == "unlimited" ? 99 : fields.value(0).toLongLong();
+                break;
+            }
+        }
+    }
+    if (limit < 0) {
+        struct rlimit rl;
+        if (getrlimit(RLIMIT_RTPRIO, &rl) == 0) {
+            limit = rl.rlim_cur == RLIM_INFINITY ? 99 : qint64(rl.rlim_cur);
+        }
+    }
+    
+    const QString group = realtimeGroup();
+    const QString user = currentUserName();
+    if (limit >= PIPEWIRE_RT_PRIORITY) {
+        finding.severity = RealtimeFinding::Ok;
+        finding.detail = QString("RLIMIT_RTPRIO is %1, PipeWire can raise its own threads to priority %2.")
+                         .arg(limit).arg(PIPEWIRE_RT_PRIORITY);
+    } else {
+        finding.severity = limit > 0 ? RealtimeFinding::Warning : RealtimeFinding::Info;
+        finding.detail = QString("RLIMIT_RTPRIO is %1, so PipeWire depends on rtkit for real-time scheduling.")
+                         .arg(qMax<qint64>(limit, 0));
+        finding.fixDescription = QString("Allow the '%1' group real-time priority 95 and add %2 to it (takes effect at next login)")
+                                 .arg(group, user);
+        finding.fixScript = QString("printf '@%1 - rtprio 95\\n@%1 - nice -19\\n@%1 - memlock 4194304\\n' "
+                                    "> /etc/security/limits.d/95-oreon-audio.conf")
+                            .arg(group);
+        if (!user.isEmpty()) {
+            finding.fixScript += QString(" && usermod -aG %1 %2").arg(group, shellQuote(user));
+        }
+    }
+    findings << finding;
+}
+
+void RealtimeDiagnostics::checkRtkit(QList<RealtimeFinding> &findings)
+{
+    RealtimeFinding finding;
+    finding.title = "rtkit";
+    
+    if (findProcess("rtkit-daemon") > 0) {
+        finding.severity = RealtimeFinding::Ok;
+        finding.detail = "rtkit-daemon is running and can grant real-time priority on request.";
+    } else if (QFileInfo::exists("/usr/libexec/rtkit-daemon") || QFileInfo::exists("/usr/lib/rtkit/rtkit-daemon")) {
+        finding.severity = RealtimeFinding::Warning;
+        finding.detail = "rtkit is installed but not running.";
+        finding.fixDescription = "Enable and start rtkit-daemon";
+        finding.fixScript = "systemctl enable --now rtkit-daemon.service";
+    } else {
+        finding.severity = RealtimeFinding::Warning;
+        finding.detail = "rtkit is not installed; without it or an RT rlimit PipeWire runs with normal priority.";
+        finding.fixDescription = "Install and start rtkit";
+        finding.fixScript = "dnf install -y rtkit && systemctl enable --now rtkit-daemon.service";
+    }
+    findings << finding;
+}
+
+void RealtimeDiagnostics::checkDataLoop(int pipeWirePid, QList<RealtimeFinding> &findings, int *dataLoopPriority)
+{
+    RealtimeFinding finding;
+    finding.title = "PipeWire data loop";
+    
+    if (pipeWirePid <= 0) {
+        finding.severity = RealtimeFinding::Info;
+        finding.detail = "PipeWire is not running for this user.";
+        findings << finding;
+        return;
+    }
+    
+    ThreadSched dataLoop;
+    const QDir taskDir(QString("/proc/%1/task").arg(pipeWirePid));
+    const QStringList tasks = taskDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &task : tasks) {
+        ThreadSched sched;
+        if (readThreadSched(taskDir.filePath(task + "/stat"), sched) && sched.comm.startsWith("data-loop")) {
+            dataLoop = sched;
+            break;
+        }
+    }
+    
+    if (dataLoop.pid == 0) {
+        finding.severity = RealtimeFinding::Info;
+        finding.detail = "No data-loop thread found in the PipeWire process.";
+    } else if (isRealtimePolicy(dataLoop.policy)) {
+        *dataLoopPriority = dataLoop.priority;
+        finding.severity = RealtimeFinding::Ok;
+        finding.detail = QString("Thread %1 (%2) runs %3 at priority %4.")
+                         .arg(dataLoop.comm).arg(dataLoop.pid).arg(policyName(dataLoop.policy)).arg(dataLoop.priority);
+    } else {
+        finding.severity = RealtimeFinding::Critical;
+        finding.detail = QString("Thread %1 (%2) runs %3, not real-time. Small quantums will xrun under load.")
+                         .arg(dataLoop.comm).arg(dataLoop.pid).arg(policyName(dataLoop.policy));
+        finding.fixDescription = "Switch the running data loop to SCHED_FIFO (fix the rlimit or rtkit findings to make this permanent)";
+        finding.fixScript = QString("chrt -f -p %1 %2").arg(PIPEWIRE_RT_PRIORITY).arg(dataLoop.pid);
+    }
+    findings << finding;
+}
+
+void RealtimeDiagnostics::checkGovernor(QList<RealtimeFinding> &findings)
+{
+    const QDir cpuDir("/sys/devices/system/cpu");
+    const QStringList cpus = cpuDir.entryList(QStringList() << "cpu[0-9]*", QDir::Dirs);
+    
+    QMap<QString, int> governors;
+    for (const QString &cpu : cpus) {
+        const QString governor = QString::fromLatin1(readProcFile(cpuDir.filePath(cpu + "/cpufreq/scaling_governor"))).trimmed();
+        if (!governor.isEmpty()) {
+            governors[governor]++;
+        }
+    }
+    if (governors.isEmpty()) return;
+    
+    const QString driver = QString::fromLatin1(readProcFile(cpuDir.filePath("cpu0/cpufreq/scaling_driver"))).trimmed();
+    
+    QStringList summary;
+    for (auto it = governors.cbegin(); it != governors.cend(); ++it) {
+        summary << QString("%1 x%2").arg(it.key()).arg(it.value());
+    }
+    
+    RealtimeFinding finding;
+    finding.title = "CPU frequency governor";
+    finding.detail = QString("%1 (driver %2).").arg(summary.join(", "), driver.isEmpty() ? "unknown" : driver);
+    
+    if (governors.size() == 1 && governors.contains("performance")) {
+        finding.severity = RealtimeFinding::Ok;
+    } else {
+        // Ramping up from a low clock takes longer than a 64-sample period
+        finding.severity = (governors.contains("powersave") || governors.contains("conservative"))
+                           ? RealtimeFinding::Warning : RealtimeFinding::Info;
+        finding.detail += " Frequency ramp-up delays can cause xruns at small quantums.";
+        finding.fixDescription = "Set the performance governor on all CPUs (until reboot)";
+        finding.fixScript = "for g in /sys/devices/system/cpu/cpu[0-9]*/cpufreq/scaling_governor; do echo performance > \"$g\"; done";
+    }
+    findings << finding;
+}
+
+void RealtimeDiagnostics::checkIrqThreads(int dataLoopPriority, QList<RealtimeFinding> &findings)
+{
+    // Interrupt lines of sound devices, e.g. "snd_hda_intel:card0"
+    const bool usbAudio = readProcFile("/proc/asound/cards").contains("USB-Audio");
+    QMap<int, QString> audioIrqs;
+    const QList<QByteArray> lines = readProcFile("/proc/interrupts").split('\n');
+    for (const QByteArray &line : lines) {
+        const int colon = line.indexOf(':');
+        if (colon < 0) continue;
+        
+        bool ok = false;
+        const int irq = line.left(colon).trimmed().toInt(&ok);
+        if (!ok) continue;
+        
+        const QString devices = QString::fromLatin1(line.mid(colon + 1)).simplified();
+        if (devices.contains("snd_") || (usbAudio && devices.contains("xhci_hcd"))) {
+            audioIrqs.insert(irq, devices.section(' ', -1));
+        }
+    }
+    
+    if (audioIrqs.isEmpty()) return;
+    
+    // Threaded IRQ handlers are kernel threads named "irq/<n>-<device>"
+    QMap<int, ThreadSched> irqThreads;
+    const QList<int> pids = processIds();
+    for (int pid : pids) {
+        ThreadSched sched;
+        if (!readThreadSched(QString("/proc/%1/stat").arg(pid), sched) || !sched.comm.startsWith("irq/")) {
+            continue;
+        }
+        const int irq = sched.comm.mid(4).section('-', 0, 0).toInt();
+        if (audioIrqs.contains(irq)) {
+            irqThreads.insert(irq, sched);
+        }
+    }
+    
+    RealtimeFinding finding;
+    finding.title = "Audio IRQ threads";
+    
+    if (irqThreads.isEmpty()) {
+        QStringList irqs;
+        for (auto it = audioIrqs.cbegin(); it != audioIrqs.cend(); ++it) {
+            irqs << QString("%1 (%2)").arg(it.key()).arg(it.value());
+        }
+        finding.severity = RealtimeFinding::Info;
+        finding.detail = QString("IRQ %1 serve audio devices but interrupts are not threaded, so their "
+                                 "priority cannot be raised above other devices.").arg(irqs.join(", "));
+        finding.fixDescription = "Add 'threadirqs' to the kernel command line (takes effect after reboot)";
+        finding.fixScript = "grubby --update-kernel=ALL --args=threadirqs";
+        findings << finding;
+        return;
+    }
+    
+    // IRQ threads should run above PipeWire's data loop so the device
+    // interrupt is never delayed by the work it triggers
+    const int wanted = qMax(dataLoopPriority, PIPEWIRE_RT_PRIORITY) + 2;
+    QStringList details;
+    QStringList fixes;
+    for (auto it = irqThreads.cbegin(); it != irqThreads.cend(); ++it) {
+        const QString affinity = QString::fromLatin1(readProcFile(QString("/proc/irq/%1/smp_affinity_list").arg(it.key()))).trimmed();
+        details << QString("IRQ %1 (%2): %3 priority %4, CPUs %5")
+                   .arg(it.key()).arg(audioIrqs.value(it.key()), policyName(it->policy))
+                   .arg(it->priority).arg(affinity.isEmpty() ? "?" : affinity);
+        if (!isRealtimePolicy(it->policy) || it->priority < wanted) {
+            fixes << QString("chrt -f -p %1 %2").arg(wanted).arg(it->pid);
+        }
+    }
+    
+    finding.detail = details.join("\n");
+    if (fixes.isEmpty()) {
+        finding.severity = RealtimeFinding::Ok;
+    } else {
+        finding.severity = RealtimeFinding::Warning;
+        finding.detail += QString("\nAudio IRQ threads run below PipeWire's data loop (priority %1).").arg(dataLoopPriority);
+        finding.fixDescription = QString("Raise audio IRQ threads to SCHED_FIFO priority %1 (until reboot)").arg(wanted);
+        finding.fixScript = fixes.join(" && ");
+    }
+    findings << finding;
+}
+
+void RealtimeDiagnostics::checkKernel(QList<RealtimeFinding> &findings)
+{
+    const QString version = QString::fromLatin1(readProcFile("/proc/version")).trimmed();
+    const QString cmdline = QString::fromLatin1(readProcFile("/proc/cmdline"));
+    
+    RealtimeFinding finding;
+    finding.title = "Kernel preemption";
+    finding.severity = RealtimeFinding::Info;
+    
+    if (QFile::exists("/sys/kernel/realtime") || version.contains("PREEMPT_RT")) {
+        finding.severity = RealtimeFinding::Ok;
+        finding.detail = "Running a PREEMPT_RT kernel.";
+    } else if (cmdline.contains("preempt=full")) {
+        finding.severity = RealtimeFinding::Ok;
+        finding.detail = "Full preemption is enabled (preempt=full).";
+    } else if (version.contains("PREEMPT_DYNAMIC")) {
+        finding.detail = "The kernel supports dynamic preemption but is not booted with preempt=full.";
+        finding.fixDescription = "Boot with preempt=full (takes effect after reboot)";
+        finding.fixScript = "grubby --update-kernel=ALL --args=preempt=full";
+    } else {
+        finding.detail = "Voluntary preemption kernel; consider a low-latency kernel for very small quantums.";
+    }
+    findings << finding;
+}
+
+QByteArray RealtimeDiagnostics::readProcFile(const QString &path)
+{
+    // /proc and /sys files report size 0, so read until EOF
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+    return file.readAll();
+}
+
+bool RealtimeDiagnostics::readThreadSched(const QString &statPath, ThreadSched &sched)
+{
+    const QByteArray stat = readProcFile(statPath);
+    const int open = stat.indexOf('(');
+    const int close = stat.lastIndexOf(')');
+    if (open < 0 || close < open) return false;
+    
+    // Fields after the command name start at field 3 (state); rt_priority
+    // is field 40 and policy field 41
+    const QList<QByteArray> fields = stat.mid(close + 2).split(' ');
+    if (fields.size() < 39) return false;
+    
+    sched.pid = stat.left(open).trimmed().toInt();
+    sched.comm = QString::fromUtf8(stat.mid(open + 1, close - open - 1));
+    sched.priority = fields.at(37).toInt();
+    sched.policy = fields.at(38).toInt();
+    return true;
+}
+
+QList<int> RealtimeDiagnostics::processIds()
+{
+    QList<int> pids;
+    const QStringList entries = QDir("/proc").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &entry : entries) {
+        bool ok = false;
+        const int pid = entry.toInt(&ok);
+        if (ok) {
+            pids << pid;
+        }
+    }
+    return pids;
+}
+
+int RealtimeDiagnostics::findProcess(const QString &comm)
+{
+    const uint uid = QFileInfo("/proc/self").ownerId();
+    const bool perUser = comm == "pipewire";
+    
+    const QList<int> pids = processIds();
+    for (int pid : pids) {
+        if (QString::fromUtf8(readProcFile(QString("/proc/%1/comm").arg(pid))).trimmed() != comm) continue;
+        // PipeWire runs per user; pick ours
+        if (perUser && QFileInfo(QString("/proc/%1").arg(pid)).ownerId() != uid) continue;
+        return pid;
+    }
+    return 0;
+}
+
+QString RealtimeDiagnostics::realtimeGroup()
+{
+    // Fedora's pipewire package ships RT limits for the "pipewire" group
+    const QByteArray groups = readProcFile("/etc/group");
+    if (groups.startsWith("pipewire:") || groups.contains("\npipewire:")) {
+        return "pipewire";
+    }
+    return "audio";
+}
@@ -0,0 +1,63 @@
+#ifndef REALTIMEDIAGNOSTICS_H
+#define REALTIMEDIAGNOSTICS_H
+
+#include <QThread>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QList>
+
+struct RealtimeFinding {
+    enum Severity { Ok, Info, Warning, Critical };
+    
+    Severity severity = Info;
+    QString title;
+    QString detail;
+    QString fixDescription;
+    QString fixScript;      // run as root through sh -c; empty if there is no automatic fix
+};
+
+// Audits whether the system can actually sustain small PipeWire quantums:
+// RT rlimits and rtkit, the scheduling class of PipeWire's data loop, the
+// CPU frequency governor and the IRQ threads of audio devices. Everything is
+// read from /proc and /sys directly, on a worker thread.
+class RealtimeDiagnostics : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit RealtimeDiagnostics(QObject *parent = nullptr);
+    
+    QList<RealtimeFinding> findings() const;
+    
+    static QString severityName(RealtimeFinding::Severity severity);
+
+protected:
+    void run() override;
+
+private:
+    struct ThreadSched {
+        int pid = 0;
+        QString comm;
+        int policy = 0;
+        int priority = 0;
+    };
+    
+    void checkRtLimits(int pipeWirePid, QList<RealtimeFinding> &findings);
+    void checkRtkit(QList<RealtimeFinding> &findings);
+    void checkDataLoop(int pipeWirePid, QList<RealtimeFinding> &findings, int *dataLoopPriority);
+    void checkGovernor(QList<RealtimeFinding> &findings);
+    void checkIrqThreads(int dataLoopPriority, QList<RealtimeFinding> &findings);
+    void checkKernel(QList<RealtimeFinding> &findings);
+    
+    static QByteArray readProcFile(const QString &path);
+    static bool readThreadSched(const QString &statPath, ThreadSched &sched);
+    static QList<int> processIds();
+    static int findProcess(const QString &comm);
+    static QString realtimeGroup();
+    
+    mutable QMutex m_mutex;
+    QList<RealtimeFinding> m_findings;
+};
+
+#endif // REALTIMEDIAGNOSTICS_H
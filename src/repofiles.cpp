@@ -0,0 +1,236 @@
+#include "repofiles.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSysInfo>
+#include <QProcessEnvironment>
+
+namespace {
+
+bool isTrue(const QString &value)
+{
+    const QString lower = value.trimmed().toLower();
+    return lower == "1" || lower == "yes" || lower == "true" || lower == "on";
+}
+
+QString readFirstLine(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+    return QString::fromUtf8(file.readLine()).trimmed();
+}
+
+}
+
+// RepoFiles Implementation
+QStringList RepoFiles::variableDirectories()
+{
+    return QStringList() << "/etc/dnf/vars" << "/etc/yum/vars";
+}
+
+QList<RepositoryInfo> RepoFiles::readAll(const QString &directory)
+{
+    const QHash<QString, QString> vars = variables();
+    QList<RepositoryInfo> repositories;
+    
+    const QDir dir(directory);
+    const QStringList files = dir.entryList(QStringList() << "*.repo", QDir::Files | QDir::Readable, QDir::Name);
+    for (const QString &file : files) {
+        repositories << readFile(dir.filePath(file), vars);
+    }
+    
+    return repositories;
+}
+
+QList<RepositoryInfo> RepoFiles::readFile(const QString &path, const QHash<QString, QString> &variables)
+{
+    QList<RepositoryInfo> repositories;
+    
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return repositories;
+    }
+    
+    // Collect raw key/values per section first; continuation lines can only
+    // be attached once the whole value has been seen
+    QList<QPair<QString, QHash<QString, QString>>> sections;
+    QString lastKey;
+    
+    const QStringList lines = QString::fromUtf8(file.readAll()).split('\n');
+    for (const QString &line : lines) {
+        const QString trimmed = line.trimmed();
+        if (trimmed.isEmpty() || trimmed.startsWith('#') || trimmed.startsWith(';')) continue;
+        
+        if (trimmed.startsWith('[') && trimmed.endsWith(']')) {
+            sections.append(qMakePair(trimmed.mid(1, trimmed.size() - 2).trimmed(), QHash<QString, QString>()));
+            lastKey.clear();
+            continue;
+        }
+        if (sections.isEmpty()) continue;
+        
+        QHash<QString, QString> &values = sections.last().second;
+        if (line.at(0).isSpace() && !lastKey.isEmpty()) {
+            values[lastKey] += ' ' + trimmed;  // baseurl and gpgkey may list several
+            continue;
+        }
+        
+        // The first '=' or ':' separates the key; URLs keep theirs
+        int separator = trimmed.indexOf('=');
+        const int colon = trimmed.indexOf(':');
+        if (separator < 0 || (colon >= 0 && colon < separator)) {
+            separator = colon;
+        }
+        if (separator <= 0) continue;
+        
+        lastKey = trimmed.left(separator).trimmed().toLower();
+        values.insert(lastKey, trimmed.mid(separator + 1).trimmed());
+    }
+    
+    for (const auto &section : sections) {
+        if (section.first == "main") continue;  // dnf.conf style global options
+        
+        const QHash<QString, QString> &values = section.second;
+        RepositoryInfo repo;
+        repo.id = section.first;
+        repo.filePath = path;
+        repo.name = expand(values.value("name", repo.id), variables);
+        repo.baseUrl = expand(values.value("baseurl"), variables);
+        repo.mirrorList = expand(values.value("mirrorlist"), variables);
+        repo.metalink = expand(values.value("metalink"), variables);
+        repo.enabled = !values.contains("enabled") || isTrue(values.value("enabled"));
+        repo.status = repo.enabled ? "enabled" : "disabled";
+        repo.gpgCheck = values.value("gpgcheck");
+        repo.gpgKey = expand(values.value("gpgkey"), variables);
+        repo.cost = values.value("cost");
+        repo.priority = values.value("priority");
+        repo.metadataExpire = values.value("metadata_expire");
+        repo.description = expand(values.value("description"), variables);
+        repositories << repo;
+    }
+    
+    return repositories;
+}
+
+QHash<QString, QString> RepoFiles::variables()
+{
+    QHash<QString, QString> vars;
+    vars.insert("releasever", releaseVersion());
+    vars.insert("basearch", baseArchitecture());
+    vars.insert("arch", QSysInfo::currentCpuArchitecture());
+    
+    // One file per variable, named after it; /etc/dnf/vars wins
+    const QStringList dirs = variableDirectories();
+    for (auto dir = dirs.crbegin(); dir != dirs.crend(); ++dir) {
+        const QDir varsDir(*dir);
+        for (const QString &name : varsDir.entryList(QDir::Files | QDir::Readable)) {
+            vars.insert(name, readFirstLine(varsDir.filePath(name)));
+        }
+    }
+    
+    // DNF0..DNF9 and DNF_VAR_<name> from the environment, as dnf honours them
+    const QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    for (const QString &key : environment.keys()) {
+        if (key.startsWith("DNF_VAR_")) {
+            vars.insert(key.mid(8), environment.value(key));
+        } else if (key.size() == 4 && key.startsWith("DNF") && key.at(3).isDigit()) {
+            vars.insert(key, environment.value(key));
+        }
+    }
+    
+    return vars;
+}
+
+QString RepoFiles::expand(const QString &value, const QHash<QString, QString> &variables)
+{
+    if (!value.contains('$')) return value;
+    
+    QString result;
+    result.reserve(value.size() + 32);
+    
+    for (int i = 0; i < value.size(); ++i) {
+        if (value.at(i) != '$' || i + 1 >= value.size()) {
+            result += value.at(i);
+            continue;
+        }
+        
+        // ${name}, ${name:-default}, ${name:+alternative} or $name
+        if (value.at(i + 1) == '{') {
+            const int close = value.indexOf('}', i + 2);
+            if (close < 0) {
+                result += value.mid(i);
+                break;
+            }
+            const QString body = value.mid(i + 2, close - i - 2);
+            const int modifier = body.indexOf(':');
+            const QString name = modifier < 0 ? body : body.left(modifier);
+            const bool isSet = variables.contains(name) && !variables.value(name).isEmpty();
+            
+            if (modifier >= 0 && body.mid(modifier, 2) == ":-") {
+                result += isSet ? variables.value(name) : expand(body.mid(modifier + 2), variables);
+            } else if (modifier >= 0 && body.mid(modifier, 2) == ":+") {
+                result += isSet ? expand(body.mid(modifier + 2), variables) : QString();
+            } else if (variables.contains(name)) {
+                result += variables.value(name);
+            } else {
+                result += value.mid(i, close - i + 1);  // unknown: left as written, like dnf
+            }
+            i = close;
+            continue;
+        }
+        
+        int end = i + 1;
+        while (end < value.size() && (value.at(end).isLetterOrNumber() || value.at(end) == '_')) {
+            ++end;
+        }
+        const QString name = value.mid(i + 1, end - i - 1);
+        if (!name.isEmpty() && variables.contains(name)) {
+            result += variables.value(name);
+        } else {
+            result += value.mid(i, end - i);
+        }
+        i = end - 1;
+    }
+    
+    return result;
+}
+
+QString RepoFiles::releaseVersion()
+{
+    // An explicit override first, then what the distribution reports
+    for (const QString &dir : variableDirectories()) {
+        const QString value = readFirstLine(dir + "/releasever");
+        if (!value.isEmpty()) return value;
+    }
+    
+    // dnf takes the system-release(releasever) provide, which is the major
+    // version: VERSION_ID 10.0 on an EL system means $releasever 10
+    QString version;
+    QFile osRelease("/etc/os-release");
+    if (osRelease.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        const QStringList lines = QString::fromUtf8(osRelease.readAll()).split('\n');
+        for (const QString &line : lines) {
+            if (line.startsWith("VERSION_ID=")) {
+                version = line.mid(11).trimmed();
+                version.remove('"');
+                break;
+            }
+        }
+    }
+    if (version.isEmpty()) {
+        version = QSysInfo::productVersion();
+    }
+    
+    return version.section('.', 0, 0);
+}
+
+QString RepoFiles::baseArchitecture()
+{
+    const QString arch = QSysInfo::currentCpuArchitecture();
+    if (arch == "i386" || arch == "i686") return "i386";
+    if (arch.startsWith("arm") && arch != "arm64") return "armhfp";
+    if (arch == "arm64") return "aarch64";
+    if (arch == "power64") return "ppc64le";
+    return arch;
+}
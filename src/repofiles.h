@@ -0,0 +1,47 @@
+#ifndef REPOFILES_H
+#define REPOFILES_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+
+struct RepositoryInfo {
+    QString id;
+    QString name;
+    QString baseUrl;
+    QString mirrorList;
+    QString metalink;
+    bool enabled = true;
+    QString status;
+    QString description;
+    QString gpgCheck;
+    QString gpgKey;
+    QString cost;
+    QString priority;
+    QString metadataExpire;
+    QString filePath;       // the .repo file that defines it
+};
+
+// Reads dnf repository definitions straight from the .repo INI files, the
+// way dnf does before it touches any metadata: sections are repositories,
+// indented lines continue the previous value, and $releasever, $basearch
+// and the variables under /etc/dnf/vars are substituted.
+class RepoFiles
+{
+public:
+    static QString repositoryDirectory() { return "/etc/yum.repos.d"; }
+    static QStringList variableDirectories();
+    
+    static QList<RepositoryInfo> readAll(const QString &directory = repositoryDirectory());
+    static QList<RepositoryInfo> readFile(const QString &path, const QHash<QString, QString> &variables);
+    
+    static QHash<QString, QString> variables();
+    static QString expand(const QString &value, const QHash<QString, QString> &variables);
+
+private:
+    static QString releaseVersion();
+    static QString baseArchitecture();
+};
+
+#endif // REPOFILES_H
@@ -0,0 +1,373 @@
+#include "repohealth.h"
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QXmlStreamReader>
+#include <QUrl>
+#include <QRegularExpression>
+#include <algorithm>
+
+namespace {
+
+const int DEFAULT_MAX_CONCURRENT = 8;
+const int DEFAULT_MIRRORS_PER_REPO = 5;
+const int DEFAULT_TIMEOUT_MS = 10000;
+
+// dnf's default cost, and the ceiling for anything slower
+const int BASE_COST = 1000;
+const int MAX_COST = 10000;
+
+const char *REPOMD_PATH = "repodata/repomd.xml";
+
+bool isProbeable(const QString &url)
+{
+    const QString scheme = QUrl(url).scheme();
+    return scheme == "http" || scheme == "https" || scheme == "file";
+}
+
+QList<QPair<QString, QString>> &urlRewrites()
+{
+    static QList<QPair<QString, QString>> rewrites;
+    return rewrites;
+}
+
+QString repomdUrl(const QString &baseUrl)
+{
+    return baseUrl.endsWith('/') ? baseUrl + REPOMD_PATH : baseUrl + '/' + REPOMD_PATH;
+}
+
+// Fresh, reachable mirrors first, then the quickest to answer, then the fastest transfer
+bool betterMirror(const MirrorProbe &a, const MirrorProbe &b)
+{
+    if (a.isReachable() != b.isReachable()) return a.isReachable();
+    if (a.fresh != b.fresh) return a.fresh;
+    if (a.ttfbMs != b.ttfbMs) return a.ttfbMs < b.ttfbMs;
+    return a.bytesPerSecond > b.bytesPerSecond;
+}
+
+}
+
+// RepoHealth Implementation
+QString RepoHealth::summary() const
+{
+    const MirrorProbe *mirror = best();
+    if (!mirror || !mirror->isReachable()) return "unreachable";
+    if (!mirror->fresh) return "stale";
+    return QString("%1 ms").arg(mirror->ttfbMs);
+}
+
+// RepoHealthProber Implementation
+RepoHealthProber::RepoHealthProber(QObject *parent)
+    : QObject(parent)
+    , m_network(new QNetworkAccessManager(this))
+    , m_maxConcurrent(DEFAULT_MAX_CONCURRENT)
+    , m_mirrorsPerRepo(DEFAULT_MIRRORS_PER_REPO)
+    , m_timeoutMs(DEFAULT_TIMEOUT_MS)
+    , m_running(false)
+{
+}
+
+void RepoHealthProber::probe(const QList<RepositoryInfo> &repositories)
+{
+    cancel();
+    m_health.clear();
+    m_outstanding.clear();
+    m_running = true;
+    
+    for (const RepositoryInfo &repo : repositories) {
+        if (!repo.enabled) continue;
+        
+        RepoHealth health;
+        health.repoId = repo.id;
+        m_health.insert(repo.id, health);
+        m_outstanding.insert(repo.id, 0);
+        
+        // dnf prefers the metalink, then the mirrorlist, and adds any baseurl
+        if (isProbeable(repo.metalink)) {
+            enqueue(MetalinkJob, repo.id, repo.metalink);
+        } else if (isProbeable(repo.mirrorList)) {
+            enqueue(MirrorlistJob, repo.id, repo.mirrorList);
+        }
+        addMirrors(repo.id, repo.baseUrl.split(QRegularExpression("[\\s,]+"), Qt::SkipEmptyParts));
+        
+        if (m_outstanding.value(repo.id) == 0) {
+            finalize(repo.id);  // nothing to contact, e.g. a local path without a scheme
+        }
+    }
+    
+    if (m_queue.isEmpty() && m_inFlight.isEmpty()) {
+        assignCosts();
+        m_running = false;
+        emit finished();
+        return;
+    }
+    dispatch();
+}
+
+void RepoHealthProber::cancel()
+{
+    m_queue.clear();
+    const QList<QNetworkReply *> replies = m_inFlight.keys();
+    m_inFlight.clear();
+    for (QNetworkReply *reply : replies) {
+        reply->disconnect(this);
+        reply->abort();
+        reply->deleteLater();
+    }
+    m_running = false;
+}
+
+void RepoHealthProber::addUrlRewrite(const QString &from, const QString &to)
+{
+    urlRewrites().append(qMakePair(from, to));
+}
+
+QString RepoHealthProber::rewriteUrl(const QString &url)
+{
+    // The first, i.e. earliest added, match wins
+    for (const auto &rewrite : std::as_const(urlRewrites())) {
+        if (!rewrite.first.isEmpty() && url.startsWith(rewrite.first)) {
+            return rewrite.second + url.mid(rewrite.first.size());
+        }
+    }
+    return url;
+}
+
+void RepoHealthProber::enqueue(JobKind kind, const QString &repoId, const QString &url)
+{
+    Job job;
+    job.kind = kind;
+    job.repoId = repoId;
+    job.url = rewriteUrl(url);
+    m_queue.enqueue(job);
+    ++m_outstanding[repoId];
+}
+
+void RepoHealthProber::addMirrors(const QString &repoId, const QStringList &baseUrls)
+{
+    RepoHealth &health = m_health[repoId];
+    // Probed, waiting and running mirrors all count against the cap
+    int queued = health.mirrors.size();
+    for (const Job &job : std::as_const(m_queue)) {
+        if (job.kind == RepomdJob && job.repoId == repoId) ++queued;
+    }
+    for (const Job &job : std::as_const(m_inFlight)) {
+        if (job.kind == RepomdJob && job.repoId == repoId) ++queued;
+    }
+    
+    for (const QString &baseUrl : baseUrls) {
+        if (queued >= m_mirrorsPerRepo) break;
+        if (!isProbeable(baseUrl)) continue;
+        enqueue(RepomdJob, repoId, baseUrl);
+        ++queued;
+    }
+}
+
+void RepoHealthProber::dispatch()
+{
+    while (m_inFlight.size() < m_maxConcurrent && !m_queue.isEmpty()) {
+        Job job = m_queue.dequeue();
+        
+        QNetworkRequest request(QUrl(job.kind == RepomdJob ? repomdUrl(job.url) : job.url));
+        request.setTransferTimeout(m_timeoutMs);
+        request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+        request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
+        request.setHeader(QNetworkRequest::UserAgentHeader, "oreon-system-manager");
+        
+        job.timer.start();
+        QNetworkReply *reply = m_network->get(request);
+        m_inFlight.insert(reply, job);
+        
+        // Headers arriving is the first byte as far as a client can tell
+        auto markFirstByte = [this, reply]() {
+            auto it = m_inFlight.find(reply);
+            if (it != m_inFlight.end() && it->ttfbMs < 0) {
+                it->ttfbMs = it->timer.elapsed();
+            }
+        };
+        connect(reply, &QNetworkReply::metaDataChanged, this, markFirstByte);
+        connect(reply, &QIODevice::readyRead, this, markFirstByte);
+        connect(reply, &QNetworkReply::finished, this, [this, reply]() { onReplyFinished(reply); });
+    }
+}
+
+void RepoHealthProber::onReplyFinished(QNetworkReply *reply)
+{
+    reply->deleteLater();
+    if (!m_inFlight.contains(reply)) return;
+    
+    Job job = m_inFlight.take(reply);
+    if (job.ttfbMs < 0) {
+        job.ttfbMs = job.timer.elapsed();
+    }
+    
+    if (job.kind == RepomdJob) {
+        finishRepomd(reply, job);
+    } else if (reply->error() == QNetworkReply::NoError) {
+        const QByteArray body = reply->readAll();
+        if (job.kind == MetalinkJob) {
+            qint64 timestamp = 0;
+            const QStringList mirrors = parseMetalink(body, &timestamp);
+            m_health[job.repoId].expectedRevision = timestamp;
+            addMirrors(job.repoId, mirrors);
+        } else {
+            addMirrors(job.repoId, parseMirrorlist(body));
+        }
+    }
+    
+    jobDone(job.repoId);
+    dispatch();
+    
+    if (m_running && m_queue.isEmpty() && m_inFlight.isEmpty()) {
+        assignCosts();
+        m_running = false;
+        emit finished();
+    }
+}
+
+void RepoHealthProber::finishRepomd(QNetworkReply *reply, const Job &job)
+{
+    MirrorProbe probe;
+    probe.repoId = job.repoId;
+    probe.baseUrl = job.url;
+    probe.httpStatus = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    probe.totalMs = job.timer.elapsed();
+    probe.ttfbMs = job.ttfbMs;
+    
+    if (reply->url().isLocalFile() && reply->error() == QNetworkReply::NoError) {
+        probe.httpStatus = 200;
+    }
+    
+    if (reply->error() != QNetworkReply::NoError) {
+        probe.error = reply->errorString();
+    } else {
+        const QByteArray body = reply->readAll();
+        const qint64 transferMs = qMax<qint64>(1, probe.totalMs - probe.ttfbMs);
+        probe.bytesPerSecond = body.size() * 1000.0 / transferMs;
+        probe.revision = parseRepomdRevision(body);
+        if (probe.revision == 0) {
+            probe.error = "Not repository metadata";
+        }
+    }
+    
+    m_health[job.repoId].mirrors << probe;
+    emit mirrorProbed(probe);
+}
+
+void RepoHealthProber::jobDone(const QString &repoId)
+{
+    if (--m_outstanding[repoId] == 0) {
+        finalize(repoId);
+    }
+}
+
+void RepoHealthProber::finalize(const QString &repoId)
+{
+    RepoHealth &health = m_health[repoId];
+    
+    // Without a metalink to say what is current, the newest copy any mirror serves is
+    if (health.expectedRevision == 0) {
+        for (const MirrorProbe &mirror : std::as_const(health.mirrors)) {
+            health.expectedRevision = qMax(health.expectedRevision, mirror.revision);
+        }
+    }
+    for (MirrorProbe &mirror : health.mirrors) {
+        mirror.fresh = mirror.isReachable() && mirror.revision >= health.expectedRevision;
+    }
+    
+    std::sort(health.mirrors.begin(), health.mirrors.end(), betterMirror);
+    emit repositoryProbed(health);
+}
+
+void RepoHealthProber::assignCosts()
+{
+    // Scale dnf's default cost by how much slower each repository's best
+    // mirror answered than the quickest repository's did
+    qint64 fastest = 0;
+    for (const RepoHealth &health : std::as_const(m_health)) {
+        const MirrorProbe *mirror = health.best();
+        if (mirror && mirror->isReachable() && (fastest == 0 || mirror->ttfbMs < fastest)) {
+            fastest = qMax<qint64>(1, mirror->ttfbMs);
+        }
+    }
+    
+    for (RepoHealth &health : m_health) {
+        const MirrorProbe *mirror = health.best();
+        if (!mirror || !mirror->isReachable() || fastest == 0) {
+            health.suggestedCost = MAX_COST;
+        } else {
+            const qint64 cost = BASE_COST * qMax<qint64>(1, mirror->ttfbMs) / fastest;
+            health.suggestedCost = int(qBound<qint64>(BASE_COST, cost, MAX_COST));
+        }
+    }
+}
+
+QStringList RepoHealthProber::parseMetalink(const QByteArray &xml, qint64 *timestamp)
+{
+    // <file name="repomd.xml"> carries mm0:timestamp and the mirror <url>s,
+    // best preference first; mm0:alternates holds older timestamps
+    QStringList mirrors;
+    int alternates = 0;
+    
+    QXmlStreamReader reader(xml);
+    while (!reader.atEnd()) {
+        reader.readNext();
+        if (reader.isEndElement() && reader.name() == QLatin1String("alternates")) {
+            --alternates;
+            continue;
+        }
+        if (!reader.isStartElement()) continue;
+        
+        if (reader.name() == QLatin1String("alternates")) {
+            ++alternates;
+        } else if (reader.name() == QLatin1String("timestamp") && alternates == 0) {
+            *timestamp = reader.readElementText().trimmed().toLongLong();
+        } else if (reader.name() == QLatin1String("url")) {
+            const QString protocol = reader.attributes().value("protocol").toString();
+            QString url = reader.readElementText().trimmed();
+            if ((protocol == "http" || protocol == "https") && url.endsWith(REPOMD_PATH)) {
+                url.chop(int(qstrlen(REPOMD_PATH)));
+                mirrors << url;
+            }
+        }
+    }
+    
+    return mirrors;
+}
+
+QStringList RepoHealthProber::parseMirrorlist(const QByteArray &text)
+{
+    QStringList mirrors;
+    for (const QByteArray &line : text.split('\n')) {
+        const QString url = QString::fromUtf8(line).trimmed();
+        if (!url.isEmpty() && !url.startsWith('#')) {
+            mirrors << url;
+        }
+    }
+    return mirrors;
+}
+
+qint64 RepoHealthProber::parseRepomdRevision(const QByteArray &xml)
+{
+    // <revision> is the createrepo timestamp; the newest <timestamp> of a
+    // data entry stands in when a repository sets a custom revision
+    qint64 revision = 0;
+    qint64 newest = 0;
+    
+    QXmlStreamReader reader(xml);
+    while (!reader.atEnd()) {
+        reader.readNext();
+        if (!reader.isStartElement()) continue;
+        
+        if (reader.name() == QLatin1String("revision")) {
+            bool ok = false;
+            const qint64 value = reader.readElementText().trimmed().toLongLong(&ok);
+            if (ok) revision = value;
+        } else if (reader.name() == QLatin1String("timestamp")) {
+            newest = qMax(newest, reader.readElementText().trimmed().toLongLong());
+        }
+    }
+    
+    if (reader.hasError() && revision == 0 && newest == 0) return 0;
+    return revision > 0 ? revision : newest;
+}
@@ -0,0 +1,107 @@
+#ifndef REPOHEALTH_H
+#define REPOHEALTH_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QQueue>
+#include <QElapsedTimer>
+#include "repofiles.h"
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+struct MirrorProbe {
+    QString repoId;
+    QString baseUrl;
+    int httpStatus = 0;
+    qint64 ttfbMs = -1;             // request sent to first byte of the response
+    qint64 totalMs = -1;
+    double bytesPerSecond = 0;      // after the first byte
+    qint64 revision = 0;            // repomd.xml <revision>, usually a timestamp
+    bool fresh = false;
+    QString error;
+    
+    bool isReachable() const { return error.isEmpty() && httpStatus == 200; }
+};
+
+struct RepoHealth {
+    QString repoId;
+    QList<MirrorProbe> mirrors;     // best first
+    qint64 expectedRevision = 0;    // from the metalink, or the newest any mirror had
+    int suggestedCost = 0;          // dnf cost, relative to the fastest repository
+    
+    const MirrorProbe *best() const { return mirrors.isEmpty() ? nullptr : &mirrors.first(); }
+    QString summary() const;
+};
+
+// Fetches repodata/repomd.xml from every enabled repository's mirrors with
+// a bounded number of requests in flight. Metalinks and mirrorlists are
+// expanded first, so each repository is measured on the mirrors dnf would
+// actually pick from. Only the URLs in RepositoryInfo and the mirrors they
+// list are contacted, and those can be redirected with addUrlRewrite(), so
+// a local HTTP server can stand in for real mirrors and metalinks.
+class RepoHealthProber : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RepoHealthProber(QObject *parent = nullptr);
+    
+    void probe(const QList<RepositoryInfo> &repositories);
+    void cancel();
+    bool isRunning() const { return m_running; }
+    
+    void setMaxConcurrentRequests(int count) { m_maxConcurrent = qMax(1, count); }
+    void setMirrorsPerRepository(int count) { m_mirrorsPerRepo = qMax(1, count); }
+    void setTimeout(int milliseconds) { m_timeoutMs = milliseconds; }
+    
+    QHash<QString, RepoHealth> results() const { return m_health; }
+    
+    // Every URL starting with `from` is requested with `to` in its place
+    static void addUrlRewrite(const QString &from, const QString &to);
+    static QString rewriteUrl(const QString &url);
+
+signals:
+    void mirrorProbed(const MirrorProbe &probe);
+    void repositoryProbed(const RepoHealth &health);
+    void finished();
+
+private:
+    enum JobKind { MetalinkJob, MirrorlistJob, RepomdJob };
+    
+    struct Job {
+        JobKind kind;
+        QString repoId;
+        QString url;
+        QElapsedTimer timer;
+        qint64 ttfbMs = -1;
+    };
+    
+    void enqueue(JobKind kind, const QString &repoId, const QString &url);
+    void dispatch();
+    void onReplyFinished(QNetworkReply *reply);
+    void finishRepomd(QNetworkReply *reply, const Job &job);
+    void addMirrors(const QString &repoId, const QStringList &baseUrls);
+    void jobDone(const QString &repoId);
+    void finalize(const QString &repoId);
+    void assignCosts();
+    
+    static QStringList parseMetalink(const QByteArray &xml, qint64 *timestamp);
+    static QStringList parseMirrorlist(const QByteArray &text);
+    static qint64 parseRepomdRevision(const QByteArray &xml);
+    
+    QNetworkAccessManager *m_network;
+    QQueue<Job> m_queue;
+    QHash<QNetworkReply *, Job> m_inFlight;
+    QHash<QString, RepoHealth> m_health;
+    QHash<QString, int> m_outstanding;      // jobs not yet finished, per repository
+    int m_maxConcurrent;
+    int m_mirrorsPerRepo;
+    int m_timeoutMs;
+    bool m_running;
+};
+
+#endif // REPOHEALTH_H
@@ -1,6 +1,7 @@
 #include "repositorymanager.h"
 #include "systemutils.h"
 #include "privilegedexecutor.h"
+#include "tracing.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -29,6 +30,9 @@
 #include <QDesktopServices>
 #include <QUrl>
 #include <QProcess>
+#include <QFileInfo>
+#include <QSignalBlocker>
+#include <QElapsedTimer>
 
 RepositoryManager::RepositoryManager(QWidget *parent)
     : QWidget(parent)
@@ -46,6 +50,12 @@ RepositoryManager::RepositoryManager(QWidget *parent)
     , m_removeRepoButton(nullptr)
     , m_editRepoButton(nullptr)
     , m_refreshRepoButton(nullptr)
+    , m_checkHealthButton(nullptr)
+    , m_cacheGroup(nullptr)
+    , m_cacheTable(nullptr)
+    , m_cacheSummaryLabel(nullptr)
+    , m_makeCacheButton(nullptr)
+    , m_autoMakeCacheCheck(nullptr)
     , m_repoDetailsGroup(nullptr)
     , m_repoDetailsText(nullptr)
     , m_flatpakTab(nullptr)
@@ -61,6 +71,17 @@ RepositoryManager::RepositoryManager(QWidget *parent)
     , m_refreshFlatpakButton(nullptr)
     , m_flatpakDetailsGroup(nullptr)
     , m_flatpakDetailsText(nullptr)
+    , m_appSearchGroup(nullptr)
+    , m_appSearchEdit(nullptr)
+    , m_appResultsList(nullptr)
+    , m_appSearchLabel(nullptr)
+    , m_installAppButton(nullptr)
+    , m_appSearchTimer(nullptr)
+    , m_flatpakUpdateGroup(nullptr)
+    , m_flatpakUpdateTable(nullptr)
+    , m_flatpakUpdateLabel(nullptr)
+    , m_checkFlatpakUpdatesButton(nullptr)
+    , m_updateFlatpaksButton(nullptr)
     , m_predefinedGroup(nullptr)
     , m_predefinedLayout(nullptr)
     , m_predefinedLabel(nullptr)
@@ -74,15 +95,64 @@ RepositoryManager::RepositoryManager(QWidget *parent)
     , m_systemUtils(nullptr)
     , m_privilegedExecutor(nullptr)
     , m_statusLabel(nullptr)
+    , m_repoWatcher(new QFileSystemWatcher(this))
+    , m_repoReloadTimer(new QTimer(this))
+    , m_healthProber(new RepoHealthProber(this))
+    , m_metadataCache(new MetadataCache(this))
+    , m_metadataRefreshTotal(0)
+    , m_metadataRefreshDone(0)
+    , m_cacheTableTimer(new QTimer(this))
+    , m_inspectingCache(false)
+    , m_inspectCacheAgain(false)
+    , m_flatpakUpdater(new FlatpakUpdater(this))
 {
+    TraceSpan span("RepositoryManager::RepositoryManager");
+    
     m_systemUtils = new SystemUtils(this);
     m_privilegedExecutor = new PrivilegedExecutor(this);
     
     setupUI();
     setupConnections();
     
+    m_repoReloadTimer->setSingleShot(true);
+    m_repoReloadTimer->setInterval(200);
+    connect(m_repoReloadTimer, &QTimer::timeout, this, &RepositoryManager::refreshRepositories);
+    connect(m_repoWatcher, &QFileSystemWatcher::directoryChanged, this, &RepositoryManager::onRepoFilesChanged);
+    connect(m_repoWatcher, &QFileSystemWatcher::fileChanged, this, &RepositoryManager::onRepoFilesChanged);
+    
+    connect(m_healthProber, &RepoHealthProber::mirrorProbed, this, &RepositoryManager::onMirrorProbed);
+    connect(m_healthProber, &RepoHealthProber::repositoryProbed, this, &RepositoryManager::onRepositoryProbed);
+    connect(m_healthProber, &RepoHealthProber::finished, this, &RepositoryManager::onHealthCheckFinished);
+    
+    connect(m_metadataCache, &MetadataCache::repoOutput, this, [this](const QString &repoId, const QString &line) {
+        onRepositoryActionProgress(repoId.isEmpty() ? line : QString("[%1] %2").arg(repoId, line));
+    });
+    connect(m_metadataCache, &MetadataCache::repoFinished, this, &RepositoryManager::onMetadataRepoFinished);
+    m_cacheTableTimer->setSingleShot(true);
+    m_cacheTableTimer->setInterval(500);
+    connect(m_cacheTableTimer, &QTimer::timeout, this, &RepositoryManager::updateCacheTable);
+    connect(m_metadataCache, &MetadataCache::finished, this, &RepositoryManager::onMetadataRefreshFinished);
+    m_autoMakeCacheCheck->setChecked(MetadataCache::isAutomatic());
+    connect(m_autoMakeCacheCheck, &QCheckBox::clicked, m_metadataCache, &MetadataCache::setAutomatic);
+    connect(m_metadataCache, &MetadataCache::automaticChanged, m_autoMakeCacheCheck, &QCheckBox::setChecked);
+    
+    FlatpakBackend *flatpak = FlatpakBackend::instance();
+    connect(flatpak, &FlatpakBackend::refreshed, this, &RepositoryManager::onFlatpakRefreshed);
+    connect(flatpak, &FlatpakBackend::refreshFailed, this, [this](const QString &error) {
+        onRepositoryActionProgress(QString("Failed to load Flatpak remotes: %1").arg(error));
+    });
+    connect(flatpak, &FlatpakBackend::progress, this, &RepositoryManager::onFlatpakProgress);
+    connect(flatpak, &FlatpakBackend::transactionFinished, this, &RepositoryManager::onFlatpakTransactionFinished);
+    connect(AppstreamCatalog::instance(), &AppstreamCatalog::loaded, this, &RepositoryManager::onAppCatalogLoaded);
+    
+    connect(m_flatpakUpdater, &FlatpakUpdater::updatesAvailable, this, &RepositoryManager::onFlatpakUpdatesAvailable);
+    connect(m_flatpakUpdater, &FlatpakUpdater::itemAdded, this, &RepositoryManager::onFlatpakUpdateItemChanged);
+    connect(m_flatpakUpdater, &FlatpakUpdater::itemChanged, this, &RepositoryManager::onFlatpakUpdateItemChanged);
+    connect(m_flatpakUpdater, &FlatpakUpdater::statusChanged, this, &RepositoryManager::onRepositoryActionProgress);
+    connect(m_flatpakUpdater, &FlatpakUpdater::finished, this, &RepositoryManager::onFlatpakUpdateFinished);
+    
     refreshRepositories();
-    if (SystemUtils::isFlatpakAvailable()) {
+    if (FlatpakBackend::isAvailable()) {
         refreshFlatpakRemotes();
     }
 }
@@ -176,14 +246,47 @@ void RepositoryManager::setupDNFTab()
     m_removeRepoButton = new QPushButton(QIcon::fromTheme("list-remove"), "Remove Repository", m_repoActionGroup);
     m_editRepoButton = new QPushButton(QIcon::fromTheme("document-edit"), "Edit Repository", m_repoActionGroup);
     m_refreshRepoButton = new QPushButton(QIcon::fromTheme("view-refresh"), "Refresh", m_repoActionGroup);
+    m_checkHealthButton = new QPushButton(QIcon::fromTheme("network-wired"), "Check Mirrors", m_repoActionGroup);
+    m_checkHealthButton->setToolTip("Measure response time and metadata freshness of each enabled repository's mirrors");
     
     repoActionLayout->addWidget(m_addRepoButton, 0, 0);
     repoActionLayout->addWidget(m_removeRepoButton, 0, 1);
     repoActionLayout->addWidget(m_editRepoButton, 1, 0);
     repoActionLayout->addWidget(m_refreshRepoButton, 1, 1);
+    repoActionLayout->addWidget(m_checkHealthButton, 2, 0, 1, 2);
     
     leftLayout->addWidget(m_repoActionGroup);
     
+    m_cacheGroup = new QGroupBox("Metadata Cache", leftWidget);
+    QVBoxLayout *cacheLayout = new QVBoxLayout(m_cacheGroup);
+    
+    m_cacheTable = new QTableWidget(0, 4, m_cacheGroup);
+    m_cacheTable->setHorizontalHeaderLabels({"Repository ID", "Updated", "Size", "State"});
+    m_cacheTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_cacheTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_cacheTable->setAlternatingRowColors(true);
+    m_cacheTable->horizontalHeader()->setStretchLastSection(true);
+    m_cacheTable->verticalHeader()->setVisible(false);
+    m_cacheTable->setColumnWidth(0, 200);
+    m_cacheTable->setMaximumHeight(160);
+    cacheLayout->addWidget(m_cacheTable);
+    
+    m_cacheSummaryLabel = new QLabel(m_cacheGroup);
+    cacheLayout->addWidget(m_cacheSummaryLabel);
+    
+    QHBoxLayout *cacheButtonLayout = new QHBoxLayout();
+    m_makeCacheButton = new QPushButton(QIcon::fromTheme("download"), "Refresh Metadata", m_cacheGroup);
+    m_makeCacheButton->setToolTip("Download metadata for repositories whose cache is missing or about to expire");
+    m_autoMakeCacheCheck = new QCheckBox("Refresh automatically overnight", m_cacheGroup);
+    m_autoMakeCacheCheck->setToolTip(QString("Enables %1.timer, with an extra run between 01:00 and 05:00 "
+                                             "at idle priority").arg(MetadataCache::makecacheUnit()));
+    cacheButtonLayout->addWidget(m_makeCacheButton);
+    cacheButtonLayout->addWidget(m_autoMakeCacheCheck);
+    cacheButtonLayout->addStretch();
+    cacheLayout->addLayout(cacheButtonLayout);
+    
+    leftLayout->addWidget(m_cacheGroup);
+    
     m_dnfSplitter->addWidget(leftWidget);
     
     m_repoDetailsGroup = new QGroupBox("Repository Details", m_dnfTab);
@@ -246,6 +349,11 @@ void RepositoryManager::setupFlatpakTab()
     connect(m_removeFlatpakButton, &QPushButton::clicked, this, &RepositoryManager::removeFlatpakRemote);
     buttonLayout->addWidget(m_removeFlatpakButton);
     
+    m_installFlatpakButton = new QPushButton("Install App");
+    m_installFlatpakButton->setToolTip("Install a Flatpak application by its ID");
+    connect(m_installFlatpakButton, &QPushButton::clicked, this, &RepositoryManager::installFlatpak);
+    buttonLayout->addWidget(m_installFlatpakButton);
+    
     m_refreshFlatpakButton = new QPushButton("Refresh");
     m_refreshFlatpakButton->setToolTip("Refresh the list of Flatpak remotes");
     connect(m_refreshFlatpakButton, &QPushButton::clicked, this, &RepositoryManager::refreshFlatpakRemotes);
@@ -263,6 +371,80 @@ void RepositoryManager::setupFlatpakTab()
     
     m_flatpakLayout->addWidget(flatpakGroup);
     
+    // Application search over the remotes' appstream data
+    m_appSearchGroup = new QGroupBox("Find Apps");
+    QVBoxLayout *appSearchLayout = new QVBoxLayout(m_appSearchGroup);
+    
+    m_appSearchEdit = new QLineEdit();
+    m_appSearchEdit->setPlaceholderText("Search applications by name, keyword or category");
+    m_appSearchEdit->setClearButtonEnabled(true);
+    // Searching waits for a pause in typing rather than running per keystroke
+    m_appSearchTimer = new QTimer(this);
+    m_appSearchTimer->setSingleShot(true);
+    m_appSearchTimer->setInterval(APP_SEARCH_DELAY_MS);
+    connect(m_appSearchTimer, &QTimer::timeout, this, &RepositoryManager::searchApps);
+    connect(m_appSearchEdit, &QLineEdit::textChanged, m_appSearchTimer, qOverload<>(&QTimer::start));
+    appSearchLayout->addWidget(m_appSearchEdit);
+    
+    m_appResultsList = new QListWidget();
+    m_appResultsList->setIconSize(QSize(32, 32));
+    m_appResultsList->setAlternatingRowColors(true);
+    connect(m_appResultsList, &QListWidget::itemSelectionChanged, this, [this]() {
+        m_installAppButton->setEnabled(m_appResultsList->currentItem() != nullptr);
+    });
+    connect(m_appResultsList, &QListWidget::itemDoubleClicked, this, &RepositoryManager::installSelectedApp);
+    appSearchLayout->addWidget(m_appResultsList);
+    
+    QHBoxLayout *appSearchButtons = new QHBoxLayout();
+    m_appSearchLabel = new QLabel("Loading application catalog...");
+    appSearchButtons->addWidget(m_appSearchLabel);
+    appSearchButtons->addStretch();
+    
+    m_installAppButton = new QPushButton("Install");
+    m_installAppButton->setToolTip("Install the selected application from its remote");
+    m_installAppButton->setEnabled(false);
+    connect(m_installAppButton, &QPushButton::clicked, this, &RepositoryManager::installSelectedApp);
+    appSearchButtons->addWidget(m_installAppButton);
+    appSearchLayout->addLayout(appSearchButtons);
+    
+    m_flatpakLayout->addWidget(m_appSearchGroup);
+    
+    // Updates of installed apps and runtimes, in every installation
+    m_flatpakUpdateGroup = new QGroupBox("Flatpak Updates");
+    QVBoxLayout *updateLayout = new QVBoxLayout(m_flatpakUpdateGroup);
+    
+    m_flatpakUpdateTable = new QTableWidget(0, 5);
+    m_flatpakUpdateTable->setHorizontalHeaderLabels({"Ref", "Installation", "Progress", "Downloaded", "Status"});
+    m_flatpakUpdateTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_flatpakUpdateTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_flatpakUpdateTable->setAlternatingRowColors(true);
+    m_flatpakUpdateTable->horizontalHeader()->setStretchLastSection(true);
+    m_flatpakUpdateTable->verticalHeader()->setVisible(false);
+    m_flatpakUpdateTable->setColumnWidth(0, 300);
+    m_flatpakUpdateTable->setColumnWidth(1, 90);
+    m_flatpakUpdateTable->setColumnWidth(2, 70);
+    m_flatpakUpdateTable->setColumnWidth(3, 140);
+    updateLayout->addWidget(m_flatpakUpdateTable);
+    
+    QHBoxLayout *updateButtons = new QHBoxLayout();
+    m_flatpakUpdateLabel = new QLabel("Not checked yet");
+    updateButtons->addWidget(m_flatpakUpdateLabel);
+    updateButtons->addStretch();
+    
+    m_checkFlatpakUpdatesButton = new QPushButton("Check for Updates");
+    m_checkFlatpakUpdatesButton->setToolTip("Compare installed apps and runtimes with their remotes");
+    connect(m_checkFlatpakUpdatesButton, &QPushButton::clicked, this, &RepositoryManager::checkFlatpakUpdates);
+    updateButtons->addWidget(m_checkFlatpakUpdatesButton);
+    
+    m_updateFlatpaksButton = new QPushButton("Update All");
+    m_updateFlatpaksButton->setToolTip("Update every installation at once, each in a single transaction");
+    m_updateFlatpaksButton->setEnabled(false);
+    connect(m_updateFlatpaksButton, &QPushButton::clicked, this, &RepositoryManager::updateAllFlatpaks);
+    updateButtons->addWidget(m_updateFlatpaksButton);
+    updateLayout->addLayout(updateButtons);
+    
+    m_flatpakLayout->addWidget(m_flatpakUpdateGroup);
+    
     // Status and Progress
     m_statusLabel = new QLabel("Ready");
     m_statusLabel->setStyleSheet("color: #666; font-size: 10px;");
@@ -274,8 +456,10 @@ void RepositoryManager::setupFlatpakTab()
     
     m_flatpakLayout->addStretch();
     
-    if (!SystemUtils::isFlatpakAvailable()) {
+    if (!FlatpakBackend::isAvailable()) {
         flatpakGroup->setEnabled(false);
+        m_appSearchGroup->setEnabled(false);
+        m_flatpakUpdateGroup->setEnabled(false);
         m_statusLabel->setText("Flatpak is not installed on this system");
     }
 }
@@ -319,6 +503,8 @@ void RepositoryManager::setupConnections()
     connect(m_removeRepoButton, &QPushButton::clicked, this, &RepositoryManager::removeRepository);
     connect(m_editRepoButton, &QPushButton::clicked, this, &RepositoryManager::editRepository);
     connect(m_refreshRepoButton, &QPushButton::clicked, this, &RepositoryManager::refreshRepositories);
+    connect(m_checkHealthButton, &QPushButton::clicked, this, &RepositoryManager::checkRepositoryHealth);
+    connect(m_makeCacheButton, &QPushButton::clicked, this, &RepositoryManager::refreshMetadataCache);
     
     connect(m_flatpakTable, &QTableWidget::cellClicked, this, &RepositoryManager::showFlatpakDetails);
     connect(m_flatpakTable, &QTableWidget::itemChanged, this, &RepositoryManager::onFlatpakTableItemChanged);
@@ -343,48 +529,460 @@ void RepositoryManager::setupConnections()
 
 void RepositoryManager::refreshRepositories()
 {
-    showProgress("Loading repository information...");
+    // Straight from the .repo files; no metadata is loaded, so this is instant
+    m_repositories = RepoFiles::readAll();
+    updateRepositoryTable(m_repositories);
+    watchRepositoryFiles();
+    
+    updateCacheTable();
+}
+
+void RepositoryManager::watchRepositoryFiles()
+{
+    // Files replaced by rename drop out of the watch, so re-add after every load
+    QStringList paths;
+    paths << RepoFiles::repositoryDirectory() << RepoFiles::variableDirectories();
+    for (const RepositoryInfo &repo : m_repositories) {
+        if (!paths.contains(repo.filePath)) {
+            paths << repo.filePath;
+        }
+    }
+    
+    for (auto it = paths.begin(); it != paths.end();) {
+        if (!QFileInfo::exists(*it) || m_repoWatcher->files().contains(*it)
+            || m_repoWatcher->directories().contains(*it)) {
+            it = paths.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (!paths.isEmpty()) {
+        m_repoWatcher->addPaths(paths);
+    }
+}
+
+void RepositoryManager::onRepoFilesChanged()
+{
+    m_repoReloadTimer->start();
+}
+
+void RepositoryManager::updateRepositoryStatus(int row)
+{
+    QTableWidgetItem *nameItem = m_repoTable->item(row, REPO_COLUMN_NAME);
+    QTableWidgetItem *statusItem = m_repoTable->item(row, REPO_COLUMN_STATUS);
+    const int index = nameItem ? nameItem->data(Qt::UserRole).toInt() : -1;
+    if (!statusItem || index < 0 || index >= m_repositories.size()) return;
+    
+    const RepositoryInfo &repo = m_repositories[index];
+    if (!repo.enabled || !m_repoHealth.contains(repo.id)) {
+        statusItem->setText(repo.status);
+        statusItem->setToolTip(QString());
+        statusItem->setBackground(repo.enabled ? QColor(0, 255, 0, 100) : QColor(255, 0, 0, 100));
+        return;
+    }
+    
+    const RepoHealth &health = m_repoHealth[repo.id];
+    const MirrorProbe *best = health.best();
+    statusItem->setText(QString("%1 · %2").arg(repo.status, health.summary()));
+    if (best && best->isReachable()) {
+        statusItem->setToolTip(best->baseUrl);
+    }
+    
+    if (!best || !best->isReachable()) {
+        statusItem->setBackground(QColor(255, 0, 0, 100));
+    } else if (!best->fresh) {
+        statusItem->setBackground(QColor(255, 165, 0, 100));
+    } else {
+        statusItem->setBackground(QColor(0, 255, 0, 100));
+    }
+}
+
+void RepositoryManager::updateCacheTable()
+{
+    if (m_inspectingCache) {
+        m_inspectCacheAgain = true;
+        return;
+    }
+    m_inspectingCache = true;
+    
+    MetadataCache::inspectAsync(m_repositories).then(this, [this](const QList<RepoCacheInfo> &caches) {
+        m_inspectingCache = false;
+        fillCacheTable(caches);
+        if (m_inspectCacheAgain) {
+            m_inspectCacheAgain = false;
+            updateCacheTable();
+        }
+    });
+}
+
+void RepositoryManager::fillCacheTable(const QList<RepoCacheInfo> &caches)
+{
+    m_cacheTable->setRowCount(caches.size());
+    
+    qint64 totalSize = 0;
+    int stale = 0;
+    for (int i = 0; i < caches.size(); ++i) {
+        const RepoCacheInfo &info = caches[i];
+        totalSize += info.sizeBytes;
+        
+        QString updated = "Never";
+        if (info.refreshed.isValid()) {
+            const qint64 hours = info.ageSeconds() / 3600;
+            updated = hours < 1 ? QString("%1 min ago").arg(info.ageSeconds() / 60)
+                    : hours < 48 ? QString("%1 h ago").arg(hours)
+                    : QString("%1 days ago").arg(hours / 24);
+        }
+        
+        QString state;
+        QColor color;
+        switch (info.state) {
+        case RepoCacheInfo::Fresh:
+            state = "Fresh";
+            color = QColor(0, 255, 0, 100);
+            break;
+        case RepoCacheInfo::Expiring:
+            state = "Expires soon";
+            color = QColor(255, 165, 0, 100);
+            ++stale;
+            break;
+        case RepoCacheInfo::Expired:
+            state = "Expired";
+            color = QColor(255, 0, 0, 100);
+            ++stale;
+            break;
+        case RepoCacheInfo::Missing:
+            state = "Not cached";
+            color = QColor(255, 0, 0, 100);
+            ++stale;
+            break;
+        }
+        
+        QTableWidgetItem *nameItem = new QTableWidgetItem(info.repoId);
+        nameItem->setToolTip(info.path);
+        m_cacheTable->setItem(i, 0, nameItem);
+        QTableWidgetItem *updatedItem = new QTableWidgetItem(updated);
+        if (info.refreshed.isValid()) {
+            updatedItem->setToolTip(info.refreshed.toString(Qt::ISODate));
+        }
+        m_cacheTable->setItem(i, 1, updatedItem);
+        m_cacheTable->setItem(i, 2, new QTableWidgetItem(QString("%1 MiB").arg(info.sizeBytes / 1048576.0, 0, 'f', 1)));
+        QTableWidgetItem *stateItem = new QTableWidgetItem(state);
+        stateItem->setBackground(color);
+        m_cacheTable->setItem(i, 3, stateItem);
+    }
+    
+    m_cacheSummaryLabel->setText(QString("%1 MiB in %2, %3 to refresh")
+                                 .arg(totalSize / 1048576.0, 0, 'f', 1)
+                                 .arg(MetadataCache::cacheDirectory()).arg(stale));
+    m_makeCacheButton->setEnabled(!m_metadataCache->isRunning());
+}
+
+void RepositoryManager::refreshMetadataCache()
+{
+    if (m_metadataCache->isRunning()) return;
+    
+    m_makeCacheButton->setEnabled(false);
+    MetadataCache::inspectAsync(m_repositories).then(this, [this](const QList<RepoCacheInfo> &caches) {
+        if (m_metadataCache->isRunning()) return;
+        
+        QStringList due;
+        for (const RepoCacheInfo &info : caches) {
+            if (info.state != RepoCacheInfo::Fresh) {
+                due << info.repoId;
+            }
+        }
+        if (due.isEmpty()) {
+            m_makeCacheButton->setEnabled(true);
+            m_statusLabel->setText("Repository metadata is up to date");
+            return;
+        }
+        
+        m_metadataRefreshTotal = due.size();
+        m_metadataRefreshDone = 0;
+        showProgress(QString("Refreshing metadata for %1 repositories...").arg(due.size()));
+        m_progressBar->setRange(0, m_metadataRefreshTotal);
+        m_progressBar->setValue(0);
+        
+        if (!m_metadataCache->start(due)) {
+            hideProgress();
+            m_makeCacheButton->setEnabled(true);
+            onRepositoryActionError("No privilege escalation method available");
+        }
+    });
+}
+
+void RepositoryManager::onMetadataRepoFinished(const QString &repoId, bool success)
+{
+    ++m_metadataRefreshDone;
+    if (m_metadataRefreshTotal > 0) {
+        m_progressBar->setValue(m_metadataRefreshDone);
+    }
+    onRepositoryActionProgress(QString("%1: metadata %2").arg(repoId, success ? "refreshed" : "refresh failed"));
+    m_cacheTableTimer->start();
+}
+
+void RepositoryManager::onMetadataRefreshFinished(int refreshed, int failed)
+{
+    // Scheduled refreshes run without a progress bar of their own
+    if (m_metadataRefreshTotal > 0) {
+        hideProgress();
+    }
+    m_metadataRefreshTotal = 0;
+    m_metadataRefreshDone = 0;
+    
+    m_cacheTableTimer->stop();
+    updateCacheTable();
+    m_progressOutput->append(QString("[%1] Metadata refreshed for %2 repositories, %3 failed")
+                             .arg(QDateTime::currentDateTime().toString("hh:mm:ss"))
+                             .arg(refreshed).arg(failed));
+}
+
+void RepositoryManager::checkRepositoryHealth()
+{
+    if (m_healthProber->isRunning()) return;
     
-    auto result = SystemUtils::runCommand("dnf", {"repolist", "all", "--verbose"});
-    if (result.first == 0) {
-        m_repositories = parseRepositoryList(result.second);
-        updateRepositoryTable(m_repositories);
+    m_repoHealth.clear();
+    m_checkHealthButton->setEnabled(false);
+    showProgress("Checking repository mirrors...");
+    m_healthProber->probe(m_repositories);
+}
+
+void RepositoryManager::onMirrorProbed(const MirrorProbe &probe)
+{
+    if (probe.isReachable()) {
+        m_progressOutput->append(QString("%1: %2 in %3 ms, %4 KiB/s")
+                                 .arg(probe.repoId, probe.baseUrl).arg(probe.ttfbMs)
+                                 .arg(qRound(probe.bytesPerSecond / 1024)));
     } else {
-        onRepositoryActionError("Failed to load repository information");
+        m_progressOutput->append(QString("%1: %2 failed: %3")
+                                 .arg(probe.repoId, probe.baseUrl,
+                                      probe.error.isEmpty() ? QString("HTTP %1").arg(probe.httpStatus) : probe.error));
+    }
+}
+
+void RepositoryManager::onRepositoryProbed(const RepoHealth &health)
+{
+    m_repoHealth.insert(health.repoId, health);
+    
+    for (int row = 0; row < m_repoTable->rowCount(); ++row) {
+        QTableWidgetItem *nameItem = m_repoTable->item(row, REPO_COLUMN_NAME);
+        if (nameItem && nameItem->text() == health.repoId) {
+            updateRepositoryStatus(row);
+            if (m_repoTable->currentRow() == row) {
+                showRepositoryDetails(row, REPO_COLUMN_NAME);
+            }
+            break;
+        }
+    }
+}
+
+void RepositoryManager::onHealthCheckFinished()
+{
+    // Suggested costs are only known once every repository has answered
+    m_repoHealth = m_healthProber->results();
+    
+    int unreachable = 0;
+    int stale = 0;
+    for (const RepoHealth &health : std::as_const(m_repoHealth)) {
+        const MirrorProbe *best = health.best();
+        if (!best || !best->isReachable()) {
+            ++unreachable;
+        } else if (!best->fresh) {
+            ++stale;
+        }
+    }
+    
+    if (m_repoTable->currentRow() >= 0) {
+        showRepositoryDetails(m_repoTable->currentRow(), REPO_COLUMN_NAME);
     }
     
     hideProgress();
+    m_checkHealthButton->setEnabled(true);
+    m_progressOutput->append(QString("[%1] Checked %2 repositories: %3 unreachable, %4 serving stale metadata")
+                             .arg(QDateTime::currentDateTime().toString("hh:mm:ss"))
+                             .arg(m_repoHealth.size()).arg(unreachable).arg(stale));
 }
 
 void RepositoryManager::refreshFlatpakRemotes()
 {
-    if (!SystemUtils::isFlatpakAvailable()) {
+    if (!FlatpakBackend::isAvailable()) {
         return;
     }
     
-    showProgress("Loading Flatpak remotes...");
+    // Loads in the background; the table is filled when it is done
+    FlatpakBackend::instance()->refresh();
+}
+
+void RepositoryManager::onFlatpakRefreshed()
+{
+    m_flatpakRemotes = FlatpakBackend::instance()->remotes();
+    updateFlatpakTable(m_flatpakRemotes);
+}
+
+void RepositoryManager::onAppCatalogLoaded(int apps, int reparsedRemotes)
+{
+    Q_UNUSED(reparsedRemotes)
+    m_appSearchLabel->setText(QString("%1 applications available").arg(apps));
+    if (!m_appSearchEdit->text().trimmed().isEmpty()) {
+        searchApps();
+    }
+}
+
+void RepositoryManager::searchApps()
+{
+    AppstreamCatalog *catalog = AppstreamCatalog::instance();
+    const QString query = m_appSearchEdit->text();
+    
+    QElapsedTimer timer;
+    timer.start();
+    const QList<CatalogApp> results = catalog->search(query);
+    const double elapsedMs = timer.nsecsElapsed() / 1e6;
+    
+    m_appResultsList->clear();
+    for (const CatalogApp &app : results) {
+        QListWidgetItem *item = new QListWidgetItem(QString("%1 - %2").arg(app.name, app.summary));
+        item->setData(Qt::UserRole, app.id);
+        item->setToolTip(QString("%1\nFrom %2%3").arg(app.id, app.remote, app.isSystem ? QString() : " (user)"));
+        
+        item->setIcon(app.iconFile.isEmpty() ? QIcon::fromTheme("application-x-executable") : QIcon(app.iconFile));
+        m_appResultsList->addItem(item);
+    }
     
-    auto result = SystemUtils::runCommand("flatpak", {"remotes", "--show-details"});
-    if (result.first == 0) {
-        m_flatpakRemotes = parseFlatpakRemotes(result.second);
-        updateFlatpakTable(m_flatpakRemotes);
+    if (query.trimmed().isEmpty()) {
+        m_appSearchLabel->setText(QString("%1 applications available").arg(catalog->size()));
     } else {
-        onRepositoryActionError("Failed to load Flatpak remotes");
+        m_appSearchLabel->setText(QString("%1 results in %2 ms").arg(results.size()).arg(elapsedMs, 0, 'f', 1));
     }
+    m_installAppButton->setEnabled(false);
+}
+
+void RepositoryManager::installSelectedApp()
+{
+    QListWidgetItem *item = m_appResultsList->currentItem();
+    if (!item) return;
     
-    hideProgress();
+    const CatalogApp *app = AppstreamCatalog::instance()->app(item->data(Qt::UserRole).toString());
+    if (!app) return;
+    
+    startFlatpakTransaction(FlatpakBackend::instance()->installApp(app->id, app->remote, !app->isSystem),
+                            QString("Installing %1 from %2...").arg(app->name, app->remote));
+}
+
+void RepositoryManager::checkFlatpakUpdates()
+{
+    if (m_flatpakUpdater->isRunning()) return;
+    
+    m_checkFlatpakUpdatesButton->setEnabled(false);
+    m_updateFlatpaksButton->setEnabled(false);
+    m_flatpakUpdateLabel->setText("Checking remotes for updates...");
+    m_flatpakUpdater->checkForUpdates();
+}
+
+void RepositoryManager::onFlatpakUpdatesAvailable(int count, const QString &error)
+{
+    m_checkFlatpakUpdatesButton->setEnabled(true);
+    m_updateFlatpaksButton->setEnabled(count > 0);
+    
+    const QList<FlatpakRefInfo> updates = m_flatpakUpdater->pendingUpdates();
+    m_flatpakUpdateTable->setRowCount(updates.size());
+    for (int i = 0; i < updates.size(); ++i) {
+        const FlatpakRefInfo &ref = updates[i];
+        m_flatpakUpdateTable->setItem(i, 0, new QTableWidgetItem(ref.ref()));
+        m_flatpakUpdateTable->setItem(i, 1, new QTableWidgetItem(ref.isSystem ? ref.installation : "user"));
+        m_flatpakUpdateTable->setItem(i, 2, new QTableWidgetItem());
+        m_flatpakUpdateTable->setItem(i, 3, new QTableWidgetItem());
+        m_flatpakUpdateTable->setItem(i, 4, new QTableWidgetItem(QString("%1 -> %2")
+                                                                     .arg(ref.commit.left(12), ref.latestCommit.left(12))));
+    }
+    
+    if (!error.isEmpty()) {
+        onRepositoryActionProgress(QString("Checking Flatpak updates: %1").arg(error));
+    }
+    m_flatpakUpdateLabel->setText(count > 0 ? QString("%1 updates available").arg(count) : QString("Everything is up to date"));
+}
+
+void RepositoryManager::updateAllFlatpaks()
+{
+    if (!m_flatpakUpdater->start()) return;
+    
+    m_checkFlatpakUpdatesButton->setEnabled(false);
+    m_updateFlatpaksButton->setEnabled(false);
+    m_flatpakUpdateTable->setRowCount(0);
+    const QList<FlatpakUpdateItem> items = m_flatpakUpdater->items();
+    for (int i = 0; i < items.size(); ++i) {
+        onFlatpakUpdateItemChanged(i);
+    }
+    showProgress("Updating Flatpak applications and runtimes...");
+}
+
+void RepositoryManager::onFlatpakUpdateItemChanged(int index)
+{
+    const QList<FlatpakUpdateItem> items = m_flatpakUpdater->items();
+    if (index < 0 || index >= items.size()) return;
+    const FlatpakUpdateItem &item = items[index];
+    
+    if (index >= m_flatpakUpdateTable->rowCount()) {
+        m_flatpakUpdateTable->setRowCount(index + 1);
+        for (int column = 0; column < m_flatpakUpdateTable->columnCount(); ++column) {
+            m_flatpakUpdateTable->setItem(index, column, new QTableWidgetItem());
+        }
+    }
+    
+    QString downloaded = QString("%1 MiB").arg(item.bytesTransferred / 1048576.0, 0, 'f', 1);
+    if (item.downloadSize > 0) {
+        downloaded += QString(" of %1").arg(item.downloadSize / 1048576.0, 0, 'f', 1);
+    }
+    m_flatpakUpdateTable->item(index, 0)->setText(item.ref);
+    m_flatpakUpdateTable->item(index, 1)->setText(item.isSystem ? item.installation : "user");
+    m_flatpakUpdateTable->item(index, 2)->setText(QString("%1%").arg(item.percent));
+    m_flatpakUpdateTable->item(index, 3)->setText(downloaded);
+    m_flatpakUpdateTable->item(index, 4)->setText(item.status);
+    
+    updateFlatpakUpdateSummary();
+}
+
+void RepositoryManager::updateFlatpakUpdateSummary()
+{
+    const int percent = m_flatpakUpdater->overallPercent();
+    if (m_progressBar && m_flatpakUpdater->isRunning()) {
+        m_progressBar->setRange(0, 100);
+        m_progressBar->setValue(percent);
+    }
+    
+    // Saved bytes show how much static deltas and shared objects spared; a large
+    // download with little saved means whole new commits were fetched
+    m_flatpakUpdateLabel->setText(QString("%1% of %2 refs, %3 MiB downloaded, %4 MiB saved by deltas")
+                                  .arg(percent)
+                                  .arg(m_flatpakUpdater->items().size())
+                                  .arg(m_flatpakUpdater->bytesTransferred() / 1048576.0, 0, 'f', 1)
+                                  .arg(m_flatpakUpdater->bytesSaved() / 1048576.0, 0, 'f', 1));
+}
+
+void RepositoryManager::onFlatpakUpdateFinished(bool success, const QString &error)
+{
+    updateFlatpakUpdateSummary();
+    m_checkFlatpakUpdatesButton->setEnabled(true);
+    
+    if (success) {
+        onRepositoryActionSuccess(QString());
+    } else {
+        onRepositoryActionError(error);
+    }
 }
 
 void RepositoryManager::updateRepositoryTable(const QList<RepositoryInfo> &repositories)
 {
-    m_repoTable->setRowCount(repositories.size());
+    // Filling the enabled column must not look like the user toggling it
+    const QSignalBlocker blocker(m_repoTable);
     m_repoTable->setSortingEnabled(false);
+    m_repoTable->setRowCount(repositories.size());
     
     for (int i = 0; i < repositories.size(); ++i) {
         const RepositoryInfo &repo = repositories[i];
         
         QTableWidgetItem *nameItem = new QTableWidgetItem(repo.id);
         nameItem->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
+        nameItem->setData(Qt::UserRole, i);
         m_repoTable->setItem(i, REPO_COLUMN_NAME, nameItem);
         
         QTableWidgetItem *enabledItem = new QTableWidgetItem();
@@ -392,18 +990,17 @@ void RepositoryManager::updateRepositoryTable(const QList<RepositoryInfo> &repos
         enabledItem->setFlags(Qt::ItemIsEnabled | Qt::ItemIsUserCheckable);
         m_repoTable->setItem(i, REPO_COLUMN_ENABLED, enabledItem);
         
-        QTableWidgetItem *urlItem = new QTableWidgetItem(repo.baseUrl);
+        QString url = repo.baseUrl;
+        if (url.isEmpty()) url = repo.metalink;
+        if (url.isEmpty()) url = repo.mirrorList;
+        QTableWidgetItem *urlItem = new QTableWidgetItem(url);
         urlItem->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
         m_repoTable->setItem(i, REPO_COLUMN_URL, urlItem);
         
-        QTableWidgetItem *statusItem = new QTableWidgetItem(repo.status);
+        QTableWidgetItem *statusItem = new QTableWidgetItem();
         statusItem->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
-        if (repo.enabled) {
-            statusItem->setBackground(QColor(0, 255, 0, 100));
-        } else {
-            statusItem->setBackground(QColor(255, 0, 0, 100));
-        }
         m_repoTable->setItem(i, REPO_COLUMN_STATUS, statusItem);
+        updateRepositoryStatus(i);
     }
     
     m_repoTable->setSortingEnabled(true);
@@ -411,16 +1008,19 @@ void RepositoryManager::updateRepositoryTable(const QList<RepositoryInfo> &repos
     updateButtonStates();
 }
 
-void RepositoryManager::updateFlatpakTable(const QList<FlatpakRemote> &remotes)
+void RepositoryManager::updateFlatpakTable(const QList<FlatpakRemoteInfo> &remotes)
 {
-    m_flatpakTable->setRowCount(remotes.size());
+    const QSignalBlocker blocker(m_flatpakTable);
     m_flatpakTable->setSortingEnabled(false);
+    m_flatpakTable->setRowCount(remotes.size());
     
     for (int i = 0; i < remotes.size(); ++i) {
-        const FlatpakRemote &remote = remotes[i];
+        const FlatpakRemoteInfo &remote = remotes[i];
         
         QTableWidgetItem *nameItem = new QTableWidgetItem(remote.name);
         nameItem->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
+        nameItem->setData(Qt::UserRole, i);
+        nameItem->setToolTip(remote.isSystem ? QString("System installation (%1)").arg(remote.installation) : "User installation");
         m_flatpakTable->setItem(i, FLATPAK_COLUMN_NAME, nameItem);
         
         QTableWidgetItem *enabledItem = new QTableWidgetItem();
@@ -438,14 +1038,22 @@ void RepositoryManager::updateFlatpakTable(const QList<FlatpakRemote> &remotes)
     }
     
     m_flatpakTable->setSortingEnabled(true);
-    m_flatpakCountLabel->setText(QString("%1 remotes").arg(remotes.size()));
+    int apps = 0;
+    int runtimes = 0;
+    for (const FlatpakRefInfo &ref : FlatpakBackend::instance()->installedRefs()) {
+        ref.kind == FlatpakRefInfo::App ? ++apps : ++runtimes;
+    }
+    m_flatpakCountLabel->setText(QString("%1 remotes, %2 apps and %3 runtimes installed")
+                                 .arg(remotes.size()).arg(apps).arg(runtimes));
     updateButtonStates();
 }
 
 void RepositoryManager::onRepoTableItemChanged(QTableWidgetItem *item)
 {
     if (item->column() == REPO_COLUMN_ENABLED) {
-        int row = item->row();
+        // Rows are sorted, so go through the index stored on the name cell
+        QTableWidgetItem *nameItem = m_repoTable->item(item->row(), REPO_COLUMN_NAME);
+        int row = nameItem ? nameItem->data(Qt::UserRole).toInt() : -1;
         if (row >= 0 && row < m_repositories.size()) {
             const RepositoryInfo &repo = m_repositories[row];
             bool enable = item->checkState() == Qt::Checked;
@@ -464,17 +1072,15 @@ void RepositoryManager::onRepoTableItemChanged(QTableWidgetItem *item)
 void RepositoryManager::onFlatpakTableItemChanged(QTableWidgetItem *item)
 {
     if (item->column() == FLATPAK_COLUMN_ENABLED) {
-        int row = item->row();
+        QTableWidgetItem *nameItem = m_flatpakTable->item(item->row(), FLATPAK_COLUMN_NAME);
+        int row = nameItem ? nameItem->data(Qt::UserRole).toInt() : -1;
         if (row >= 0 && row < m_flatpakRemotes.size()) {
-            const FlatpakRemote &remote = m_flatpakRemotes[row];
+            const FlatpakRemoteInfo &remote = m_flatpakRemotes[row];
             bool enable = item->checkState() == Qt::Checked;
             
             if (enable != remote.enabled) {
-                if (enable) {
-                    enableFlatpakRemote(remote.name);
-                } else {
-                    disableFlatpakRemote(remote.name);
-                }
+                startFlatpakTransaction(FlatpakBackend::instance()->setRemoteEnabled(remote, enable),
+                                        QString("%1 Flatpak remote %2...").arg(enable ? "Enabling" : "Disabling", remote.name));
             }
         }
     }
@@ -482,6 +1088,8 @@ void RepositoryManager::onFlatpakTableItemChanged(QTableWidgetItem *item)
 
 void RepositoryManager::showRepositoryDetails(int row, int column)
 {
+    QTableWidgetItem *nameItem = m_repoTable->item(row, REPO_COLUMN_NAME);
+    row = nameItem ? nameItem->data(Qt::UserRole).toInt() : -1;
     if (row >= 0 && row < m_repositories.size()) {
         updateRepositoryDetails(m_repositories[row]);
     }
@@ -489,6 +1097,8 @@ void RepositoryManager::showRepositoryDetails(int row, int column)
 
 void RepositoryManager::showFlatpakDetails(int row, int column)
 {
+    QTableWidgetItem *nameItem = m_flatpakTable->item(row, FLATPAK_COLUMN_NAME);
+    row = nameItem ? nameItem->data(Qt::UserRole).toInt() : -1;
     if (row >= 0 && row < m_flatpakRemotes.size()) {
         updateFlatpakDetails(m_flatpakRemotes[row]);
     }
@@ -508,22 +1118,46 @@ void RepositoryManager::updateRepositoryDetails(const RepositoryInfo &repo)
         "<p><b>Cost:</b> %9</p>"
         "<p><b>Priority:</b> %10</p>"
         "<p><b>Description:</b><br>%11</p>"
+        "<p><b>File:</b> %12</p>"
     ).arg(repo.id)
      .arg(repo.name.isEmpty() ? "N/A" : repo.name)
      .arg(repo.enabled ? "Yes" : "No")
      .arg(repo.baseUrl.isEmpty() ? "N/A" : repo.baseUrl)
-     .arg(repo.mirrorList.isEmpty() ? "N/A" : repo.mirrorList)
+     .arg(!repo.metalink.isEmpty() ? repo.metalink : repo.mirrorList.isEmpty() ? "N/A" : repo.mirrorList)
      .arg(repo.status)
      .arg(repo.gpgCheck.isEmpty() ? "N/A" : repo.gpgCheck)
      .arg(repo.gpgKey.isEmpty() ? "N/A" : repo.gpgKey)
      .arg(repo.cost.isEmpty() ? "N/A" : repo.cost)
      .arg(repo.priority.isEmpty() ? "N/A" : repo.priority)
-     .arg(repo.description.isEmpty() ? "No description available." : repo.description);
+     .arg(repo.description.isEmpty() ? "No description available." : repo.description)
+     .arg(repo.filePath);
+    
+    if (m_repoHealth.contains(repo.id)) {
+        const RepoHealth &health = m_repoHealth[repo.id];
+        details += "<h4>Mirrors</h4><table cellspacing=\"4\">"
+                   "<tr><th align=\"left\">URL</th><th>Response</th><th>Speed</th><th>Metadata</th></tr>";
+        for (const MirrorProbe &mirror : health.mirrors) {
+            if (mirror.isReachable()) {
+                details += QString("<tr><td>%1</td><td>%2 ms</td><td>%3 KiB/s</td><td>%4</td></tr>")
+                           .arg(mirror.baseUrl.toHtmlEscaped()).arg(mirror.ttfbMs)
+                           .arg(qRound(mirror.bytesPerSecond / 1024))
+                           .arg(mirror.fresh ? "current" : "stale");
+            } else {
+                details += QString("<tr><td>%1</td><td colspan=\"3\">%2</td></tr>")
+                           .arg(mirror.baseUrl.toHtmlEscaped(),
+                                (mirror.error.isEmpty() ? QString("HTTP %1").arg(mirror.httpStatus) : mirror.error).toHtmlEscaped());
+            }
+        }
+        details += "</table>";
+        if (health.suggestedCost > 0) {
+            details += QString("<p><b>Suggested cost:</b> %1</p>").arg(health.suggestedCost);
+        }
+    }
     
     m_repoDetailsText->setHtml(details);
 }
 
-void RepositoryManager::updateFlatpakDetails(const FlatpakRemote &remote)
+void RepositoryManager::updateFlatpakDetails(const FlatpakRemoteInfo &remote)
 {
     QString details = QString(
         "<h3>%1</h3>"
@@ -537,10 +1171,24 @@ void RepositoryManager::updateFlatpakDetails(const FlatpakRemote &remote)
      .arg(remote.title.isEmpty() ? "N/A" : remote.title)
      .arg(remote.enabled ? "Yes" : "No")
      .arg(remote.url)
-     .arg(remote.isSystem ? "System" : "User")
+     .arg(remote.isSystem ? QString("System (%1)").arg(remote.installation) : QString("User"))
      .arg(remote.filter.isEmpty() ? "None" : remote.filter)
      .arg(remote.description.isEmpty() ? "No description available." : remote.description);
     
+    QStringList installed;
+    for (const FlatpakRefInfo &ref : FlatpakBackend::instance()->installedRefs()) {
+        if (ref.origin == remote.name && ref.installation == remote.installation && ref.kind == FlatpakRefInfo::App) {
+            installed << (ref.appName.isEmpty() ? ref.name : ref.appName).toHtmlEscaped();
+        }
+    }
+    details += QString("<p><b>Installed from here:</b> %1</p>")
+               .arg(installed.isEmpty() ? QString("None") : installed.join(", "));
+    
+    // The details pane is optional in this layout; the status line gets a summary instead
+    if (!m_flatpakDetailsText) {
+        m_statusLabel->setText(QString("%1: %2 apps installed from this remote").arg(remote.name).arg(installed.size()));
+        return;
+    }
     m_flatpakDetailsText->setHtml(details);
 }
 
@@ -583,19 +1231,30 @@ void RepositoryManager::addRepository()
 
 void RepositoryManager::removeRepository()
 {
-    int currentRow = m_repoTable->currentRow();
+    QTableWidgetItem *nameItem = m_repoTable->item(m_repoTable->currentRow(), REPO_COLUMN_NAME);
+    int currentRow = nameItem ? nameItem->data(Qt::UserRole).toInt() : -1;
     if (currentRow >= 0 && currentRow < m_repositories.size()) {
         const RepositoryInfo &repo = m_repositories[currentRow];
         
-        int result = QMessageBox::question(this, "Remove Repository",
-                                         QString("Are you sure you want to remove repository '%1'?").arg(repo.id),
+        // The file goes as a whole, so name every repository it defines
+        QStringList sharing;
+        for (const RepositoryInfo &other : m_repositories) {
+            if (other.filePath == repo.filePath && other.id != repo.id) {
+                sharing << other.id;
+            }
+        }
+        QString question = QString("Are you sure you want to remove repository '%1'?").arg(repo.id);
+        if (!sharing.isEmpty()) {
+            question += QString("\n\n%1 also defines: %2").arg(repo.filePath, sharing.join(", "));
+        }
+        
+        int result = QMessageBox::question(this, "Remove Repository", question,
                                          QMessageBox::Yes | QMessageBox::No);
         
         if (result == QMessageBox::Yes) {
             showProgress(QString("Removing repository %1...").arg(repo.id));
             
-            QString repoFile = QString("/etc/yum.repos.d/%1.repo").arg(repo.id);
-            m_privilegedExecutor->deleteSystemFile(repoFile, this,
+            m_privilegedExecutor->deleteSystemFile(repo.filePath, this,
                                                   SLOT(onRepositoryActionSuccess(QString)),
                                                   SLOT(onRepositoryActionError(QString)));
         }
@@ -620,71 +1279,46 @@ void RepositoryManager::addFlatpakRemote()
                                           "Remote URL:", QLineEdit::Normal, "", &ok);
         
         if (ok && !url.isEmpty()) {
-            showProgress(QString("Adding Flatpak remote %1...").arg(name));
-            
-            QStringList args;
-            args << "remote-add" << "--if-not-exists" << name << url;
-            
-            m_privilegedExecutor->executeCommandAsync("flatpak", args,
-                                                     QString("Adding Flatpak remote %1").arg(name),
-                                                     this,
-                                                     SLOT(onRepositoryActionSuccess(QString)),
-                                                     SLOT(onRepositoryActionError(QString)));
+            startFlatpakTransaction(FlatpakBackend::instance()->addRemote(name, url),
+                                    QString("Adding Flatpak remote %1...").arg(name));
         }
     }
 }
 
 void RepositoryManager::removeFlatpakRemote()
 {
-    int currentRow = m_flatpakTable->currentRow();
+    QTableWidgetItem *nameItem = m_flatpakTable->item(m_flatpakTable->currentRow(), FLATPAK_COLUMN_NAME);
+    int currentRow = nameItem ? nameItem->data(Qt::UserRole).toInt() : -1;
     if (currentRow >= 0 && currentRow < m_flatpakRemotes.size()) {
-        const FlatpakRemote &remote = m_flatpakRemotes[currentRow];
+        const FlatpakRemoteInfo remote = m_flatpakRemotes[currentRow];
         
         int result = QMessageBox::question(this, "Remove Flatpak Remote",
                                          QString("Are you sure you want to remove remote '%1'?").arg(remote.name),
                                          QMessageBox::Yes | QMessageBox::No);
         
         if (result == QMessageBox::Yes) {
-            showProgress(QString("Removing Flatpak remote %1...").arg(remote.name));
-            
-            QStringList args;
-            args << "remote-delete" << remote.name;
-            
-            m_privilegedExecutor->executeCommandAsync("flatpak", args,
-                                                     QString("Removing Flatpak remote %1").arg(remote.name),
-                                                     this,
-                                                     SLOT(onRepositoryActionSuccess(QString)),
-                                                     SLOT(onRepositoryActionError(QString)));
+            startFlatpakTransaction(FlatpakBackend::instance()->removeRemote(remote),
+                                    QString("Removing Flatpak remote %1...").arg(remote.name));
         }
     }
 }
 
 void RepositoryManager::enableFlatpakRemote(const QString &remoteName)
 {
-    showProgress(QString("Enabling Flatpak remote %1...").arg(remoteName));
+    const FlatpakRemoteInfo *remote = findFlatpakRemote(remoteName);
+    if (!remote) return;
     
-    QStringList args;
-    args << "remote-modify" << "--enable" << remoteName;
-    
-    m_privilegedExecutor->executeCommandAsync("flatpak", args,
-                                             QString("Enabling Flatpak remote %1").arg(remoteName),
-                                             this,
-                                             SLOT(onRepositoryActionSuccess(QString)),
-                                             SLOT(onRepositoryActionError(QString)));
+    startFlatpakTransaction(FlatpakBackend::instance()->setRemoteEnabled(*remote, true),
+                            QString("Enabling Flatpak remote %1...").arg(remoteName));
 }
 
 void RepositoryManager::disableFlatpakRemote(const QString &remoteName)
 {
-    showProgress(QString("Disabling Flatpak remote %1...").arg(remoteName));
-    
-    QStringList args;
-    args << "remote-modify" << "--disable" << remoteName;
+    const FlatpakRemoteInfo *remote = findFlatpakRemote(remoteName);
+    if (!remote) return;
     
-    m_privilegedExecutor->executeCommandAsync("flatpak", args,
-                                             QString("Disabling Flatpak remote %1").arg(remoteName),
-                                             this,
-                                             SLOT(onRepositoryActionSuccess(QString)),
-                                             SLOT(onRepositoryActionError(QString)));
+    startFlatpakTransaction(FlatpakBackend::instance()->setRemoteEnabled(*remote, false),
+                            QString("Disabling Flatpak remote %1...").arg(remoteName));
 }
 
 void RepositoryManager::installFlatpak()
@@ -695,38 +1329,21 @@ void RepositoryManager::installFlatpak()
                                          QLineEdit::Normal, "", &ok);
     
     if (ok && !appId.isEmpty()) {
-        showProgress(QString("Installing Flatpak application %1...").arg(appId));
-        
-        QStringList args;
-        args << "install" << "-y" << appId;
-        
-        m_privilegedExecutor->executeCommandAsync("flatpak", args,
-                                                 QString("Installing Flatpak application %1").arg(appId),
-                                                 this,
-                                                 SLOT(onRepositoryActionSuccess(QString)),
-                                                 SLOT(onRepositoryActionError(QString)),
-                                                 SLOT(onRepositoryActionProgress(QString)));
+        startFlatpakTransaction(FlatpakBackend::instance()->installApp(appId.trimmed()),
+                                QString("Installing Flatpak application %1...").arg(appId));
     }
 }
 
 void RepositoryManager::addPredefinedFlatpakRemote(const QString &remoteName, const QString &url)
 {
-    if (!SystemUtils::isFlatpakAvailable()) {
+    if (!FlatpakBackend::isAvailable()) {
         QMessageBox::warning(this, "Flatpak Not Available", 
                            "Flatpak is not installed on this system. Please install Flatpak first.");
         return;
     }
     
-    showProgress(QString("Adding %1 remote...").arg(remoteName));
-    
-    QStringList args;
-    args << "remote-add" << "--if-not-exists" << remoteName << url;
-    
-    m_privilegedExecutor->executeCommandAsync("flatpak", args,
-                                             QString("Adding %1 remote").arg(remoteName),
-                                             this,
-                                             SLOT(onRepositoryActionSuccess(QString)),
-                                             SLOT(onRepositoryActionError(QString)));
+    startFlatpakTransaction(FlatpakBackend::instance()->addRemote(remoteName, url),
+                            QString("Adding %1 remote...").arg(remoteName));
 }
 
 void RepositoryManager::onRepositoryActionSuccess(const QString &output)
@@ -740,7 +1357,7 @@ void RepositoryManager::onRepositoryActionSuccess(const QString &output)
     }
     
     refreshRepositories();
-    if (SystemUtils::isFlatpakAvailable()) {
+    if (FlatpakBackend::isAvailable()) {
         refreshFlatpakRemotes();
     }
 }
@@ -782,7 +1399,7 @@ void RepositoryManager::updateButtonStates()
     m_removeRepoButton->setEnabled(hasRepoSelection);
     m_editRepoButton->setEnabled(hasRepoSelection);
     
-    if (SystemUtils::isFlatpakAvailable()) {
+    if (FlatpakBackend::isAvailable()) {
         m_removeFlatpakButton->setEnabled(hasFlatpakSelection);
     }
 }
@@ -808,135 +1425,76 @@ void RepositoryManager::hideProgress()
     }
 }
 
-QList<RepositoryInfo> RepositoryManager::parseRepositoryList(const QString &output)
+void RepositoryManager::quickAddFlathub()
 {
-    QList<RepositoryInfo> repositories;
-    QStringList lines = output.split('\n');
-    
-    RepositoryInfo currentRepo;
-    bool inRepoSection = false;
-    
-    for (const QString &line : lines) {
-        QString trimmedLine = line.trimmed();
-        
-        if (trimmedLine.startsWith("Repo-id")) {
-            if (inRepoSection && !currentRepo.id.isEmpty()) {
-                repositories.append(currentRepo);
-            }
-            currentRepo = RepositoryInfo();
-            inRepoSection = true;
-            currentRepo.id = trimmedLine.split(":").last().trimmed();
-        } else if (inRepoSection) {
-            if (trimmedLine.startsWith("Repo-name")) {
-                currentRepo.name = trimmedLine.split(":").last().trimmed();
-            } else if (trimmedLine.startsWith("Repo-status")) {
-                QString status = trimmedLine.split(":").last().trimmed();
-                currentRepo.enabled = status.contains("enabled", Qt::CaseInsensitive);
-                currentRepo.status = status;
-            } else if (trimmedLine.startsWith("Repo-baseurl")) {
-                currentRepo.baseUrl = trimmedLine.split(":").last().trimmed();
-            } else if (trimmedLine.startsWith("Repo-metalink")) {
-                if (currentRepo.baseUrl.isEmpty()) {
-                    currentRepo.baseUrl = trimmedLine.split(":").last().trimmed();
-                }
-            } else if (trimmedLine.startsWith("Repo-mirrors")) {
-                currentRepo.mirrorList = trimmedLine.split(":").last().trimmed();
-            } else if (trimmedLine.startsWith("Repo-description")) {
-                currentRepo.description = trimmedLine.split(":").last().trimmed();
-            }
-        }
+    if (!FlatpakBackend::isAvailable()) {
+        m_statusLabel->setText("Flatpak is not installed on this system");
+        return;
     }
     
-    if (inRepoSection && !currentRepo.id.isEmpty()) {
-        repositories.append(currentRepo);
+    // Check if Flathub already exists
+    for (const FlatpakRemoteInfo &remote : m_flatpakRemotes) {
+        if (remote.name == "flathub") {
+            m_statusLabel->setText("Flathub is already added");
+            QTimer::singleShot(3000, [this]() { m_statusLabel->setText("Ready"); });
+            return;
+        }
     }
     
-    return repositories;
+    startFlatpakTransaction(FlatpakBackend::instance()->addRemote("flathub", "https://dl.flathub.org/repo/flathub.flatpakrepo"),
+                            "Adding Flathub repository...");
 }
 
-QList<FlatpakRemote> RepositoryManager::parseFlatpakRemotes(const QString &output)
+void RepositoryManager::startFlatpakTransaction(int transaction, const QString &message)
 {
-    QList<FlatpakRemote> remotes;
-    QStringList lines = output.split('\n');
+    if (transaction <= 0) return;
     
-    for (const QString &line : lines) {
-        QString trimmedLine = line.trimmed();
-        if (trimmedLine.isEmpty() || trimmedLine.startsWith("Name")) {
-            continue;
-        }
-        
-        QStringList parts = trimmedLine.split('\t');
-        if (parts.size() >= 4) {
-            FlatpakRemote remote;
-            remote.name = parts[0].trimmed();
-            remote.enabled = !parts[1].contains("disabled");
-            remote.url = parts[2].trimmed();
-            remote.title = parts[3].trimmed();
-            remote.isSystem = parts.size() > 4 && parts[4].contains("system");
-            
-            remotes.append(remote);
+    m_flatpakTransactions.insert(transaction);
+    m_lastFlatpakStatus.clear();
+    showProgress(message);
+}
+
+const FlatpakRemoteInfo *RepositoryManager::findFlatpakRemote(const QString &name) const
+{
+    for (const FlatpakRemoteInfo &remote : m_flatpakRemotes) {
+        if (remote.name == name) {
+            return &remote;
         }
     }
-    
-    return remotes;
+    return nullptr;
 }
 
-RepositoryInfo RepositoryManager::parseRepositoryInfo(const QString &block)
+void RepositoryManager::onFlatpakProgress(const FlatpakProgress &progress)
 {
-    RepositoryInfo repo;
-    QStringList lines = block.split('\n');
+    if (!m_flatpakTransactions.contains(progress.transaction)) return;
     
-    for (const QString &line : lines) {
-        QString trimmedLine = line.trimmed();
-        if (trimmedLine.startsWith("repo id:")) {
-            repo.id = trimmedLine.split(":").last().trimmed();
-        } else if (trimmedLine.startsWith("repo name:")) {
-            repo.name = trimmedLine.split(":").last().trimmed();
-        } else if (trimmedLine.startsWith("repo status:")) {
-            QString status = trimmedLine.split(":").last().trimmed();
-            repo.enabled = status == "enabled";
-            repo.status = status;
-        } else if (trimmedLine.startsWith("repo baseurl:")) {
-            repo.baseUrl = trimmedLine.split(":").last().trimmed();
-        } else if (trimmedLine.startsWith("repo gpgcheck:")) {
-            repo.gpgCheck = trimmedLine.split(":").last().trimmed();
-        }
+    if (progress.percent >= 0 && m_progressBar) {
+        m_progressBar->setRange(0, 100);
+        m_progressBar->setValue(progress.percent);
     }
     
-    return repo;
+    // Progress arrives several times a second; only new status lines are logged
+    QString line = progress.status;
+    if (progress.count > 0) {
+        static const char *const verbs[] = {"Installing", "Updating", "Removing"};
+        line = QString("[%1/%2] %3 %4: %5").arg(progress.index).arg(progress.count)
+               .arg(verbs[progress.operation], progress.ref, progress.status);
+    } else if (progress.done) {
+        line = QString("%1: done").arg(progress.ref);
+    }
+    if (!line.isEmpty() && line != m_lastFlatpakStatus) {
+        m_lastFlatpakStatus = line;
+        onRepositoryActionProgress(line);
+    }
 }
 
-void RepositoryManager::quickAddFlathub()
+void RepositoryManager::onFlatpakTransactionFinished(int transaction, bool success, const QString &error)
 {
-    if (!SystemUtils::isFlatpakAvailable()) {
-        m_statusLabel->setText("Flatpak is not installed on this system");
-        return;
-    }
+    if (!m_flatpakTransactions.remove(transaction)) return;
     
-    // Check if Flathub already exists
-    for (const FlatpakRemote &remote : m_flatpakRemotes) {
-        if (remote.name == "flathub") {
-            m_statusLabel->setText("Flathub is already added");
-            QTimer::singleShot(3000, [this]() { m_statusLabel->setText("Ready"); });
-            return;
-        }
+    if (success) {
+        onRepositoryActionSuccess(QString());
+    } else {
+        onRepositoryActionError(error);
     }
-    
-    showProgress("Adding Flathub repository...");
-    
-    QProcess *process = new QProcess(this);
-    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, [this, process](int exitCode, QProcess::ExitStatus exitStatus) {
-        hideProgress();
-        if (exitCode == 0) {
-            m_statusLabel->setText("Flathub added successfully");
-            refreshFlatpakRemotes();
-        } else {
-            m_statusLabel->setText("Failed to add Flathub");
-        }
-        QTimer::singleShot(3000, [this]() { m_statusLabel->setText("Ready"); });
-        process->deleteLater();
-    });
-    
-    process->start("flatpak", QStringList() << "remote-add" << "--if-not-exists" << "flathub" << "https://dl.flathub.org/repo/flathub.flatpakrepo");
-} 
\ No newline at end of file
+}
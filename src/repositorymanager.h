@@ -19,34 +19,18 @@
 #include <QListWidget>
 #include <QProgressBar>
 #include <QTimer>
+#include <QFileSystemWatcher>
+#include <QSet>
+#include "repofiles.h"
+#include "repohealth.h"
+#include "metadatacache.h"
+#include "flatpakbackend.h"
+#include "appstreamcatalog.h"
+#include "flatpakupdater.h"
 
 class SystemUtils;
 class PrivilegedExecutor;
 
-struct RepositoryInfo {
-    QString id;
-    QString name;
-    QString baseUrl;
-    QString mirrorList;
-    bool enabled;
-    QString status;
-    QString description;
-    QString gpgCheck;
-    QString gpgKey;
-    QString cost;
-    QString priority;
-};
-
-struct FlatpakRemote {
-    QString name;
-    QString url;
-    QString title;
-    QString description;
-    bool enabled;
-    bool isSystem;
-    QString filter;
-};
-
 class RepositoryManager : public QWidget
 {
     Q_OBJECT
@@ -61,6 +45,8 @@ public:
 public slots:
     void refreshRepositories();
     void refreshFlatpakRemotes();
+    void checkRepositoryHealth();
+    void refreshMetadataCache();
     void enableRepository(const QString &repoId);
     void disableRepository(const QString &repoId);
     void addRepository();
@@ -86,6 +72,23 @@ private slots:
     void onFlatpakSelectionChanged();
     void showRepositoryDetails(int row, int column);
     void showFlatpakDetails(int row, int column);
+    void onRepoFilesChanged();
+    void onMirrorProbed(const MirrorProbe &probe);
+    void onRepositoryProbed(const RepoHealth &health);
+    void onHealthCheckFinished();
+    void onMetadataRepoFinished(const QString &repoId, bool success);
+    void onMetadataRefreshFinished(int refreshed, int failed);
+    void onFlatpakRefreshed();
+    void onFlatpakProgress(const FlatpakProgress &progress);
+    void onFlatpakTransactionFinished(int transaction, bool success, const QString &error);
+    void searchApps();
+    void onAppCatalogLoaded(int apps, int reparsedRemotes);
+    void installSelectedApp();
+    void checkFlatpakUpdates();
+    void updateAllFlatpaks();
+    void onFlatpakUpdatesAvailable(int count, const QString &error);
+    void onFlatpakUpdateItemChanged(int index);
+    void onFlatpakUpdateFinished(bool success, const QString &error);
 
 private:
     void setupUI();
@@ -94,13 +97,17 @@ private:
     void setupFlatpakTab();
     void createPredefinedRemotes();
     void updateRepositoryTable(const QList<RepositoryInfo> &repositories);
-    void updateFlatpakTable(const QList<FlatpakRemote> &remotes);
+    void updateFlatpakTable(const QList<FlatpakRemoteInfo> &remotes);
     void updateRepositoryDetails(const RepositoryInfo &repo);
-    void updateFlatpakDetails(const FlatpakRemote &remote);
+    void updateFlatpakDetails(const FlatpakRemoteInfo &remote);
     void updateButtonStates();
-    QList<RepositoryInfo> parseRepositoryList(const QString &output);
-    QList<FlatpakRemote> parseFlatpakRemotes(const QString &output);
-    RepositoryInfo parseRepositoryInfo(const QString &block);
+    void watchRepositoryFiles();
+    void updateRepositoryStatus(int row);
+    void updateCacheTable();
+    void fillCacheTable(const QList<RepoCacheInfo> &caches);
+    void updateFlatpakUpdateSummary();
+    void startFlatpakTransaction(int transaction, const QString &message);
+    const FlatpakRemoteInfo *findFlatpakRemote(const QString &name) const;
     
     // UI Components
     QVBoxLayout *m_mainLayout;
@@ -119,6 +126,12 @@ private:
     QPushButton *m_removeRepoButton;
     QPushButton *m_editRepoButton;
     QPushButton *m_refreshRepoButton;
+    QPushButton *m_checkHealthButton;
+    QGroupBox *m_cacheGroup;
+    QTableWidget *m_cacheTable;
+    QLabel *m_cacheSummaryLabel;
+    QPushButton *m_makeCacheButton;
+    QCheckBox *m_autoMakeCacheCheck;
     QGroupBox *m_repoDetailsGroup;
     QTextEdit *m_repoDetailsText;
     
@@ -136,6 +149,17 @@ private:
     QPushButton *m_refreshFlatpakButton;
     QGroupBox *m_flatpakDetailsGroup;
     QTextEdit *m_flatpakDetailsText;
+    QGroupBox *m_appSearchGroup;
+    QLineEdit *m_appSearchEdit;
+    QListWidget *m_appResultsList;
+    QLabel *m_appSearchLabel;
+    QPushButton *m_installAppButton;
+    QTimer *m_appSearchTimer;
+    QGroupBox *m_flatpakUpdateGroup;
+    QTableWidget *m_flatpakUpdateTable;
+    QLabel *m_flatpakUpdateLabel;
+    QPushButton *m_checkFlatpakUpdatesButton;
+    QPushButton *m_updateFlatpaksButton;
     
     // Status and Progress
     QLabel *m_statusLabel;
@@ -160,7 +184,32 @@ private:
     
     // Data
     QList<RepositoryInfo> m_repositories;
-    QList<FlatpakRemote> m_flatpakRemotes;
+    QList<FlatpakRemoteInfo> m_flatpakRemotes;
+    
+    // /etc/yum.repos.d and the dnf variable directories; edits are picked up
+    // after a short settle delay, since tools often write several files
+    QFileSystemWatcher *m_repoWatcher;
+    QTimer *m_repoReloadTimer;
+    
+    // Mirror latency and freshness from the last health check, by repository id
+    RepoHealthProber *m_healthProber;
+    QHash<QString, RepoHealth> m_repoHealth;
+    
+    // Cached dnf metadata per repository, refreshed ahead of expiry
+    MetadataCache *m_metadataCache;
+    int m_metadataRefreshTotal;
+    int m_metadataRefreshDone;
+    // Inspections run one at a time, and finished refreshes are shown together
+    QTimer *m_cacheTableTimer;
+    bool m_inspectingCache;
+    bool m_inspectCacheAgain;
+    
+    // Flatpak transactions started from this page, and the last status shown
+    QSet<int> m_flatpakTransactions;
+    QString m_lastFlatpakStatus;
+    
+    // Pending Flatpak updates, applied per installation in parallel
+    FlatpakUpdater *m_flatpakUpdater;
     
     // Constants
     static const int REPO_COLUMN_NAME = 0;
@@ -172,6 +221,8 @@ private:
     static const int FLATPAK_COLUMN_ENABLED = 1;
     static const int FLATPAK_COLUMN_URL = 2;
     static const int FLATPAK_COLUMN_TITLE = 3;
+    
+    static const int APP_SEARCH_DELAY_MS = 150;
 };
 
 #endif // REPOSITORYMANAGER_H 
\ No newline at end of file
@@ -0,0 +1,232 @@
+#include "sysfsdevices.h"
+#include "hardwareids.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+
+namespace {
+
+const char *PCI_DEVICES_PATH = "/sys/bus/pci/devices";
+const char *USB_DEVICES_PATH = "/sys/bus/usb/devices";
+
+QString hex4(quint16 value)
+{
+    return QString("%1").arg(value, 4, 16, QChar('0'));
+}
+
+}
+
+// SysfsDevice Implementation
+QString SysfsDevice::vendorName() const
+{
+    const HardwareIds &ids = bus == "usb" ? HardwareIds::usb() : HardwareIds::pci();
+    QString name = ids.vendorName(vendorId);
+    if (name.isEmpty()) name = manufacturer;
+    if (name.isEmpty()) name = hex4(vendorId);
+    return name;
+}
+
+QString SysfsDevice::deviceName() const
+{
+    const HardwareIds &ids = bus == "usb" ? HardwareIds::usb() : HardwareIds::pci();
+    QString name = ids.deviceName(vendorId, deviceId);
+    if (name.isEmpty()) name = product;
+    if (name.isEmpty()) {
+        name = QString("%1 [%2:%3]").arg(className(), hex4(vendorId), hex4(deviceId));
+    }
+    return name;
+}
+
+QString SysfsDevice::className() const
+{
+    const HardwareIds &ids = bus == "usb" ? HardwareIds::usb() : HardwareIds::pci();
+    QString name = ids.subclassName(baseClass(), subclass());
+    if (name.isEmpty()) name = ids.className(baseClass());
+    if (name.isEmpty()) name = QString("Class %1").arg(classCode >> 8, 4, 16, QChar('0'));
+    return name;
+}
+
+QJsonObject SysfsDevice::toJson() const
+{
+    QJsonObject device;
+    device["bus_id"] = address;
+    device["type"] = bus;
+    device["vendor_id"] = hex4(vendorId);
+    device["device_id"] = hex4(deviceId);
+    device["vendor"] = vendorName();
+    device["description"] = deviceName();
+    device["class"] = className();
+    device["class_id"] = QString("%1").arg(classCode, 6, 16, QChar('0'));
+    device["modaliases"] = QJsonArray::fromStringList(modaliases);
+    device["sysfs_path"] = sysfsPath;
+    
+    if (bus == "pci") {
+        device["subsystem_vendor_id"] = hex4(subsystemVendorId);
+        device["subsystem_device_id"] = hex4(subsystemDeviceId);
+        const QString subsystem = HardwareIds::pci().subsystemName(vendorId, deviceId,
+                                                                   subsystemVendorId, subsystemDeviceId);
+        if (!subsystem.isEmpty()) {
+            device["subsystem"] = subsystem;
+        }
+    } else {
+        device["product_id"] = hex4(deviceId);
+        device["bus"] = QString("%1").arg(busNumber, 3, 10, QChar('0'));
+        device["device"] = QString("%1").arg(deviceNumber, 3, 10, QChar('0'));
+    }
+    
+    // For USB the device itself is bound to the generic "usb" driver, the
+    // interesting drivers sit on its interfaces
+    const QString driverName = interfaceDrivers.isEmpty() ? driver : interfaceDrivers.join(", ");
+    if (!driverName.isEmpty()) {
+        device["driver"] = driverName;
+        device["status"] = "loaded";
+    } else {
+        device["status"] = "detected";
+    }
+    
+    return device;
+}
+
+// SysfsDeviceEnumerator Implementation
+QList<SysfsDevice> SysfsDeviceEnumerator::pciDevices()
+{
+    QList<SysfsDevice> devices;
+    
+    const QDir dir(PCI_DEVICES_PATH);
+    const QStringList entries = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::System, QDir::Name);
+    for (const QString &entry : entries) {
+        SysfsDevice device;
+        if (readPciDevice(dir.filePath(entry), &device)) {
+            devices << device;
+        }
+    }
+    
+    return devices;
+}
+
+QList<SysfsDevice> SysfsDeviceEnumerator::usbDevices()
+{
+    QList<SysfsDevice> devices;
+    
+    const QDir dir(USB_DEVICES_PATH);
+    const QStringList entries = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::System, QDir::Name);
+    for (const QString &entry : entries) {
+        // Interfaces ("1-4:1.0") are picked up through their device ("1-4")
+        if (entry.contains(':')) continue;
+        
+        SysfsDevice device;
+        if (readUsbDevice(dir.filePath(entry), &device)) {
+            devices << device;
+        }
+    }
+    
+    return devices;
+}
+
+bool SysfsDeviceEnumerator::readDevice(const QString &bus, const QString &path, SysfsDevice *device)
+{
+    if (bus == "pci") {
+        return readPciDevice(path, device);
+    }
+    if (bus == "usb") {
+        return readUsbDevice(path, device);
+    }
+    return false;
+}
+
+bool SysfsDeviceEnumerator::readPciDevice(const QString &path, SysfsDevice *device)
+{
+    if (!QFile::exists(path + "/vendor")) {
+        return false;
+    }
+    
+    device->bus = "pci";
+    device->address = QFileInfo(path).fileName();
+    device->sysfsPath = QFileInfo(path).canonicalFilePath();
+    device->vendorId = quint16(readHexAttribute(path, "vendor"));
+    device->deviceId = quint16(readHexAttribute(path, "device"));
+    device->subsystemVendorId = quint16(readHexAttribute(path, "subsystem_vendor"));
+    device->subsystemDeviceId = quint16(readHexAttribute(path, "subsystem_device"));
+    device->classCode = readHexAttribute(path, "class");
+    device->driver = boundDriver(path);
+    const QByteArray modalias = readAttribute(path, "modalias");
+    if (!modalias.isEmpty()) {
+        device->modaliases << QString::fromLatin1(modalias);
+    }
+    
+    return true;
+}
+
+bool SysfsDeviceEnumerator::readUsbDevice(const QString &path, SysfsDevice *device)
+{
+    if (!QFile::exists(path + "/idVendor")) {
+        return false;
+    }
+    
+    device->bus = "usb";
+    device->address = QFileInfo(path).fileName();
+    device->sysfsPath = QFileInfo(path).canonicalFilePath();
+    device->vendorId = quint16(readHexAttribute(path, "idVendor"));
+    device->deviceId = quint16(readHexAttribute(path, "idProduct"));
+    device->classCode = (readHexAttribute(path, "bDeviceClass") << 16)
+                      | (readHexAttribute(path, "bDeviceSubClass") << 8)
+                      | readHexAttribute(path, "bDeviceProtocol");
+    device->driver = boundDriver(path);
+    device->manufacturer = QString::fromUtf8(readAttribute(path, "manufacturer"));
+    device->product = QString::fromUtf8(readAttribute(path, "product"));
+    device->busNumber = readAttribute(path, "busnum").toInt();
+    device->deviceNumber = readAttribute(path, "devnum").toInt();
+    
+    // The interfaces are subdirectories named "<device>:<config>.<interface>".
+    // USB drivers bind to interfaces, so only those carry a modalias.
+    const QDir dir(path);
+    const QStringList interfaces = dir.entryList(QStringList() << device->address + ":*",
+                                                 QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+    for (const QString &entry : interfaces) {
+        const QString interfacePath = dir.filePath(entry);
+        
+        // Class 00 means "defined per interface"; take the first interface's
+        if (device->classCode == 0) {
+            device->classCode = (readHexAttribute(interfacePath, "bInterfaceClass") << 16)
+                              | (readHexAttribute(interfacePath, "bInterfaceSubClass") << 8)
+                              | readHexAttribute(interfacePath, "bInterfaceProtocol");
+        }
+        
+        const QString modalias = QString::fromLatin1(readAttribute(interfacePath, "modalias"));
+        if (!modalias.isEmpty() && !device->modaliases.contains(modalias)) {
+            device->modaliases << modalias;
+        }
+        
+        const QString driver = boundDriver(interfacePath);
+        if (!driver.isEmpty() && !device->interfaceDrivers.contains(driver)) {
+            device->interfaceDrivers << driver;
+        }
+    }
+    
+    return true;
+}
+
+QByteArray SysfsDeviceEnumerator::readAttribute(const QString &devicePath, const char *name)
+{
+    QFile file(devicePath + '/' + QLatin1String(name));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll().trimmed();
+}
+
+quint32 SysfsDeviceEnumerator::readHexAttribute(const QString &devicePath, const char *name)
+{
+    // PCI attributes carry a 0x prefix, USB ones do not; toUInt(16) takes both
+    return readAttribute(devicePath, name).toUInt(nullptr, 16);
+}
+
+QString SysfsDeviceEnumerator::boundDriver(const QString &devicePath)
+{
+    const QFileInfo link(devicePath + "/driver");
+    if (!link.isSymLink()) {
+        return QString();
+    }
+    return QFileInfo(link.symLinkTarget()).fileName();
+}
@@ -0,0 +1,56 @@
+#ifndef SYSFSDEVICES_H
+#define SYSFSDEVICES_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QJsonObject>
+
+struct SysfsDevice {
+    QString bus;            // "pci" or "usb"
+    QString address;        // 0000:00:02.0, 1-4 ...
+    QString sysfsPath;
+    quint16 vendorId = 0;
+    quint16 deviceId = 0;
+    quint16 subsystemVendorId = 0;
+    quint16 subsystemDeviceId = 0;
+    quint32 classCode = 0;  // base class << 16 | subclass << 8 | prog-if
+    QString driver;         // bound driver, empty if none
+    QStringList interfaceDrivers;
+    QStringList modaliases; // the device's own for PCI, one per interface for USB
+    QString manufacturer;   // USB string descriptors, when present
+    QString product;
+    int busNumber = 0;
+    int deviceNumber = 0;
+    
+    quint8 baseClass() const { return quint8(classCode >> 16); }
+    quint8 subclass() const { return quint8(classCode >> 8); }
+    quint8 progIf() const { return quint8(classCode); }
+    
+    QString vendorName() const;
+    QString deviceName() const;
+    QString className() const;
+    QJsonObject toJson() const;
+};
+
+// Walks /sys/bus/pci/devices and /sys/bus/usb/devices directly. Everything
+// lspci and lsusb print about a device is available there without running
+// either tool or needing root; names come from HardwareIds.
+class SysfsDeviceEnumerator
+{
+public:
+    static QList<SysfsDevice> pciDevices();
+    static QList<SysfsDevice> usbDevices();
+    
+    // Re-reads a single device, e.g. after a hotplug event
+    static bool readDevice(const QString &bus, const QString &path, SysfsDevice *device);
+
+private:
+    static bool readPciDevice(const QString &path, SysfsDevice *device);
+    static bool readUsbDevice(const QString &path, SysfsDevice *device);
+    static QByteArray readAttribute(const QString &devicePath, const char *name);
+    static quint32 readHexAttribute(const QString &devicePath, const char *name);
+    static QString boundDriver(const QString &devicePath);
+};
+
+#endif // SYSFSDEVICES_H
@@ -1,4 +1,6 @@
 #include "systemutils.h"
+#include "moduleinventory.h"
+#include "repofiles.h"
 #include <QFile>
 #include <QDir>
 #include <QStandardPaths>
@@ -9,6 +11,7 @@
 #include <QNetworkRequest>
 #include <QEventLoop>
 #include <QApplication>
+#include <QSysInfo>
 
 QNetworkAccessManager *SystemUtils::networkManager = nullptr;
 
@@ -33,8 +36,7 @@ QString SystemUtils::getDistroName()
 
 QString SystemUtils::getKernelVersion()
 {
-    auto result = runCommand("uname", {"-r"});
-    return result.second.trimmed();
+    return QSysInfo::kernelVersion();
 }
 
 QString SystemUtils::getDesktopEnvironment()
@@ -53,59 +55,32 @@ bool SystemUtils::isSystemdAvailable()
 
 bool SystemUtils::isFlatpakAvailable()
 {
-    auto result = runCommand("which", {"flatpak"});
-    return result.first == 0;
+    return !QStandardPaths::findExecutable("flatpak").isEmpty();
 }
 
 bool SystemUtils::isDockerAvailable()
 {
-    auto result = runCommand("which", {"docker"});
-    return result.first == 0;
+    return !QStandardPaths::findExecutable("docker").isEmpty();
 }
 
 bool SystemUtils::isDistroboxAvailable()
 {
-    auto result = runCommand("which", {"distrobox"});
-    return result.first == 0;
+    return !QStandardPaths::findExecutable("distrobox").isEmpty();
 }
 
-QProcess* SystemUtils::createProcess(QObject *parent)
+QFuture<ProcessResult> SystemUtils::runCommand(const QString &command, const QStringList &args, int timeoutMs)
 {
-    QProcess *process = new QProcess(parent);
-    process->setProcessChannelMode(QProcess::MergedChannels);
-    return process;
-}
-
-QPair<int, QString> SystemUtils::runCommand(const QString &command, const QStringList &args)
-{
-    QProcess process;
-    process.setProcessChannelMode(QProcess::MergedChannels);
-    process.start(command, args);
-    
-    if (!process.waitForStarted(2000)) {
-        return {-1, "Failed to start process"};
-    }
-    
-    if (!process.waitForFinished(5000)) {
-        process.kill();
-        return {-1, "Process timed out"};
-    }
-    
-    QString output = process.readAllStandardOutput();
-    return {process.exitCode(), output};
+    ProcessRequest request(command, args);
+    request.channelMode = QProcess::MergedChannels;
+    request.timeoutMs = timeoutMs;
+    return ProcessRunner::instance()->run(request);
 }
 
 void SystemUtils::runCommandAsync(const QString &command, const QStringList &args, QObject *receiver, const char* slot)
 {
-    QProcess *process = new QProcess(receiver);
-    process->setProcessChannelMode(QProcess::MergedChannels);
-    
-    QObject::connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-                     [receiver, slot](int exitCode, QProcess::ExitStatus status) {
-                         QMetaObject::invokeMethod(receiver, slot, Q_ARG(int, exitCode), Q_ARG(int, static_cast<int>(status)));
-                     });
-    
-    process->start(command, args);
+    runCommand(command, args).then(receiver, [receiver, slot](const ProcessResult &result) {
+        QMetaObject::invokeMethod(receiver, slot, Q_ARG(int, result.exitCode), Q_ARG(int, static_cast<int>(result.exitStatus)));
+    });
 }
 
 bool SystemUtils::fileExists(const QString &path)
@@ -148,10 +123,11 @@ QStringList SystemUtils::listFiles(const QString &directory, const QString &patt
     return dir.entryList(QStringList() << pattern, QDir::Files);
 }
 
-bool SystemUtils::isOnline()
+QFuture<bool> SystemUtils::isOnline()
 {
-    auto result = runCommand("ping", {"-c", "1", "-W", "3", "8.8.8.8"});
-    return result.first == 0;
+    return runCommand("ping", {"-c", "1", "-W", "3", "8.8.8.8"}, 5000).then([](const ProcessResult &result) {
+        return result.success();
+    });
 }
 
 QString SystemUtils::downloadString(const QString &url)
@@ -175,31 +151,20 @@ QString SystemUtils::downloadString(const QString &url)
 
 bool SystemUtils::isDnfAvailable()
 {
-    auto result = runCommand("which", {"dnf"});
-    return result.first == 0;
+    return !QStandardPaths::findExecutable("dnf").isEmpty();
 }
 
 bool SystemUtils::isYumAvailable()
 {
-    auto result = runCommand("which", {"yum"});
-    return result.first == 0;
+    return !QStandardPaths::findExecutable("yum").isEmpty();
 }
 
 QStringList SystemUtils::getEnabledRepos()
 {
-    auto result = runCommand("dnf", {"repolist", "enabled", "--quiet"});
-    if (result.first != 0) {
-        return QStringList();
-    }
-    
     QStringList repos;
-    QStringList lines = result.second.split('\n');
-    for (const QString &line : lines) {
-        if (line.contains(' ')) {
-            QString repo = line.split(' ').first();
-            if (!repo.isEmpty() && repo != "repo") {
-                repos.append(repo);
-            }
+    for (const RepositoryInfo &repo : RepoFiles::readAll()) {
+        if (repo.enabled) {
+            repos.append(repo.id);
         }
     }
     return repos;
@@ -207,43 +172,37 @@ QStringList SystemUtils::getEnabledRepos()
 
 QStringList SystemUtils::getAvailableRepos()
 {
-    auto result = runCommand("dnf", {"repolist", "all", "--quiet"});
-    if (result.first != 0) {
-        return QStringList();
-    }
-    
     QStringList repos;
-    QStringList lines = result.second.split('\n');
-    for (const QString &line : lines) {
-        if (line.contains(' ')) {
-            QString repo = line.split(' ').first();
-            if (!repo.isEmpty() && repo != "repo") {
-                repos.append(repo);
-            }
-        }
+    for (const RepositoryInfo &repo : RepoFiles::readAll()) {
+        repos.append(repo.id);
     }
     return repos;
 }
 
-QStringList SystemUtils::getDockerContainers()
+QFuture<QStringList> SystemUtils::getDockerContainers()
 {
-    auto result = runCommand("docker", {"ps", "-a", "--format", "{{.Names}}"});
-    if (result.first != 0) {
-        return QStringList();
-    }
-    
-    return result.second.split('\n', Qt::SkipEmptyParts);
+    return runCommand("docker", {"ps", "-a", "--format", "{{.Names}}"}).then([](const ProcessResult &result) {
+        if (!result.success()) {
+            return QStringList();
+        }
+        
+        return result.output().split('\n', Qt::SkipEmptyParts);
+    });
 }
 
-QStringList SystemUtils::getDistroboxContainers()
+QFuture<QStringList> SystemUtils::getDistroboxContainers()
 {
-    auto result = runCommand("distrobox", {"list", "--no-color"});
-    if (result.first != 0) {
+    return runCommand("distrobox", {"list", "--no-color"}).then(parseDistroboxList);
+}
+
+QStringList SystemUtils::parseDistroboxList(const ProcessResult &result)
+{
+    if (!result.success()) {
         return QStringList();
     }
     
     QStringList containers;
-    QStringList lines = result.second.split('\n');
+    QStringList lines = result.output().split('\n');
     for (const QString &line : lines) {
         if (line.contains('|')) {
             QString container = line.split('|').first().trimmed();
@@ -255,37 +214,38 @@ QStringList SystemUtils::getDistroboxContainers()
     return containers;
 }
 
-bool SystemUtils::isContainerRunning(const QString &containerName)
+QFuture<bool> SystemUtils::isContainerRunning(const QString &containerName)
 {
-    auto result = runCommand("docker", {"ps", "--format", "{{.Names}}"});
-    if (result.first != 0) {
-        return false;
-    }
-    
-    return result.second.contains(containerName);
+    return runCommand("docker", {"ps", "--format", "{{.Names}}"}).then([containerName](const ProcessResult &result) {
+        return result.success() && result.output().contains(containerName);
+    });
 }
 
-bool SystemUtils::isPipeWireRunning()
+QFuture<bool> SystemUtils::isPipeWireRunning()
 {
-    auto result = runCommand("systemctl", {"--user", "is-active", "pipewire"});
-    return result.first == 0 && result.second.trimmed() == "active";
+    return runCommand("systemctl", {"--user", "is-active", "pipewire"}).then([](const ProcessResult &result) {
+        return result.success() && result.output().trimmed() == "active";
+    });
 }
 
 bool SystemUtils::isEasyEffectsInstalled()
 {
-    auto result = runCommand("which", {"easyeffects"});
-    return result.first == 0;
+    return !QStandardPaths::findExecutable("easyeffects").isEmpty();
+}
+
+QFuture<QStringList> SystemUtils::getAudioDevices()
+{
+    return runCommand("pactl", {"list", "short", "sinks"}).then(parseAudioDevices);
 }
 
-QStringList SystemUtils::getAudioDevices()
+QStringList SystemUtils::parseAudioDevices(const ProcessResult &result)
 {
-    auto result = runCommand("pactl", {"list", "short", "sinks"});
-    if (result.first != 0) {
+    if (!result.success()) {
         return QStringList();
     }
     
     QStringList devices;
-    QStringList lines = result.second.split('\n');
+    QStringList lines = result.output().split('\n');
     for (const QString &line : lines) {
         if (!line.isEmpty()) {
             QStringList parts = line.split('\t');
@@ -299,69 +259,40 @@ QStringList SystemUtils::getAudioDevices()
 
 QStringList SystemUtils::getLoadedKernelModules()
 {
-    auto result = runCommand("lsmod", {});
-    if (result.first != 0) {
-        return QStringList();
-    }
-    
-    QStringList modules;
-    QStringList lines = result.second.split('\n');
-    for (const QString &line : lines) {
-        if (!line.isEmpty()) {
-            QString module = line.split(' ').first();
-            if (!module.isEmpty() && module != "Module") {
-                modules.append(module);
-            }
-        }
-    }
-    return modules;
+    return ModuleInventory::snapshot()->loadedModuleNames();
 }
 
-QStringList SystemUtils::getAvailableDrivers()
+QFuture<QStringList> SystemUtils::getAvailableDrivers()
 {
-    QStringList drivers;
-    
-    // Check for NVIDIA drivers
-    auto nvidiaResult = runCommand("dnf", {"list", "available", "*nvidia*", "--quiet"});
-    if (nvidiaResult.first == 0) {
-        QStringList lines = nvidiaResult.second.split('\n');
-        for (const QString &line : lines) {
-            if (line.contains("nvidia")) {
-                QString driver = line.split(' ').first();
-                if (!driver.isEmpty()) {
-                    drivers.append(driver);
-                }
-            }
+    // One dnf run for both vendors; dnf takes several package specs at once
+    return runCommand("dnf", {"list", "available", "*nvidia*", "*amd*", "--quiet"}, 120000)
+        .then([](const ProcessResult &result) {
+        QStringList drivers;
+        if (!result.success()) {
+            return drivers;
         }
-    }
-    
-    // Check for AMD drivers
-    auto amdResult = runCommand("dnf", {"list", "available", "*amd*", "--quiet"});
-    if (amdResult.first == 0) {
-        QStringList lines = amdResult.second.split('\n');
+        
+        const QStringList lines = result.output().split('\n');
         for (const QString &line : lines) {
-            if (line.contains("amd")) {
+            if (line.contains("nvidia") || line.contains("amd")) {
                 QString driver = line.split(' ').first();
                 if (!driver.isEmpty()) {
                     drivers.append(driver);
                 }
             }
         }
-    }
-    
-    return drivers;
+        return drivers;
+    });
 }
 
 bool SystemUtils::isNvidiaDriverInstalled()
 {
-    auto result = runCommand("lsmod", {});
-    return result.second.contains("nvidia");
+    return ModuleInventory::snapshot()->isLoaded("nvidia");
 }
 
 bool SystemUtils::isAmdDriverInstalled()
 {
-    auto result = runCommand("lsmod", {});
-    return result.second.contains("amdgpu");
+    return ModuleInventory::snapshot()->isLoaded("amdgpu");
 }
 
 void SystemUtils::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
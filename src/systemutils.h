@@ -8,6 +8,8 @@
 #include <QTimer>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
+#include <QFuture>
+#include "processrunner.h"
 
 class SystemUtils : public QObject
 {
@@ -25,9 +27,8 @@ public:
     static bool isDockerAvailable();
     static bool isDistroboxAvailable();
     
-    // Process management
-    static QProcess* createProcess(QObject *parent = nullptr);
-    static QPair<int, QString> runCommand(const QString &command, const QStringList &args = QStringList());
+    // Process management; commands go through ProcessRunner and never block the caller
+    static QFuture<ProcessResult> runCommand(const QString &command, const QStringList &args = QStringList(), int timeoutMs = 30000);
     static void runCommandAsync(const QString &command, const QStringList &args, QObject *receiver, const char* slot);
     
     // File system utilities
@@ -38,7 +39,7 @@ public:
     static QStringList listFiles(const QString &directory, const QString &pattern = "*");
     
     // Network utilities
-    static bool isOnline();
+    static QFuture<bool> isOnline();
     static QString downloadString(const QString &url);
     
     // Package management helpers
@@ -48,18 +49,18 @@ public:
     static QStringList getAvailableRepos();
     
     // Container utilities
-    static QStringList getDockerContainers();
-    static QStringList getDistroboxContainers();
-    static bool isContainerRunning(const QString &containerName);
+    static QFuture<QStringList> getDockerContainers();
+    static QFuture<QStringList> getDistroboxContainers();
+    static QFuture<bool> isContainerRunning(const QString &containerName);
     
     // Audio utilities
-    static bool isPipeWireRunning();
+    static QFuture<bool> isPipeWireRunning();
     static bool isEasyEffectsInstalled();
-    static QStringList getAudioDevices();
+    static QFuture<QStringList> getAudioDevices();
     
     // Driver utilities
     static QStringList getLoadedKernelModules();
-    static QStringList getAvailableDrivers();
+    static QFuture<QStringList> getAvailableDrivers();
     static bool isNvidiaDriverInstalled();
     static bool isAmdDriverInstalled();
 
@@ -72,6 +73,9 @@ private slots:
     void onProcessError(QProcess::ProcessError error);
 
 private:
+    static QStringList parseDistroboxList(const ProcessResult &result);
+    static QStringList parseAudioDevices(const ProcessResult &result);
+    
     static QNetworkAccessManager *networkManager;
 };
 
@@ -0,0 +1,184 @@
+#include "tracing.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+#include <QDebug>
+#include <atomic>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace {
+
+struct TraceEvent {
+    QString name;
+    const char *category;
+    char phase;             // X complete, b/e async begin/end, i instant
+    qint64 timestamp;
+    qint64 duration;
+    qint64 threadId;
+    quint64 id;
+    QJsonObject args;
+};
+
+struct TraceState {
+    TraceState() { clock.start(); }
+    
+    QElapsedTimer clock;
+    std::atomic<bool> enabled{false};
+    std::atomic<quint64> nextId{1};
+    QMutex mutex;
+    QString path;
+    qint64 mainThreadId = 0;
+    QVector<TraceEvent> events;
+};
+
+TraceState &state()
+{
+    static TraceState traceState;
+    return traceState;
+}
+
+qint64 currentThreadId()
+{
+    static thread_local const qint64 tid = qint64(::syscall(SYS_gettid));
+    return tid;
+}
+
+void record(TraceEvent event)
+{
+    TraceState &s = state();
+    event.threadId = currentThreadId();
+    QMutexLocker locker(&s.mutex);
+    s.events.append(std::move(event));
+}
+
+}
+
+// Trace Implementation
+void Trace::enable(const QString &path)
+{
+    TraceState &s = state();
+    {
+        QMutexLocker locker(&s.mutex);
+        s.path = path;
+        s.mainThreadId = currentThreadId();
+        s.events.reserve(4096);
+    }
+    s.enabled = true;
+    
+    if (QCoreApplication *app = QCoreApplication::instance()) {
+        QObject::connect(app, &QCoreApplication::aboutToQuit, app, []() {
+            Trace::write();
+        });
+    }
+}
+
+bool Trace::isEnabled()
+{
+    return state().enabled.load(std::memory_order_relaxed);
+}
+
+qint64 Trace::now()
+{
+    return state().clock.nsecsElapsed() / 1000;
+}
+
+void Trace::complete(const QString &name, const char *category, qint64 startUs, qint64 durationUs,
+                     const QJsonObject &args)
+{
+    if (!isEnabled()) return;
+    record({ name, category, 'X', startUs, durationUs, 0, 0, args });
+}
+
+void Trace::async(const QString &name, const char *category, qint64 startUs, qint64 durationUs,
+                  const QJsonObject &args)
+{
+    if (!isEnabled()) return;
+    const quint64 id = state().nextId++;
+    record({ name, category, 'b', startUs, 0, 0, id, args });
+    record({ name, category, 'e', startUs + durationUs, 0, 0, id, QJsonObject() });
+}
+
+void Trace::instant(const char *name, const char *category, const QJsonObject &args)
+{
+    if (!isEnabled()) return;
+    record({ QString::fromUtf8(name), category, 'i', now(), 0, 0, 0, args });
+}
+
+bool Trace::write()
+{
+    TraceState &s = state();
+    if (!isEnabled()) return false;
+    
+    QVector<TraceEvent> events;
+    QString path;
+    qint64 mainThreadId;
+    {
+        QMutexLocker locker(&s.mutex);
+        events = s.events;
+        path = s.path;
+        mainThreadId = s.mainThreadId;
+    }
+    
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray traceEvents;
+    traceEvents.append(QJsonObject{
+        { "ph", "M" }, { "name", "process_name" }, { "pid", pid }, { "tid", mainThreadId },
+        { "args", QJsonObject{ { "name", QCoreApplication::applicationName() } } } });
+    traceEvents.append(QJsonObject{
+        { "ph", "M" }, { "name", "thread_name" }, { "pid", pid }, { "tid", mainThreadId },
+        { "args", QJsonObject{ { "name", "main" } } } });
+    
+    for (const TraceEvent &event : std::as_const(events)) {
+        QJsonObject object{
+            { "name", event.name },
+            { "cat", QString::fromLatin1(event.category) },
+            { "ph", QString(QChar::fromLatin1(event.phase)) },
+            { "ts", event.timestamp },
+            { "pid", pid },
+            { "tid", event.threadId },
+        };
+        if (event.phase == 'X') object.insert("dur", event.duration);
+        if (event.phase == 'i') object.insert("s", "t");
+        if (event.id != 0) object.insert("id", QString::number(event.id));
+        if (!event.args.isEmpty()) object.insert("args", event.args);
+        traceEvents.append(object);
+    }
+    
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Cannot write trace to" << path << ":" << file.errorString();
+        return false;
+    }
+    const QJsonObject root{
+        { "traceEvents", traceEvents },
+        { "displayTimeUnit", "ms" },
+    };
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    qInfo() << "Wrote" << events.size() << "trace events to" << path;
+    return true;
+}
+
+// TraceSpan Implementation
+TraceSpan::TraceSpan(const char *name, const char *category)
+    : m_name(name)
+    , m_category(category)
+    , m_start(Trace::isEnabled() ? Trace::now() : -1)
+{
+}
+
+TraceSpan::~TraceSpan()
+{
+    if (m_start < 0) return;
+    Trace::complete(QString::fromUtf8(m_name), m_category, m_start, Trace::now() - m_start, m_args);
+}
+
+void TraceSpan::setArg(const QString &key, const QJsonValue &value)
+{
+    if (m_start >= 0) m_args.insert(key, value);
+}
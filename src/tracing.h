@@ -0,0 +1,53 @@
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <QString>
+#include <QJsonObject>
+#include <QJsonValue>
+
+// Records where time goes as Chrome trace events, written as JSON that
+// chrome://tracing and ui.perfetto.dev open directly. Off unless enable()
+// was called (--trace <file>); until then a span or instant costs an atomic
+// load, since their names stay C strings unless the event is recorded. When
+// on, a span costs two clock reads and an append under a lock. The file is
+// written when the application quits.
+class Trace
+{
+public:
+    static void enable(const QString &path);
+    static bool isEnabled();
+    static bool write();
+    
+    // Microseconds on the trace clock, which starts the first time it is read
+    static qint64 now();
+    
+    // A span on the calling thread; spans on one thread must nest
+    static void complete(const QString &name, const char *category, qint64 startUs, qint64 durationUs,
+                         const QJsonObject &args = QJsonObject());
+    // A span on its own track, for work that overlaps freely (e.g. child processes)
+    static void async(const QString &name, const char *category, qint64 startUs, qint64 durationUs,
+                      const QJsonObject &args = QJsonObject());
+    static void instant(const char *name, const char *category, const QJsonObject &args = QJsonObject());
+};
+
+// Times the enclosing scope as a complete event. Details that vary go in
+// args, built only when isRecording() says they will be kept.
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *name, const char *category = "startup");
+    ~TraceSpan();
+    
+    bool isRecording() const { return m_start >= 0; }
+    void setArg(const QString &key, const QJsonValue &value);
+
+private:
+    Q_DISABLE_COPY(TraceSpan)
+    
+    const char *m_name;
+    const char *m_category;
+    qint64 m_start;
+    QJsonObject m_args;
+};
+
+#endif // TRACING_H
@@ -0,0 +1,135 @@
+#include "ueventmonitor.h"
+#include <QSocketNotifier>
+#include <QDebug>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+// Kernel uevents are small; this also covers the largest environment the kernel sends
+const int UEVENT_BUFFER_SIZE = 8192;
+
+// Hotplug storms (docking, USB hubs) can queue hundreds of events at once
+const int RECEIVE_BUFFER_SIZE = 1024 * 1024;
+
+}
+
+// UeventMonitor Implementation
+UeventMonitor::UeventMonitor(QObject *parent)
+    : QObject(parent)
+    , m_socket(-1)
+    , m_notifier(nullptr)
+{
+}
+
+UeventMonitor::~UeventMonitor()
+{
+    stop();
+}
+
+bool UeventMonitor::start()
+{
+    if (m_socket >= 0) {
+        return true;
+    }
+    
+    m_socket = ::socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+    if (m_socket < 0) {
+        qWarning() << "Cannot open uevent socket:" << strerror(errno);
+        return false;
+    }
+    
+    int bufferSize = RECEIVE_BUFFER_SIZE;
+    ::setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+    
+    sockaddr_nl address;
+    memset(&address, 0, sizeof(address));
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = 1;  // kernel events; group 2 is udev's re-broadcast
+    
+    if (::bind(m_socket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+        qWarning() << "Cannot bind uevent socket:" << strerror(errno);
+        ::close(m_socket);
+        m_socket = -1;
+        return false;
+    }
+    
+    m_notifier = new QSocketNotifier(m_socket, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &UeventMonitor::readEvents);
+    return true;
+}
+
+void UeventMonitor::stop()
+{
+    delete m_notifier;
+    m_notifier = nullptr;
+    
+    if (m_socket >= 0) {
+        ::close(m_socket);
+        m_socket = -1;
+    }
+}
+
+void UeventMonitor::readEvents()
+{
+    char buffer[UEVENT_BUFFER_SIZE];
+    
+    for (;;) {
+        sockaddr_nl sender;
+        socklen_t senderLength = sizeof(sender);
+        const ssize_t size = ::recvfrom(m_socket, buffer, sizeof(buffer) - 1, 0,
+                                        reinterpret_cast<sockaddr *>(&sender), &senderLength);
+        if (size < 0) {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS) {
+                // The queue overflowed; later events still arrive, the lost ones are gone
+                qWarning() << "Uevent queue overflowed, some hotplug events were dropped";
+                continue;
+            }
+            break;  // EAGAIN: drained
+        }
+        
+        // Only the kernel (port 0) is trusted; anyone can send to the group otherwise
+        if (senderLength != sizeof(sender) || sender.nl_pid != 0) continue;
+        
+        buffer[size] = '\0';
+        Uevent event;
+        if (parse(buffer, int(size), &event)) {
+            emit ueventReceived(event);
+        }
+    }
+}
+
+bool UeventMonitor::parse(const char *data, int size, Uevent *event)
+{
+    // "add@/devices/...\0ACTION=add\0DEVPATH=/devices/...\0SUBSYSTEM=usb\0..."
+    const char *header = data;
+    const int headerLength = int(strnlen(header, size_t(size)));
+    if (!memchr(header, '@', size_t(headerLength))) {
+        return false;
+    }
+    
+    for (int offset = headerLength + 1; offset < size;) {
+        const char *entry = data + offset;
+        const int length = int(strnlen(entry, size_t(size - offset)));
+        const char *equals = static_cast<const char *>(memchr(entry, '=', size_t(length)));
+        if (equals) {
+            const QString key = QString::fromLatin1(entry, int(equals - entry));
+            const QString value = QString::fromUtf8(equals + 1, int(entry + length - equals - 1));
+            event->properties.insert(key, value);
+        }
+        offset += length + 1;
+    }
+    
+    event->action = event->properties.value("ACTION");
+    event->devpath = event->properties.value("DEVPATH");
+    event->subsystem = event->properties.value("SUBSYSTEM");
+    event->devtype = event->properties.value("DEVTYPE");
+    event->driver = event->properties.value("DRIVER");
+    event->modalias = event->properties.value("MODALIAS");
+    
+    return !event->action.isEmpty() && !event->devpath.isEmpty();
+}
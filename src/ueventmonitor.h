@@ -0,0 +1,50 @@
+#ifndef UEVENTMONITOR_H
+#define UEVENTMONITOR_H
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+
+class QSocketNotifier;
+
+struct Uevent {
+    QString action;         // add, remove, bind, unbind, change, move
+    QString devpath;        // relative to /sys
+    QString subsystem;
+    QString devtype;
+    QString driver;
+    QString modalias;
+    QHash<QString, QString> properties;
+    
+    QString sysfsPath() const { return "/sys" + devpath; }
+};
+
+// Listens on the kernel's NETLINK_KOBJECT_UEVENT multicast group, the same
+// events udev consumes, so hotplug, driver bind/unbind and module load/unload
+// arrive as they happen instead of being found by the next rescan.
+class UeventMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit UeventMonitor(QObject *parent = nullptr);
+    ~UeventMonitor();
+    
+    bool start();
+    void stop();
+    bool isActive() const { return m_socket >= 0; }
+    
+    static bool parse(const char *data, int size, Uevent *event);
+
+signals:
+    void ueventReceived(const Uevent &event);
+
+private slots:
+    void readEvents();
+
+private:
+    int m_socket;
+    QSocketNotifier *m_notifier;
+};
+
+#endif // UEVENTMONITOR_H